@@ -13,15 +13,15 @@
 
 #include <cstdio>
 #include <cstdlib>
-#include <map>
 
 #include "controller_port.hpp"
+#include "device_registry.hpp"
 #include "global.hpp"
-#include "handlers/bare_xbox360_wireless.hpp"
-#include "handlers/bare_xbox_one.hpp"
 #include "pico/stdlib.h"
 #include "processors/pipeline.hpp"
+#include "processors/report_capture.hpp"
 #include "tusb.h"
+#include "usb_devices.hpp"
 #include "utility.h"
 
 /// last mounted device descriptor
@@ -114,15 +114,6 @@ static uint16_t count_interface_total_len(tusb_desc_interface_t const *desc_itf,
     return len;
 }
 
-/**
- * @brief Hash map with the TinyUSB device address as key
- *
- * and implementations of \ref ReportSourceInterface as value.
- * Used to store mounted vendor class devices for proper deletion
- * during unmount.
- */
-std::map<uint8_t, std::shared_ptr<ReportSourceInterface>> bare_handlers;
-
 /**
  * @brief Called for every found USB interface description that is off vendor class type
  *
@@ -137,21 +128,10 @@ static void open_vendor_interface(uint8_t daddr, tusb_desc_interface_t const *de
 
     PRINTF("open_vendor_interface %x %x\n", vid, pid);
 
-    // Xbox One Controller
-    if (check_xbox_one_vid_pid(vid, pid)) {
-        auto handler = std::make_shared<XboxOneHandler>();
-
-        handler->open_vendor_interface(daddr, desc_itf, max_len);
-        bare_handlers[daddr] = handler;
-        gbl_pipeline->integrate_handler(handler);
-    }
-
-    // XBox 360 Wireless Receiver
-    if (check_xbox_360_wireless_receiver_vid_pid(vid, pid)) {
-        auto handler = std::make_shared<Xbox360WirelessReceiverHandler>();
-
-        handler->open_vendor_interface(daddr, desc_itf, max_len);
-        bare_handlers[daddr] = handler;
+    const DeviceRegistry::Entry *entry = DeviceRegistry::find(vid, pid);
+    std::shared_ptr<ReportSourceInterface> *slot = gbl_usb_devices.vendor(daddr);
+    if (entry && entry->vendor_ && slot) {
+        *slot = entry->vendor_(daddr, reinterpret_cast<uint8_t const *>(desc_itf), max_len);
     }
 }
 
@@ -256,6 +236,18 @@ static void handle_device_descriptor(tuh_xfer_t *xfer) {
     }
 }
 
+void capture_vendor_report(uint8_t daddr, uint8_t instance, std::span<const uint8_t> data) {
+#if CONFIG_REPORT_CAPTURE == 1
+    uint16_t vid, pid;
+    tuh_vid_pid_get(daddr, &vid, &pid);
+    ReportCapture::instance().report(ReportCapture::kVendorReport, daddr, instance, vid, pid, data);
+#else
+    std::ignore = daddr;
+    std::ignore = instance;
+    std::ignore = data;
+#endif
+}
+
 /// Invoked when device is mounted (configured)
 void tuh_mount_cb(uint8_t daddr) {
     PRINTF("Device attached, address = %d\r\n", daddr);
@@ -266,13 +258,9 @@ void tuh_mount_cb(uint8_t daddr) {
     PRINTF("tuh_mount_cb device address = %d is mounted\n", daddr);
     PRINTF("VID = %04x, PID = %04x\n", vid, pid);
 
-    // Xbox One Controller
-    if (check_xbox_one_vid_pid(vid, pid)) {
-        tuh_descriptor_get_device(daddr, &desc_device, 18, handle_device_descriptor, 0);
-    }
-
-    // XBox 360 Wireless Receiver
-    if (check_xbox_360_wireless_receiver_vid_pid(vid, pid)) {
+    // Only devices with a vendor class driver need their descriptors
+    const DeviceRegistry::Entry *entry = DeviceRegistry::find(vid, pid);
+    if (entry && entry->vendor_) {
         tuh_descriptor_get_device(daddr, &desc_device, 18, handle_device_descriptor, 0);
     }
 }
@@ -280,5 +268,5 @@ void tuh_mount_cb(uint8_t daddr) {
 /// Invoked when device is unmounted (bus reset/unplugged)
 void tuh_umount_cb(uint8_t daddr) {
     PRINTF("Device removed, address = %d\r\n", daddr);
-    bare_handlers.erase(daddr);
+    gbl_usb_devices.remove(daddr);
 }
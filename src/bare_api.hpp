@@ -1,3 +1,15 @@
 #pragma once
 
 #include <cstdint>
+#include <span>
+
+/**
+ * @brief Stores a transfer of a vendor class interface in the \ref ReportCapture
+ *
+ * Does nothing without CONFIG_REPORT_CAPTURE
+ *
+ * @param daddr     TinyUSB device identifier
+ * @param instance  Index of the interface or controller on this device
+ * @param data      Received data
+ */
+void capture_vendor_report(uint8_t daddr, uint8_t instance, std::span<const uint8_t> data);
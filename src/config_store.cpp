@@ -0,0 +1,65 @@
+/**
+ * @file config_store.cpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "config_store.hpp"
+#include "hardware/flash.h"
+#include "processors/mouse_c1351.hpp"
+#include "utility.h"
+
+static_assert(FlashInterface::kPageSize == FLASH_PAGE_SIZE);
+static_assert(FlashInterface::kSectorSize == FLASH_SECTOR_SIZE);
+
+/**
+ * @brief Both sectors of \ref kFlashConfigStoreOffset
+ */
+class PicoFlash : public FlashInterface {
+  private:
+    /// @brief Returns the offset of a sector from the start of the flash
+    static uint32_t offset(size_t index) {
+        return kFlashConfigStoreOffset + index * kSectorSize;
+    }
+
+  public:
+    std::span<const uint8_t> sector(size_t index) override {
+        return {reinterpret_cast<const uint8_t *>(XIP_BASE + offset(index)), kSectorSize};
+    }
+
+    void erase(size_t index) override {
+        PRINTF("Erase sector at 0x%lx\n", offset(index));
+        FlashAccessGuard guard;
+        flash_range_erase(offset(index), kSectorSize);
+    }
+
+    void program_page(size_t index, size_t page_offset, const uint8_t *data) override {
+        FlashAccessGuard guard;
+        flash_range_program(offset(index) + page_offset, data, kPageSize);
+    }
+};
+
+FlashKvStore &config_store() {
+    static PicoFlash flash;
+    static FlashKvStore store(flash);
+    static bool migrated = false;
+
+    if (!migrated) {
+        migrated = true;
+        if (!store.formatted()) {
+            PRINTF("Migrate configuration of older firmware\n");
+            LegacyConfig::migrate(
+                store, {reinterpret_cast<const uint8_t *>(XIP_BASE + kFlashLegacyMouseModeOffset), FLASH_SECTOR_SIZE},
+                {reinterpret_cast<const uint8_t *>(XIP_BASE + kFlashLegacyCalibrationDataOffset), FLASH_SECTOR_SIZE},
+                sizeof(std::array<C1351CalibrationData, 2>));
+        }
+        PRINTF("Configuration in sector %u with %u bytes free\n", store.active_sector(), store.free_space());
+    }
+
+    return store;
+}
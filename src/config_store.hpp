@@ -0,0 +1,101 @@
+/**
+ * @file config_store.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <cstring>
+#include <optional>
+#include <span>
+
+#include "flash_kv_store.hpp"
+
+/// @brief Keys of all settings inside \ref config_store
+enum ConfigKey : uint8_t {
+    /// Mouse type, rate profiles and acceleration curve as a single byte
+    kConfigMouseMode = 0,
+    /// Calibration of the C1351 emulation for both ports
+    kConfigC1351Calibration = 1,
+};
+
+/**
+ * @brief Provides the store of all settings
+ *
+ * Older configurations are migrated on first use.
+ *
+ * @return FlashKvStore& Store which must only be used by the output core
+ */
+FlashKvStore &config_store();
+
+/**
+ * @brief Reads settings in the format of older firmware
+ *
+ * Before \ref FlashKvStore, every setting had its own flash sector.
+ */
+struct LegacyConfig {
+    /**
+     * @brief Recovers the mouse mode of the single byte flash EEPROM emulation
+     *
+     * Configuration bytes were appended to the sector. The last one before
+     * the first erased byte is the newest.
+     *
+     * @param sector    Content of the sector
+     * @return std::optional<uint8_t> Configuration byte if one was stored
+     */
+    static std::optional<uint8_t> mouse_mode(std::span<const uint8_t> sector) {
+        for (size_t i = 0; i < sector.size(); i++) {
+            if (sector[i] == 0xff)
+                return i ? std::optional<uint8_t>(sector[i - 1]) : std::nullopt;
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Recovers the calibration data of the C1351 emulation
+     *
+     * The data was followed by the string "VALID".
+     *
+     * @param sector    Content of the sector
+     * @param size      Size of the calibration data in bytes
+     * @return std::span<const uint8_t> Calibration data. Empty if not stored
+     */
+    static std::span<const uint8_t> calibration(std::span<const uint8_t> sector, size_t size) {
+        static constexpr char kValid[] = "VALID";
+        if (sector.size() < size + sizeof(kValid) || memcmp(&sector[size], kValid, sizeof(kValid)) != 0)
+            return {};
+        return sector.first(size);
+    }
+
+    /**
+     * @brief Copies the settings of older firmware into a store which was never used
+     *
+     * The store is formatted afterwards, even without any older settings, so the migration is only performed once.
+     * The older sectors are not modified. A loss of power just causes another migration.
+     *
+     * @param store                 Store to fill
+     * @param mouse_mode_sector     Content of the sector of the mouse mode
+     * @param calibration_sector    Content of the sector of the C1351 calibration
+     * @param calibration_size      Size of the calibration data in bytes
+     */
+    static void migrate(FlashKvStore &store, std::span<const uint8_t> mouse_mode_sector,
+                        std::span<const uint8_t> calibration_sector, size_t calibration_size) {
+        if (store.formatted())
+            return;
+
+        std::optional<uint8_t> mode = mouse_mode(mouse_mode_sector);
+        std::span<const uint8_t> calibration_data = calibration(calibration_sector, calibration_size);
+
+        if (mode)
+            store.write(kConfigMouseMode, std::span(&mode.value(), 1));
+        if (!calibration_data.empty())
+            store.write(kConfigC1351Calibration, calibration_data);
+        store.format();
+    }
+};
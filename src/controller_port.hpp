@@ -13,7 +13,9 @@
 #include <array>
 #include <memory>
 
+#include "controller_port_pins.hpp"
 #include "pico/stdlib.h"
+#include "processors/binary_trace.hpp"
 #include "processors/interfaces.hpp"
 #include "utility.h"
 
@@ -54,43 +56,42 @@ class RightControllerPort : public ControllerPortInterface {
     }
 
     uint get_pot_x_drain_gpio() override {
-        return 7;
+        return kRightPortPins.fire2;
     }
     uint get_pot_y_drain_gpio() override {
-        return 11;
+        return kRightPortPins.fire3;
     }
     uint get_pot_y_sense_gpio() override {
         return 13;
     }
 
     void configure_gpios() override {
-        const uint drain_pins[] = {7, 9, 10, 11, 12, 14, 15};
-
         const uint sense_pin = get_pot_y_sense_gpio();
 
         gpio_set_dir(sense_pin, GPIO_IN);
         gpio_set_pulls(sense_pin, true, false);
         gpio_set_input_hysteresis_enabled(sense_pin, 1);
 
-        for (auto i : drain_pins) {
-            gpio_init(i);
-            gpio_set_dir(i, GPIO_OUT);
-            gpio_put(i, 0);
-        }
+        gpio_init_mask(kRightPortMasks.mask());
+        gpio_clr_mask(kRightPortMasks.mask());
+        gpio_set_dir_out_masked(kRightPortMasks.mask());
         PRINTF("GPIOs set for joystick mode on right port\n");
     }
 
     void set_port_state(ControllerPortState &state) override {
-        gpio_put(7, state.fire2); // Also used as Pot X
-        gpio_put(9, state.fire1);
-        gpio_put(15, state.up);
-        gpio_put(11, state.fire3); // Also used as Pot Y
-        gpio_put(14, state.down);
-        gpio_put(12, state.left);
-        gpio_put(10, state.right);
+        // All signals change with the same write
+        gpio_put_masked(kRightPortMasks.mask(), kRightPortMasks.levels(state));
+
+        BinaryTrace::write<kTraceRightPort>(state.all_buttons);
+    }
 
-        PRINTF("R %d%d%d%d %d%d%d\n", state.left, state.up, state.down, state.right, state.fire1, state.fire2,
-               state.fire3);
+    uint32_t get_gpio_mask(const ControllerPortState &state) override {
+        return kRightPortMasks.levels(state);
+    }
+
+    uint get_direction_gpio_base() override {
+        // Lowest of the directional pins
+        return kRightPortPins.right;
     }
 };
 
@@ -128,43 +129,42 @@ class LeftControllerPort : public ControllerPortInterface {
     }
 
     uint get_pot_x_drain_gpio() override {
-        return 6;
+        return kLeftPortPins.fire2;
     }
     uint get_pot_y_drain_gpio() override {
-        return 5;
+        return kLeftPortPins.fire3;
     }
     uint get_pot_y_sense_gpio() override {
         return 8;
     }
 
     void configure_gpios() override {
-        const uint drain_pins[] = {0, 1, 2, 3, 4, 5, 6};
-
         const uint sense_pin = get_pot_y_sense_gpio();
 
         gpio_set_dir(sense_pin, GPIO_IN);
         gpio_set_pulls(sense_pin, true, false);
         gpio_set_input_hysteresis_enabled(sense_pin, 1);
 
-        for (auto i : drain_pins) {
-            gpio_init(i);
-            gpio_set_dir(i, GPIO_OUT);
-            gpio_put(i, 0);
-        }
+        gpio_init_mask(kLeftPortMasks.mask());
+        gpio_clr_mask(kLeftPortMasks.mask());
+        gpio_set_dir_out_masked(kLeftPortMasks.mask());
 
         PRINTF("GPIOs set for joystick mode on left port\n");
     }
 
-    void set_port_state(ControllerPortState &state) {
-        gpio_put(0, state.right);
-        gpio_put(1, state.left);
-        gpio_put(2, state.down);
-        gpio_put(3, state.up);
-        gpio_put(4, state.fire1);
-        gpio_put(5, state.fire3); // Also used as Pot Y
-        gpio_put(6, state.fire2); // Also used as Pot X
+    void set_port_state(ControllerPortState &state) override {
+        // All signals change with the same write
+        gpio_put_masked(kLeftPortMasks.mask(), kLeftPortMasks.levels(state));
+
+        BinaryTrace::write<kTraceLeftPort>(state.all_buttons);
+    }
+
+    uint32_t get_gpio_mask(const ControllerPortState &state) override {
+        return kLeftPortMasks.levels(state);
+    }
 
-        PRINTF("L %d%d%d%d %d%d%d\n", state.left, state.up, state.down, state.right, state.fire1, state.fire2,
-               state.fire3);
+    uint get_direction_gpio_base() override {
+        // Lowest of the directional pins
+        return kLeftPortPins.right;
     }
 };
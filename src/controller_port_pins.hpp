@@ -0,0 +1,104 @@
+/**
+ * @file controller_port_pins.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "processors/interfaces.hpp"
+
+/// @brief GPIO of every signal of a controller port
+struct ControllerPortPins {
+    uint8_t up;    ///< GPIO of Up
+    uint8_t down;  ///< GPIO of Down
+    uint8_t left;  ///< GPIO of Left
+    uint8_t right; ///< GPIO of Right
+    uint8_t fire1; ///< GPIO of Fire 1
+    uint8_t fire2; ///< GPIO of Fire 2. Also used as Pot X
+    uint8_t fire3; ///< GPIO of Fire 3. Also used as Pot Y
+};
+
+/**
+ * @brief GPIO levels of all states of a controller port
+ *
+ * Calculated at compile time from the pins of the port. This allows to apply
+ * a complete \ref ControllerPortState with a single write to the SIO. The
+ * target machine never samples a state in which only some of the signals have changed.
+ */
+class ControllerPortMasks {
+  public:
+    /// @brief Number of different values of \ref ControllerPortState::all_buttons
+    static constexpr size_t kStates{1 << 7};
+
+  private:
+    /// @brief All GPIOs of the port
+    uint32_t mask_{0};
+
+    /// @brief GPIO levels for every value of \ref ControllerPortState::all_buttons
+    std::array<uint32_t, kStates> levels_{};
+
+  public:
+    /**
+     * @brief Calculates the levels of all states
+     *
+     * @param pins  GPIO of every signal
+     */
+    constexpr explicit ControllerPortMasks(const ControllerPortPins &pins) {
+        // Same order as the bits of ControllerPortState::all_buttons
+        const std::array<uint8_t, 7> bit_to_pin{pins.up,    pins.down,  pins.left, pins.right,
+                                                pins.fire1, pins.fire2, pins.fire3};
+
+        for (uint8_t pin : bit_to_pin)
+            mask_ |= 1u << pin;
+
+        for (size_t state = 0; state < kStates; state++) {
+            for (size_t bit = 0; bit < bit_to_pin.size(); bit++) {
+                if (state & (1u << bit))
+                    levels_[state] |= 1u << bit_to_pin[bit];
+            }
+        }
+    }
+
+    /// @brief Returns a mask of all GPIOs of the port. Bit n is GPIO n
+    constexpr uint32_t mask() const {
+        return mask_;
+    }
+
+    /**
+     * @brief Returns the GPIO levels of a state
+     *
+     * @param state     State of the port
+     * @return uint32_t Bit n is the level of GPIO n
+     */
+    constexpr uint32_t levels(const ControllerPortState &state) const {
+        return levels_[state.all_buttons & (kStates - 1)];
+    }
+};
+
+/// @brief Pins of the right port. On the Amiga, this is used for the Mouse
+inline constexpr ControllerPortPins kRightPortPins{
+    .up = 15, .down = 14, .left = 12, .right = 10, .fire1 = 9, .fire2 = 7, .fire3 = 11};
+
+/// @brief Pins of the left port. On the Amiga, this is used for the Joystick
+inline constexpr ControllerPortPins kLeftPortPins{
+    .up = 3, .down = 2, .left = 1, .right = 0, .fire1 = 4, .fire2 = 6, .fire3 = 5};
+
+/// @brief GPIO levels of all states of the right port
+inline constexpr ControllerPortMasks kRightPortMasks{kRightPortPins};
+
+/// @brief GPIO levels of all states of the left port
+inline constexpr ControllerPortMasks kLeftPortMasks{kLeftPortPins};
+
+static_assert(std::popcount(kRightPortMasks.mask()) == 7, "Every signal of the right port needs its own pin");
+static_assert(std::popcount(kLeftPortMasks.mask()) == 7, "Every signal of the left port needs its own pin");
@@ -0,0 +1,80 @@
+/**
+ * @file device_registry.cpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "device_registry.hpp"
+#include "handlers/bare_xbox360_wireless.hpp"
+#include "handlers/bare_xbox_one.hpp"
+#include "tusb.h"
+
+/// @brief All devices with a dedicated driver. The order doesn't matter as the table is sorted at compile time
+static constexpr auto kDevices = DeviceRegistry::sort(std::to_array<DeviceRegistry::Entry>({
+    {0x07b5, 0x0314, make_impact_handler, nullptr},     // Impact Gamepad
+    {0x0079, 0x0011, make_hizue_handler, nullptr},      // Hizue / DragonRise SNES Gamepad
+    {0x054c, 0x0268, make_ps3_handler, nullptr},        // PS3 Dual Shock
+    {0x0810, 0x0001, make_ps3_handler, nullptr},        // PS3 Clone
+    // https://github.com/felis/USB_Host_Shield_2.0/blob/master/PS4USB.h
+    {0x054c, 0x05c4, make_ps4_handler, nullptr},        // PS4 Controller
+    {0x054c, 0x09cc, make_ps4_handler, nullptr},        // PS4 Slim Controller
+    {0x057e, 0x2009, make_switch_pro_handler, nullptr}, // Switch Pro Controller
+
+    // Xbox One Controllers
+    {XBOX_VID1, XBOX_ONE_PID1, nullptr, open_xbox_one_handler},
+    {XBOX_VID1, XBOX_ONE_PID2, nullptr, open_xbox_one_handler},
+    {XBOX_VID1, XBOX_ONE_PID3, nullptr, open_xbox_one_handler},
+    {XBOX_VID1, XBOX_ONE_PID4, nullptr, open_xbox_one_handler},
+    {XBOX_VID1, XBOX_ONE_PID13, nullptr, open_xbox_one_handler},
+    {XBOX_VID1, XBOX_ONE_PID14, nullptr, open_xbox_one_handler},
+    {XBOX_VID2, XBOX_ONE_PID5, nullptr, open_xbox_one_handler},
+    {XBOX_VID3, XBOX_ONE_PID6, nullptr, open_xbox_one_handler},
+    {XBOX_VID3, XBOX_ONE_PID7, nullptr, open_xbox_one_handler},
+    {XBOX_VID4, XBOX_ONE_PID8, nullptr, open_xbox_one_handler},
+    {XBOX_VID5, XBOX_ONE_PID9, nullptr, open_xbox_one_handler},
+    {XBOX_VID6, XBOX_ONE_PID10, nullptr, open_xbox_one_handler},
+    {XBOX_VID6, XBOX_ONE_PID11, nullptr, open_xbox_one_handler},
+    {XBOX_VID6, XBOX_ONE_PID12, nullptr, open_xbox_one_handler},
+
+    // Xbox 360 Wireless Receivers
+    {XBOX_VID, XBOX_WIRELESS_RECEIVER_PID_1, nullptr, open_xbox_360_wireless_receiver_handler},
+    {XBOX_VID, XBOX_WIRELESS_RECEIVER_PID_2, nullptr, open_xbox_360_wireless_receiver_handler},
+    {XBOX_VID, XBOX_WIRELESS_RECEIVER_THIRD_PARTY_PID, nullptr, open_xbox_360_wireless_receiver_handler},
+    {MADCATZ_VID, XBOX_WIRELESS_RECEIVER_PID_1, nullptr, open_xbox_360_wireless_receiver_handler},
+    {MADCATZ_VID, XBOX_WIRELESS_RECEIVER_PID_2, nullptr, open_xbox_360_wireless_receiver_handler},
+    {MADCATZ_VID, XBOX_WIRELESS_RECEIVER_THIRD_PARTY_PID, nullptr, open_xbox_360_wireless_receiver_handler},
+    {JOYTECH_VID, XBOX_WIRELESS_RECEIVER_PID_1, nullptr, open_xbox_360_wireless_receiver_handler},
+    {JOYTECH_VID, XBOX_WIRELESS_RECEIVER_PID_2, nullptr, open_xbox_360_wireless_receiver_handler},
+    {JOYTECH_VID, XBOX_WIRELESS_RECEIVER_THIRD_PARTY_PID, nullptr, open_xbox_360_wireless_receiver_handler},
+}));
+
+static_assert(DeviceRegistry::is_valid(kDevices), "Devices must be listed only once");
+
+/// @brief Generic drivers for devices which are not listed in \ref kDevices. First match is used
+static constexpr std::array<DeviceRegistry::UsageEntry, 3> kUsages{{
+    {HID_USAGE_PAGE_DESKTOP, HID_USAGE_DESKTOP_MOUSE, make_mouse_handler},
+    {HID_USAGE_PAGE_DESKTOP, HID_USAGE_DESKTOP_JOYSTICK, make_joystick_handler},
+    {HID_USAGE_PAGE_DESKTOP, HID_USAGE_DESKTOP_GAMEPAD, make_joystick_handler},
+}};
+
+const DeviceRegistry::Entry *DeviceRegistry::find(uint16_t vid, uint16_t pid) {
+    return lookup(kDevices, vid, pid);
+}
+
+HidHandlerFactory DeviceRegistry::find_hid(uint16_t vid, uint16_t pid, uint16_t usage_page, uint16_t usage) {
+    const Entry *entry = find(vid, pid);
+    if (entry && entry->hid_)
+        return entry->hid_;
+
+    for (auto &i : kUsages) {
+        if (i.usage_page_ == usage_page && i.usage_ == usage)
+            return i.hid_;
+    }
+
+    return nullptr;
+}
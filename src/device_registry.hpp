@@ -0,0 +1,153 @@
+/**
+ * @file device_registry.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "processors/interfaces.hpp"
+
+/// @brief Creates the handler of a HID interface
+using HidHandlerFactory = std::unique_ptr<HidHandlerInterface> (*)();
+
+/**
+ * @brief Creates the handler of a vendor class interface and opens it
+ *
+ * @param daddr         TinyUSB device identifier
+ * @param desc_itf      Interface descriptor to process
+ * @param max_len       Length of data referenced by desc_itf
+ */
+using VendorHandlerFactory = std::shared_ptr<ReportSourceInterface> (*)(uint8_t daddr, uint8_t const *desc_itf,
+                                                                         uint16_t max_len);
+
+/**
+ * @brief Table of all supported devices
+ *
+ * Devices with a dedicated driver are found by VID and PID using a binary search
+ * in a table which is sorted at compile time. Devices without a dedicated driver
+ * are matched by the usage of their HID report.
+ *
+ * All tables are constant and placed in flash. Nothing is constructed during boot.
+ */
+class DeviceRegistry {
+  public:
+    /// @brief Driver of a device identified by VID and PID
+    struct Entry {
+        uint16_t vid_;                ///< Vendor ID
+        uint16_t pid_;                ///< Product ID
+        HidHandlerFactory hid_;       ///< Factory for HID interfaces. Can be nullptr
+        VendorHandlerFactory vendor_; ///< Factory for vendor class interfaces. Can be nullptr
+
+        /// @brief Returns VID and PID combined as sort key
+        constexpr uint32_t key() const {
+            return (static_cast<uint32_t>(vid_) << 16) | pid_;
+        }
+    };
+
+    /// @brief Driver of HID devices identified by the usage of their report
+    struct UsageEntry {
+        uint16_t usage_page_;   ///< Usage Page of the report
+        uint16_t usage_;        ///< Usage of the report
+        HidHandlerFactory hid_; ///< Factory of the handler
+    };
+
+    /**
+     * @brief Sorts a table by VID and PID
+     *
+     * @param table     Unsorted table
+     * @return          Sorted table
+     */
+    template <size_t N> static constexpr std::array<Entry, N> sort(std::array<Entry, N> table) {
+        std::sort(table.begin(), table.end(), [](const Entry &a, const Entry &b) { return a.key() < b.key(); });
+        return table;
+    }
+
+    /**
+     * @brief Checks that a table is sorted and that every device is only listed once
+     *
+     * @param table     Table to check
+     * @return true     The table can be searched with \ref lookup
+     */
+    template <size_t N> static constexpr bool is_valid(const std::array<Entry, N> &table) {
+        for (size_t i = 1; i < N; i++) {
+            if (table[i - 1].key() >= table[i].key())
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Searches a table for a device
+     *
+     * @param table     Table sorted by \ref sort
+     * @param vid       Vendor ID of the device
+     * @param pid       Product ID of the device
+     * @param probes    Incremented for every entry which is compared. Can be nullptr
+     * @return          Entry of the device or nullptr if not listed
+     */
+    template <size_t N>
+    static constexpr const Entry *lookup(const std::array<Entry, N> &table, uint16_t vid, uint16_t pid,
+                                         uint32_t *probes = nullptr) {
+        uint32_t key = (static_cast<uint32_t>(vid) << 16) | pid;
+        auto it = std::lower_bound(table.begin(), table.end(), key, [probes](const Entry &entry, uint32_t k) {
+            if (probes)
+                (*probes)++;
+            return entry.key() < k;
+        });
+
+        if (it == table.end() || it->key() != key)
+            return nullptr;
+        return &*it;
+    }
+
+    /**
+     * @brief Searches for a device with a dedicated driver
+     *
+     * @param vid       Vendor ID of the device
+     * @param pid       Product ID of the device
+     * @return          Entry of the device or nullptr if not listed
+     */
+    static const Entry *find(uint16_t vid, uint16_t pid);
+
+    /**
+     * @brief Searches for the driver of a HID interface
+     *
+     * It is first tried to use the VID/PID. If no match is found,
+     * the usage of the first report is used.
+     *
+     * @param vid           Vendor ID of the device
+     * @param pid           Product ID of the device
+     * @param usage_page    Usage Page of the first report
+     * @param usage         Usage of the first report
+     * @return              Factory of the handler or nullptr if not supported
+     */
+    static HidHandlerFactory find_hid(uint16_t vid, uint16_t pid, uint16_t usage_page, uint16_t usage);
+};
+
+// Factories of all drivers. Defined next to the driver.
+
+std::unique_ptr<HidHandlerInterface> make_impact_handler();
+std::unique_ptr<HidHandlerInterface> make_hizue_handler();
+std::unique_ptr<HidHandlerInterface> make_ps3_handler();
+std::unique_ptr<HidHandlerInterface> make_ps4_handler();
+std::unique_ptr<HidHandlerInterface> make_switch_pro_handler();
+std::unique_ptr<HidHandlerInterface> make_mouse_handler();
+std::unique_ptr<HidHandlerInterface> make_joystick_handler();
+
+std::shared_ptr<ReportSourceInterface> open_xbox_one_handler(uint8_t daddr, uint8_t const *desc_itf,
+                                                             uint16_t max_len);
+std::shared_ptr<ReportSourceInterface> open_xbox_360_wireless_receiver_handler(uint8_t daddr,
+                                                                               uint8_t const *desc_itf,
+                                                                               uint16_t max_len);
@@ -0,0 +1,116 @@
+/**
+ * @file device_table.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Fixed capacity table of all mounted USB devices
+ *
+ * Stores the state of HID interfaces and vendor class drivers of every device.
+ * HID interfaces are identified by device address and instance, as multiple
+ * devices behind a hub usually use the same instance numbers.
+ * The device address is used as index, so every lookup is done in constant
+ * time without allocating memory.
+ *
+ * @tparam HidSlot      State of a single HID interface. Must be default constructible
+ * @tparam VendorSlot   State of a vendor class driver. Must be default constructible
+ * @tparam kDevices     Number of device addresses. TinyUSB starts with address 1
+ * @tparam kInstances   Number of HID interfaces per device
+ */
+template <typename HidSlot, typename VendorSlot, size_t kDevices, size_t kInstances> class DeviceTable {
+  private:
+    /// @brief All slots of a single device
+    struct Device {
+        std::array<HidSlot, kInstances> hid_{};
+        VendorSlot vendor_{};
+    };
+
+    /// @brief Slots of all devices. Index is the device address - 1
+    std::array<Device, kDevices> devices_{};
+
+  public:
+    /**
+     * @brief Provides the slot of a HID interface
+     *
+     * @param dev_addr      TinyUSB device address
+     * @param instance      TinyUSB HID instance
+     * @return HidSlot*     Slot or nullptr if the address or instance exceeds the table
+     */
+    HidSlot *hid(uint8_t dev_addr, uint8_t instance) {
+        if (dev_addr == 0 || dev_addr > kDevices || instance >= kInstances)
+            return nullptr;
+
+        return &devices_[dev_addr - 1].hid_[instance];
+    }
+
+    /**
+     * @brief Provides the slot of a vendor class driver
+     *
+     * @param dev_addr      TinyUSB device address
+     * @return VendorSlot*  Slot or nullptr if the address exceeds the table
+     */
+    VendorSlot *vendor(uint8_t dev_addr) {
+        if (dev_addr == 0 || dev_addr > kDevices)
+            return nullptr;
+
+        return &devices_[dev_addr - 1].vendor_;
+    }
+
+    /**
+     * @brief Resets the slot of a single HID interface
+     *
+     * @param dev_addr      TinyUSB device address
+     * @param instance      TinyUSB HID instance
+     */
+    void remove_hid(uint8_t dev_addr, uint8_t instance) {
+        HidSlot *slot = hid(dev_addr, instance);
+        if (slot)
+            *slot = HidSlot{};
+    }
+
+    /**
+     * @brief Resets all slots of a device
+     *
+     * @param dev_addr      TinyUSB device address
+     */
+    void remove(uint8_t dev_addr) {
+        if (dev_addr == 0 || dev_addr > kDevices)
+            return;
+
+        devices_[dev_addr - 1] = Device{};
+    }
+
+    /**
+     * @brief Calls a function for every HID slot
+     *
+     * @param f     Function taking HidSlot&
+     */
+    template <typename F> void for_each_hid(F &&f) {
+        for (auto &device : devices_) {
+            for (auto &slot : device.hid_)
+                f(slot);
+        }
+    }
+
+    /**
+     * @brief Calls a function for every vendor class slot
+     *
+     * @param f     Function taking VendorSlot&
+     */
+    template <typename F> void for_each_vendor(F &&f) {
+        for (auto &device : devices_)
+            f(device.vendor_);
+    }
+};
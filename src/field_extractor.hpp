@@ -11,6 +11,12 @@
  *
  */
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+
 /**
  * @brief Helper class to extract a bit field from a byte array
  *
@@ -49,6 +55,21 @@ class FieldExtractor {
         byte_aligned_ = (((offset | length) & 0b0111) == 0);
     }
 
+    /// @brief Returns the position of the field in bits
+    size_t offset() const {
+        return offset_;
+    }
+
+    /// @brief Returns the length of the field in bits
+    size_t length() const {
+        return length_;
+    }
+
+    /// @brief Returns true if the field is sign extended
+    bool is_signed() const {
+        return signed_;
+    }
+
     /**
      * @brief Extracts a field from the report
      *
@@ -58,7 +79,7 @@ class FieldExtractor {
      * @param len       Size in bytes
      * @return int32_t  Value of field
      */
-    int32_t extract(const uint8_t *report, size_t len) {
+    int32_t extract(const uint8_t *report, size_t len) const {
         std::ignore = len;
 
         if (byte_aligned_) {
@@ -158,3 +179,230 @@ class FieldExtractor {
         return 0;
     }
 };
+
+/**
+ * @brief Extracts multiple fields of a report in one pass
+ *
+ * The layout of the fields is analyzed once during \ref finalize.
+ * Common mouse layouts are then extracted by kernels which are specialized
+ * for them, avoiding the branches of \ref FieldExtractor::extract.
+ * All other fields are extracted with a \ref FieldExtractor each.
+ *
+ * X and Y are expected to be two successive fields with X first.
+ */
+class FieldExtractorPlan {
+  public:
+    /// @brief Maximum number of fields
+    static constexpr size_t kMaxFields{16};
+
+    /// @brief Layout of the report, selecting the kernel
+    enum class Layout : uint8_t {
+        kGeneric,     ///< No specialization available
+        kBoot,        ///< Buttons in byte 0, 8 bit X and Y in byte 1 and 2 and an optional 8 bit wheel in byte 3
+        kAlignedXY8,  ///< Signed 8 bit X and Y, byte aligned
+        kAlignedXY16, ///< Signed 16 bit X and Y, byte aligned
+        kPackedXY12,  ///< Signed 12 bit X and Y packed into 3 bytes, byte aligned
+    };
+
+  private:
+    /// @brief Type of the specialized kernels
+    using Kernel = void (FieldExtractorPlan::*)(const uint8_t *report, size_t len, int32_t *values) const;
+
+    /// @brief Configured fields. Only the first \ref count_ are valid
+    std::array<FieldExtractor, kMaxFields> fields_{};
+
+    /// @brief Number of valid entries in \ref fields_
+    size_t count_{0};
+
+    /// @brief Detected layout
+    Layout layout_{Layout::kGeneric};
+
+    /// @brief Kernel of \ref layout_
+    Kernel kernel_{&FieldExtractorPlan::run<Layout::kGeneric>};
+
+    /// @brief Index of the X field. Y is the following one
+    size_t xy_index_{0};
+
+    /// @brief Position of X in bytes
+    size_t xy_byte_{0};
+
+    /// @brief Mask of the button bits for \ref Layout::kBoot
+    uint8_t boot_buttons_mask_{0};
+
+    /**
+     * @brief Extracts X and Y in the specialized way of a layout
+     *
+     * @tparam L        Layout to use
+     * @param data      Report, starting at the byte of X
+     * @param[out] x    Value of X
+     * @param[out] y    Value of Y
+     */
+    template <Layout L> static void extract_xy(const uint8_t *data, int32_t &x, int32_t &y) {
+        if constexpr (L == Layout::kAlignedXY8 || L == Layout::kBoot) {
+            x = static_cast<int8_t>(data[0]);
+            y = static_cast<int8_t>(data[1]);
+        } else if constexpr (L == Layout::kAlignedXY16) {
+            x = static_cast<int16_t>(data[0] | (data[1] << 8));
+            y = static_cast<int16_t>(data[2] | (data[3] << 8));
+        } else if constexpr (L == Layout::kPackedXY12) {
+            // Sign extension by shifting the 12 bits to the top of a 16 bit value
+            x = static_cast<int16_t>((data[0] << 4) | (data[1] << 12)) >> 4;
+            y = static_cast<int16_t>((data[1] & 0xf0) | (data[2] << 8)) >> 4;
+        }
+    }
+
+    /**
+     * @brief Extracts all fields with the kernel of a layout
+     *
+     * @tparam L            Layout to use
+     * @param report        Pointer to report buffer
+     * @param len           Size in bytes
+     * @param[out] values   Values of all fields
+     */
+    template <Layout L> void run(const uint8_t *report, size_t len, int32_t *values) const {
+        if constexpr (L == Layout::kBoot) {
+            values[0] = report[0] & boot_buttons_mask_;
+            extract_xy<L>(&report[1], values[1], values[2]);
+            if (count_ > 3)
+                values[3] = static_cast<int8_t>(report[3]);
+        } else if constexpr (L == Layout::kGeneric) {
+            for (size_t i = 0; i < count_; i++)
+                values[i] = fields_[i].extract(report, len);
+        } else {
+            for (size_t i = 0; i < xy_index_; i++)
+                values[i] = fields_[i].extract(report, len);
+
+            extract_xy<L>(&report[xy_byte_], values[xy_index_], values[xy_index_ + 1]);
+
+            for (size_t i = xy_index_ + 2; i < count_; i++)
+                values[i] = fields_[i].extract(report, len);
+        }
+    }
+
+    /**
+     * @brief Checks whether a field is a signed and byte aligned field of a certain length
+     *
+     * @param field     Field to check
+     * @param length    Expected length in bits
+     */
+    static bool signed_aligned(const FieldExtractor &field, size_t length) {
+        return field.is_signed() && field.length() == length && (field.offset() & 7) == 0;
+    }
+
+    /**
+     * @brief Detects the layout of X and Y
+     *
+     * @param index     Index of the X field
+     * @return Layout   Specialized layout or \ref Layout::kGeneric
+     */
+    Layout detect_xy(size_t index) const {
+        const FieldExtractor &x = fields_[index];
+        const FieldExtractor &y = fields_[index + 1];
+
+        if (!x.is_signed() || !y.is_signed() || x.length() != y.length() || (x.offset() & 7) != 0 ||
+            y.offset() != x.offset() + x.length())
+            return Layout::kGeneric;
+
+        switch (x.length()) {
+        case 8:
+            return Layout::kAlignedXY8;
+        case 12:
+            return Layout::kPackedXY12;
+        case 16:
+            return Layout::kAlignedXY16;
+        default:
+            return Layout::kGeneric;
+        }
+    }
+
+  public:
+    /// @brief Removes all fields
+    void clear() {
+        count_ = 0;
+        finalize();
+    }
+
+    /**
+     * @brief Adds a field
+     *
+     * @param offset    Position of the field in bits
+     * @param length    Length of the field in bits
+     * @param relative  True for Relative data, False for Absolute
+     * @return size_t   Index of the field in the values provided by \ref extract
+     */
+    size_t add(size_t offset, size_t length, bool relative) {
+        if (count_ == fields_.size())
+            return count_ - 1;
+
+        fields_[count_].configure(offset, length, relative);
+        return count_++;
+    }
+
+    /**
+     * @brief Selects the kernel for the configured fields
+     *
+     * Must be called after the last \ref add.
+     *
+     * @param x_index   Index of the X field, followed by Y. Ignored if out of range
+     */
+    void finalize(size_t x_index = 0) {
+        layout_ = Layout::kGeneric;
+        kernel_ = &FieldExtractorPlan::run<Layout::kGeneric>;
+
+        if (x_index + 1 >= count_)
+            return;
+
+        xy_index_ = x_index;
+        xy_byte_ = fields_[x_index].offset() >> 3;
+        layout_ = detect_xy(x_index);
+
+        // Buttons, X, Y and optionally the wheel in successive bytes
+        const FieldExtractor &buttons = fields_[0];
+        if (layout_ == Layout::kAlignedXY8 && x_index == 1 && xy_byte_ == 1 && buttons.offset() == 0 &&
+            !buttons.is_signed() && buttons.length() <= 8 &&
+            (count_ == 3 || (count_ == 4 && signed_aligned(fields_[3], 8) && fields_[3].offset() == 24))) {
+            layout_ = Layout::kBoot;
+            boot_buttons_mask_ = static_cast<uint8_t>((1u << buttons.length()) - 1);
+        }
+
+        switch (layout_) {
+        case Layout::kBoot:
+            kernel_ = &FieldExtractorPlan::run<Layout::kBoot>;
+            break;
+        case Layout::kAlignedXY8:
+            kernel_ = &FieldExtractorPlan::run<Layout::kAlignedXY8>;
+            break;
+        case Layout::kAlignedXY16:
+            kernel_ = &FieldExtractorPlan::run<Layout::kAlignedXY16>;
+            break;
+        case Layout::kPackedXY12:
+            kernel_ = &FieldExtractorPlan::run<Layout::kPackedXY12>;
+            break;
+        case Layout::kGeneric:
+            break;
+        }
+    }
+
+    /// @brief Returns the detected layout
+    Layout layout() const {
+        return layout_;
+    }
+
+    /// @brief Returns the number of fields
+    size_t size() const {
+        return count_;
+    }
+
+    /**
+     * @brief Extracts all fields from the report
+     *
+     * The caller must ensure that the report contains all fields.
+     *
+     * @param report        Pointer to report buffer
+     * @param len           Size in bytes
+     * @param[out] values   Values of all fields in the order of \ref add
+     */
+    void extract(const uint8_t *report, size_t len, int32_t *values) const {
+        (this->*kernel_)(report, len, values);
+    }
+};
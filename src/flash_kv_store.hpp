@@ -0,0 +1,394 @@
+/**
+ * @file flash_kv_store.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+/**
+ * @brief Access to a pair of flash erase sectors
+ *
+ * Behaves like NOR flash. Erasing sets all bytes of a sector to 0xff.
+ * Programming can only clear bits.
+ */
+class FlashInterface {
+  public:
+    /// @brief Size of a program page
+    static constexpr size_t kPageSize{256};
+
+    /// @brief Size of an erase sector
+    static constexpr size_t kSectorSize{4096};
+
+    /**
+     * @brief Provides the content of a sector
+     *
+     * @param index     0 or 1
+     * @return std::span<const uint8_t> Content. Stays valid and reflects later changes
+     */
+    virtual std::span<const uint8_t> sector(size_t index) = 0;
+
+    /**
+     * @brief Sets all bytes of a sector to 0xff
+     *
+     * @param index     0 or 1
+     */
+    virtual void erase(size_t index) = 0;
+
+    /**
+     * @brief Programs a complete page
+     *
+     * @param index     Sector of the page
+     * @param offset    Position of the page inside the sector. Must be a multiple of \ref kPageSize
+     * @param data      \ref kPageSize bytes to program
+     */
+    virtual void program_page(size_t index, size_t offset, const uint8_t *data) = 0;
+};
+
+/**
+ * @brief Log structured key value store on a pair of flash sectors
+ *
+ * Every write appends a record to the active sector. The newest record of a
+ * key is valid. Every record is protected by a CRC, so a record which was only
+ * partially programmed during a loss of power is ignored, together with everything
+ * written after it.
+ *
+ * If the active sector is full, the newest record of every key is copied to the
+ * other sector. The header of the other sector is programmed last, with an
+ * increased sequence number. Until then, the previous sector stays valid. As
+ * the sectors are used alternately, the wear is spread evenly over both.
+ *
+ * The position of the newest record of every key is kept in RAM, so reading is
+ * possible without searching. Records are at least 4 bytes long, which bounds the
+ * scan during \ref mount to about 1000 steps, instead of a walk over every byte.
+ */
+class FlashKvStore {
+  public:
+    /// @brief Number of different keys
+    static constexpr size_t kKeys{16};
+
+    /// @brief Maximum size of a value in bytes
+    static constexpr size_t kMaxValue{255};
+
+    /// @brief Identifies the header of a valid sector. Has bytes above 0x7f, which the
+    /// legacy mouse mode sector never contained
+    static constexpr uint32_t kMagic{0xc5f14b01};
+
+    /// @brief Header of every sector
+    struct __attribute__((packed)) SectorHeader {
+        uint32_t magic_;    ///< \ref kMagic
+        uint32_t sequence_; ///< Increased by every compaction. The sector with the newer sequence is active
+        uint16_t crc_;      ///< CRC of magic_ and sequence_
+        uint16_t reserved_; ///< Left erased
+    };
+
+    /// @brief Header of every record. Followed by the value and padding to 4 bytes
+    struct __attribute__((packed)) RecordHeader {
+        uint8_t key_;    ///< Key of the record. 0xff marks the end of the log
+        uint8_t length_; ///< Length of the value in bytes
+        uint16_t crc_;   ///< CRC of key_, length_ and the value
+    };
+
+    /// @brief Position of the first record
+    static constexpr size_t kFirstRecord{sizeof(SectorHeader)};
+
+  private:
+    /// @brief Marks a key without record in \ref index_
+    static constexpr uint16_t kNoRecord{0};
+
+    /// @brief Flash to use
+    FlashInterface &flash_;
+
+    /// @brief Sector holding the current records
+    size_t active_{0};
+
+    /// @brief Sequence number of \ref active_
+    uint32_t sequence_{0};
+
+    /// @brief True if \ref active_ has a valid header
+    bool formatted_{false};
+
+    /// @brief Position of the next record inside \ref active_
+    size_t end_{FlashInterface::kSectorSize};
+
+    /// @brief Position of the newest record of every key inside \ref active_
+    std::array<uint16_t, kKeys> index_{};
+
+    /// @brief Page to program. Modified copy of the flash content
+    std::array<uint8_t, FlashInterface::kPageSize> page_buffer_;
+
+    /// @brief Returns the size of a record with padding
+    static size_t record_size(size_t length) {
+        return (sizeof(RecordHeader) + length + 3) & ~size_t{3};
+    }
+
+    /// @brief Checks the header of a sector
+    static bool valid_header(std::span<const uint8_t> sector, uint32_t &sequence) {
+        SectorHeader header;
+        memcpy(&header, sector.data(), sizeof(header));
+        sequence = header.sequence_;
+        return header.magic_ == kMagic && header.crc_ == crc16(sector.first(offsetof(SectorHeader, crc_)));
+    }
+
+    /**
+     * @brief Programs bytes at any position
+     *
+     * The pages are read, modified and programmed again.
+     * Bytes which are not part of the data are programmed with their current value.
+     *
+     * @param index     Sector to program
+     * @param offset    Position inside the sector
+     * @param data      Bytes to program
+     */
+    void program(size_t index, size_t offset, std::span<const uint8_t> data) {
+        while (!data.empty()) {
+            size_t page = offset & ~(FlashInterface::kPageSize - 1);
+            size_t in_page = offset - page;
+            size_t chunk = std::min(data.size(), FlashInterface::kPageSize - in_page);
+
+            memcpy(page_buffer_.data(), &flash_.sector(index)[page], page_buffer_.size());
+            memcpy(&page_buffer_[in_page], data.data(), chunk);
+            flash_.program_page(index, page, page_buffer_.data());
+
+            data = data.subspan(chunk);
+            offset += chunk;
+        }
+    }
+
+    /**
+     * @brief Programs a record
+     *
+     * @param index     Sector to program
+     * @param offset    Position of the record
+     * @param key       Key of the record
+     * @param value     Value of the record
+     * @return true     Flash content is as expected
+     */
+    bool program_record(size_t index, size_t offset, uint8_t key, std::span<const uint8_t> value) {
+        std::array<uint8_t, sizeof(RecordHeader) + kMaxValue + 3> record;
+        size_t size = record_size(value.size());
+
+        record.fill(0xff);
+        record[0] = key;
+        record[1] = static_cast<uint8_t>(value.size());
+        std::copy(value.begin(), value.end(), &record[sizeof(RecordHeader)]);
+        uint16_t crc = record_crc(key, value);
+        record[2] = static_cast<uint8_t>(crc);
+        record[3] = static_cast<uint8_t>(crc >> 8);
+
+        program(index, offset, std::span(record).first(size));
+
+        auto written = flash_.sector(index).subspan(offset, size);
+        return std::equal(written.begin(), written.end(), record.begin());
+    }
+
+    /// @brief Calculates the CRC of a record
+    static uint16_t record_crc(uint8_t key, std::span<const uint8_t> value) {
+        const uint8_t header[2] = {key, static_cast<uint8_t>(value.size())};
+        return crc16(value, crc16(header));
+    }
+
+    /**
+     * @brief Copies the newest record of every key and a new record to the other sector
+     *
+     * @param key       Key of the new record
+     * @param value     Value of the new record
+     * @return true     Compaction was successful
+     * @return false    Not enough space. Nothing was changed
+     */
+    bool compact(uint8_t key, std::span<const uint8_t> value) {
+        size_t required = kFirstRecord + record_size(value.size());
+        for (size_t k = 0; k < kKeys; k++) {
+            if (k != key && index_[k] != kNoRecord)
+                required += record_size(get(k).size());
+        }
+        if (required > FlashInterface::kSectorSize)
+            return false;
+
+        size_t target = formatted_ ? 1 - active_ : 0;
+        flash_.erase(target);
+
+        std::array<uint16_t, kKeys> index{};
+        size_t offset = kFirstRecord;
+        for (size_t k = 0; k < kKeys; k++) {
+            std::span<const uint8_t> copy = (k == key) ? value : get(k);
+            if (k != key && index_[k] == kNoRecord)
+                continue;
+
+            if (!program_record(target, offset, static_cast<uint8_t>(k), copy))
+                return false;
+            index[k] = static_cast<uint16_t>(offset);
+            offset += record_size(copy.size());
+        }
+
+        // Commit
+        SectorHeader header;
+        memset(&header, 0xff, sizeof(header));
+        header.magic_ = kMagic;
+        header.sequence_ = sequence_ + 1;
+        header.crc_ = crc16(std::span(reinterpret_cast<const uint8_t *>(&header), offsetof(SectorHeader, crc_)));
+        program(target, 0, std::span(reinterpret_cast<const uint8_t *>(&header), sizeof(header)));
+
+        active_ = target;
+        sequence_++;
+        formatted_ = true;
+        end_ = offset;
+        index_ = index;
+        return true;
+    }
+
+  public:
+    /**
+     * @brief Construct a new Flash Kv Store and reads the current records
+     *
+     * @param flash     Flash to use. Must outlive this object
+     */
+    explicit FlashKvStore(FlashInterface &flash) : flash_(flash) {
+        mount();
+    }
+
+    /**
+     * @brief Calculates a CRC-16/CCITT
+     *
+     * @param data      Bytes to check
+     * @param crc       Initial value or result of the previous block
+     * @return uint16_t CRC of the data
+     */
+    static uint16_t crc16(std::span<const uint8_t> data, uint16_t crc = 0xffff) {
+        for (uint8_t byte : data) {
+            crc ^= static_cast<uint16_t>(byte << 8);
+            for (int bit = 0; bit < 8; bit++)
+                crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+        }
+        return crc;
+    }
+
+    /**
+     * @brief Finds the active sector and the newest record of every key
+     *
+     * Called by the constructor. Only the active sector is scanned, record by record.
+     */
+    void mount() {
+        uint32_t sequence[2];
+        bool valid[2] = {valid_header(flash_.sector(0), sequence[0]), valid_header(flash_.sector(1), sequence[1])};
+
+        index_.fill(kNoRecord);
+        formatted_ = valid[0] || valid[1];
+        end_ = FlashInterface::kSectorSize;
+        if (!formatted_)
+            return;
+
+        if (valid[0] && valid[1])
+            active_ = static_cast<int32_t>(sequence[1] - sequence[0]) > 0 ? 1 : 0;
+        else
+            active_ = valid[0] ? 0 : 1;
+        sequence_ = sequence[active_];
+
+        std::span<const uint8_t> sector = flash_.sector(active_);
+        size_t offset = kFirstRecord;
+        while (offset + sizeof(RecordHeader) <= sector.size()) {
+            RecordHeader header;
+            memcpy(&header, &sector[offset], sizeof(header));
+
+            if (header.key_ == 0xff && header.length_ == 0xff && header.crc_ == 0xffff) {
+                // End of the log
+                end_ = offset;
+                return;
+            }
+
+            size_t size = record_size(header.length_);
+            if (offset + size > sector.size() ||
+                header.crc_ != record_crc(header.key_, sector.subspan(offset + sizeof(header), header.length_))) {
+                // Partially programmed. Nothing can be appended until the next compaction
+                return;
+            }
+
+            if (header.key_ < kKeys)
+                index_[header.key_] = static_cast<uint16_t>(offset);
+            offset += size;
+        }
+    }
+
+    /// @brief Returns true if a sector was initialized
+    bool formatted() const {
+        return formatted_;
+    }
+
+    /// @brief Returns the sector holding the current records
+    size_t active_sector() const {
+        return active_;
+    }
+
+    /// @brief Returns the number of bytes which can be appended until the next compaction
+    size_t free_space() const {
+        return FlashInterface::kSectorSize - end_;
+    }
+
+    /**
+     * @brief Provides the value of a key
+     *
+     * @param key   Key to read
+     * @return std::span<const uint8_t> Value inside the flash. Empty if the key was never written.
+     *                                  Only valid until the next write
+     */
+    std::span<const uint8_t> get(size_t key) {
+        if (key >= kKeys || index_[key] == kNoRecord)
+            return {};
+
+        auto record = flash_.sector(active_).subspan(index_[key]);
+        return record.subspan(sizeof(RecordHeader), record[1]);
+    }
+
+    /**
+     * @brief Stores the value of a key
+     *
+     * Nothing is written if the value is already stored.
+     *
+     * @param key       Key to write
+     * @param value     Value to store. At most \ref kMaxValue bytes
+     * @return true     Value is stored
+     * @return false    Invalid key or no space left
+     */
+    bool write(size_t key, std::span<const uint8_t> value) {
+        if (key >= kKeys || value.size() > kMaxValue)
+            return false;
+
+        std::span<const uint8_t> current = get(key);
+        if (index_[key] != kNoRecord && std::equal(current.begin(), current.end(), value.begin(), value.end()))
+            return true;
+
+        if (formatted_ && record_size(value.size()) <= free_space()) {
+            if (program_record(active_, end_, static_cast<uint8_t>(key), value)) {
+                index_[key] = static_cast<uint16_t>(end_);
+                end_ += record_size(value.size());
+                return true;
+            }
+            // Bits which were not erased. Start over in the other sector
+            end_ = FlashInterface::kSectorSize;
+        }
+
+        return compact(static_cast<uint8_t>(key), value);
+    }
+
+    /**
+     * @brief Initializes the store without any records
+     *
+     * Used after migrating older configurations, to avoid searching them again.
+     */
+    void format() {
+        if (!formatted_)
+            compact(kKeys, {});
+    }
+};
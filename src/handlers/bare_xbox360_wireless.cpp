@@ -13,7 +13,10 @@
 // https://github.com/felis/USB_Host_Shield_2.0/blob/master/XBOXRECV.cpp
 
 #include "bare_xbox360_wireless.hpp"
+#include "device_registry.hpp"
 #include "global.hpp"
+#include "processors/binary_trace.hpp"
+#include "processors/latency_trace.hpp"
 
 struct __attribute__((packed)) Xbox360WirelessButtonData {
     uint8_t type1; // if 0x08, connection status
@@ -64,11 +67,14 @@ static void configure_finished_received(tuh_xfer_t *xfer) {
 }
 
 void Xbox360WirelessReceiverHandler::report_received(tuh_xfer_t *xfer) {
+    LatencyTrace::mark_arrival();
+
     auto obj = reinterpret_cast<Xbox360WirelessReceiverHandler::WirelessGamepadInstance *>(xfer->user_data);
     int index = obj->id_;
     uint8_t *buffer = user_data[index].buf_in_.data();
 
     if (xfer->result == XFER_RESULT_SUCCESS) {
+        capture_vendor_report(xfer->daddr, static_cast<uint8_t>(index), std::span(buffer, xfer->actual_len));
 
         static constexpr int16_t kAnalogThreshold{16000};
         static constexpr uint8_t kTypeButtonData{0x01};
@@ -77,7 +83,7 @@ void Xbox360WirelessReceiverHandler::report_received(tuh_xfer_t *xfer) {
         auto dat = reinterpret_cast<const Xbox360WirelessButtonData *>(buffer);
 
         if (dat->type1 == kConnectionStatus && dat->type2 == 0x80) {
-            PRINTF("Connected %d\n", index);
+            BinaryTrace::write<kTraceXbox360Connected>(index);
             obj->report_proxy_ = std::make_shared<ReportProxy>();
             gbl_pipeline->integrate_handler(obj->report_proxy_);
 
@@ -95,16 +101,14 @@ void Xbox360WirelessReceiverHandler::report_received(tuh_xfer_t *xfer) {
             PRINTF("out %d\r\n", result);
         }
         if (dat->type1 == kConnectionStatus && dat->type2 == 0x00) {
-            PRINTF("Disconnected %d\n", index);
+            BinaryTrace::write<kTraceXbox360Disconnected>(index);
             obj->report_proxy_.reset();
         }
 
         if (dat->type1 == 0x00 && dat->type2 == kTypeButtonData) {
-            PRINTF("Report @%d: ", index);
-            for (uint32_t i = 0; i < xfer->actual_len; i++) {
-                PRINTF(" %02x", buffer[i]);
-            }
-            PRINTF("\n");
+            // Buttons are in byte 6 and 7
+            BinaryTrace::write<kTraceXbox360Report>(index, buffer[6] | (buffer[7] << 8), dat->stick_left_x,
+                                                    dat->stick_left_y);
             /*
             PRINTF("Xbox360W: %d%d%d%d %d%d%d%d %d %d\r\n", dat->dpad_down, dat->dpad_left, dat->dpad_right,
                    dat->dpad_up, dat->x, dat->y, dat->b, dat->a, dat->stick_left_x, dat->stick_left_y);
@@ -119,6 +123,7 @@ void Xbox360WirelessReceiverHandler::report_received(tuh_xfer_t *xfer) {
                    dat->back, dat->start);*/
 
             GamepadReport aj;
+            aj.arrival_us = LatencyTrace::arrival();
 
             aj.left = dat->dpad_left || dat->stick_left_x < (-kAnalogThreshold);
             aj.down = dat->dpad_down || dat->stick_left_y < (-kAnalogThreshold);
@@ -253,3 +258,13 @@ void c_report_received(tuh_xfer_t *xfer) {
     auto obj = reinterpret_cast<Xbox360WirelessReceiverHandler::WirelessGamepadInstance *>(xfer->user_data);
     obj->handler_->report_received(xfer);
 }
+
+std::shared_ptr<ReportSourceInterface> open_xbox_360_wireless_receiver_handler(uint8_t daddr,
+                                                                               uint8_t const *desc_itf,
+                                                                               uint16_t max_len) {
+    // The gamepads are integrated into the pipeline as soon as they connect
+    auto handler = std::make_shared<Xbox360WirelessReceiverHandler>();
+
+    handler->open_vendor_interface(daddr, reinterpret_cast<tusb_desc_interface_t const *>(desc_itf), max_len);
+    return handler;
+}
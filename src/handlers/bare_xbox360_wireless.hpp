@@ -15,12 +15,6 @@
 #define XBOX_WIRELESS_RECEIVER_PID_2 0x02A9           // Microsoft Wireless Gaming Receiver
 #define XBOX_WIRELESS_RECEIVER_THIRD_PARTY_PID 0x0291 // Third party Wireless Gaming Receiver
 
-static inline bool check_xbox_360_wireless_receiver_vid_pid(uint16_t vid, uint16_t pid) {
-    return !((vid != XBOX_VID && vid != MADCATZ_VID && vid != JOYTECH_VID) ||
-             (pid != XBOX_WIRELESS_RECEIVER_PID_1 && pid != XBOX_WIRELESS_RECEIVER_PID_2 &&
-              pid != XBOX_WIRELESS_RECEIVER_THIRD_PARTY_PID));
-}
-
 /**
  * @brief Handles the USB vendor class interface of Xbox 360 Wireless Receivers
  *
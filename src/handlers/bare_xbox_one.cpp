@@ -3,6 +3,9 @@
 // https://github.com/felis/USB_Host_Shield_2.0/blob/master/XBOXONE
 
 #include "bare_xbox_one.hpp"
+#include "device_registry.hpp"
+#include "global.hpp"
+#include "processors/latency_trace.hpp"
 
 struct __attribute__((packed)) XboxOneButtonData {
     uint8_t type;
@@ -46,7 +49,11 @@ static void configure_finished_received(tuh_xfer_t *xfer) {
 }
 
 void XboxOneHandler::report_received(tuh_xfer_t *xfer) {
+    LatencyTrace::mark_arrival();
+
     if (xfer->result == XFER_RESULT_SUCCESS) {
+        capture_vendor_report(xfer->daddr, 0, std::span(buf_in.data(), xfer->actual_len));
+
         static constexpr int16_t kAnalogThreshold{16000};
         static constexpr uint8_t kTypeButtonData{0x20};
 
@@ -57,6 +64,7 @@ void XboxOneHandler::report_received(tuh_xfer_t *xfer) {
                    dat->dpad_up, dat->x, dat->y, dat->b, dat->a, dat->stick_left_x, dat->stick_left_y, dat->back);
 #endif
             GamepadReport aj;
+            aj.arrival_us = LatencyTrace::arrival();
 
             aj.left = dat->dpad_left || dat->stick_left_x < (-kAnalogThreshold);
             aj.down = dat->dpad_down || dat->stick_left_y < (-kAnalogThreshold);
@@ -166,3 +174,12 @@ void c_report_received(tuh_xfer_t *xfer) {
     auto obj = reinterpret_cast<XboxOneHandler *>(xfer->user_data);
     obj->report_received(xfer);
 }
+
+std::shared_ptr<ReportSourceInterface> open_xbox_one_handler(uint8_t daddr, uint8_t const *desc_itf,
+                                                             uint16_t max_len) {
+    auto handler = std::make_shared<XboxOneHandler>();
+
+    handler->open_vendor_interface(daddr, reinterpret_cast<tusb_desc_interface_t const *>(desc_itf), max_len);
+    gbl_pipeline->integrate_handler(handler);
+    return handler;
+}
@@ -36,15 +36,6 @@
 #define XBOX_ONE_PID11 0x542A // Xbox ONE spectra
 #define XBOX_ONE_PID12 0x543A // PowerA Xbox One wired controller
 
-static inline bool check_xbox_one_vid_pid(uint16_t vid, uint16_t pid) {
-    return (vid == XBOX_VID1 || vid == XBOX_VID2 || vid == XBOX_VID3 || vid == XBOX_VID4 || vid == XBOX_VID5 ||
-            vid == XBOX_VID6) &&
-           (pid == XBOX_ONE_PID1 || pid == XBOX_ONE_PID2 || pid == XBOX_ONE_PID3 || pid == XBOX_ONE_PID4 ||
-            pid == XBOX_ONE_PID5 || pid == XBOX_ONE_PID6 || pid == XBOX_ONE_PID7 || pid == XBOX_ONE_PID8 ||
-            pid == XBOX_ONE_PID9 || pid == XBOX_ONE_PID10 || pid == XBOX_ONE_PID11 || pid == XBOX_ONE_PID12 ||
-            pid == XBOX_ONE_PID13 || pid == XBOX_ONE_PID14);
-}
-
 /**
  * @brief Handles the USB vendor class interface of Xbox One Controllers
  *
@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "processors/interfaces.hpp"
+#include "tusb.h"
 #include "utility.h"
 
 /**
@@ -31,7 +32,7 @@ class DefaultHidHandler : public HidHandlerInterface {
     std::shared_ptr<ReportHubInterface> target_;
 
   public:
-    void parse_hid_report_descriptor(uint8_t const *, uint16_t) override {
+    void parse_hid_report_descriptor(uint16_t, uint16_t, uint8_t const *, uint16_t) override {
         // Just ignore it...
     }
 
@@ -10,10 +10,10 @@
  */
 
 #include "default_hid_handler.hpp"
-#include "hid_handler_builder.hpp"
+#include "device_registry.hpp"
 
-#include "controller_port.hpp"
 #include "pico/stdlib.h"
+#include "processors/latency_trace.hpp"
 
 /**
  * @brief Packed struct representing the HID report
@@ -67,6 +67,7 @@ class HizueHidHandler : public DefaultHidHandler {
 #endif
 
         GamepadReport aj;
+        aj.arrival_us = LatencyTrace::arrival();
 
         aj.left = dat->joy_rel_x < (kAnalogCenter - kAnalogThreshold);
         aj.down = (dat->joy_rel_y > (kAnalogCenter + kAnalogThreshold));
@@ -89,4 +90,6 @@ class HizueHidHandler : public DefaultHidHandler {
     }
 };
 
-static HidHandlerBuilder builder(0x0079, 0x0011, []() { return std::make_unique<HizueHidHandler>(); }, nullptr);
+std::unique_ptr<HidHandlerInterface> make_hizue_handler() {
+    return std::make_unique<HizueHidHandler>();
+}
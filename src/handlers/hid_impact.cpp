@@ -10,10 +10,10 @@
  */
 
 #include "default_hid_handler.hpp"
-#include "hid_handler_builder.hpp"
+#include "device_registry.hpp"
 
-#include "controller_port.hpp"
 #include "pico/stdlib.h"
+#include "processors/latency_trace.hpp"
 
 /**
  * @brief Packed struct representing the HID report
@@ -61,6 +61,7 @@ class ImpactHidHandler : public DefaultHidHandler {
 #endif
 
         GamepadReport aj;
+        aj.arrival_us = LatencyTrace::arrival();
 
         aj.update_from_coolie_hat(dat->coolie_hat); // Coolie Hat D-Pad
 
@@ -80,5 +81,6 @@ class ImpactHidHandler : public DefaultHidHandler {
     }
 };
 
-static HidHandlerBuilder builder(
-    0x07b5, 0x0314, []() { return std::make_unique<ImpactHidHandler>(); }, nullptr);
\ No newline at end of file
+std::unique_ptr<HidHandlerInterface> make_impact_handler() {
+    return std::make_unique<ImpactHidHandler>();
+}
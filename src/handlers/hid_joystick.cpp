@@ -0,0 +1,124 @@
+/**
+ * @file hid_joystick.cpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "default_hid_handler.hpp"
+#include "device_registry.hpp"
+#include "hid_layout_cache.hpp"
+
+#include "pico/stdlib.h"
+#include "processors/latency_trace.hpp"
+#include "tusb.h"
+
+/**
+ * @brief Generic handler of USB HID reports for joysticks and gamepads
+ *
+ * Used for all devices which declare a joystick or gamepad application
+ * and are not handled by a dedicated driver. The report layout is taken
+ * from the HID report descriptor.
+ */
+class JoystickReportHandler : public DefaultHidHandler {
+  private:
+    /// Position of all fields inside the report
+    HidReportPlan plan_;
+
+    /// HID Report Descriptor is usable for this application
+    bool hid_report_desc_valid_{false};
+
+    /// @brief Below this value, X is considered left
+    int32_t left_threshold_{0};
+    /// @brief Above this value, X is considered right
+    int32_t right_threshold_{0};
+    /// @brief Below this value, Y is considered up
+    int32_t up_threshold_{0};
+    /// @brief Above this value, Y is considered down
+    int32_t down_threshold_{0};
+
+    /// @brief Buttons which trigger Fire1. Button 1 is bit 0
+    static constexpr uint32_t kFireButtons{1 << 0};
+    /// @brief Buttons which trigger Fire2
+    static constexpr uint32_t kSecFireButtons{1 << 1};
+    /// @brief Buttons which trigger Turbo Fire1
+    static constexpr uint32_t kAutoFireButtons{1 << 2};
+    /// @brief Buttons which trigger Fire3
+    static constexpr uint32_t kThirdFireButtons{1 << 3};
+    /// @brief Buttons which swap the controller ports. Select of most gamepads
+    static constexpr uint32_t kSwapButtons{1 << 8};
+
+    /**
+     * @brief Calculates the thresholds of an axis
+     *
+     * A direction is registered if the axis is moved by more than half
+     * of the way from the center.
+     *
+     * @param field         Field of the axis or nullptr if not available
+     * @param[out] low      Threshold towards the minimum
+     * @param[out] high     Threshold towards the maximum
+     */
+    static void thresholds(const HidReportPlan::Field *field, int32_t &low, int32_t &high) {
+        if (!field) {
+            // Values are 0 if the axis is not available
+            low = -1;
+            high = 1;
+            return;
+        }
+
+        int32_t quarter = (field->logical_max_ - field->logical_min_) / 4;
+        low = field->logical_min_ + quarter;
+        high = field->logical_max_ - quarter;
+    }
+
+  public:
+    void parse_hid_report_descriptor(uint16_t vid, uint16_t pid, uint8_t const *desc_report,
+                                     uint16_t desc_len) override {
+        hid_report_desc_valid_ = HidLayoutCache::compile(vid, pid, desc_report, desc_len,
+                                                         HidReportParser::Application::kJoystick, plan_);
+
+        thresholds(plan_.find(HidReportPlan::Role::kX), left_threshold_, right_threshold_);
+        thresholds(plan_.find(HidReportPlan::Role::kY), up_threshold_, down_threshold_);
+
+        PRINTF("Generic joystick with %u fields, report ID %u, valid %d\n", plan_.fields().size(), plan_.report_id(),
+               hid_report_desc_valid_);
+    }
+
+    void process_report(std::span<const uint8_t> report) override {
+        HidInputState input;
+
+        if (!hid_report_desc_valid_ || !plan_.extract(report, input))
+            return;
+
+        GamepadReport aj;
+        aj.arrival_us = LatencyTrace::arrival();
+        aj.update_from_coolie_hat(input.hat_);
+
+        aj.left |= input.x_ < left_threshold_;
+        aj.right |= input.x_ > right_threshold_;
+        aj.up |= input.y_ < up_threshold_;
+        aj.down |= input.y_ > down_threshold_;
+
+        aj.fire = (input.buttons_ & kFireButtons) != 0;
+        aj.sec_fire = (input.buttons_ & kSecFireButtons) != 0;
+        aj.auto_fire = (input.buttons_ & kAutoFireButtons) != 0;
+        aj.third_fire = (input.buttons_ & kThirdFireButtons) != 0;
+        aj.joystick_swap = (input.buttons_ & kSwapButtons) != 0;
+
+        if (target_) {
+            target_->process_gamepad_report(aj);
+        }
+    }
+
+    ReportType expected_report() override {
+        return kGamePad;
+    }
+};
+
+std::unique_ptr<HidHandlerInterface> make_joystick_handler() {
+    return std::make_unique<JoystickReportHandler>();
+}
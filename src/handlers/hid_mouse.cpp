@@ -9,13 +9,13 @@
  *
  */
 
-#include <numeric>
-#include <queue>
-
 #include "config.h"
 #include "default_hid_handler.hpp"
-#include "field_extractor.hpp"
-#include "hid_handler_builder.hpp"
+#include "device_registry.hpp"
+#include "hid_layout_cache.hpp"
+#include "processors/binary_trace.hpp"
+#include "processors/dpi_scaler.hpp"
+#include "processors/latency_trace.hpp"
 
 /**
  * @brief Generic handler of USB HID reports for mouses
@@ -23,239 +23,38 @@
  */
 class MouseReportHandler : public DefaultHidHandler {
   private:
-    FieldExtractor get_x;       ///< extracts relative X movement from report
-    FieldExtractor get_y;       ///< extracts relative Y movement from report
-    FieldExtractor get_wheel;   ///< extracts relative wheel movement from report
-    FieldExtractor get_buttons; ///< extracts button flags from report
-    /// Some HID have multiple reports. If it has, we need to filter
-    /// out the right one.
-    uint8_t expected_report_id_{0};
+    /// Position of all fields inside the report
+    HidReportPlan plan_;
 
     /// HID Report Descriptor is usable for this application
     bool hid_report_desc_valid_{false};
 
-  public:
-    void parse_hid_report_descriptor(uint8_t const *desc_report, uint16_t desc_len) override {
-        PRINTF("HID Descriptor:");
-        for (size_t i = 0; i < desc_len; i++) {
-            PRINTF(" %02x", desc_report[i]);
-        }
-        PRINTF("\n");
+    /// Brings the movement to a common resolution
+    DpiScaler dpi_scaler_;
 
+  public:
+    void parse_hid_report_descriptor(uint16_t vid, uint16_t pid, uint8_t const *desc_report,
+                                     uint16_t desc_len) override {
         hid_report_desc_valid_ = false;
+        // Boot mode doesn't provide the resolution
+        dpi_scaler_.set_resolution(0);
 
 #if CONFIG_FORCE_MOUSE_BOOT_MODE == 1
         return;
 #endif
 
-        // Report Item 6.2.2.2 USB HID 1.11
-        union TU_ATTR_PACKED {
-            uint8_t byte;
-            struct TU_ATTR_PACKED {
-                uint8_t size : 2;
-                uint8_t type : 2;
-                uint8_t tag : 4;
-            };
-        } header;
-
-        uint8_t report_num = 0;
-
-        // current parsed report count & size from descriptor
-        uint16_t ri_report_count = 0;
-        uint16_t ri_report_size = 0;
-
-        size_t bit_offset = 0;
-
-        uint8_t ri_collection_depth = 0;
-
-        std::queue<uint8_t> usages_level2;
-
-        uint8_t usage0{0};
-        uint8_t usage1{0};
-
-        while (desc_len) {
-            header.byte = *desc_report++;
-            desc_len--;
-
-            uint8_t const tag = header.tag;
-            uint8_t const type = header.type;
-            uint8_t const size = header.size;
-
-            uint8_t const data8 = desc_report[0];
-
-            switch (type) {
-            case RI_TYPE_MAIN:
-                switch (tag) {
-                case RI_MAIN_INPUT: {
-
-                    if (usage0 == HID_USAGE_DESKTOP_MOUSE && usage1 == HID_USAGE_DESKTOP_POINTER) {
-                        bool is_relative = (data8 & HID_RELATIVE) != 0;
-                        bool is_const = (data8 & HID_CONSTANT) != 0;
-
-                        if (is_const) {
-                            bit_offset += ri_report_size * ri_report_count;
-
-                        } else {
-                            if (is_relative) {
-                                if (usages_level2.size() != ri_report_count) {
-                                    return;
-                                }
-
-                                while (usages_level2.empty() == false) {
-                                    uint8_t usage = usages_level2.front();
-                                    usages_level2.pop();
-
-                                    switch (usage) {
-                                    case HID_USAGE_DESKTOP_X:
-                                        get_x.configure(bit_offset, ri_report_size, true);
-                                        break;
-                                    case HID_USAGE_DESKTOP_Y:
-                                        get_y.configure(bit_offset, ri_report_size, true);
-                                        break;
-                                    case HID_USAGE_DESKTOP_WHEEL:
-                                        get_wheel.configure(bit_offset, ri_report_size, true);
-                                        break;
-                                    }
-                                    bit_offset += ri_report_size;
-                                }
-
-                            } else {
-                                // Yes, report_count is correct.
-                                // Buttons are bools
-                                get_buttons.configure(bit_offset, ri_report_count, false);
-
-                                bit_offset += ri_report_size * ri_report_count;
-                            }
-                        }
-                    }
-
-                    break;
-                }
-                case RI_MAIN_OUTPUT:
-                    break;
-                case RI_MAIN_FEATURE:
-                    break;
-
-                case RI_MAIN_COLLECTION:
-
-                    if (ri_collection_depth == 0)
-                        bit_offset = 0;
-
-                    ri_collection_depth++;
-                    break;
-
-                case RI_MAIN_COLLECTION_END:
-                    ri_collection_depth--;
-                    if (ri_collection_depth == 0) {
-                        report_num++;
-                    }
-                    break;
-
-                default:
-                    break;
-                }
-                break;
-
-            case RI_TYPE_GLOBAL:
-                switch (tag) {
-                case RI_GLOBAL_USAGE_PAGE:
-                    // only take in account the "usage page" before REPORT ID
-                    if (ri_collection_depth == 0) {
-                    }
-
-                    switch (data8) {
-                    case HID_USAGE_PAGE_BUTTON:
-                        break;
-                    }
-
-                    break;
-
-                case RI_GLOBAL_LOGICAL_MIN:
-                    break;
-                case RI_GLOBAL_LOGICAL_MAX:
-                    break;
-                case RI_GLOBAL_PHYSICAL_MIN:
-                    break;
-                case RI_GLOBAL_PHYSICAL_MAX:
-                    break;
-
-                case RI_GLOBAL_REPORT_ID:
-                    bit_offset += 8;
-
-                    if (usage0 == HID_USAGE_DESKTOP_MOUSE)
-                        expected_report_id_ = data8;
-                    break;
-
-                case RI_GLOBAL_REPORT_SIZE:
-                    ri_report_size = data8;
-                    break;
-
-                case RI_GLOBAL_REPORT_COUNT:
-                    ri_report_count = data8;
-                    break;
-
-                case RI_GLOBAL_UNIT_EXPONENT:
-                    break;
-                case RI_GLOBAL_UNIT:
-                    break;
-                case RI_GLOBAL_PUSH:
-                    break;
-                case RI_GLOBAL_POP:
-                    break;
-
-                default:
-                    break;
-                }
-                break;
-
-            case RI_TYPE_LOCAL:
-                switch (tag) {
-                case RI_LOCAL_USAGE: {
-                    // only take in account the "usage" before starting REPORT ID
-
-                    if (ri_collection_depth == 2) {
-                        usages_level2.push(data8);
-                    } else if (ri_collection_depth == 0) {
-                        usage0 = data8;
-                    } else if (ri_collection_depth == 1) {
-                        usage1 = data8;
-                    }
-                    break;
-                }
-                case RI_LOCAL_USAGE_MIN:
-                    break;
-                case RI_LOCAL_USAGE_MAX:
-                    break;
-                case RI_LOCAL_DESIGNATOR_INDEX:
-                    break;
-                case RI_LOCAL_DESIGNATOR_MIN:
-                    break;
-                case RI_LOCAL_DESIGNATOR_MAX:
-                    break;
-                case RI_LOCAL_STRING_INDEX:
-                    break;
-                case RI_LOCAL_STRING_MIN:
-                    break;
-                case RI_LOCAL_STRING_MAX:
-                    break;
-                case RI_LOCAL_DELIMITER:
-                    break;
-                default:
-                    break;
-                }
-                break;
-
-            // error
-            default:
-                break;
-            }
-
-            desc_report += size;
-            desc_len -= size;
+        if (!HidLayoutCache::compile(vid, pid, desc_report, desc_len, HidReportParser::Application::kMouse, plan_)) {
+            PRINTF("Use boot mode!\n");
+            return;
         }
 
+        dpi_scaler_.set_resolution(plan_.resolution());
+
         hid_report_desc_valid_ = true;
         PRINTF("Use report mode!\n");
+        if (dpi_scaler_.active()) {
+            PRINTF("Mouse movement is scaled to %lu CPI\n", DpiScaler::kTargetResolution);
+        }
     }
 
     void process_report(std::span<const uint8_t> report) override {
@@ -267,25 +66,33 @@ class MouseReportHandler : public DefaultHidHandler {
         PRINTF("\n");
 #endif
         MouseReport mouse_report;
+        mouse_report.arrival_us = LatencyTrace::arrival();
 
         if (hid_report_desc_valid_) {
-            if (expected_report_id_ > 0 && expected_report_id_ != report[0]) {
-                PRINTF("DISCARD!\n");
+            HidInputState input;
+            if (!plan_.extract(report, input)) {
+                BinaryTrace::write<kTraceMouseDiscard>(report.size());
                 return;
             }
 
-            mouse_report.relx = saturating_cast(get_x.extract(report.data(), report.size()));
-            mouse_report.rely = saturating_cast(get_y.extract(report.data(), report.size()));
-            mouse_report.wheel = saturating_cast(get_wheel.extract(report.data(), report.size()));
-            mouse_report.button_pressed = static_cast<uint8_t>(get_buttons.extract(report.data(), report.size()));
+            dpi_scaler_.scale(mouse_report, input.x_, input.y_);
+            mouse_report.wheel = saturating_cast<int16_t>(input.wheel_);
+            mouse_report.button_pressed = static_cast<uint8_t>(input.buttons_);
 
         } else {
-            mouse_report = *reinterpret_cast<const struct MouseReport *>(report.data());
+            // Boot mode reports carry 8 bit movement
+            if (report.size() < 3)
+                return;
+
+            mouse_report.button_pressed = report[0];
+            dpi_scaler_.scale(mouse_report, static_cast<int8_t>(report[1]), static_cast<int8_t>(report[2]));
+            if (report.size() > 3)
+                mouse_report.wheel = static_cast<int8_t>(report[3]);
         }
 
         if (target_) {
-            PRINTF("Mouse X:%d Y:%d W:%d  %d %d %d   %x\n", mouse_report.relx, mouse_report.rely, mouse_report.wheel,
-                   mouse_report.left, mouse_report.middle, mouse_report.right, mouse_report.button_pressed);
+            BinaryTrace::write<kTraceMouseReport>(mouse_report.relx, mouse_report.rely, mouse_report.wheel,
+                                                  mouse_report.button_pressed);
             target_->process_mouse_report(mouse_report);
         }
     }
@@ -307,10 +114,6 @@ class MouseReportHandler : public DefaultHidHandler {
     }
 };
 
-static HidHandlerBuilder builder(0, 0, nullptr, [](tuh_hid_report_info_t *info) {
-    if (info->usage == HID_USAGE_DESKTOP_MOUSE && info->usage_page == HID_USAGE_PAGE_DESKTOP) {
-        return std::make_unique<MouseReportHandler>();
-    } else {
-        return std::unique_ptr<MouseReportHandler>(nullptr);
-    }
-});
+std::unique_ptr<HidHandlerInterface> make_mouse_handler() {
+    return std::make_unique<MouseReportHandler>();
+}
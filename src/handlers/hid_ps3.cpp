@@ -10,13 +10,12 @@
  */
 
 #include "default_hid_handler.hpp"
-#include "hid_handler_builder.hpp"
+#include "device_registry.hpp"
 
 #include "pico/stdlib.h"
+#include "processors/latency_trace.hpp"
 #include "tusb.h"
 
-#include "controller_port.hpp"
-
 /**
  * @brief Packed struct representing PS3 DualShock HID report
  */
@@ -105,6 +104,7 @@ class PS3DualShockHandler : public DefaultHidHandler {
 #endif
 
         GamepadReport aj;
+        aj.arrival_us = LatencyTrace::arrival();
 
         // The Dual shock doesn't use a coolie hat for the D-Pad
         // instead it is handled like 4 buttons
@@ -138,7 +138,6 @@ class PS3DualShockHandler : public DefaultHidHandler {
     }
 };
 
-// PS3 Original Dual Shock
-static HidHandlerBuilder builder(0x054c, 0x0268, []() { return std::make_unique<PS3DualShockHandler>(); }, nullptr);
-// PS3 Clone
-static HidHandlerBuilder builder2(0x0810, 0x0001, []() { return std::make_unique<PS3DualShockHandler>(); }, nullptr);
+std::unique_ptr<HidHandlerInterface> make_ps3_handler() {
+    return std::make_unique<PS3DualShockHandler>();
+}
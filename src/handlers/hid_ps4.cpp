@@ -10,13 +10,12 @@
  */
 
 #include "default_hid_handler.hpp"
-#include "hid_handler_builder.hpp"
+#include "device_registry.hpp"
 
 #include "pico/stdlib.h"
+#include "processors/latency_trace.hpp"
 #include "tusb.h"
 
-#include "controller_port.hpp"
-
 // a lot is stolen from here as the tinyusb example already supports DS4
 // https://github.com/hathach/tinyusb/blob/master/examples/host/hid_controller/src/hid_app.c
 
@@ -108,6 +107,7 @@ class PS4DualShockHandler : public DefaultHidHandler {
 #endif
 
             GamepadReport aj;
+            aj.arrival_us = LatencyTrace::arrival();
             update_from_dpad(aj, dat->dpad);
 
             aj.left |= dat->joy_left_x < (kAnalogCenter - kAnalogThreshold);
@@ -132,13 +132,6 @@ class PS4DualShockHandler : public DefaultHidHandler {
     }
 };
 
-// https://github.com/felis/USB_Host_Shield_2.0/blob/master/PS4USB.h
-
-#define PS4_VID 0x054C      ///< Sony Corporation
-#define PS4_PID 0x05C4      ///< PS4 Controller
-#define PS4_PID_SLIM 0x09CC ///< PS4 Slim Controller
-
-static HidHandlerBuilder
-    builder_normal(PS4_VID, PS4_PID, []() { return std::make_unique<PS4DualShockHandler>(); }, nullptr);
-static HidHandlerBuilder
-    builder_slim(PS4_VID, PS4_PID_SLIM, []() { return std::make_unique<PS4DualShockHandler>(); }, nullptr);
\ No newline at end of file
+std::unique_ptr<HidHandlerInterface> make_ps4_handler() {
+    return std::make_unique<PS4DualShockHandler>();
+}
@@ -10,13 +10,12 @@
  */
 
 #include "default_hid_handler.hpp"
-#include "hid_handler_builder.hpp"
+#include "device_registry.hpp"
 
 #include "pico/stdlib.h"
+#include "processors/latency_trace.hpp"
 #include "tusb.h"
 
-#include "controller_port.hpp"
-
 // much code and constants from
 // https://github.com/Dan611/hid-procon/blob/master/hid-procon.c
 // https://github.com/felis/USB_Host_Shield_2.0/blob/master/SwitchProParser.h
@@ -252,6 +251,7 @@ class SwitchProHandler : public DefaultHidHandler {
 #endif
 
         GamepadReport aj;
+        aj.arrival_us = LatencyTrace::arrival();
 
         if (dat->input_report_id == PROCON_REPORT_INPUT_FULL) {
             aj.left = dat->btn.dpad_left || dat->leftHatX < (kAnalogCenter - kAnalogThreshold);
@@ -291,5 +291,6 @@ class SwitchProHandler : public DefaultHidHandler {
     }
 };
 
-static HidHandlerBuilder builder(
-    0x057e, 0x2009, []() { return std::make_unique<SwitchProHandler>(); }, nullptr);
+std::unique_ptr<HidHandlerInterface> make_switch_pro_handler() {
+    return std::make_unique<SwitchProHandler>();
+}
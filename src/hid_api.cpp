@@ -9,31 +9,25 @@
  *
  */
 
-#include <map>
 #include <memory>
 
 #include "controller_port.hpp"
-#include "default_hid_handler.hpp"
+#include "handlers/default_hid_handler.hpp"
+#include "device_registry.hpp"
 #include "global.hpp"
-#include "hid_handler_builder.hpp"
 #include "pico/stdlib.h"
+#include "processors/latency_trace.hpp"
 #include "processors/pipeline.hpp"
+#include "processors/report_capture.hpp"
+#include "usb_devices.hpp"
 
-/// Maximum number of reports to read from a single HID Report Descriptor
-#define MAX_REPORT 4
-
-// Each HID instance can has multiple reports
-static struct {
-    uint8_t report_count;
-    tuh_hid_report_info_t report_info[MAX_REPORT];
-    std::shared_ptr<HidHandlerInterface> handler;
-} hid_info[CFG_TUH_HID];
+UsbDeviceTable gbl_usb_devices;
 
 void hid_app_task() {
-    for (auto &i : hid_info) {
-        if (i.handler)
-            i.handler->run();
-    }
+    gbl_usb_devices.for_each_hid([](HidInterfaceSlot &slot) {
+        if (slot.handler)
+            slot.handler->run();
+    });
 }
 
 //--------------------------------------------------------------------+
@@ -55,18 +49,33 @@ void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance, uint8_t const *desc_re
     PRINTF("HID device address = %d, instance = %d is mounted\n", dev_addr, instance);
     PRINTF("VID = %04x, PID = %04x\n", vid, pid);
 
-    hid_info[instance].report_count =
-        tuh_hid_parse_report_descriptor(hid_info[instance].report_info, MAX_REPORT, desc_report, desc_len);
-    PRINTF("HID has %u reports %d %d %d\n", hid_info[instance].report_count,
-           hid_info[instance].report_info[0].report_id, hid_info[instance].report_info[0].usage,
-           hid_info[instance].report_info[0].usage_page);
+    HidInterfaceSlot *slot = gbl_usb_devices.hid(dev_addr, instance);
+    if (!slot) {
+        PRINTF("Error: no space for HID device\n");
+        return;
+    }
+
+    slot->mount_time_us = board_micros();
+    slot->awaiting_first_report = true;
 
-    hid_info[instance].handler = HidHandlerBuilder::find(vid, pid, hid_info[instance].report_info);
+    slot->report_count = tuh_hid_parse_report_descriptor(slot->report_info, MAX_REPORT, desc_report, desc_len);
+    PRINTF("HID has %u reports %d %d %d\n", slot->report_count, slot->report_info[0].report_id,
+           slot->report_info[0].usage, slot->report_info[0].usage_page);
 
-    if (hid_info[instance].handler) {
-        gbl_pipeline->integrate_handler(hid_info[instance].handler);
-        hid_info[instance].handler->parse_hid_report_descriptor(desc_report, desc_len);
-        hid_info[instance].handler->setup_reception(dev_addr, instance);
+#if CONFIG_REPORT_CAPTURE == 1
+    ReportCapture::instance().mount(dev_addr, instance, vid, pid, slot->report_info[0].usage_page,
+                                    slot->report_info[0].usage, std::span(desc_report, desc_len));
+#endif
+
+    HidHandlerFactory make =
+        DeviceRegistry::find_hid(vid, pid, slot->report_info[0].usage_page, slot->report_info[0].usage);
+    slot->handler = make ? make() : nullptr;
+
+    if (slot->handler) {
+        gbl_pipeline->integrate_handler(slot->handler);
+        slot->handler->parse_hid_report_descriptor(vid, pid, desc_report, desc_len);
+        slot->handler->setup_reception(dev_addr, instance);
+        PRINTF("Handler ready after %lu us\n", board_micros() - slot->mount_time_us);
     } else {
         // request to receive report
         // tuh_hid_report_received_cb() will be invoked when report is
@@ -84,11 +93,9 @@ void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance, uint8_t const *desc_re
  * @param instance TinyUSB internal endpoint identifier
  */
 void tuh_hid_umount_cb(uint8_t dev_addr, uint8_t instance) {
-    std::ignore = dev_addr;
-
     PRINTF("HID device address = %d, instance = %d is unmounted\n", dev_addr, instance);
 
-    hid_info[instance].handler.reset();
+    gbl_usb_devices.remove_hid(dev_addr, instance);
 }
 
 /**
@@ -117,8 +124,25 @@ void print_generic_report(uint8_t const *d, uint16_t len) {
  * @param len Length of report in bytes
  */
 void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t instance, uint8_t const *report, uint16_t len) {
-    if (hid_info[instance].handler) {
-        hid_info[instance].handler.get()->process_report(std::span(report, len));
+    LatencyTrace::mark_arrival();
+
+    HidInterfaceSlot *slot = gbl_usb_devices.hid(dev_addr, instance);
+    if (!slot)
+        return;
+
+#if CONFIG_REPORT_CAPTURE == 1
+    uint16_t vid, pid;
+    tuh_vid_pid_get(dev_addr, &vid, &pid);
+    ReportCapture::instance().report(ReportCapture::kHidReport, dev_addr, instance, vid, pid, std::span(report, len));
+#endif
+
+    if (slot->awaiting_first_report) {
+        slot->awaiting_first_report = false;
+        PRINTF("First report after %lu us\n", board_micros() - slot->mount_time_us);
+    }
+
+    if (slot->handler) {
+        slot->handler->process_report(std::span(report, len));
     } else {
         print_generic_report(report, len);
     }
@@ -1,14 +0,0 @@
-/**
- * @file hid_handler_builder.cpp
- * @author André Zeps
- * @brief
- * @version 0.1
- * @date 2023-08-16
- *
- * @copyright Copyright (c) 2023
- *
- */
-
-#include "hid_handler_builder.hpp"
-
-std::vector<HidHandlerBuilder *> HidHandlerBuilder::builders_;
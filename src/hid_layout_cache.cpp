@@ -0,0 +1,76 @@
+/**
+ * @file hid_layout_cache.cpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#include "hid_layout_cache.hpp"
+#include "hardware/flash.h"
+#include "utility.h"
+
+static_assert(HidLayoutCache::kRecordSize == FLASH_PAGE_SIZE);
+static_assert(HidLayoutCache::kSectorSize == FLASH_SECTOR_SIZE);
+
+/// Address in CPU memory map to read the cache from flash
+static const uint8_t *flash_target_contents = (const uint8_t *)(XIP_BASE + kFlashHidLayoutCacheOffset);
+
+static std::array<uint8_t, FLASH_PAGE_SIZE> page_buffer_;
+
+bool HidLayoutCache::compile(uint16_t vid, uint16_t pid, const uint8_t *desc, size_t len,
+                             HidReportParser::Application application, HidReportPlan &plan) {
+    std::span<const uint8_t> sector(flash_target_contents, FLASH_SECTOR_SIZE);
+
+    const Record *cached = find(sector, vid, pid, desc, len, application);
+    if (cached) {
+        PRINTF("HID layout of %04x:%04x taken from cache\n", vid, pid);
+        return restore(*cached, plan);
+    }
+
+    PRINTF("HID Descriptor:");
+    for (size_t i = 0; i < len; i++) {
+        PRINTF(" %02x", desc[i]);
+    }
+    PRINTF("\n");
+
+    bool valid = HidReportParser::compile(desc, len, application, plan);
+
+    // Written by the output core while the controller ports are quiet
+    if (queue(make_record(vid, pid, desc, len, application, plan, valid))) {
+        PRINTF("HID layout of %04x:%04x queued for the cache\n", vid, pid);
+    } else {
+        PRINTF("HID layout of %04x:%04x not cached. Too many are waiting\n", vid, pid);
+    }
+
+    return valid;
+}
+
+bool HidLayoutCache::write_pending() {
+    std::span<const uint8_t> sector(flash_target_contents, FLASH_SECTOR_SIZE);
+
+    Record record;
+    if (!take_pending(sector, record))
+        return false;
+
+    size_t slot = used_records(sector);
+
+    memset(page_buffer_.data(), 0xff, page_buffer_.size());
+    memcpy(page_buffer_.data(), &record, sizeof(record));
+
+    {
+        FlashAccessGuard guard;
+        if (slot == kRecords) {
+            flash_range_erase(kFlashHidLayoutCacheOffset, FLASH_SECTOR_SIZE);
+            slot = 0;
+        }
+        flash_range_program(kFlashHidLayoutCacheOffset + slot * kRecordSize, page_buffer_.data(),
+                            page_buffer_.size());
+    }
+
+    PRINTF("HID layout of %04x:%04x stored in slot %u\n", record.vid_, record.pid_, slot);
+    return true;
+}
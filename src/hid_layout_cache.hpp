@@ -0,0 +1,289 @@
+/**
+ * @file hid_layout_cache.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include "hid_report_parser.hpp"
+#include "spsc_queue.hpp"
+
+/**
+ * @brief Stores compiled HID report descriptors in a flash sector
+ *
+ * A device which was attached before doesn't need its report descriptor
+ * to be compiled again. The layout is identified by VID, PID and a hash
+ * of the descriptor and stored as one record per flash page.
+ *
+ * Records are appended to the sector. The newest record of a device is used.
+ * If the sector is full, it is erased and filling starts again.
+ *
+ * Writing the flash stalls the controller ports. Newly compiled layouts are
+ * therefore only queued in RAM by the USB core. They are written by the output
+ * core using \ref write_pending, while the ports are quiet.
+ */
+class HidLayoutCache {
+  public:
+    /// @brief Size of a record. Equal to the flash page size
+    static constexpr size_t kRecordSize{256};
+
+    /// @brief Size of the sector holding all records. Equal to the flash erase sector size
+    static constexpr size_t kSectorSize{4096};
+
+    /// @brief Number of records inside the sector
+    static constexpr size_t kRecords{kSectorSize / kRecordSize};
+
+    /// @brief Identifies a valid record. Must be changed if the record or the parser changes
+    static constexpr uint32_t kMagic{0x0148434c}; // "LCH" and version 1
+
+    /// @brief Single field of \ref HidReportPlan as stored in flash
+    struct __attribute__((packed)) StoredField {
+        uint16_t offset_;      ///< Position in bits, including the report ID
+        uint8_t length_;       ///< Length in bits
+        uint8_t role_;         ///< \ref HidReportPlan::Role of the field
+        uint8_t first_button_; ///< Index of the first button
+        uint8_t flags_;        ///< Bit 0 is signed, bit 1 is relative
+        int32_t logical_min_;  ///< Logical Minimum of the field
+        int32_t logical_max_;  ///< Logical Maximum of the field
+    };
+
+    /// @brief Compiled report descriptor as stored in flash
+    struct __attribute__((packed)) Record {
+        uint32_t magic_;       ///< \ref kMagic or 0xffffffff if the page is erased
+        uint16_t vid_;         ///< Vendor ID of the device
+        uint16_t pid_;         ///< Product ID of the device
+        uint32_t hash_;        ///< Hash of the report descriptor
+        uint16_t desc_len_;    ///< Length of the report descriptor
+        uint8_t application_;  ///< \ref HidReportParser::Application which was searched for
+        uint8_t valid_;        ///< Result of \ref HidReportParser::compile
+        uint8_t report_id_;    ///< Report ID of the plan
+        uint8_t count_;        ///< Number of valid entries in fields_
+        uint32_t resolution_;  ///< Resolution of the plan
+        std::array<StoredField, HidReportPlan::kMaxFields> fields_; ///< Fields of the plan
+    };
+
+    static_assert(sizeof(Record) <= kRecordSize, "A record must fit into a flash page");
+
+    /// @brief Number of compiled layouts which can wait to be written
+    static constexpr size_t kPendingRecords{4};
+
+  private:
+    /// @brief Records from the USB core which are not yet written by the output core
+    static inline SpscQueue<Record, kPendingRecords> pending_;
+
+    /**
+     * @brief Searches the newest record with the given identity
+     *
+     * @param sector        Content of the flash sector
+     * @param vid           Vendor ID of the device
+     * @param pid           Product ID of the device
+     * @param h             Hash of the report descriptor
+     * @param len           Length of the descriptor in bytes
+     * @param application   Type of device to search for
+     * @return const Record*    Record or nullptr if not stored
+     */
+    static const Record *find_record(std::span<const uint8_t> sector, uint16_t vid, uint16_t pid, uint32_t h,
+                                     size_t len, uint8_t application) {
+        // Search backwards as the newest record is the last one
+        for (size_t i = used_records(sector); i > 0; i--) {
+            auto record = reinterpret_cast<const Record *>(&sector[(i - 1) * kRecordSize]);
+
+            if (record->magic_ == kMagic && record->vid_ == vid && record->pid_ == pid && record->hash_ == h &&
+                record->desc_len_ == len && record->application_ == application)
+                return record;
+        }
+
+        return nullptr;
+    }
+
+  public:
+
+    /**
+     * @brief Calculates the hash of a report descriptor
+     *
+     * FNV-1a with 32 bit.
+     *
+     * @param desc      HID report descriptor
+     * @param len       Length of the descriptor in bytes
+     * @return uint32_t Hash of the descriptor
+     */
+    static uint32_t hash(const uint8_t *desc, size_t len) {
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < len; i++) {
+            h ^= desc[i];
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    /**
+     * @brief Creates a record of a compiled descriptor
+     *
+     * @param vid           Vendor ID of the device
+     * @param pid           Product ID of the device
+     * @param desc          HID report descriptor
+     * @param len           Length of the descriptor in bytes
+     * @param application   Type of device which was searched for
+     * @param plan          Result of the compilation
+     * @param valid         Return value of the compilation
+     * @return Record       Record to store
+     */
+    static Record make_record(uint16_t vid, uint16_t pid, const uint8_t *desc, size_t len,
+                              HidReportParser::Application application, const HidReportPlan &plan, bool valid) {
+        Record record;
+        memset(&record, 0xff, sizeof(record));
+
+        record.magic_ = kMagic;
+        record.vid_ = vid;
+        record.pid_ = pid;
+        record.hash_ = hash(desc, len);
+        record.desc_len_ = static_cast<uint16_t>(len);
+        record.application_ = static_cast<uint8_t>(application);
+        record.valid_ = valid;
+        record.report_id_ = plan.report_id();
+        record.count_ = static_cast<uint8_t>(plan.fields().size());
+        record.resolution_ = plan.resolution();
+
+        for (size_t i = 0; i < record.count_; i++) {
+            const HidReportPlan::Field &field = plan.fields()[i];
+            StoredField &stored = record.fields_[i];
+
+            stored.offset_ = field.offset_;
+            stored.length_ = field.length_;
+            stored.role_ = static_cast<uint8_t>(field.role_);
+            stored.first_button_ = field.first_button_;
+            stored.flags_ = (field.signed_ ? 1 : 0) | (field.relative_ ? 2 : 0);
+            stored.logical_min_ = field.logical_min_;
+            stored.logical_max_ = field.logical_max_;
+        }
+
+        return record;
+    }
+
+    /**
+     * @brief Fills a plan with the content of a record
+     *
+     * @param record    Record to use
+     * @param plan      Plan to fill
+     * @return true     Descriptor was valid during compilation
+     */
+    static bool restore(const Record &record, HidReportPlan &plan) {
+        std::array<HidReportPlan::Field, HidReportPlan::kMaxFields> fields{};
+        size_t count = std::min<size_t>(record.count_, fields.size());
+
+        for (size_t i = 0; i < count; i++) {
+            const StoredField &stored = record.fields_[i];
+            HidReportPlan::Field &field = fields[i];
+
+            field.role_ = static_cast<HidReportPlan::Role>(stored.role_);
+            field.offset_ = stored.offset_;
+            field.length_ = stored.length_;
+            field.first_button_ = stored.first_button_;
+            field.signed_ = (stored.flags_ & 1) != 0;
+            field.relative_ = (stored.flags_ & 2) != 0;
+            field.logical_min_ = stored.logical_min_;
+            field.logical_max_ = stored.logical_max_;
+        }
+
+        plan.restore({fields.data(), count}, record.report_id_, record.resolution_);
+        return record.valid_ != 0;
+    }
+
+    /**
+     * @brief Searches the newest record of a descriptor
+     *
+     * @param sector        Content of the flash sector
+     * @param vid           Vendor ID of the device
+     * @param pid           Product ID of the device
+     * @param desc          HID report descriptor
+     * @param len           Length of the descriptor in bytes
+     * @param application   Type of device to search for
+     * @return const Record*    Record or nullptr if not stored
+     */
+    static const Record *find(std::span<const uint8_t> sector, uint16_t vid, uint16_t pid, const uint8_t *desc,
+                              size_t len, HidReportParser::Application application) {
+        return find_record(sector, vid, pid, hash(desc, len), len, static_cast<uint8_t>(application));
+    }
+
+    /**
+     * @brief Determines the number of written records
+     *
+     * @param sector    Content of the flash sector
+     * @return size_t   Index of the first erased record or \ref kRecords if the sector is full
+     */
+    static size_t used_records(std::span<const uint8_t> sector) {
+        for (size_t i = 0; i < kRecords; i++) {
+            auto record = reinterpret_cast<const Record *>(&sector[i * kRecordSize]);
+            if (record->magic_ == 0xffffffff)
+                return i;
+        }
+        return kRecords;
+    }
+
+    /**
+     * @brief Queues a record to be written later. Must only be called by the USB core
+     *
+     * @param record    Record to write
+     * @return true     Record was queued
+     * @return false    Too many records are waiting. The record is dropped
+     */
+    static bool queue(const Record &record) {
+        return pending_.push(record);
+    }
+
+    /**
+     * @brief Takes the next queued record which is not yet stored. Must only be called by the output core
+     *
+     * A device which was attached again before its record was written is queued twice.
+     * Records which are already in the sector are skipped.
+     *
+     * @param sector        Content of the flash sector
+     * @param[out] record   Record to write
+     * @return true         A record has to be written
+     */
+    static bool take_pending(std::span<const uint8_t> sector, Record &record) {
+        while (pending_.pop(record)) {
+            if (!find_record(sector, record.vid_, record.pid_, record.hash_, record.desc_len_, record.application_))
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Writes a single queued record to flash
+     *
+     * Must only be called by the output core, while the controller ports are quiet.
+     *
+     * @return true     A record was written
+     */
+    static bool write_pending();
+
+    /**
+     * @brief Compiles a report descriptor or takes the result from flash
+     *
+     * Newly compiled descriptors are queued to be stored in flash.
+     *
+     * @param vid           Vendor ID of the device
+     * @param pid           Product ID of the device
+     * @param desc          HID report descriptor
+     * @param len           Length of the descriptor in bytes
+     * @param application   Type of device to search for
+     * @param[out] plan     Compiled fields
+     * @return true         The descriptor is usable
+     */
+    static bool compile(uint16_t vid, uint16_t pid, const uint8_t *desc, size_t len,
+                        HidReportParser::Application application, HidReportPlan &plan);
+};
@@ -0,0 +1,685 @@
+/**
+ * @file hid_report_parser.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <tuple>
+
+#include "field_extractor.hpp"
+#include "processors/dpi_scaler.hpp"
+
+/**
+ * @brief Input data of a HID report, reduced to what is used by this project
+ */
+struct HidInputState {
+    int32_t x_{0};        ///< Generic Desktop X
+    int32_t y_{0};        ///< Generic Desktop Y
+    int32_t wheel_{0};    ///< Generic Desktop Wheel
+    uint8_t hat_{0};      ///< Hat switch. 0 if released, 1 to 8 clockwise starting with north
+    uint32_t buttons_{0}; ///< Buttons 1 to 32. Bit 0 is button 1
+};
+
+/**
+ * @brief Compiled form of a HID report descriptor
+ *
+ * Contains the position of every field which is used by this project.
+ * Created once per device by \ref HidReportParser. Afterwards, every report
+ * is processed by a loop over the fields without further interpretation
+ * of the descriptor.
+ */
+class HidReportPlan {
+  public:
+    /// @brief Meaning of a field
+    enum class Role : uint8_t {
+        kX,       ///< Generic Desktop X
+        kY,       ///< Generic Desktop Y
+        kWheel,   ///< Generic Desktop Wheel
+        kHat,     ///< Generic Desktop Hat switch
+        kButtons, ///< Consecutive buttons of the Button page
+    };
+
+    /// @brief Position and meaning of a single field inside the report
+    struct Field {
+        Role role_;            ///< Meaning of the field
+        uint16_t offset_;      ///< Position in bits, including the report ID
+        uint8_t length_;       ///< Length in bits
+        uint8_t first_button_; ///< Index of the first button for \ref Role::kButtons
+        bool signed_;          ///< True if the logical minimum is negative or the data is relative
+        bool relative_;        ///< True for Relative data
+        int32_t logical_min_;  ///< Logical Minimum of the field
+        int32_t logical_max_;  ///< Logical Maximum of the field
+    };
+
+    /// @brief Maximum number of fields inside a plan
+    static constexpr size_t kMaxFields{FieldExtractorPlan::kMaxFields};
+
+  private:
+    /// @brief Fields to extract. Only the first \ref count_ are valid
+    std::array<Field, kMaxFields> fields_{};
+
+    /// @brief Number of valid entries in \ref fields_
+    size_t count_{0};
+
+    /// @brief Extracts all fields in one pass. Configured by \ref finalize
+    FieldExtractorPlan extractors_;
+
+    /// @brief Report ID of the used report. 0 if the device doesn't use report IDs
+    uint8_t report_id_{0};
+
+    /// @brief Minimum length of the report in bytes to contain all fields
+    size_t min_length_{0};
+
+    /// @brief Shift to convert the hat switch to 8 directions
+    uint8_t hat_shift_{0};
+
+    /// @brief Resolution of the X axis in counts per inch. 0 if unknown
+    uint32_t resolution_{0};
+
+    friend class HidReportParser;
+
+    /**
+     * @brief Adds a field
+     *
+     * Buttons following the previous buttons are merged into a single field.
+     *
+     * @param field     Field to add
+     */
+    void add(const Field &field) {
+        if (count_ > 0) {
+            Field &last = fields_[count_ - 1];
+
+            if (field.role_ == Role::kButtons && last.role_ == Role::kButtons && field.length_ == 1 &&
+                last.offset_ + last.length_ == field.offset_ &&
+                last.first_button_ + last.length_ == field.first_button_ && last.length_ < 32) {
+                last.length_++;
+                return;
+            }
+        }
+
+        if (count_ < fields_.size())
+            fields_[count_++] = field;
+    }
+
+    /// @brief Prepares the fields for extraction
+    void finalize() {
+        min_length_ = 0;
+        extractors_.clear();
+
+        size_t x_index = count_;
+        for (size_t i = 0; i < count_; i++) {
+            Field &field = fields_[i];
+            extractors_.add(field.offset_, field.length_, field.signed_);
+            if (field.role_ == Role::kX && i + 1 < count_ && fields_[i + 1].role_ == Role::kY)
+                x_index = i;
+
+            min_length_ = std::max<size_t>(min_length_, (field.offset_ + field.length_ + 7) / 8);
+
+            if (field.role_ == Role::kHat) {
+                // 4 directions are converted to 8 directions
+                hat_shift_ = (field.logical_max_ - field.logical_min_ == 3) ? 1 : 0;
+            }
+        }
+
+        extractors_.finalize(x_index);
+    }
+
+  public:
+    /// @brief Removes all fields
+    void clear() {
+        count_ = 0;
+        extractors_.clear();
+        report_id_ = 0;
+        min_length_ = 0;
+        hat_shift_ = 0;
+        resolution_ = 0;
+    }
+
+    /**
+     * @brief Replaces all fields by previously compiled ones
+     *
+     * @param fields        Fields as provided by \ref fields
+     * @param report_id     Report ID as provided by \ref report_id
+     * @param resolution    Resolution as provided by \ref resolution
+     */
+    void restore(std::span<const Field> fields, uint8_t report_id, uint32_t resolution) {
+        clear();
+
+        count_ = std::min(fields.size(), fields_.size());
+        std::copy_n(fields.begin(), count_, fields_.begin());
+        report_id_ = report_id;
+        resolution_ = resolution;
+
+        finalize();
+    }
+
+    /// @brief Returns the fields of the plan
+    std::span<const Field> fields() const {
+        return {fields_.data(), count_};
+    }
+
+    /// @brief Returns the field with the given role or nullptr if not available
+    const Field *find(Role role) const {
+        for (size_t i = 0; i < count_; i++) {
+            if (fields_[i].role_ == role)
+                return &fields_[i];
+        }
+        return nullptr;
+    }
+
+    /// @brief Returns the Report ID of the used report. 0 if not used
+    uint8_t report_id() const {
+        return report_id_;
+    }
+
+    /// @brief Returns the resolution of the X axis in counts per inch. 0 if unknown
+    uint32_t resolution() const {
+        return resolution_;
+    }
+
+    /// @brief Returns the layout selected for extraction
+    FieldExtractorPlan::Layout layout() const {
+        return extractors_.layout();
+    }
+
+    /**
+     * @brief Extracts all fields of a report
+     *
+     * @param report    Report as received from the device
+     * @param state     Filled with the content of the report
+     * @return true     The report was processed
+     * @return false    The report is of another report ID or too short
+     */
+    bool extract(std::span<const uint8_t> report, HidInputState &state) const {
+        if (report.size() < min_length_)
+            return false;
+
+        if (report_id_ && report[0] != report_id_)
+            return false;
+
+        state = HidInputState();
+
+        std::array<int32_t, kMaxFields> values;
+        extractors_.extract(report.data(), report.size(), values.data());
+
+        for (size_t i = 0; i < count_; i++) {
+            const Field &field = fields_[i];
+            int32_t value = values[i];
+
+            switch (field.role_) {
+            case Role::kX:
+                state.x_ = value;
+                break;
+            case Role::kY:
+                state.y_ = value;
+                break;
+            case Role::kWheel:
+                state.wheel_ = value;
+                break;
+            case Role::kHat:
+                if (value >= field.logical_min_ && value <= field.logical_max_)
+                    state.hat_ = static_cast<uint8_t>(((value - field.logical_min_) << hat_shift_) + 1);
+                break;
+            case Role::kButtons:
+                state.buttons_ |= static_cast<uint32_t>(value) << field.first_button_;
+                break;
+            }
+        }
+
+        return true;
+    }
+};
+
+/**
+ * @brief Compiles a HID report descriptor into a \ref HidReportPlan
+ *
+ * Follows chapter 6.2.2 of USB HID 1.11. Supports short and long items,
+ * Push and Pop, Usage Minimum and Maximum, extended usages and data of up to 4 bytes.
+ * Only the input report of the first application collection of the requested type
+ * is used. If the device uses report IDs, the first report containing a used field
+ * is taken.
+ */
+class HidReportParser {
+  public:
+    /// @brief Type of device to search for
+    enum class Application {
+        kMouse,    ///< Generic Desktop Mouse
+        kJoystick, ///< Generic Desktop Joystick or Game Pad
+    };
+
+  private:
+    /// @brief Item types of 6.2.2.2
+    enum ItemType : uint8_t {
+        kMain = 0,
+        kGlobal = 1,
+        kLocal = 2,
+    };
+
+    /// @brief Tags of main items of 6.2.2.4
+    enum MainTag : uint8_t {
+        kInput = 0x8,
+        kOutput = 0x9,
+        kCollection = 0xa,
+        kFeature = 0xb,
+        kEndCollection = 0xc,
+    };
+
+    /// @brief Tags of global items of 6.2.2.7
+    enum GlobalTag : uint8_t {
+        kUsagePage = 0x0,
+        kLogicalMinimum = 0x1,
+        kLogicalMaximum = 0x2,
+        kPhysicalMinimum = 0x3,
+        kPhysicalMaximum = 0x4,
+        kUnitExponent = 0x5,
+        kUnit = 0x6,
+        kReportSize = 0x7,
+        kReportId = 0x8,
+        kReportCount = 0x9,
+        kPush = 0xa,
+        kPop = 0xb,
+    };
+
+    /// @brief Tags of local items of 6.2.2.8
+    enum LocalTag : uint8_t {
+        kUsage = 0x0,
+        kUsageMinimum = 0x1,
+        kUsageMaximum = 0x2,
+    };
+
+    /// @brief Bits of the data of input items
+    enum InputFlags : uint32_t {
+        kConstant = 0x01,
+        kVariable = 0x02,
+        kRelative = 0x04,
+    };
+
+    static constexpr uint8_t kLongItem{0xfe};
+    static constexpr uint32_t kCollectionApplication{0x01};
+
+    static constexpr uint16_t kPageDesktop{0x01};
+    static constexpr uint16_t kPageButton{0x09};
+
+    static constexpr uint16_t kDesktopMouse{0x02};
+    static constexpr uint16_t kDesktopJoystick{0x04};
+    static constexpr uint16_t kDesktopGamepad{0x05};
+    static constexpr uint16_t kDesktopX{0x30};
+    static constexpr uint16_t kDesktopY{0x31};
+    static constexpr uint16_t kDesktopWheel{0x38};
+    static constexpr uint16_t kDesktopHat{0x39};
+
+    /// @brief Global items which can be stored by Push
+    struct Globals {
+        uint16_t usage_page_{0};
+        int32_t logical_min_{0};
+        int32_t logical_max_{0};
+        uint32_t logical_max_raw_{0};
+        int32_t physical_min_{0};
+        int32_t physical_max_{0};
+        int32_t unit_exponent_{0};
+        uint32_t unit_{0};
+        uint32_t report_size_{0};
+        uint32_t report_count_{0};
+        uint8_t report_id_{0};
+    };
+
+    /// @brief Maximum depth of Push
+    static constexpr size_t kStackDepth{4};
+
+    /// @brief Maximum number of Usage items before a main item
+    static constexpr size_t kMaxUsages{16};
+
+    /// @brief Maximum number of report IDs to track the size of
+    static constexpr size_t kMaxReports{16};
+
+    /**
+     * @brief Reads the data of a short item
+     *
+     * @param data  Data of the item
+     * @param len   Number of data bytes
+     * @return uint32_t Zero extended value
+     */
+    static uint32_t item_unsigned(const uint8_t *data, size_t len) {
+        uint32_t value = 0;
+        for (size_t i = 0; i < len; i++)
+            value |= static_cast<uint32_t>(data[i]) << (8 * i);
+        return value;
+    }
+
+    /**
+     * @brief Reads the data of a short item
+     *
+     * @param data  Data of the item
+     * @param len   Number of data bytes
+     * @return int32_t Sign extended value
+     */
+    static int32_t item_signed(const uint8_t *data, size_t len) {
+        switch (len) {
+        case 1:
+            return static_cast<int8_t>(data[0]);
+        case 2:
+            return static_cast<int16_t>(item_unsigned(data, 2));
+        case 4:
+            return static_cast<int32_t>(item_unsigned(data, 4));
+        default:
+            return 0;
+        }
+    }
+
+    /**
+     * @brief Checks whether an application collection is searched for
+     *
+     * @param application   Type of device to search for
+     * @param usage         Extended usage of the collection
+     */
+    static bool application_matches(Application application, uint32_t usage) {
+        if ((usage >> 16) != kPageDesktop)
+            return false;
+
+        uint16_t id = usage & 0xffff;
+        if (application == Application::kMouse)
+            return id == kDesktopMouse;
+        return id == kDesktopJoystick || id == kDesktopGamepad;
+    }
+
+    /**
+     * @brief Determines the role of a single report element
+     *
+     * @param usage         Extended usage of the element
+     * @param[out] role     Role of the element
+     * @return true         The element is used by this project
+     */
+    static bool role_of(uint32_t usage, HidReportPlan::Role &role) {
+        uint16_t page = usage >> 16;
+        uint16_t id = usage & 0xffff;
+
+        if (page == kPageButton && id >= 1 && id <= 32) {
+            role = HidReportPlan::Role::kButtons;
+            return true;
+        }
+
+        if (page != kPageDesktop)
+            return false;
+
+        switch (id) {
+        case kDesktopX:
+            role = HidReportPlan::Role::kX;
+            return true;
+        case kDesktopY:
+            role = HidReportPlan::Role::kY;
+            return true;
+        case kDesktopWheel:
+            role = HidReportPlan::Role::kWheel;
+            return true;
+        case kDesktopHat:
+            role = HidReportPlan::Role::kHat;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+  public:
+    /**
+     * @brief Compiles a report descriptor
+     *
+     * @param desc          HID report descriptor
+     * @param len           Length of the descriptor in bytes
+     * @param application   Type of device to search for
+     * @param[out] plan     Compiled fields
+     * @return true         The descriptor contains X and Y, or a hat switch for joysticks
+     */
+    static bool compile(const uint8_t *desc, size_t len, Application application, HidReportPlan &plan) {
+        plan.clear();
+
+        Globals globals;
+        std::array<Globals, kStackDepth> stack;
+        size_t stack_level = 0;
+
+        size_t usage_count = 0;
+        uint32_t usage_min = 0;
+        uint32_t usage_max = 0;
+        bool usage_range = false;
+
+        // Bits of the input report per report ID
+        std::array<std::pair<uint8_t, uint32_t>, kMaxReports> report_bits{};
+        size_t report_count = 0;
+
+        // Depth of the collections and depth of the searched application collection
+        uint32_t depth = 0;
+        uint32_t application_depth = 0;
+        bool plan_has_report = false;
+
+        // The usage page of a local item is taken from the global state at the main item.
+        // Extended usages are marked to keep their page.
+        static constexpr uint64_t kExtended = 1ull << 32;
+        std::array<uint64_t, kMaxUsages> raw_usages;
+
+        const uint8_t *end = desc + len;
+
+        while (desc < end) {
+            uint8_t header = *desc++;
+
+            if (header == kLongItem) {
+                if (end - desc < 2)
+                    break;
+                size_t data_len = desc[0];
+                desc += 2 + data_len;
+                continue;
+            }
+
+            uint8_t size = header & 0x3;
+            uint8_t type = (header >> 2) & 0x3;
+            uint8_t tag = header >> 4;
+            // A size of 3 means 4 bytes of data
+            size_t data_len = (size == 3) ? 4 : size;
+
+            if (static_cast<size_t>(end - desc) < data_len)
+                break;
+
+            uint32_t data = item_unsigned(desc, data_len);
+            int32_t data_signed = item_signed(desc, data_len);
+
+            switch (type) {
+            case kMain:
+                switch (tag) {
+                case kInput: {
+                    // Find the bit counter of the report
+                    size_t report = 0;
+                    while (report < report_count && report_bits[report].first != globals.report_id_)
+                        report++;
+                    if (report == report_count) {
+                        if (report_count == report_bits.size())
+                            break;
+                        report_bits[report_count++] = {globals.report_id_, 0};
+                    }
+                    uint32_t &bits = report_bits[report].second;
+
+                    bool used = application_depth != 0 && !(data & kConstant) && (data & kVariable) &&
+                                globals.report_size_ >= 1 && globals.report_size_ <= 32 &&
+                                (!plan_has_report || plan.report_id_ == globals.report_id_);
+
+                    for (uint32_t i = 0; used && i < globals.report_count_; i++) {
+                        uint64_t raw;
+                        if (usage_range) {
+                            raw = kExtended | std::min(usage_min + i, usage_max);
+                        } else if (usage_count > 0) {
+                            raw = raw_usages[std::min<size_t>(i, usage_count - 1)];
+                        } else {
+                            break;
+                        }
+
+                        uint32_t usage = (raw & kExtended) ? static_cast<uint32_t>(raw)
+                                                           : (static_cast<uint32_t>(globals.usage_page_) << 16) |
+                                                                 static_cast<uint32_t>(raw & 0xffff);
+
+                        HidReportPlan::Role role;
+                        if (!role_of(usage, role))
+                            continue;
+
+                        HidReportPlan::Field field{};
+                        field.role_ = role;
+                        field.offset_ = static_cast<uint16_t>(bits + i * globals.report_size_ +
+                                                              (globals.report_id_ ? 8 : 0));
+                        field.length_ = static_cast<uint8_t>(globals.report_size_);
+                        field.first_button_ = static_cast<uint8_t>((usage & 0xffff) - 1);
+                        field.relative_ = (data & kRelative) != 0;
+                        field.signed_ = globals.logical_min_ < 0 || field.relative_;
+                        field.logical_min_ = globals.logical_min_;
+                        field.logical_max_ = globals.logical_max_;
+
+                        // Buttons are only merged if they are single bits
+                        if (role == HidReportPlan::Role::kButtons && field.length_ != 1)
+                            continue;
+
+                        // Only the first field of a role is used, except for buttons
+                        if (role != HidReportPlan::Role::kButtons && plan.find(role))
+                            continue;
+
+                        if (role == HidReportPlan::Role::kX) {
+                            plan.resolution_ = DpiScaler::resolution_from_descriptor(
+                                globals.logical_min_, globals.logical_max_, globals.physical_min_,
+                                globals.physical_max_, globals.unit_, globals.unit_exponent_);
+                        }
+
+                        plan.add(field);
+                        plan.report_id_ = globals.report_id_;
+                        plan_has_report = true;
+                    }
+
+                    bits += globals.report_size_ * globals.report_count_;
+                    break;
+                }
+                case kCollection:
+                    depth++;
+                    if (data == kCollectionApplication && application_depth == 0 && !plan_has_report) {
+                        uint64_t raw = usage_count ? raw_usages[0] : 0;
+                        uint32_t usage = (raw & kExtended) ? static_cast<uint32_t>(raw)
+                                                           : (static_cast<uint32_t>(globals.usage_page_) << 16) |
+                                                                 static_cast<uint32_t>(raw & 0xffff);
+                        if (usage_count && application_matches(application, usage))
+                            application_depth = depth;
+                    }
+                    break;
+                case kEndCollection:
+                    if (depth == application_depth)
+                        application_depth = 0;
+                    if (depth > 0)
+                        depth--;
+                    break;
+                case kOutput:
+                case kFeature:
+                default:
+                    break;
+                }
+
+                // Local items are only valid for the next main item
+                usage_count = 0;
+                usage_range = false;
+                usage_min = 0;
+                usage_max = 0;
+                break;
+
+            case kGlobal:
+                switch (tag) {
+                case kUsagePage:
+                    globals.usage_page_ = static_cast<uint16_t>(data);
+                    break;
+                case kLogicalMinimum:
+                    globals.logical_min_ = data_signed;
+                    break;
+                case kLogicalMaximum:
+                    globals.logical_max_ = data_signed;
+                    globals.logical_max_raw_ = data;
+                    break;
+                case kPhysicalMinimum:
+                    globals.physical_min_ = data_signed;
+                    break;
+                case kPhysicalMaximum:
+                    globals.physical_max_ = data_signed;
+                    break;
+                case kUnitExponent:
+                    globals.unit_exponent_ = data_signed;
+                    break;
+                case kUnit:
+                    globals.unit_ = data;
+                    break;
+                case kReportSize:
+                    globals.report_size_ = data;
+                    break;
+                case kReportId:
+                    globals.report_id_ = static_cast<uint8_t>(data);
+                    break;
+                case kReportCount:
+                    globals.report_count_ = data;
+                    break;
+                case kPush:
+                    if (stack_level < stack.size())
+                        stack[stack_level++] = globals;
+                    break;
+                case kPop:
+                    if (stack_level > 0)
+                        globals = stack[--stack_level];
+                    break;
+                default:
+                    break;
+                }
+
+                // Many devices declare "0 to 255" using a single byte.
+                // The maximum is unsigned if the minimum isn't negative.
+                if ((tag == kLogicalMinimum || tag == kLogicalMaximum) && globals.logical_min_ >= 0 &&
+                    globals.logical_max_ < 0) {
+                    globals.logical_max_ = static_cast<int32_t>(globals.logical_max_raw_);
+                }
+                break;
+
+            case kLocal:
+                switch (tag) {
+                case kUsage:
+                    if (usage_count < raw_usages.size())
+                        raw_usages[usage_count++] = (data_len == 4) ? (kExtended | data) : data;
+                    break;
+                case kUsageMinimum:
+                    usage_min = (data_len == 4) ? data : (static_cast<uint32_t>(globals.usage_page_) << 16) | data;
+                    usage_range = true;
+                    break;
+                case kUsageMaximum:
+                    usage_max = (data_len == 4) ? data : (static_cast<uint32_t>(globals.usage_page_) << 16) | data;
+                    usage_range = true;
+                    break;
+                default:
+                    break;
+                }
+                break;
+
+            default:
+                break;
+            }
+
+            desc += data_len;
+        }
+
+        plan.finalize();
+
+        if (application == Application::kMouse) {
+            const HidReportPlan::Field *x = plan.find(HidReportPlan::Role::kX);
+            const HidReportPlan::Field *y = plan.find(HidReportPlan::Role::kY);
+            return x && y && x->relative_ && y->relative_;
+        }
+
+        return (plan.find(HidReportPlan::Role::kX) && plan.find(HidReportPlan::Role::kY)) ||
+               plan.find(HidReportPlan::Role::kHat);
+    }
+};
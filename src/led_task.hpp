@@ -35,11 +35,13 @@ class LedPatternGenerator : public Runnable {
     static constexpr uint16_t blink_morse_r[] = {50, 250, 200, 250, 50, 50};
     /// 1 short flash
     static constexpr uint16_t blink_1short[] = {50, 10};
+    /// 2 short blinks with long pauses
+    static constexpr uint16_t blink_2short[] = {50, 250, 50, 50};
 
     /// @brief Collection of all blinking patterns
-    std::span<const uint16_t> variants[5] = {
+    std::span<const uint16_t> variants[6] = {
         std::span(blink_2long),  std::span(blink_4short),  std::span(blink_1short),
-        std::span(blink_3short), std::span(blink_morse_r),
+        std::span(blink_3short), std::span(blink_morse_r), std::span(blink_2short),
     };
 
     /// @brief currently selected blinking pattern
@@ -63,6 +65,7 @@ class LedPatternGenerator : public Runnable {
         k1Short,
         k3Short,
         kMorseR,
+        k2Short,
     };
     LedPatternGenerator() {
     }
@@ -107,4 +110,11 @@ class LedPatternGenerator : public Runnable {
             }
         }
     }
+
+    uint32_t next_deadline(uint32_t now) override {
+        if (!active_)
+            return now + kIdlePeriod;
+
+        return deadline_after_ms(now, static_cast<int32_t>(wait_until_ms - board_millis()));
+    }
 };
\ No newline at end of file
@@ -16,9 +16,15 @@
 #include "controller_port.hpp"
 #include "global.hpp"
 #include "hid_api.hpp"
+#include "hid_layout_cache.hpp"
 #include "pico/stdlib.h"
+#include "processors/binary_trace.hpp"
+#include "processors/config_writer.hpp"
+#include "processors/latency_trace.hpp"
 #include "processors/mouse_c1351.hpp"
 #include "processors/pipeline.hpp"
+#include "processors/port_recorder.hpp"
+#include "processors/report_capture.hpp"
 #include "tusb.h"
 #include "utility.h"
 
@@ -28,6 +34,10 @@
 
 PIO C1351Converter::pio_{nullptr};
 uint C1351Converter::offset_{0};
+PIO QuadraturePio::pio_{nullptr};
+uint QuadraturePio::offset_{0};
+PIO SidCycleMonitor::pio_{nullptr};
+uint SidCycleMonitor::offset_{0};
 
 /**
  * @brief global instance of the primary input pipeline
@@ -40,6 +50,145 @@ uint C1351Converter::offset_{0};
  */
 std::optional<Pipeline> gbl_pipeline;
 
+/// Period in milliseconds to poll the user button. Every read of the BOOTSEL button stalls the flash
+static constexpr uint32_t kButtonPollPeriod{10};
+
+/**
+ * @brief Checks if the user button should be polled again
+ *
+ * @return true     \ref kButtonPollPeriod has passed since the last poll
+ */
+static bool button_poll_due() {
+    static uint32_t last_button_poll = 0;
+    uint32_t now = board_millis();
+
+    if ((now - last_button_poll) < kButtonPollPeriod)
+        return false;
+
+    last_button_poll = now;
+    return true;
+}
+
+/**
+ * @brief Checks the user button
+ *
+ * A short press cycles the mouse mode on release.
+ * Holding the button cycles the rate profile of the current mouse mode instead.
+ *
+ * Must be called every \ref kButtonPollPeriod. A new press is only accepted after the
+ * button was released for \ref kReleaseDebounceDuration.
+ */
+static void poll_button() {
+    /// Duration in milliseconds to hold the button to cycle the rate profile on release
+    static constexpr uint32_t kLongPressDuration{1500};
+    /// Duration in milliseconds to hold the button to cycle the acceleration curve
+    static constexpr uint32_t kVeryLongPressDuration{4000};
+    /// Minimum duration in milliseconds of a press. Shorter releases are bouncing
+    static constexpr uint32_t kMinPressDuration{30};
+    /// Duration in milliseconds the button must be released before the next press. Filters bouncing
+    static constexpr uint32_t kReleaseDebounceDuration{100};
+
+    static uint32_t last_pressed_time = 0;
+    static uint32_t last_button_state = 0;
+    static uint32_t press_start_time = 0;
+    static bool long_press_performed = false;
+    bool button_state = board_button_read();
+    uint32_t now = board_millis();
+
+    if (!last_button_state && button_state && (now - last_pressed_time) >= kReleaseDebounceDuration) {
+        press_start_time = now;
+        long_press_performed = false;
+    } else if (last_button_state && button_state && !long_press_performed &&
+               (now - press_start_time) >= kVeryLongPressDuration) {
+        gbl_pipeline->cycle_acceleration_curve();
+        long_press_performed = true;
+    } else if (last_button_state && !button_state && !long_press_performed &&
+               (now - press_start_time) >= kLongPressDuration) {
+        gbl_pipeline->cycle_rate_profile();
+        long_press_performed = true;
+    } else if (last_button_state && !button_state && !long_press_performed &&
+               (now - press_start_time) >= kMinPressDuration) {
+        gbl_pipeline->cycle_mouse_mode();
+        long_press_performed = true;
+    }
+
+    if (button_state)
+        last_pressed_time = now;
+    last_button_state = button_state;
+}
+
+#if CONFIG_REPORT_CAPTURE == 1 || CONFIG_PORT_RECORDER == 1 || CONFIG_LATENCY_TRACE == 1
+/**
+ * @brief Handles commands received via RTT
+ *
+ * 'c' prints all captured reports. 'w' prints the waveform of the controller ports.
+ * 'l' prints the latency histograms.
+ * Must be called by the USB core, as it owns the capture and does all printing.
+ */
+static void poll_rtt_commands() {
+    int command = board_getchar();
+    std::ignore = command;
+
+#if CONFIG_REPORT_CAPTURE == 1
+    if (command == 'c')
+        ReportCapture::instance().dump();
+#endif
+#if CONFIG_PORT_RECORDER == 1
+    // The waveform is owned by the output core, which only provides a copy
+    if (command == 'w')
+        PortWaveform::instance().request_dump();
+    PortWaveform::instance().dump_if_ready();
+#endif
+#if CONFIG_LATENCY_TRACE == 1
+    // The histograms are owned by the output core, which only provides a copy
+    if (command == 'l')
+        LatencyTrace::instance().request_dump();
+    LatencyTrace::instance().dump_if_ready();
+#endif
+}
+#endif
+
+/**
+ * @brief Places a \ref PortRecorder in front of a controller port if enabled
+ *
+ * @param port  Physical controller port
+ * @return std::shared_ptr<ControllerPortInterface> Port to use by the pipeline
+ */
+static std::shared_ptr<ControllerPortInterface> with_recorder(std::shared_ptr<ControllerPortInterface> port) {
+#if CONFIG_PORT_RECORDER == 1
+    return std::make_shared<PortRecorder>(port, PortWaveform::instance());
+#else
+    return port;
+#endif
+}
+
+#if CONFIG_DUAL_CORE == 1
+/**
+ * @brief Main loop of the output core
+ *
+ * Owns the processors of the pipeline and the controller ports.
+ * Will never return.
+ */
+static void core1_main() {
+    multicore_lockout_victim_init();
+
+    for (;;) {
+        gbl_pipeline->run_outputs();
+#if CONFIG_PORT_RECORDER == 1
+        PortWaveform::instance().provide_snapshot();
+#endif
+
+        if (button_poll_due()) {
+            // Reading the BOOTSEL button disables the flash.
+            // Core 0 must not execute from it in the meantime.
+            multicore_lockout_start_blocking();
+            poll_button();
+            multicore_lockout_end_blocking();
+        }
+    }
+}
+#endif
+
 /**
  * @brief First function to call
  *
@@ -48,6 +197,7 @@ std::optional<Pipeline> gbl_pipeline;
  */
 int main() {
     board_init();
+    BinaryTrace::init();
 
     PRINTF("Yaumataca says hello!\n");
 
@@ -55,26 +205,46 @@ int main() {
     tuh_init(BOARD_TUH_RHPORT);
 
     C1351Converter::load_calibration_data();
+    // New HID layouts are stored while the controller ports are quiet
+    ConfigWriter::instance().set_deferred_write(HidLayoutCache::write_pending);
     C1351Converter::setup_pio();
+    QuadraturePio::setup_pio();
+    SidCycleMonitor::setup_pio();
+
+#if CONFIG_DUAL_CORE == 1
+    gbl_pipeline.emplace(with_recorder(LeftControllerPort::getInstance()),
+                         with_recorder(RightControllerPort::getInstance()), true);
 
-    gbl_pipeline.emplace(LeftControllerPort::getInstance(), RightControllerPort::getInstance());
+    // Core 1 might write to flash. Allow it to park us in RAM.
+    multicore_lockout_victim_init();
+    multicore_launch_core1(core1_main);
 
     for (;;) {
         // tinyusb host task
         tuh_task();
         hid_app_task();
-        gbl_pipeline->run();
-
-        static uint32_t button_debounce_cnt = 0;
-        static uint32_t last_button_state = 0;
-        bool button_state = board_button_read();
+        gbl_pipeline->run_inputs();
+#if CONFIG_REPORT_CAPTURE == 1 || CONFIG_PORT_RECORDER == 1 || CONFIG_LATENCY_TRACE == 1
+        poll_rtt_commands();
+#endif
+    }
+#else
+    gbl_pipeline.emplace(with_recorder(LeftControllerPort::getInstance()),
+                         with_recorder(RightControllerPort::getInstance()));
 
-        if (!last_button_state && button_state && button_debounce_cnt == 0) {
-            gbl_pipeline->cycle_mouse_mode();
-            button_debounce_cnt = 100;
-        } else if (button_debounce_cnt > 0 && !button_state) {
-            button_debounce_cnt--;
-        }
-        last_button_state = button_state;
+    for (;;) {
+        // tinyusb host task
+        tuh_task();
+        hid_app_task();
+        gbl_pipeline->run();
+        if (button_poll_due())
+            poll_button();
+#if CONFIG_PORT_RECORDER == 1
+        PortWaveform::instance().provide_snapshot();
+#endif
+#if CONFIG_REPORT_CAPTURE == 1 || CONFIG_PORT_RECORDER == 1 || CONFIG_LATENCY_TRACE == 1
+        poll_rtt_commands();
+#endif
     }
+#endif
 }
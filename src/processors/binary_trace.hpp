@@ -0,0 +1,257 @@
+/**
+ * @file binary_trace.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <tuple>
+
+#include "config.h"
+#include "utility.h"
+
+#if CONFIG_BINARY_TRACE == 1
+#include "SEGGER_RTT.h"
+#endif
+
+/**
+ * @brief All events of the binary trace
+ *
+ * Every entry provides the name and the format the event is printed with.
+ * The number of arguments is derived from the format. Only integer conversions are allowed.
+ * Port states are printed as \ref ControllerPortState::all_buttons.
+ * Bit 0 to 6 are Up, Down, Left, Right, Fire 1, Fire 2 and Fire 3.
+ *
+ * New events must be added at the end, to keep old traces readable.
+ */
+#define BINARY_TRACE_EVENTS(X)                                                                                         \
+    X(Overflow, "Trace overflow, %d records lost")                                                                     \
+    X(RightPort, "R %02x")                                                                                             \
+    X(LeftPort, "L %02x")                                                                                              \
+    X(MouseReport, "Mouse X:%d Y:%d W:%d B:%x")                                                                        \
+    X(MouseDiscard, "Mouse report discarded, %d bytes")                                                                \
+    X(Xbox360Connected, "Xbox360W %d connected")                                                                       \
+    X(Xbox360Disconnected, "Xbox360W %d disconnected")                                                                 \
+    X(Xbox360Report, "Xbox360W %d: buttons %04x LX:%d LY:%d")
+
+/// @brief Identifier of an event of the binary trace
+enum TraceEvent : uint8_t {
+#define BINARY_TRACE_ENUM(name, format) kTrace##name,
+    BINARY_TRACE_EVENTS(BINARY_TRACE_ENUM)
+#undef BINARY_TRACE_ENUM
+        kTraceEvents
+};
+
+/**
+ * @brief Counts the conversions of a format
+ *
+ * @param format    printf style format
+ * @return size_t   Number of arguments the format expects
+ */
+static constexpr size_t count_trace_args(const char *format) {
+    size_t args = 0;
+    for (; *format; format++) {
+        if (*format != '%')
+            continue;
+        if (format[1] == '%')
+            format++;
+        else
+            args++;
+    }
+    return args;
+}
+
+/**
+ * @brief Compact binary log of events in hot paths
+ *
+ * Formatting text with printf takes longer than most of the processing it reports on.
+ * This changes the timing to an extent that debug builds can't reproduce timing
+ * problems. Instead, events are written as binary records which are converted
+ * to text on the host by the trace_decoder.
+ *
+ * A record is one byte of \ref TraceEvent, followed by the time in microseconds and the
+ * arguments. All of them are 32 bit little endian. The records are written to RTT up channel
+ * \ref kChannel. With CONFIG_DUAL_CORE, every core has its own channel, as the ring
+ * buffers of RTT are lock-free with a single writer only.
+ * A record which doesn't fit is skipped completely, so the stream stays aligned.
+ * Lost records are reported by a \ref kTraceOverflow record.
+ *
+ * Without CONFIG_BINARY_TRACE, the events are printed as text instead.
+ */
+class BinaryTrace {
+  public:
+    /// @brief True if binary records are written
+    static constexpr bool kEnabled{CONFIG_BINARY_TRACE == 1};
+
+    /// @brief RTT up channel of the first core. The second core uses the next one
+    static constexpr unsigned kChannel{1};
+
+    /// @brief Size in bytes of the RTT buffer of every core
+    static constexpr size_t kBufferSize{4096};
+
+    /// @brief Maximum number of arguments of an event
+    static constexpr size_t kMaxArgs{4};
+
+    /// @brief Size in bytes of the event and the time stamp
+    static constexpr size_t kHeaderSize{1 + 4};
+
+    /// @brief Size in bytes of the longest record
+    static constexpr size_t kMaxRecord{kHeaderSize + 4 * kMaxArgs};
+
+    /// @brief Format of every event
+    static constexpr std::array<const char *, kTraceEvents> kFormats{
+#define BINARY_TRACE_FORMAT(name, format) format,
+        BINARY_TRACE_EVENTS(BINARY_TRACE_FORMAT)
+#undef BINARY_TRACE_FORMAT
+    };
+
+    /// @brief Number of arguments of every event
+    static constexpr std::array<uint8_t, kTraceEvents> kArgs{
+#define BINARY_TRACE_ARGS(name, format) static_cast<uint8_t>(count_trace_args(format)),
+        BINARY_TRACE_EVENTS(BINARY_TRACE_ARGS)
+#undef BINARY_TRACE_ARGS
+    };
+
+    /// @brief A decoded record
+    struct Record {
+        TraceEvent event{kTraceOverflow};
+        uint32_t time_us{0};
+        std::array<int32_t, kMaxArgs> args{};
+    };
+
+  private:
+#if CONFIG_BINARY_TRACE == 1
+    /// @brief Storage of the RTT channels
+    static inline std::array<std::array<uint8_t, kBufferSize>, CONFIG_DUAL_CORE + 1> buffers_;
+
+    /// @brief Number of records lost since the last overflow record, for every core
+    static inline std::array<uint32_t, CONFIG_DUAL_CORE + 1> lost_{};
+#endif
+
+    static void put32(uint8_t *dest, uint32_t value) {
+        dest[0] = static_cast<uint8_t>(value);
+        dest[1] = static_cast<uint8_t>(value >> 8);
+        dest[2] = static_cast<uint8_t>(value >> 16);
+        dest[3] = static_cast<uint8_t>(value >> 24);
+    }
+
+    static uint32_t get32(const uint8_t *src) {
+        return src[0] | (src[1] << 8) | (src[2] << 16) | (static_cast<uint32_t>(src[3]) << 24);
+    }
+
+  public:
+    /// @brief Configures the RTT channels. Must be called once before the first event
+    static void init() {
+#if CONFIG_BINARY_TRACE == 1
+        for (unsigned core = 0; core < buffers_.size(); core++) {
+            SEGGER_RTT_ConfigUpBuffer(kChannel + core, "Trace", buffers_[core].data(), kBufferSize,
+                                      SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+        }
+#endif
+    }
+
+    /**
+     * @brief Writes an event
+     *
+     * Only writes a few bytes into the RTT buffer. No formatting is performed.
+     *
+     * @tparam kEvent   Event to write
+     * @param args      Arguments of the event. Must match the format
+     */
+    template <TraceEvent kEvent, typename... Args> static void write(Args... args) {
+        static_assert(sizeof...(Args) == kArgs[kEvent], "Arguments don't match the format of the event");
+
+#if CONFIG_BINARY_TRACE == 1
+#if CONFIG_DUAL_CORE == 1
+        const unsigned core = get_core_num();
+#else
+        const unsigned core = 0;
+#endif
+        uint32_t now = board_micros();
+        uint8_t record[kMaxRecord];
+        uint8_t *pos = record;
+
+        if (lost_[core]) {
+            record[0] = kTraceOverflow;
+            put32(&record[1], now);
+            put32(&record[kHeaderSize], lost_[core]);
+            if (SEGGER_RTT_WriteNoLock(kChannel + core, record, kHeaderSize + 4) == 0) {
+                lost_[core]++;
+                return;
+            }
+            lost_[core] = 0;
+        }
+
+        *pos++ = kEvent;
+        put32(pos, now);
+        pos += 4;
+        ((put32(pos, static_cast<uint32_t>(args)), pos += 4), ...);
+
+        if (SEGGER_RTT_WriteNoLock(kChannel + core, record, static_cast<unsigned>(pos - record)) == 0)
+            lost_[core]++;
+#else
+        PRINTF(kFormats[kEvent], static_cast<int32_t>(args)...);
+        PRINTF("\n");
+        ((std::ignore = args), ...);
+#endif
+    }
+
+    /**
+     * @brief Decodes the first record of a trace
+     *
+     * @param data      Binary trace
+     * @param record    Destination of the record
+     * @return size_t   Number of consumed bytes. 0 if the record is incomplete.
+     *                  An unknown event consumes a single byte, with the record set to \ref kTraceEvents
+     */
+    static size_t decode(std::span<const uint8_t> data, Record &record) {
+        if (data.empty())
+            return 0;
+
+        if (data[0] >= kTraceEvents) {
+            record.event = kTraceEvents;
+            return 1;
+        }
+
+        auto event = static_cast<TraceEvent>(data[0]);
+        size_t length = kHeaderSize + 4 * kArgs[event];
+        if (data.size() < length)
+            return 0;
+
+        record.event = event;
+        record.time_us = get32(&data[1]);
+        record.args = {};
+        for (size_t i = 0; i < kArgs[event]; i++)
+            record.args[i] = static_cast<int32_t>(get32(&data[kHeaderSize + 4 * i]));
+
+        return length;
+    }
+
+    /**
+     * @brief Prints a decoded record as text, without time stamp
+     *
+     * @param record    Decoded record with a known event
+     * @param dest      Destination of the text
+     * @param len       Size of the destination
+     */
+    static void format(const Record &record, char *dest, size_t len) {
+        // Unused arguments are ignored by printf
+        snprintf(dest, len, kFormats.at(record.event), record.args[0], record.args[1], record.args[2],
+                 record.args[3]);
+    }
+};
+
+static_assert(*std::max_element(BinaryTrace::kArgs.begin(), BinaryTrace::kArgs.end()) <= BinaryTrace::kMaxArgs,
+              "Event with too many arguments");
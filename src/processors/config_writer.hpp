@@ -0,0 +1,219 @@
+/**
+ * @file config_writer.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "config_store.hpp"
+#include "utility.h"
+
+/**
+ * @brief Defers writes of settings to times without activity on the controller ports
+ *
+ * While the flash is erased or programmed, code can't be fetched from it.
+ * Interrupts are disabled and the other core is parked. Nothing feeds the
+ * PIO during this time, which would drop quadrature steps and C1351 movement.
+ * Settings are therefore only staged in RAM and written by \ref run as soon as
+ * the outputs were quiet for \ref kQuietPeriod. The PIO keeps the last levels
+ * and POT values while the CPU is stalled, which is correct for a resting device.
+ *
+ * Activity is reported by the \ref Pipeline using \ref notify_activity.
+ * Every call of \ref run performs at most a single write. The duration of
+ * every write is measured, as it is the time the outputs are frozen.
+ *
+ * Other users of the flash, like the HID layout cache, provide their writes
+ * with \ref set_deferred_write. They are performed after all settings.
+ */
+class ConfigWriter {
+  public:
+    /// @brief Time in microseconds without activity before the flash is written
+    static constexpr uint32_t kQuietPeriod{2000000};
+
+    /// @brief Statistics about the performed writes
+    struct Stats {
+        /// @brief Number of writes to the flash
+        uint32_t writes_{0};
+        /// @brief Number of writes which have failed
+        uint32_t failed_{0};
+        /// @brief Duration of the last write in microseconds
+        uint32_t last_stall_us_{0};
+        /// @brief Duration of the longest write in microseconds
+        uint32_t max_stall_us_{0};
+    };
+
+  private:
+    static_assert(FlashKvStore::kKeys <= 32, "Pending keys don't fit into the mask");
+
+    /// @brief Destination of all writes
+    FlashKvStore &store_;
+
+    /// @brief Values not yet written to \ref store_
+    std::array<std::vector<uint8_t>, FlashKvStore::kKeys> pending_;
+
+    /// @brief Bit n is set if \ref pending_ contains a value for key n
+    uint32_t pending_keys_{0};
+
+    /// @brief Time in microseconds of the latest activity
+    uint32_t last_activity_us_;
+
+    /// @brief Statistics about the performed writes
+    Stats stats_;
+
+    /// @brief Performs a single write of another user of the flash. Returns true if it has written
+    std::function<bool()> deferred_write_;
+
+    /**
+     * @brief Adds a write to the statistics
+     *
+     * @param start     Time in microseconds when the write has started
+     * @param success   False if the write has failed
+     */
+    void finished(uint32_t start, bool success) {
+        uint32_t stall = board_micros() - start;
+
+        stats_.writes_++;
+        stats_.last_stall_us_ = stall;
+        stats_.max_stall_us_ = std::max(stats_.max_stall_us_, stall);
+        if (!success)
+            stats_.failed_++;
+
+        PRINTF("Flash %s. Outputs stalled for %lu us, longest %lu us\n", success ? "written" : "not written",
+               static_cast<unsigned long>(stall), static_cast<unsigned long>(stats_.max_stall_us_));
+    }
+
+  public:
+    /**
+     * @brief Construct a new Config Writer
+     *
+     * @param store     Destination of all writes. Must outlive this object
+     * @param now_us    Current time in microseconds. Counts as activity
+     */
+    ConfigWriter(FlashKvStore &store, uint32_t now_us) : store_(store), last_activity_us_(now_us) {
+    }
+
+    /// @brief Returns the instance of the firmware. Must only be used by the output core
+    static ConfigWriter &instance() {
+        static ConfigWriter writer(config_store(), board_micros());
+        return writer;
+    }
+
+    /**
+     * @brief Stages a value to be written later
+     *
+     * Doesn't access the flash. A value which is staged again before it was written
+     * is replaced.
+     *
+     * @param key       Key of the setting
+     * @param value     New value of the setting
+     */
+    void stage(size_t key, std::span<const uint8_t> value) {
+        if (key >= FlashKvStore::kKeys)
+            return;
+
+        pending_[key].assign(value.begin(), value.end());
+        pending_keys_ |= 1u << key;
+    }
+
+    /**
+     * @brief Provides the newest value of a setting
+     *
+     * @param key   Key of the setting
+     * @return std::span<const uint8_t> Staged value if there is one, otherwise the stored value
+     */
+    std::span<const uint8_t> get(size_t key) {
+        if (key < FlashKvStore::kKeys && (pending_keys_ & (1u << key)))
+            return pending_[key];
+        return store_.get(key);
+    }
+
+    /**
+     * @brief Registers another user of the flash
+     *
+     * @param deferred_write    Called while the outputs are quiet and no setting is pending.
+     *                          Performs a single write and returns true if it has written
+     */
+    void set_deferred_write(std::function<bool()> deferred_write) {
+        deferred_write_ = deferred_write;
+    }
+
+    /// @brief Returns true if values are waiting to be written
+    bool pending() const {
+        return pending_keys_ != 0;
+    }
+
+    /**
+     * @brief Reports activity on the outputs
+     *
+     * @param time_us   Time of the activity in microseconds. Can be in the future,
+     *                  for steps the PIO performs later on
+     */
+    void notify_activity(uint32_t time_us) {
+        if (static_cast<int32_t>(time_us - last_activity_us_) > 0)
+            last_activity_us_ = time_us;
+    }
+
+    /**
+     * @brief Checks if the outputs are quiet long enough to write
+     *
+     * @param now_us    Current time in microseconds
+     * @return true     No activity since \ref kQuietPeriod
+     */
+    bool quiet(uint32_t now_us) const {
+        return static_cast<int32_t>(now_us - last_activity_us_) >= static_cast<int32_t>(kQuietPeriod);
+    }
+
+    /**
+     * @brief Writes a single staged value or a deferred write if the outputs are quiet
+     *
+     * Must be called frequently by the output core.
+     *
+     * @param now_us    Current time in microseconds
+     * @return true     The flash was written
+     */
+    bool run(uint32_t now_us) {
+        if (!quiet(now_us))
+            return false;
+
+        if (pending_keys_) {
+            size_t key = std::countr_zero(pending_keys_);
+            pending_keys_ &= ~(1u << key);
+
+            PRINTF("Write setting %u\n", static_cast<unsigned>(key));
+            uint32_t start = board_micros();
+            finished(start, store_.write(key, pending_[key]));
+            pending_[key].clear();
+            return true;
+        }
+
+        // Other users only know if they have something to write by trying
+        uint32_t start = board_micros();
+        if (deferred_write_ && deferred_write_()) {
+            finished(start, true);
+            return true;
+        }
+
+        return false;
+    }
+
+    /// @brief Provides statistics about the performed writes
+    const Stats &stats() const {
+        return stats_;
+    }
+};
@@ -0,0 +1,238 @@
+/**
+ * @file deadline_scheduler.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "interfaces.hpp"
+
+/**
+ * @brief Statistics about the dispatching of \ref DeadlineScheduler
+ */
+struct SchedulerStats {
+    /// @brief Number of performed calls to \ref Runnable::run
+    uint32_t dispatches_{0};
+
+    /// @brief Upper bounds in microseconds of the lateness buckets
+    static constexpr std::array<uint32_t, 7> kLatenessBounds{0, 8, 16, 32, 64, 128, 256};
+
+    /// @brief Histogram of microseconds between deadline and actual dispatch.
+    /// Bucket i counts dispatches with lateness <= kLatenessBounds[i].
+    /// The last bucket collects everything above.
+    std::array<uint32_t, kLatenessBounds.size() + 1> lateness_{};
+
+    /**
+     * @brief Adds a single dispatch to the statistics
+     *
+     * @param lateness  microseconds between deadline and dispatch
+     */
+    void record(uint32_t lateness) {
+        dispatches_++;
+
+        size_t bucket = 0;
+        while (bucket < kLatenessBounds.size() && lateness > kLatenessBounds[bucket])
+            bucket++;
+        lateness_[bucket]++;
+    }
+};
+
+/**
+ * @brief Calls implementations of \ref Runnable only when they are due
+ *
+ * Keeps all registered tasks in a binary min-heap ordered by
+ * \ref Runnable::next_deadline. Only the tasks at the top of the heap
+ * are looked at, so the cost of a loop iteration without due tasks is
+ * constant and independent of the number of tasks.
+ *
+ * Deadlines can only be moved to later points by the task itself after
+ * running. If new input arrives which requires earlier attention,
+ * \ref wake must be called.
+ *
+ * @tparam kCapacity    Maximum number of tasks
+ */
+template <size_t kCapacity> class DeadlineScheduler {
+    static_assert(kCapacity <= 32, "Wake mask is limited to 32 tasks");
+
+  private:
+    /// @brief Registered tasks. Index is used as identifier
+    std::array<Runnable *, kCapacity> tasks_{};
+
+    /// @brief Absolute time in microseconds when each task is due
+    std::array<uint32_t, kCapacity> deadline_{};
+
+    /// @brief Min-heap of task identifiers, ordered by deadline
+    std::array<uint8_t, kCapacity> heap_{};
+
+    /// @brief Position of each task inside \ref heap_
+    std::array<uint8_t, kCapacity> position_{};
+
+    /// @brief Number of registered tasks
+    size_t size_{0};
+
+    /// @brief Number of tasks currently inside \ref heap_
+    size_t heap_size_{0};
+
+    /// @brief Bit mask of tasks which shall be dispatched with the next call to \ref dispatch
+    uint32_t woken_{0};
+
+    /// @brief Statistics about performed dispatches
+    SchedulerStats stats_;
+
+    /**
+     * @brief Compares two absolute timestamps while considering the overflow
+     *
+     * @return true if a is before b
+     */
+    static bool before(uint32_t a, uint32_t b) {
+        return static_cast<int32_t>(a - b) < 0;
+    }
+
+    /// @brief Exchanges two entries of the heap and keeps \ref position_ updated
+    void swap_entries(size_t a, size_t b) {
+        std::swap(heap_[a], heap_[b]);
+        position_[heap_[a]] = static_cast<uint8_t>(a);
+        position_[heap_[b]] = static_cast<uint8_t>(b);
+    }
+
+    /// @brief Restores heap property by moving an entry to the top
+    void sift_up(size_t pos) {
+        while (pos > 0) {
+            size_t parent = (pos - 1) / 2;
+            if (!before(deadline_[heap_[pos]], deadline_[heap_[parent]]))
+                break;
+            swap_entries(pos, parent);
+            pos = parent;
+        }
+    }
+
+    /// @brief Restores heap property by moving an entry to the bottom
+    void sift_down(size_t pos) {
+        for (;;) {
+            size_t smallest = pos;
+            size_t left = 2 * pos + 1;
+            size_t right = left + 1;
+
+            if (left < heap_size_ && before(deadline_[heap_[left]], deadline_[heap_[smallest]]))
+                smallest = left;
+            if (right < heap_size_ && before(deadline_[heap_[right]], deadline_[heap_[smallest]]))
+                smallest = right;
+            if (smallest == pos)
+                break;
+            swap_entries(pos, smallest);
+            pos = smallest;
+        }
+    }
+
+  public:
+    /// @brief Identifier returned by \ref add if the scheduler is full
+    static constexpr size_t kInvalidId{kCapacity};
+
+    /**
+     * @brief Registers a task. It is dispatched with the next call to \ref dispatch
+     *
+     * @param task  Task to register. Must outlive the scheduler
+     * @return size_t Identifier to use with \ref wake or \ref kInvalidId if all kCapacity tasks are registered
+     */
+    size_t add(Runnable *task) {
+        if (size_ >= kCapacity)
+            return kInvalidId;
+
+        size_t id = size_;
+        tasks_[id] = task;
+        deadline_[id] = 0;
+        heap_[heap_size_] = static_cast<uint8_t>(id);
+        position_[id] = static_cast<uint8_t>(heap_size_);
+        sift_up(heap_size_);
+        size_++;
+        heap_size_++;
+        woken_ |= 1u << id;
+        return id;
+    }
+
+    /**
+     * @brief Requests a task to be dispatched with the next call to \ref dispatch
+     *
+     * Must be called if new input has arrived which might move the deadline
+     * of a task to an earlier point.
+     *
+     * @param id    Identifier as returned by \ref add. Unknown identifiers are ignored
+     */
+    void wake(size_t id) {
+        if (id < size_)
+            woken_ |= 1u << id;
+    }
+
+    /// @brief Requests all tasks to be dispatched with the next call to \ref dispatch
+    void wake_all() {
+        woken_ = (size_ >= 32) ? ~0u : ((1u << size_) - 1);
+    }
+
+    /**
+     * @brief Runs all tasks whose deadline has been reached
+     *
+     * Every task is run at most once per call.
+     *
+     * @param now   Current time in microseconds
+     * @return size_t Number of dispatched tasks
+     */
+    size_t dispatch(uint32_t now) {
+        // Move all woken tasks to the top
+        while (woken_) {
+            size_t id = __builtin_ctz(woken_);
+            woken_ &= woken_ - 1;
+            deadline_[id] = now;
+            // An overdue deadline is moved to a later point
+            sift_up(position_[id]);
+            sift_down(position_[id]);
+        }
+
+        // Collect due tasks first, as tasks might be due again right after running
+        std::array<uint8_t, kCapacity> due;
+        size_t due_cnt = 0;
+
+        while (heap_size_ > 0 && !before(now, deadline_[heap_[0]])) {
+            uint8_t id = heap_[0];
+            due[due_cnt++] = id;
+            stats_.record(now - deadline_[id]);
+
+            // Remove from heap until it has reported its new deadline
+            heap_size_--;
+            swap_entries(0, heap_size_);
+            sift_down(0);
+        }
+
+        for (size_t i = 0; i < due_cnt; i++) {
+            uint8_t id = due[i];
+            tasks_[id]->run();
+            deadline_[id] = tasks_[id]->next_deadline(now);
+
+            heap_[heap_size_] = id;
+            position_[id] = static_cast<uint8_t>(heap_size_);
+            sift_up(heap_size_);
+            heap_size_++;
+        }
+
+        return due_cnt;
+    }
+
+    /// @brief Returns the absolute time in microseconds when the next task is due
+    uint32_t next_deadline() {
+        return deadline_[heap_[0]];
+    }
+
+    /// @brief Provides statistics about performed dispatches
+    const SchedulerStats &stats() {
+        return stats_;
+    }
+};
@@ -0,0 +1,174 @@
+/**
+ * @file dpi_scaler.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+#include "config.h"
+#include "interfaces.hpp"
+
+/**
+ * @brief Scales the movement of a mouse to a common resolution
+ *
+ * High resolution mice report many counts per inch. Without scaling, a small
+ * movement of the hand would result in a long way for the pointer on the target
+ * machine and would occupy the quadrature output for a long time.
+ * The movement is multiplied with a fixed point factor. The fractional part
+ * is carried over to the next report, so no movement is lost.
+ *
+ * Mice with a lower resolution than CONFIG_MOUSE_RESOLUTION_CPI are not
+ * scaled up, as this would only create larger steps.
+ * Most mice don't describe their resolution. Their movement is divided by
+ * CONFIG_MOUSE_DEFAULT_DIVISOR instead.
+ * The wheel is never scaled as it reports detents.
+ */
+class DpiScaler {
+  private:
+    /// @brief Number of fractional bits of \ref factor_
+    static constexpr int kFractionBits{24};
+
+    /// @brief Fixed point representation of 1.0
+    static constexpr int32_t kOne{1 << kFractionBits};
+
+    /// @brief Scaling factor as fixed point value with \ref kFractionBits
+    int32_t factor_{kOne};
+
+    /// @brief Fractional horizontal movement still to output
+    int32_t remainder_x_{0};
+
+    /// @brief Fractional vertical movement still to output
+    int32_t remainder_y_{0};
+
+    /**
+     * @brief Scales a single axis
+     *
+     * Rounds towards zero, so both directions behave the same.
+     *
+     * @param value     Movement as reported by the mouse
+     * @param remainder Fractional movement of the previous call. Updated
+     * @return int16_t  Movement in target resolution
+     */
+    int16_t scale_axis(int32_t value, int32_t &remainder) {
+        int64_t product = static_cast<int64_t>(value) * factor_ + remainder;
+        int64_t result = product / kOne;
+        remainder = static_cast<int32_t>(product - result * kOne);
+
+        if (result > std::numeric_limits<int16_t>::max())
+            return std::numeric_limits<int16_t>::max();
+        else if (result < std::numeric_limits<int16_t>::min())
+            return std::numeric_limits<int16_t>::min();
+
+        return static_cast<int16_t>(result);
+    }
+
+  public:
+    /// @brief Resolution in counts per inch all mice are scaled to
+    static constexpr uint32_t kTargetResolution{CONFIG_MOUSE_RESOLUTION_CPI};
+
+    /// @brief Divisor of the movement if the resolution of the mouse is unknown
+    static constexpr uint32_t kDefaultDivisor{CONFIG_MOUSE_DEFAULT_DIVISOR};
+
+    static_assert(kDefaultDivisor >= 1, "CONFIG_MOUSE_DEFAULT_DIVISOR must be at least 1");
+
+    /**
+     * @brief Calculates the resolution of an axis as described in the HID report descriptor
+     *
+     * Follows chapter 6.2.2.7 of USB HID 1.11.
+     * Resolution = (Logical Max - Logical Min) / ((Physical Max - Physical Min) * 10 ^ Unit Exponent)
+     *
+     * @param logical_min   Logical Minimum of the axis
+     * @param logical_max   Logical Maximum of the axis
+     * @param physical_min  Physical Minimum of the axis
+     * @param physical_max  Physical Maximum of the axis
+     * @param unit          Unit of the axis. Must be a linear length in inch or centimeter
+     * @param unit_exponent Unit Exponent of the axis. Only the lower 4 bit are used
+     * @return uint32_t     Counts per inch or 0 if unknown
+     */
+    static constexpr uint32_t resolution_from_descriptor(int32_t logical_min, int32_t logical_max,
+                                                         int32_t physical_min, int32_t physical_max, uint32_t unit,
+                                                         int32_t unit_exponent) {
+        constexpr uint32_t kUnitCentimeter{0x11};
+        constexpr uint32_t kUnitInch{0x13};
+
+        // Without physical extents, both are equal to the logical extents
+        // and the resolution is not known.
+        if (physical_min == 0 && physical_max == 0)
+            return 0;
+
+        if (unit != kUnitCentimeter && unit != kUnitInch)
+            return 0;
+
+        int64_t counts = static_cast<int64_t>(logical_max) - logical_min;
+        int64_t distance = static_cast<int64_t>(physical_max) - physical_min;
+
+        if (counts <= 0 || distance <= 0)
+            return 0;
+
+        // The exponent is a signed nibble
+        unit_exponent &= 0xf;
+        if (unit_exponent & 0x8)
+            unit_exponent -= 16;
+
+        for (; unit_exponent < 0; unit_exponent++)
+            counts *= 10;
+        for (; unit_exponent > 0; unit_exponent--)
+            distance *= 10;
+
+        if (unit == kUnitCentimeter) {
+            counts *= 254;
+            distance *= 100;
+        }
+
+        int64_t resolution = counts / distance;
+        if (resolution > std::numeric_limits<int32_t>::max())
+            return std::numeric_limits<int32_t>::max();
+
+        return static_cast<uint32_t>(resolution);
+    }
+
+    /**
+     * @brief Sets the resolution of the mouse
+     *
+     * @param counts_per_inch   Resolution of the mouse. 0 if unknown, which divides by \ref kDefaultDivisor
+     */
+    void set_resolution(uint32_t counts_per_inch) {
+        remainder_x_ = 0;
+        remainder_y_ = 0;
+
+        if (counts_per_inch == 0)
+            counts_per_inch = kTargetResolution * kDefaultDivisor;
+
+        if (counts_per_inch <= kTargetResolution)
+            factor_ = kOne;
+        else
+            factor_ = static_cast<int32_t>(
+                ((static_cast<uint64_t>(kTargetResolution) << kFractionBits) + counts_per_inch / 2) / counts_per_inch);
+    }
+
+    /// @brief Returns true if the movement is modified
+    bool active() {
+        return factor_ != kOne;
+    }
+
+    /**
+     * @brief Fills the movement of a report
+     *
+     * @param report    Report to fill. The wheel is not modified
+     * @param x         Horizontal movement as reported by the mouse
+     * @param y         Vertical movement as reported by the mouse
+     */
+    void scale(MouseReport &report, int32_t x, int32_t y) {
+        report.relx = scale_axis(x, remainder_x_);
+        report.rely = scale_axis(y, remainder_y_);
+    }
+};
@@ -161,11 +161,24 @@ class GamePadFeatures : public RunnableGamepadReportProcessor {
         out_state_.down = in_state_.down;
         out_state_.left = in_state_.left;
         out_state_.right = in_state_.right;
+        out_state_.arrival_us = in_state_.arrival_us;
 
         if (target_ && last_out_state_ != out_state_) {
             last_out_state_ = out_state_;
             target_->set_port_state(out_state_);
         }
+
+        // Later changes like auto fire are not caused by the report
+        in_state_.arrival_us = 0;
+    }
+
+    uint32_t next_deadline(uint32_t now) override {
+        // Only auto fire and the swap detection depend on time.
+        // Everything else only changes with new reports.
+        if (!in_state_.auto_fire && !in_state_.joystick_swap)
+            return now + kIdlePeriod;
+
+        return deadline_after_ms(now, static_cast<int32_t>(last_update + auto_fire_period_ + 1 - board_millis()));
     }
 
     /// @brief Activates Final Cart III hack
@@ -15,6 +15,7 @@
 #include <cstdint>
 #include <memory>
 #include <span>
+#include <tuple>
 
 #include "pico/types.h"
 
@@ -24,7 +25,8 @@ enum ReportType { kMouse, kGamePad };
 /**
  * @brief Reduction of a Mouse HID Report to the required essentials.
  *
- * This format is also the typical expected one for Boot mode
+ * Movement is kept with 16 bit as high resolution mice
+ * easily exceed the range of the 8 bit Boot mode report.
  */
 class MouseReport {
   public:
@@ -37,9 +39,11 @@ class MouseReport {
         };
         uint8_t button_pressed{0};
     };
-    int8_t relx{0};  ///< relative x movement
-    int8_t rely{0};  ///< relative y movement
-    int8_t wheel{0}; ///< relative wheel movement
+    int16_t relx{0};  ///< relative x movement
+    int16_t rely{0};  ///< relative y movement
+    int16_t wheel{0}; ///< relative wheel movement
+
+    uint32_t arrival_us{0}; ///< Time in microseconds the USB report has arrived. 0 if unknown
 };
 
 /**
@@ -64,6 +68,8 @@ class GamepadReport {
         uint32_t button_pressed{0};
     };
 
+    uint32_t arrival_us{0}; ///< Time in microseconds the USB report has arrived. 0 if unknown
+
     /**
      * @brief Helper function to fill directional data via "coolie hat" value
      *
@@ -98,6 +104,13 @@ struct ControllerPortState {
         };
         uint8_t all_buttons{0};
     };
+
+    /// Time in microseconds the report reflected by this state has arrived. 0 if unknown.
+    /// Not considered for comparison
+    uint32_t arrival_us{0};
+
+    /// Type of the report reflected by this state
+    ReportType source{kGamePad};
 };
 
 /**
@@ -118,10 +131,64 @@ inline bool operator==(const ControllerPortState &lhs, const ControllerPortState
 class Runnable {
   public:
     /**
-     * @brief Expected to be executed whenever possible.
+     * @brief Maximum time in microseconds a \ref Runnable without pending work
+     * has to wait until it is called again.
+     */
+    static constexpr uint32_t kIdlePeriod{100000};
+
+    /**
+     * @brief Expected to be executed whenever due.
      * Time keeping is performed inside.
      */
     virtual void run() = 0;
+
+    /**
+     * @brief Provides the point in time when \ref run must be called next
+     *
+     * Queried after every call to \ref run. If new input arrives which requires
+     * earlier attention, the caller must be informed about it.
+     * The default implementation requests to be called all the time.
+     *
+     * @param now   Current time in microseconds
+     * @return uint32_t Absolute time in microseconds
+     */
+    virtual uint32_t next_deadline(uint32_t now) {
+        return now;
+    }
+
+  protected:
+    /**
+     * @brief Converts remaining milliseconds into an absolute deadline
+     *
+     * @param now           Current time in microseconds
+     * @param remaining_ms  Milliseconds until due. Might be negative if overdue.
+     * @return uint32_t Absolute time in microseconds
+     */
+    static uint32_t deadline_after_ms(uint32_t now, int32_t remaining_ms) {
+        return remaining_ms > 0 ? now + static_cast<uint32_t>(remaining_ms) * 1000 : now;
+    }
+
+    /**
+     * @brief Returns the earlier of two deadlines while considering the overflow
+     *
+     * @param a     Absolute time in microseconds
+     * @param b     Absolute time in microseconds
+     * @return uint32_t The earlier one
+     */
+    static uint32_t earliest_deadline(uint32_t a, uint32_t b) {
+        return static_cast<int32_t>(a - b) < 0 ? a : b;
+    }
+
+    /**
+     * @brief Limits a deadline derived from an old timestamp to the present
+     *
+     * @param now       Current time in microseconds
+     * @param deadline  Absolute time in microseconds
+     * @return uint32_t The deadline or now if it is already over
+     */
+    static uint32_t deadline_not_before(uint32_t now, uint32_t deadline) {
+        return static_cast<int32_t>(deadline - now) < 0 ? now : deadline;
+    }
 };
 
 class ReportHubInterface;
@@ -155,8 +222,14 @@ class HidHandlerInterface : public ReportSourceInterface {
      * @brief Called after readout of the HID Report Descriptor
      *
      * Allows detection of the HID Report layout
+     *
+     * @param vid           Vendor ID of the device
+     * @param pid           Product ID of the device
+     * @param desc_report   HID Report Descriptor
+     * @param desc_len      Length of the descriptor in bytes
      */
-    virtual void parse_hid_report_descriptor(uint8_t const *desc_report, uint16_t desc_len) = 0;
+    virtual void parse_hid_report_descriptor(uint16_t vid, uint16_t pid, uint8_t const *desc_report,
+                                             uint16_t desc_len) = 0;
 
     /**
      * @brief Called after the detection of a HID endpoint
@@ -305,4 +378,43 @@ class ControllerPortInterface {
      * @return const size_t index
      */
     virtual size_t get_index() = 0;
+
+    /**
+     * @brief Converts a state into the levels of the output GPIOs
+     *
+     * @param state State to convert
+     * @return uint32_t Bit mask with one bit per RP2040 GPIO, set for active signals
+     */
+    virtual uint32_t get_gpio_mask(const ControllerPortState &state) = 0;
+
+    /**
+     * @brief Returns the lowest GPIO number of the directional signals.
+     * All 4 directions are inside a range of 6 GPIOs starting here.
+     * Used to drive them as a group using PIO.
+     *
+     * @return uint RP2040 GPIO Number
+     */
+    virtual uint get_direction_gpio_base() = 0;
+
+    /**
+     * @brief Informs that the directional signals are driven by the PIO instead of \ref set_port_state
+     * Only of interest for recording the signals. Ignored by default.
+     *
+     * @param active    True if the PIO drives the directional signals from now on
+     */
+    virtual void directions_driven_by_pio(bool active) {
+        std::ignore = active;
+    }
+
+    /**
+     * @brief Informs about a step which was queued to the PIO
+     * Only of interest for recording the signals. Ignored by default.
+     *
+     * @param state     State of the directional signals during the step
+     * @param time_us   Time in microseconds the PIO is expected to perform the step
+     */
+    virtual void pio_step_queued(const ControllerPortState &state, uint32_t time_us) {
+        std::ignore = state;
+        std::ignore = time_us;
+    }
 };
\ No newline at end of file
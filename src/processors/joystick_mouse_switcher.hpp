@@ -11,10 +11,17 @@
 #pragma once
 
 #include "interfaces.hpp"
+#include "mouse_delta_accumulator.hpp"
+#include "utility.h"
+#include <functional>
 
 /**
  * @brief Detects mouse and joystick handling and changes the data source.
  * Supports one mouse source and one joystick source with one destination.
+ *
+ * Mouse movement is summed and forwarded at most once per \ref MouseDeltaAccumulator::kDrainPeriod,
+ * so the cost of the following stages doesn't depend on the polling rate of the mouse.
+ * Changes of the buttons are forwarded immediately.
  */
 class JoystickMouseSwitcher : public ReportHubInterface {
   private:
@@ -34,6 +41,40 @@ class JoystickMouseSwitcher : public ReportHubInterface {
     /// @brief Used to keep track if my joystick source exists
     std::weak_ptr<ReportSourceInterface> joystick_source_;
 
+    /// @brief Called after every report to reevaluate \ref next_deadline
+    std::function<void()> wake_callback_;
+
+    /// @brief Movement not yet forwarded to \ref mouse_target_
+    MouseDeltaAccumulator mouse_delta_;
+
+    /// @brief Button state of the last report forwarded to \ref mouse_target_
+    uint8_t forwarded_buttons_{0};
+
+    /**
+     * @brief Forwards a report to \ref mouse_target_
+     *
+     * @param report    Report to forward
+     */
+    void forward_mouse_report(MouseReport &report) {
+        forwarded_buttons_ = report.button_pressed;
+        mouse_target_->process_mouse_report(report);
+        other_gamepad_target_->final_cart_hack();
+    }
+
+    /**
+     * @brief Forwards all pending movement with the current button state
+     *
+     * @param now   Current time in microseconds
+     */
+    void drain_mouse_delta(uint32_t now) {
+        while (mouse_delta_.pending()) {
+            MouseReport report;
+            report.button_pressed = forwarded_buttons_;
+            mouse_delta_.drain(report, now);
+            forward_mouse_report(report);
+        }
+    }
+
   public:
     /**
      * @brief Construct a new Joystick Mouse Switcher
@@ -57,6 +98,23 @@ class JoystickMouseSwitcher : public ReportHubInterface {
     /// Used to activate the FC3 hack on the other port
     std::shared_ptr<GamePadFeatures> other_gamepad_target_;
 
+    /**
+     * @brief Registers callback handler for incoming reports
+     *
+     * Called after every processed report, as the deadline of the
+     * targets might have moved.
+     *
+     * @param wake_callback function pointer or lambda
+     */
+    void set_wake_callback(std::function<void()> wake_callback) {
+        wake_callback_ = wake_callback;
+    }
+
+    /// @brief Returns the type of source which currently drives the port
+    ReportType active() const {
+        return active_;
+    }
+
     /// @brief Returns true if no mouse source is registered
     bool mouse_source_empty() {
         return mouse_source_.expired();
@@ -106,11 +164,15 @@ class JoystickMouseSwitcher : public ReportHubInterface {
         if (report.button_pressed && active_ != kGamePad) {
             PRINTF("Switched to gamepad\n");
             active_ = kGamePad;
+            mouse_delta_.clear();
             gamepad_target_->ensure_joystick_muxing();
         }
         if (gamepad_target_ && active_ == kGamePad) {
             gamepad_target_->process_gamepad_report(report);
         }
+
+        if (wake_callback_)
+            wake_callback_();
     }
 
     void process_mouse_report(MouseReport &report) override {
@@ -123,19 +185,51 @@ class JoystickMouseSwitcher : public ReportHubInterface {
             mouse_target_->ensure_mouse_muxing();
         }
         if (mouse_target_ && active_ == kMouse) {
-            mouse_target_->process_mouse_report(report);
-            other_gamepad_target_->final_cart_hack();
+            uint32_t now = board_micros();
+            if (report.button_pressed != forwarded_buttons_) {
+                // Keep the order of movement and button changes
+                drain_mouse_delta(now);
+                forward_mouse_report(report);
+            } else {
+                bool first = mouse_delta_.add(report, now);
+                if (mouse_delta_.ready(now)) {
+                    // Nothing was forwarded recently. Don't wait
+                    drain_mouse_delta(now);
+                } else if (!first) {
+                    // Movement is already pending. The deadline doesn't change
+                    return;
+                }
+            }
         }
+
+        if (wake_callback_)
+            wake_callback_();
     }
 
     void run() override {
         if (mouse_target_ && active_ == kMouse) {
+            uint32_t now = board_micros();
+            if (mouse_delta_.ready(now))
+                drain_mouse_delta(now);
             mouse_target_->run();
         } else if (gamepad_target_ && active_ == kGamePad) {
             gamepad_target_->run();
         }
     }
 
+    uint32_t next_deadline(uint32_t now) override {
+        if (mouse_target_ && active_ == kMouse) {
+            uint32_t deadline = mouse_target_->next_deadline(now);
+            if (mouse_delta_.pending())
+                deadline = earliest_deadline(deadline, deadline_not_before(now, mouse_delta_.due()));
+            return deadline;
+        } else if (gamepad_target_ && active_ == kGamePad) {
+            return gamepad_target_->next_deadline(now);
+        }
+
+        return now + kIdlePeriod;
+    }
+
     void ensure_mouse_muxing() override {
         if (mouse_target_ && active_ == kMouse)
             mouse_target_->ensure_mouse_muxing();
@@ -0,0 +1,262 @@
+/**
+ * @file latency_trace.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "config.h"
+#include "interfaces.hpp"
+#include "utility.h"
+
+/**
+ * @brief Distribution of the latency between a USB report and the controller port
+ */
+struct LatencyHistogram {
+    /// @brief Upper bounds in microseconds of the buckets
+    static constexpr std::array<uint32_t, 9> kBounds{125, 250, 500, 1000, 2000, 4000, 8000, 16000, 32000};
+
+    /// @brief Bucket i counts latencies <= kBounds[i]. The last bucket collects everything above
+    std::array<uint32_t, kBounds.size() + 1> buckets_{};
+
+    /// @brief Number of recorded latencies
+    uint32_t count_{0};
+
+    /// @brief Highest recorded latency in microseconds
+    uint32_t max_us_{0};
+
+    /// @brief Sum of all recorded latencies in microseconds
+    uint64_t sum_us_{0};
+
+    /**
+     * @brief Adds a single latency
+     *
+     * @param latency_us    Time in microseconds
+     */
+    void record(uint32_t latency_us) {
+        size_t bucket = 0;
+        while (bucket < kBounds.size() && latency_us > kBounds[bucket])
+            bucket++;
+
+        buckets_[bucket]++;
+        count_++;
+        sum_us_ += latency_us;
+        max_us_ = std::max(max_us_, latency_us);
+    }
+
+    /// @brief Returns the average latency in microseconds
+    uint32_t mean_us() const {
+        return count_ ? static_cast<uint32_t>(sum_us_ / count_) : 0;
+    }
+};
+
+/**
+ * @brief Measures the time from the arrival of a USB report until the controller port reflects it
+ *
+ * Every report is stamped with \ref arrival when it is created by its handler.
+ * The stamp is carried through the pipeline by \ref MouseReport, \ref GamepadReport
+ * and \ref ControllerPortState. When the output first changes because of a report,
+ * the latency is recorded in a histogram of the port and the type of the source.
+ * Later output of the same report is ignored.
+ *
+ * Only active with CONFIG_LATENCY_TRACE. All reports are stamped with 0 otherwise,
+ * which is never recorded.
+ *
+ * The histograms are owned by the output core. To print them, the USB core calls
+ * \ref request_dump. The output core only copies the histograms in \ref provide_snapshot
+ * and the USB core prints the copy with \ref dump_if_ready.
+ */
+class LatencyTrace {
+  private:
+    /// @brief Number of controller ports
+    static constexpr size_t kPorts{2};
+
+    /// @brief Number of report types
+    static constexpr size_t kSources{2};
+
+    /// @brief Histogram for every port and source
+    using Histograms = std::array<std::array<LatencyHistogram, kSources>, kPorts>;
+
+    /// @brief Time in microseconds the report currently processed by the USB core has arrived
+    static inline uint32_t current_arrival_us_{0};
+
+    /// @brief Histogram for every port and source
+    Histograms histograms_{};
+
+    /// @brief Most recent arrival time which was recorded for every port and source
+    std::array<std::array<uint32_t, kSources>, kPorts> last_arrival_us_{};
+
+    /// @brief Copy of \ref histograms_ for the USB core
+    Histograms snapshot_{};
+
+    /// @brief Set by the USB core to have the output core fill \ref snapshot_
+    std::atomic<bool> snapshot_requested_{false};
+
+    /// @brief Set by the output core when \ref snapshot_ can be printed
+    std::atomic<bool> snapshot_ready_{false};
+
+    /**
+     * @brief Prints histograms
+     *
+     * Uses printf instead of PRINTF, as CONFIG_LATENCY_TRACE selects the RTT logger on its own.
+     *
+     * @param histograms    Histograms to print
+     */
+    static void print(const Histograms &histograms) {
+        static constexpr std::array<const char *, kSources> kSourceNames{"Mouse", "Gamepad"};
+
+        for (size_t port = 0; port < kPorts; port++) {
+            for (size_t source = 0; source < kSources; source++) {
+                const LatencyHistogram &h = histograms[port][source];
+                if (h.count_ == 0)
+                    continue;
+
+                printf("Latency port %zu %s: %lu reports, mean %lu us, max %lu us\n", port, kSourceNames[source],
+                       static_cast<unsigned long>(h.count_), static_cast<unsigned long>(h.mean_us()),
+                       static_cast<unsigned long>(h.max_us_));
+                for (size_t i = 0; i < h.buckets_.size(); i++) {
+                    if (i < LatencyHistogram::kBounds.size())
+                        printf("  <=%5lu us: %lu\n", static_cast<unsigned long>(LatencyHistogram::kBounds[i]),
+                               static_cast<unsigned long>(h.buckets_[i]));
+                    else
+                        printf("  > %5lu us: %lu\n", static_cast<unsigned long>(LatencyHistogram::kBounds.back()),
+                               static_cast<unsigned long>(h.buckets_[i]));
+                }
+            }
+        }
+    }
+
+  public:
+    /// @brief True if latencies are measured
+    static constexpr bool kEnabled{CONFIG_LATENCY_TRACE == 1};
+
+    /// @brief Returns the single instance. Latencies must only be recorded by the output core
+    static LatencyTrace &instance() {
+        static LatencyTrace trace;
+        return trace;
+    }
+
+    /**
+     * @brief Marks the arrival of a USB report
+     *
+     * Must be called by the USB core before the report is handed to its handler.
+     */
+    static void mark_arrival() {
+        if constexpr (kEnabled) {
+            // 0 is reserved for unknown
+            current_arrival_us_ = std::max<uint32_t>(board_micros(), 1);
+        }
+    }
+
+    /// @brief Provides the time stamp for reports created from the current USB report
+    static uint32_t arrival() {
+        return current_arrival_us_;
+    }
+
+    /**
+     * @brief Records the latency of a report if it was not yet recorded
+     *
+     * @param port          Index of the controller port
+     * @param source        Type of the report
+     * @param arrival_us    Time stamp of the report. 0 is ignored
+     * @param now           Current time in microseconds
+     */
+    void record(size_t port, ReportType source, uint32_t arrival_us, uint32_t now) {
+        if constexpr (!kEnabled)
+            return;
+
+        if (arrival_us == 0 || port >= kPorts)
+            return;
+
+        uint32_t &last = last_arrival_us_[port][source];
+
+        // Already recorded or older than a recorded report
+        if (last != 0 && static_cast<int32_t>(arrival_us - last) <= 0)
+            return;
+
+        last = arrival_us;
+        histograms_[port][source].record(now - arrival_us);
+    }
+
+    /**
+     * @brief Records the latency of a port state
+     *
+     * @param port      Index of the controller port
+     * @param state     State which is applied to the port
+     */
+    void record(size_t port, const ControllerPortState &state) {
+        record(port, state.source, state.arrival_us, board_micros());
+    }
+
+    /**
+     * @brief Provides the histogram of a port and source
+     *
+     * @param port      Index of the controller port
+     * @param source    Type of the report
+     */
+    const LatencyHistogram &histogram(size_t port, ReportType source) {
+        return histograms_.at(port).at(source);
+    }
+
+    /// @brief Removes all recorded latencies
+    void reset() {
+        histograms_ = {};
+        last_arrival_us_ = {};
+    }
+
+    /// @brief Prints all histograms. Only for single threaded use, like the replay on the host
+    void dump() {
+        print(histograms_);
+    }
+
+    /// @brief Asks the output core to provide a copy of the histograms. Must be called by the USB core
+    void request_dump() {
+        snapshot_requested_.store(true, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Copies the histograms if requested
+     *
+     * Must be called frequently by the output core. Doesn't print, to keep the outputs running.
+     */
+    void provide_snapshot() {
+        if (!snapshot_requested_.exchange(false, std::memory_order_relaxed))
+            return;
+
+        // The USB core might still print the previous copy
+        if (snapshot_ready_.load(std::memory_order_acquire))
+            return;
+
+        snapshot_ = histograms_;
+        snapshot_ready_.store(true, std::memory_order_release);
+    }
+
+    /**
+     * @brief Prints the copy of the histograms if the output core has provided one
+     *
+     * Must be called frequently by the USB core.
+     *
+     * @return true     The histograms were printed
+     */
+    bool dump_if_ready() {
+        if (!snapshot_ready_.load(std::memory_order_acquire))
+            return false;
+
+        print(snapshot_);
+        snapshot_ready_.store(false, std::memory_order_release);
+        return true;
+    }
+};
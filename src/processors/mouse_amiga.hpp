@@ -11,6 +11,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+
 #include "config.h"
 #include "mouse_quadrature.hpp"
 #include "processors/interfaces.hpp"
@@ -32,49 +35,80 @@ class AmigaMouse : public QuadratureMouse {
     /// last state to check for changes
     ControllerPortState last_wheel_state_;
 
-  public:
-    AmigaMouse() {
-        PRINTF("AmigaMouse +\n");
-    }
-    virtual ~AmigaMouse() {
-        PRINTF("AmigaMouse -\n");
+    void step_movement(ControllerPortState &state) override {
+        auto h_state = h.update();
+        auto v_state = v.update();
+
+        // Vertical movement
+        state.up = v_state.second;
+        state.left = v_state.first;
+
+        // Horizontal movement
+        state.right = h_state.first;
+        state.down = h_state.second;
     }
 
+  public:
     /**
-     * @brief Update period
+     * @brief Shortest time in microseconds between two steps which was verified on hardware
+     *
      * Tested in Amiga workbench on A1200
      * with permament maximum speed over seconds.
      * Period of 359 us is too fast. 532 us too.
      * 170 will lead to a period of 704 us, which is ok. No glitches.
      */
-    static constexpr uint32_t kUpdatePeriod = 170;
+    static constexpr uint32_t kVerifiedPeriod{170};
+
+    /**
+     * @brief Supported rate profiles
+     *
+     * The Amiga reads its 8 bit mouse counters once per frame. More than 127
+     * steps per frame can't be distinguished from moving backwards.
+     *
+     * Faster steps than \ref kVerifiedPeriod were not verified on hardware.
+     * The Amiga therefore keeps this fixed rate, which stays below 127 steps
+     * per frame for PAL and NTSC alike. No profile is selectable.
+     * The shorter NTSC frame is used as frame period.
+     */
+    static constexpr std::array<QuadratureRateProfile, 1> kRateProfiles{{
+        {"Amiga", kVerifiedPeriod, kVerifiedPeriod, 16683},
+    }};
+
+    static_assert(std::all_of(kRateProfiles.begin(), kRateProfiles.end(), fits_max_latency),
+                  "CONFIG_MAX_OUTPUT_LATENCY_MS is too small for the queued steps");
+
+    /**
+     * @brief Construct a new Amiga Mouse
+     *
+     * @param profile   Index in \ref kRateProfiles
+     */
+    AmigaMouse(size_t profile = 0) : QuadratureMouse(kRateProfiles.at(profile)) {
+        PRINTF("AmigaMouse +\n");
+    }
+    virtual ~AmigaMouse() {
+        PRINTF("AmigaMouse -\n");
+    }
 
     void run() override {
+        bool pio_driven = feed_pio();
+
         uint32_t now = board_micros();
         uint32_t time_diff = now - last_update;
 
-        if (time_diff >= kUpdatePeriod) {
+        if (time_diff >= update_period_) {
             last_update = now;
-            auto h_state = h.update();
-            auto v_state = v.update();
-            auto wheel_state = wheel.update();
-
-            // Vertical movement
-            state_.up = v_state.second;
-            state_.left = v_state.first;
 
-            // Horizontal movement
-            state_.right = h_state.first;
-            state_.down = h_state.second;
+            if (!pio_driven) {
+                step_movement(state_);
+                adapt_period();
+            }
 
             // Wheel movement (non standard)
+            auto wheel_state = wheel.update();
             wheel_state_.up = wheel_state.second;
             wheel_state_.left = wheel_state.first;
 
-            if (mouse_target_ && last_state_ != state_) {
-                last_state_ = state_;
-                mouse_target_->set_port_state(state_);
-            }
+            apply_state();
 
 #if CONFIG_DISABLE_AMIGA_WHEELBUSMOUSE == 0
             if (wheel_target_ && last_wheel_state_ != wheel_state_) {
@@ -11,6 +11,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+
 #include "mouse_quadrature.hpp"
 #include "processors/interfaces.hpp"
 
@@ -23,16 +26,21 @@
  * vice versa?
  */
 class AtariStMouse : public QuadratureMouse {
-  public:
-    AtariStMouse() {
-        PRINTF("AtariStMouse +\n");
-    }
-    virtual ~AtariStMouse() {
-        PRINTF("AtariStMouse -\n");
+  protected:
+    void step_movement(ControllerPortState &state) override {
+        auto h_state = h.update();
+        auto v_state = v.update();
+
+        state.up = h_state.first;
+        state.down = h_state.second;
+        state.left = v_state.first;
+        state.right = v_state.second;
     }
 
+  public:
     /**
-     * @brief Update period
+     * @brief Supported rate profiles
+     *
      * Tested with real Atari 1040STFM with GEM on Low Resolution.
      * 350 is ok. 310 is not ok. 330 is also not ok. 340 is not ok, leading
      * to 1.44ms period. We are going for 360 here which is a period of 1.7ms
@@ -40,27 +48,42 @@ class AtariStMouse : public QuadratureMouse {
      * 425 leads to 1.78ms which seems to be more stable than 1.7ms in the long
      * run.
      * 450 leads to 2ms which is even more stable. Hallucination?
+     *
+     * The mouse is sampled by the keyboard processor, which is the same on ST and
+     * STE. Therefore the profiles only differ in how close they get to the limit.
+     */
+    static constexpr std::array<QuadratureRateProfile, 2> kRateProfiles{{
+        {"Atari ST", 360, 450, 20000},
+        {"Atari ST conservative", 450, 450, 20000},
+    }};
+
+    static_assert(std::all_of(kRateProfiles.begin(), kRateProfiles.end(), fits_max_latency),
+                  "CONFIG_MAX_OUTPUT_LATENCY_MS is too small for the queued steps");
+
+    /**
+     * @brief Construct a new Atari ST Mouse
+     *
+     * @param profile   Index in \ref kRateProfiles
      */
-    static constexpr uint32_t kUpdatePeriod = 450;
+    AtariStMouse(size_t profile = 0) : QuadratureMouse(kRateProfiles.at(profile)) {
+        PRINTF("AtariStMouse +\n");
+    }
+    virtual ~AtariStMouse() {
+        PRINTF("AtariStMouse -\n");
+    }
 
     void run() override {
+        if (feed_pio())
+            return;
+
         uint32_t now = board_micros();
         uint32_t time_diff = now - last_update;
 
-        if (time_diff > kUpdatePeriod) {
+        if (time_diff >= update_period_) {
             last_update = now;
-            auto h_state = h.update();
-            auto v_state = v.update();
-
-            state_.up = h_state.first;
-            state_.down = h_state.second;
-            state_.left = v_state.first;
-            state_.right = v_state.second;
-
-            if (mouse_target_ && last_state_ != state_) {
-                last_state_ = state_;
-                mouse_target_->set_port_state(state_);
-            }
+            step_movement(state_);
+            adapt_period();
+            apply_state();
         }
     }
 };
@@ -11,7 +11,12 @@
 
 #pragma once
 
+#include "config.h"
+#include "latency_trace.hpp"
+#include "movement_backlog.hpp"
 #include "processors/interfaces.hpp"
+#include "sid_cycle_monitor.hpp"
+#include "sid_pot_stream.hpp"
 #include "utility.h"
 
 #include "c1351.pio.h"
@@ -39,6 +44,90 @@ struct C1351CalibrationData {
     int32_t pot_x_191_ = -1417;
 };
 
+/**
+ * @brief PIO clock ticks for every POT value of a single controller port
+ *
+ * Calculated from \ref C1351CalibrationData whenever it changes.
+ * Avoids the interpolation during output, as the RP2040 has no FPU.
+ */
+struct C1351TickTable {
+    /// @brief Lowest POT value of the C1351
+    static constexpr uint32_t kPotMin{64};
+    /// @brief Highest POT value of the C1351
+    static constexpr uint32_t kPotMax{191};
+    /// @brief Number of POT values of the C1351
+    static constexpr size_t kPotValues{kPotMax - kPotMin + 1};
+
+    /// @brief number of microseconds the SID will drain the capacitor
+    static constexpr int32_t kDrainLength = 256;
+    /// @brief number of PIO clock ticks per microsecond
+    static constexpr int32_t kDigitPerUs = 125;
+    /// @brief number of SID clock cycles of a measurement cycle
+    static constexpr int32_t kSidCycleClocks = 512;
+
+    /// @brief PIO clock ticks for POTX, starting with \ref kPotMin
+    std::array<uint32_t, kPotValues> pot_x_;
+    /// @brief PIO clock ticks for POTY, starting with \ref kPotMin
+    std::array<uint32_t, kPotValues> pot_y_;
+
+    /**
+     * @brief Calculates the PIO clock ticks for a single POT value
+     *
+     * Performs a linear interpolation between the calibration values
+     * at 64 and 191. Values outside of this range are extrapolated.
+     *
+     * @param calib_64      clock ticks to add for a value of 64
+     * @param calib_191     clock ticks to add for a value of 191
+     * @param pot_value     POT value to simulate
+     * @return uint32_t Clock ticks to charge the capacitor
+     */
+    static uint32_t calibrated_ticks(int32_t calib_64, int32_t calib_191, uint32_t pot_value) {
+        float x0, y0, x1, y1, xp, yp;
+
+        y0 = static_cast<float>(calib_64);
+        y1 = static_cast<float>(calib_191);
+        xp = static_cast<float>(pot_value);
+        x0 = kPotMin;
+        x1 = kPotMax;
+        yp = y0 + ((y1 - y0) / (x1 - x0)) * (xp - x0);
+
+        int32_t calibration = static_cast<int32_t>(yp);
+
+        return (kDrainLength + pot_value) * kDigitPerUs + calibration;
+    }
+
+    /**
+     * @brief Calculates the PIO clock ticks to add for a SID with another clock
+     *
+     * The calibration refers to a measurement cycle of \ref SidCycleMonitor::kReferencePeriod.
+     * The drain and the counting of the SID scale with the length of the measurement cycle,
+     * while the time to charge the capacitor doesn't.
+     *
+     * @param pot_value     POT value to simulate
+     * @param deviation     Difference of the measurement cycle to the reference in PIO clock ticks
+     * @return int32_t Clock ticks to add
+     */
+    static int32_t drift_correction(uint32_t pot_value, int32_t deviation) {
+        return (kDrainLength + static_cast<int32_t>(pot_value)) * deviation / kSidCycleClocks;
+    }
+
+    /**
+     * @brief Recalculates all entries
+     *
+     * @param calib     Calibration data of the controller port
+     */
+    void update(const C1351CalibrationData &calib) {
+        for (uint32_t i = 0; i < kPotValues; i++) {
+            pot_x_[i] = calibrated_ticks(calib.pot_x_64_, calib.pot_x_191_, kPotMin + i);
+            pot_y_[i] = calibrated_ticks(calib.pot_y_64_, calib.pot_y_191_, kPotMin + i);
+        }
+    }
+
+    C1351TickTable() {
+        update(C1351CalibrationData());
+    }
+};
+
 /**
  * @brief Emulation of the Commodore 1351 in proportional mode.
  * Uses the POTX and POTY pins to simulate analog values for the ADC inside
@@ -57,7 +146,8 @@ struct C1351CalibrationData {
  * manner to simulate a certain value in the SID that we want.
  *
  * We does this by using the PIO units of the RP2040. One PIO has 4 state
- * machines. We will use all of them to drive 2x POTX and 2x POTY
+ * machines. We will use all of them to drive 2x POTX and 2x POTY.
+ * The values are fed to the state machines by DMA, see \ref SidPotStream.
  *
  */
 class C1351Converter : public RunnableMouseReportProcessor {
@@ -97,14 +187,61 @@ class C1351Converter : public RunnableMouseReportProcessor {
     /// @brief last mouse button state. used to check for changes
     ControllerPortState last_state_;
 
+    /// @brief Time stamp of the last report with movement. Recorded when the next POT values are queued
+    uint32_t movement_arrival_us_{0};
+
     /// @brief Number of milliseconds the Wheel direction has to be kept stable
     /// According to https://wiki.icomp.de/wiki/Micromys_Protocol
     static constexpr uint32_t kWheelPulseLength{50};
 
-    /// @brief number of microseconds the SID will drain the capacitor
-    static constexpr int32_t kDrainLength = 256;
-    /// @brief number of PIO clock ticks per microsecond
-    static constexpr int32_t kDigitPerUs = 125;
+    /// @brief number of microseconds of a SID measurement cycle
+    static constexpr uint32_t kSidCycle{512};
+
+    /// @brief Period in microseconds to check whether the DMA can take new values.
+    /// The state machines take a value once per SID measurement cycle. Checking twice
+    /// per cycle refills the short queue before it runs empty.
+    static constexpr uint32_t kRefillPeriod{kSidCycle / 2};
+
+    /// @brief Maximum number of steps which can be drained within the maximum output latency.
+    /// 1.5 steps are performed per SID cycle. Within any number of cycles, this can be
+    /// 2 steps less than expected. Values of some cycles are already queued for the PIO.
+    static constexpr uint32_t kMaxBacklog{
+        ((MovementBacklog::kMaxLatency - SidPotStream::kQueuedCycles * kSidCycle) / kSidCycle) * 3 / 2 - 2};
+
+    static_assert(MovementBacklog::kMaxLatency >= (SidPotStream::kQueuedCycles + 2) * kSidCycle,
+                  "CONFIG_MAX_OUTPUT_LATENCY_MS is too small for the queued SID cycles");
+
+    /// @brief Limits horizontal and vertical movement to the maximum output latency
+    MovementBacklog movement_backlog_{kMaxBacklog};
+
+  public:
+    /// @brief Maximum change of the POT values for 8 consecutive measurement cycles
+    using SlewPattern = std::array<uint8_t, 8>;
+
+    /// @brief 1.5 per measurement cycle. See \ref run for the reasoning
+    static constexpr SlewPattern kDefaultSlewPattern{1, 1, 1, 1, 2, 2, 2, 2};
+
+  private:
+    /// @brief Maximum change of the POT values per measurement cycle
+    SlewPattern slew_pattern_{kDefaultSlewPattern};
+
+    /// @brief If true, the POT values only change by full pointer steps. See \ref pot_value
+    bool full_steps_{CONFIG_C1351_FULL_STEPS == 1};
+
+    /// @brief Feeds \ref sm_x_
+    SidPotStream stream_x_;
+    /// @brief Feeds \ref sm_y_
+    SidPotStream stream_y_;
+
+    /// @brief Measures the clock of the SID
+    SidCycleMonitor cycle_monitor_;
+
+    /// @brief Values for \ref stream_x_ which are prepared right now
+    std::array<uint32_t, SidPotStream::kBlockSize> block_x_{};
+    /// @brief Values for \ref stream_y_ which are prepared right now
+    std::array<uint32_t, SidPotStream::kBlockSize> block_y_{};
+    /// @brief Measurement cycle inside \ref block_x_ and \ref block_y_ which is prepared right now
+    size_t block_pos_{0};
 
     /// Possible modes this module can operate in
     enum class OperatingState {
@@ -119,6 +256,9 @@ class C1351Converter : public RunnableMouseReportProcessor {
     /// Required because of component tolerances
     static std::array<struct C1351CalibrationData, 2> calibration_;
 
+    /// PIO clock ticks derived from \ref calibration_
+    static std::array<C1351TickTable, 2> tick_table_;
+
     /// Current active mode
     OperatingState operating_state_{OperatingState::kEffective};
 
@@ -129,16 +269,16 @@ class C1351Converter : public RunnableMouseReportProcessor {
     uint8_t calibration_mode_enter_counter_{0};
 
     /**
-     * @brief Checks if the PIO state machines can take another value.
+     * @brief Checks if the PIO state machines can take further values.
      *
-     * Usually the FIFOs are allowed to take up to 4 values but we don't really
-     * want any latency here. Only push a value if the FIFOs are both empty.
+     * Both streams are always fed together, which keeps them in sync
+     * as the state machines are triggered by the same sense pin.
      *
      * @return true Values can be pushed
      * @return false Wait another round
      */
-    bool pio_fifos_can_take_values() {
-        return pio_sm_is_tx_fifo_empty(pio_, sm_y_) && pio_sm_is_tx_fifo_empty(pio_, sm_x_);
+    bool streams_can_take_values() {
+        return stream_x_.can_take_block() && stream_y_.can_take_block();
     }
 
     /**
@@ -151,36 +291,58 @@ class C1351Converter : public RunnableMouseReportProcessor {
      * value to help with oscillating values. This leaves us with a real range
      * of 64 values.
      *
+     * The calibrated durations are taken from \ref tick_table_ and corrected
+     * by the measured clock of the SID.
+     *
      * @param sm            State machine to affect
      * @param pot_value     Value in range of 64 to inclusive 191
      */
     void push_calibrated_value(int sm, uint32_t pot_value) {
-        float x0, y0, x1, y1, xp, yp;
+        const C1351TickTable &table = tick_table_.at(target_->get_index());
+        uint32_t index = pot_value - C1351TickTable::kPotMin;
 
-        struct C1351CalibrationData &calib = calibration_.at(target_->get_index());
+        uint32_t ticks = (sm == sm_y_) ? table.pot_y_[index] : table.pot_x_[index];
 
-        if (sm == sm_y_) {
-            y0 = static_cast<float>(calib.pot_y_64_);
-            y1 = static_cast<float>(calib.pot_y_191_);
-        } else {
-            y0 = static_cast<float>(calib.pot_x_64_);
-            y1 = static_cast<float>(calib.pot_x_191_);
-        }
+        push_ticks(sm, ticks + C1351TickTable::drift_correction(pot_value, cycle_monitor_.deviation()));
+    }
 
-        xp = static_cast<float>(pot_value);
-        x0 = 64;
-        x1 = 191;
-        yp = y0 + ((y1 - y0) / (x1 - x0)) * (xp - x0);
+    /**
+     * @brief Provide PIO with a drain duration outside of the C1351 range
+     *
+     * Used for the axis which is not calibrated right now.
+     * Only the calibration of the lower end is applied.
+     *
+     * @param sm            State machine to affect
+     * @param pot_value     Value below 64
+     */
+    void push_uncalibrated_value(int sm, uint32_t pot_value) {
+        const C1351TickTable &table = tick_table_.at(target_->get_index());
+        uint32_t offset = (C1351TickTable::kPotMin - pot_value) * C1351TickTable::kDigitPerUs;
 
-        int32_t calibration = static_cast<int32_t>(yp);
+        uint32_t ticks = ((sm == sm_y_) ? table.pot_y_[0] : table.pot_x_[0]) - offset;
+
+        push_ticks(sm, ticks + C1351TickTable::drift_correction(pot_value, cycle_monitor_.deviation()));
+    }
 
+    /**
+     * @brief Provide PIO with a drain duration
+     *
+     * The value is stored in the block of the current measurement cycle.
+     *
+     * @param sm            State machine to affect
+     * @param ticks         PIO clock ticks to charge the capacitor
+     */
+    void push_ticks(int sm, uint32_t ticks) {
         // Make the calibration fluctuate during calibration mode
         // to improve the results after calibration.
         if (operating_state_ != OperatingState::kEffective) {
-            calibration += (values_pushed_cnt_ & 0x08) ? 20 : -20;
+            ticks += (values_pushed_cnt_ & 0x08) ? 20 : -20;
         }
 
-        pio_sm_put(pio_, sm, (kDrainLength + pot_value) * kDigitPerUs + calibration);
+        if (sm == sm_y_)
+            block_y_[block_pos_] = ticks;
+        else
+            block_x_[block_pos_] = ticks;
     }
 
     /// @brief  data sink for mouse button presses
@@ -200,11 +362,11 @@ class C1351Converter : public RunnableMouseReportProcessor {
      */
     uint32_t values_pushed_cnt_{0};
 
-    /// @brief Stores calibration data to Flash
+    /// @brief Stages calibration data to be stored in Flash by the \ref ConfigWriter
     static void save_calibration_data();
 
   public:
-    /// @brief Loads calibration data from Flash
+    /// @brief Loads calibration data from Flash, or the staged data if not yet written
     static void load_calibration_data();
 
     C1351Converter() {
@@ -227,7 +389,39 @@ class C1351Converter : public RunnableMouseReportProcessor {
         target_ = t;
     }
 
+    /**
+     * @brief Changes the maximum change of the POT values per measurement cycle
+     *
+     * Allows to evaluate other values against simulated software.
+     * Only \ref kDefaultSlewPattern is known to work with all tested software.
+     *
+     * @param pattern   Maximum change for 8 consecutive measurement cycles
+     */
+    void set_slew_pattern(const SlewPattern &pattern) {
+        slew_pattern_ = pattern;
+    }
+
+    /**
+     * @brief Selects whether the POT values only change by full pointer steps
+     *
+     * The default is defined by CONFIG_C1351_FULL_STEPS.
+     *
+     * @param full_steps    True to keep the noise bit stable
+     */
+    void set_full_steps(bool full_steps) {
+        full_steps_ = full_steps;
+    }
+
+    /// @brief Provides telemetry about horizontal and vertical movement still to perform
+    const BacklogTelemetry &backlog_telemetry() {
+        return movement_backlog_.telemetry();
+    }
+
     void ensure_mouse_muxing() override {
+        // A previous quadrature mouse leaves the directional pins on its PIO.
+        // Buttons and wheel pulses are set by the CPU.
+        target_->configure_gpios();
+
         if (target_->get_pot_y_sense_gpio() == 8) {
             sm_x_ = 0;
             sm_y_ = 1;
@@ -243,6 +437,12 @@ class C1351Converter : public RunnableMouseReportProcessor {
         sid_adc_stim_program_init(pio_, sm_y_, offset_, target_->get_pot_y_sense_gpio(),
                                   target_->get_pot_y_drain_gpio());
 
+        stream_x_.start(pio_, sm_x_);
+        stream_y_.start(pio_, sm_y_);
+
+        // State machines 0 and 1 of PIO1 are used by QuadraturePio
+        cycle_monitor_.start(2 + sm_x_ / 2, target_->get_pot_y_sense_gpio());
+
         PRINTF("Enable C1351 for %s port\n", target_->get_name());
     }
 
@@ -327,13 +527,19 @@ class C1351Converter : public RunnableMouseReportProcessor {
         state_.fire1 = mouse_report.left;
         state_.up = mouse_report.right;
         state_.down = mouse_report.middle;
+        state_.source = kMouse;
+        state_.arrival_us = mouse_report.arrival_us;
+        if (mouse_report.relx || mouse_report.rely)
+            movement_arrival_us_ = mouse_report.arrival_us;
 
         struct C1351CalibrationData &calib = calibration_.at(target_->get_index());
+        bool calibrating = operating_state_ != OperatingState::kEffective;
 
         switch (operating_state_) {
         case OperatingState::kEffective:
             mouse_accumulator_x += mouse_report.relx;
             mouse_accumulator_y -= mouse_report.rely;
+            movement_backlog_.limit(mouse_accumulator_x, mouse_accumulator_y);
             mouse_accumulator_wheel += mouse_report.wheel;
 
             if (check_calibration_mode_enter_criteria()) {
@@ -374,6 +580,10 @@ class C1351Converter : public RunnableMouseReportProcessor {
             break;
         }
 
+        if (calibrating && mouse_report.wheel) {
+            tick_table_.at(target_->get_index()).update(calib);
+        }
+
         // Right mouse button to abort
         if (operating_state_ != OperatingState::kEffective && state_.up && !last_state_.up) {
             PRINTF("Aborted calibration\n");
@@ -387,6 +597,74 @@ class C1351Converter : public RunnableMouseReportProcessor {
         }
     }
 
+    /**
+     * @brief Converts the position of an axis into a POT value
+     *
+     * The lowest bit is the noise bit of the C1351. Drivers move the pointer by half
+     * of the change and take the new value as reference, which loses half a step with
+     * every odd change. With \ref full_steps_, the noise bit is kept stable and a half
+     * step stays inside the position until it is completed by further movement.
+     *
+     * @param position  Position of the axis in half pointer steps
+     * @return uint32_t POT value in range of 64 to inclusive 191
+     */
+    uint32_t pot_value(uint32_t position) {
+        if (full_steps_)
+            position &= ~1u;
+
+        return (position % 128) + 64;
+    }
+
+    /**
+     * @brief Calculates the values of the next SID measurement cycle
+     *
+     * Stores them at \ref block_pos_ of \ref block_x_ and \ref block_y_.
+     */
+    void plan_cycle() {
+        static constexpr uint8_t kNotCalibratedChanValue{25};
+
+        values_pushed_cnt_++;
+
+        switch (operating_state_) {
+        case OperatingState::kEffective: {
+            int32_t kMaxChange = slew_pattern_[values_pushed_cnt_ % slew_pattern_.size()];
+
+            int32_t inc_x = std::max(-kMaxChange, std::min(mouse_accumulator_x, kMaxChange));
+            int32_t inc_y = std::max(-kMaxChange, std::min(mouse_accumulator_y, kMaxChange));
+
+            mouse_accumulator_x -= inc_x;
+            mouse_accumulator_y -= inc_y;
+            movement_backlog_.update(mouse_accumulator_x, mouse_accumulator_y);
+            value_pot_x_ += inc_x;
+            value_pot_y_ += inc_y;
+
+            push_calibrated_value(sm_x_, pot_value(value_pot_x_));
+            push_calibrated_value(sm_y_, pot_value(value_pot_y_));
+            break;
+        }
+        case OperatingState::kCalibratePotX64: {
+            push_calibrated_value(sm_x_, 64);
+            push_uncalibrated_value(sm_y_, kNotCalibratedChanValue);
+            break;
+        }
+        case OperatingState::kCalibratePotX191: {
+            push_calibrated_value(sm_x_, 191);
+            push_uncalibrated_value(sm_y_, kNotCalibratedChanValue);
+            break;
+        }
+        case OperatingState::kCalibratePotY64: {
+            push_uncalibrated_value(sm_x_, kNotCalibratedChanValue);
+            push_calibrated_value(sm_y_, 64);
+            break;
+        }
+        case OperatingState::kCalibratePotY191: {
+            push_uncalibrated_value(sm_x_, kNotCalibratedChanValue);
+            push_calibrated_value(sm_y_, 191);
+            break;
+        }
+        }
+    }
+
     /**
      * @brief Provides new pot values for the C1351 emulation.
      *
@@ -413,48 +691,20 @@ class C1351Converter : public RunnableMouseReportProcessor {
      * software.
      */
     void run() override {
-        static constexpr uint8_t kNotCalibratedChanValue{25};
-
-        if (pio_fifos_can_take_values()) {
-            values_pushed_cnt_++;
+        cycle_monitor_.poll();
 
-            switch (operating_state_) {
-            case OperatingState::kEffective: {
-                int32_t kMaxChange = (values_pushed_cnt_ % 8) > 3 ? 2 : 1; // 1.5 per cycle
-
-                int32_t inc_x = std::max(-kMaxChange, std::min(mouse_accumulator_x, kMaxChange));
-                int32_t inc_y = std::max(-kMaxChange, std::min(mouse_accumulator_y, kMaxChange));
+        if (streams_can_take_values()) {
+            for (block_pos_ = 0; block_pos_ < SidPotStream::kBlockSize; block_pos_++) {
+                plan_cycle();
+            }
 
-                mouse_accumulator_x -= inc_x;
-                mouse_accumulator_y -= inc_y;
-                value_pot_x_ += inc_x;
-                value_pot_y_ += inc_y;
+            stream_x_.put_block(block_x_);
+            stream_y_.put_block(block_y_);
 
-                push_calibrated_value(sm_x_, (value_pot_x_ % 128) + 64);
-                push_calibrated_value(sm_y_, (value_pot_y_ % 128) + 64);
-                break;
-            }
-            case OperatingState::kCalibratePotX64: {
-                push_calibrated_value(sm_x_, 64);
-                push_calibrated_value(sm_y_, kNotCalibratedChanValue);
-                break;
-            }
-            case OperatingState::kCalibratePotX191: {
-                push_calibrated_value(sm_x_, 191);
-                push_calibrated_value(sm_y_, kNotCalibratedChanValue);
-                break;
-            }
-            case OperatingState::kCalibratePotY64: {
-                push_calibrated_value(sm_x_, kNotCalibratedChanValue);
-                push_calibrated_value(sm_y_, 64);
-                break;
-            }
-            case OperatingState::kCalibratePotY191: {
-                push_calibrated_value(sm_x_, kNotCalibratedChanValue);
-                push_calibrated_value(sm_y_, 191);
-                break;
-            }
-            }
+            // The block is read by the SID after the values already queued
+            if (target_)
+                LatencyTrace::instance().record(target_->get_index(), kMouse, movement_arrival_us_,
+                                                board_micros() + SidPotStream::kQueuedCycles * kSidCycle);
         }
 
         // Handle Micromys Wheel
@@ -495,4 +745,8 @@ class C1351Converter : public RunnableMouseReportProcessor {
             target_->set_port_state(state_);
         }
     }
+
+    uint32_t next_deadline(uint32_t now) override {
+        return now + kRefillPeriod;
+    }
 };
\ No newline at end of file
@@ -0,0 +1,148 @@
+/**
+ * @file mouse_delta_accumulator.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "interfaces.hpp"
+
+/**
+ * @brief Sums the movement of mouse reports until it is forwarded
+ *
+ * Mice with high polling rates deliver far more reports than any
+ * of the emulated mice can output. Instead of passing every report
+ * through the pipeline, the movement is summed and forwarded at most once
+ * per \ref kDrainPeriod. Movement after a pause of at least \ref kDrainPeriod
+ * is due immediately, so no latency is added to the first report after idle
+ * or to mice with low polling rates.
+ *
+ * The button state is not stored here. Reports which change the buttons
+ * must be forwarded immediately by the user, after draining the movement
+ * which was accumulated before.
+ */
+class MouseDeltaAccumulator {
+  private:
+    /// @brief Summed horizontal movement
+    int32_t x_{0};
+    /// @brief Summed vertical movement
+    int32_t y_{0};
+    /// @brief Summed wheel movement
+    int32_t wheel_{0};
+
+    /// @brief True if movement was added since the last drain
+    bool pending_{false};
+
+    /// @brief Absolute time in microseconds when the pending movement must be drained
+    uint32_t due_{0};
+
+    /// @brief Time stamp of the oldest report since the last drain
+    uint32_t arrival_us_{0};
+
+    /// @brief Absolute time in microseconds of the last drain
+    uint32_t last_drain_us_{0};
+
+    /// @brief True if \ref last_drain_us_ is valid
+    bool drained_{false};
+
+    /**
+     * @brief Takes as much as possible of an axis
+     *
+     * @param value     Summed movement. Keeps what doesn't fit into a report
+     * @return int16_t  Movement for the report
+     */
+    static int16_t take_axis(int32_t &value) {
+        int32_t part = std::clamp<int32_t>(value, std::numeric_limits<int16_t>::min(),
+                                           std::numeric_limits<int16_t>::max());
+        value -= part;
+        return static_cast<int16_t>(part);
+    }
+
+  public:
+    /// @brief Minimum time in microseconds between drains.
+    /// Well below a frame of the target machines, which read the mouse once per frame
+    static constexpr uint32_t kDrainPeriod{2000};
+
+    /**
+     * @brief Adds the movement of a report
+     *
+     * @param report    Report to add. Buttons are ignored
+     * @param now       Current time in microseconds
+     * @return true     This is the first movement since the last drain. The deadline has moved
+     */
+    bool add(const MouseReport &report, uint32_t now) {
+        bool first = !pending_;
+
+        if (first) {
+            // Only wait if the consumer was given movement recently
+            if (drained_ && static_cast<int32_t>(now - last_drain_us_) < static_cast<int32_t>(kDrainPeriod))
+                due_ = last_drain_us_ + kDrainPeriod;
+            else
+                due_ = now;
+            arrival_us_ = report.arrival_us;
+        }
+
+        x_ += report.relx;
+        y_ += report.rely;
+        wheel_ += report.wheel;
+        pending_ = true;
+
+        return first;
+    }
+
+    /// @brief Returns true if movement is waiting to be drained
+    bool pending() {
+        return pending_;
+    }
+
+    /// @brief Absolute time in microseconds when the pending movement must be drained
+    uint32_t due() {
+        return due_;
+    }
+
+    /**
+     * @brief Checks if pending movement has to be drained
+     *
+     * @param now       Current time in microseconds
+     * @return true     Movement is pending and due
+     */
+    bool ready(uint32_t now) {
+        return pending_ && static_cast<int32_t>(now - due_) >= 0;
+    }
+
+    /**
+     * @brief Moves the summed movement into a report
+     *
+     * Movement exceeding 16 bit stays pending and is due immediately.
+     * The report carries the time stamp of the oldest summed report.
+     *
+     * @param report    Report to fill. Buttons are not modified
+     * @param now       Current time in microseconds
+     */
+    void drain(MouseReport &report, uint32_t now) {
+        last_drain_us_ = now;
+        drained_ = true;
+        due_ = now;
+        report.arrival_us = arrival_us_;
+        report.relx = take_axis(x_);
+        report.rely = take_axis(y_);
+        report.wheel = take_axis(wheel_);
+        pending_ = x_ || y_ || wheel_;
+    }
+
+    /// @brief Discards all pending movement
+    void clear() {
+        x_ = y_ = wheel_ = 0;
+        pending_ = false;
+    }
+};
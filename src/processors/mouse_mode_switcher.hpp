@@ -11,6 +11,8 @@
 
 #pragma once
 
+#include <functional>
+
 #include "config.h"
 #include "interfaces.hpp"
 #include "mouse_amiga.hpp"
@@ -78,17 +80,35 @@ class MouseModeSwitcher : public RunnableMouseReportProcessor {
         return 3;
     }
 
+    /**
+     * @brief Provides number of rate profiles supported by a mouse type
+     *
+     * @param mode      a value in the range of 0-2
+     * @return number of rate profiles
+     */
+    static size_t number_rate_profiles(int mode) {
+        switch (mode) {
+        case 0:
+            return AmigaMouse::kRateProfiles.size();
+        case 1:
+            return AtariStMouse::kRateProfiles.size();
+        default:
+            return 1;
+        }
+    }
+
     /**
      * @brief Sets a type of mouse
      *
      * @param mode      a value in the range of 0-2
+     * @param profile   rate profile to use. Must be less than \ref number_rate_profiles
      */
-    void set_mode(int mode) {
-        PRINTF("Set mouse mode %d\n", mode);
+    void set_mode(int mode, size_t profile = 0) {
+        PRINTF("Set mouse mode %d with profile %zu\n", mode, profile);
 
         switch (mode) {
         case 0: {
-            auto impl = std::make_shared<AmigaMouse>();
+            auto impl = std::make_shared<AmigaMouse>(profile);
             impl->mouse_target_ = mouse_target_;
 #if CONFIG_DISABLE_AMIGA_WHEELBUSMOUSE == 0
             impl->wheel_target_ = wheel_target_;
@@ -97,7 +117,7 @@ class MouseModeSwitcher : public RunnableMouseReportProcessor {
             break;
         }
         case 1: {
-            auto impl = std::make_shared<AtariStMouse>();
+            auto impl = std::make_shared<AtariStMouse>(profile);
             impl->mouse_target_ = mouse_target_;
             impl_ = impl;
             break;
@@ -160,4 +180,16 @@ class MouseModeSwitcher : public RunnableMouseReportProcessor {
         if (impl_)
             impl_->run();
     }
+
+    uint32_t next_deadline(uint32_t now) override {
+        uint32_t deadline = impl_ ? impl_->next_deadline(now) : now + kIdlePeriod;
+
+        if (swap_combination_pressed_ && !swap_performed_) {
+            uint32_t swap_deadline = deadline_after_ms(
+                now, static_cast<int32_t>(swap_press_start_time + kSwapHoldDuration + 1 - board_millis()));
+            deadline = earliest_deadline(deadline, swap_deadline);
+        }
+
+        return deadline;
+    }
 };
@@ -11,12 +11,20 @@
 #pragma once
 
 #include "processors/interfaces.hpp"
+#include "movement_backlog.hpp"
 #include "quadrature_encoder.hpp"
+#include "quadrature_pio.hpp"
+#include "quadrature_rate.hpp"
+
+#include <cstdlib>
 
 /**
  * @brief Shared code between \ref AmigaMouse and \ref AtariStMouse
  * Provides 3 quadrature encoders and mouse button handling which is equal for
  * both systems.
+ *
+ * Horizontal and vertical movement is performed by \ref QuadraturePio if available.
+ * Otherwise the steps are performed in software when \ref run is called.
  */
 class QuadratureMouse : public RunnableMouseReportProcessor {
   protected:
@@ -29,8 +37,95 @@ class QuadratureMouse : public RunnableMouseReportProcessor {
     ControllerPortState state_;      ///< current state of the controller port
     ControllerPortState last_state_; ///< last state to check for changes
 
+    /// @brief Limits of the step rate of the target machine
+    const QuadratureRateProfile &profile_;
+
+    /// @brief Time in microseconds between the last and the next quadrature step
+    uint32_t update_period_;
+
+    /// @brief Hardware timed output of horizontal and vertical movement
+    QuadraturePio quadrature_pio_;
+
+    /// @brief Number of steps after which the PIO FIFO is refilled.
+    /// Half of the FIFO depth to never let it run empty.
+    static constexpr uint32_t kStepsPerRefill{2};
+
+    /// @brief Maximum number of steps which are queued for output but are no longer part of the backlog.
+    /// Equal to the PIO FIFO depth.
+    static constexpr uint32_t kQueuedSteps{4};
+
+    /// @brief Limits horizontal and vertical movement to the maximum output latency
+    MovementBacklog movement_backlog_;
+
+    /// @brief State of the port as last queued to \ref quadrature_pio_
+    ControllerPortState pio_state_;
+
+    /**
+     * @brief Performs a single step of horizontal and vertical movement
+     *
+     * @param state     Port state to apply the new signals to
+     */
+    virtual void step_movement(ControllerPortState &state) = 0;
+
+    /// @brief Returns the number of steps still to perform on the busier axis
+    uint32_t backlog() {
+        return std::max(std::abs(h.accumulator()), std::abs(v.accumulator()));
+    }
+
+    /// @brief Adapts \ref update_period_ to the current backlog
+    void adapt_period() {
+        movement_backlog_.update(h.accumulator(), v.accumulator());
+        update_period_ = profile_.period_for_backlog(backlog());
+    }
+
+    /**
+     * @brief Forwards pending movement to \ref quadrature_pio_
+     *
+     * @return true     Movement is performed by the PIO
+     * @return false    PIO is not available. Movement must be performed in software
+     */
+    bool feed_pio() {
+        if (!quadrature_pio_.active())
+            return false;
+
+        while ((h.accumulator() || v.accumulator()) && quadrature_pio_.can_take_step()) {
+            adapt_period();
+            step_movement(pio_state_);
+            quadrature_pio_.put_step(pio_state_, update_period_);
+        }
+        return true;
+    }
+
+    /// @brief Writes \ref state_ to the port if changed
+    void apply_state() {
+        if (mouse_target_ && last_state_ != state_) {
+            last_state_ = state_;
+            mouse_target_->set_port_state(state_);
+        }
+    }
+
   public:
-    QuadratureMouse() {
+    /**
+     * @brief Checks if a backlog is possible with a rate profile
+     *
+     * Emulations must check all of their profiles using static_assert.
+     *
+     * @param profile   Limits of the step rate of the target machine
+     * @return true     The queued steps take less than the maximum output latency
+     */
+    static constexpr bool fits_max_latency(const QuadratureRateProfile &profile) {
+        return kQueuedSteps * profile.max_period_ < MovementBacklog::kMaxLatency;
+    }
+
+    /**
+     * @brief Construct a new Quadrature Mouse
+     *
+     * @param profile   Limits of the step rate of the target machine. Must outlive this object
+     */
+    QuadratureMouse(const QuadratureRateProfile &profile)
+        : profile_(profile), update_period_(profile.max_period_),
+          movement_backlog_(profile.max_backlog(MovementBacklog::kMaxLatency - kQueuedSteps * profile.max_period_)) {
+        PRINTF("Rate profile %s with maximum backlog of %lu\n", profile.name_, movement_backlog_.max_backlog());
         PRINTF("QuadratureMouse +\n");
     }
     virtual ~QuadratureMouse() {
@@ -45,26 +140,57 @@ class QuadratureMouse : public RunnableMouseReportProcessor {
 #endif
 
     void process_mouse_report(MouseReport &mouse_report) override {
-        h.add_to_accumulator(mouse_report.relx);
-        v.add_to_accumulator(mouse_report.rely);
+        int32_t h_backlog = h.accumulator() + mouse_report.relx;
+        int32_t v_backlog = v.accumulator() + mouse_report.rely;
+        movement_backlog_.limit(h_backlog, v_backlog);
+        h.set_accumulator(h_backlog);
+        v.set_accumulator(v_backlog);
         wheel.add_to_accumulator(mouse_report.wheel);
 
         state_.fire1 = mouse_report.left;
         state_.fire2 = mouse_report.right;
         state_.fire3 = mouse_report.middle;
 
-        if (mouse_target_ && last_state_ != state_) {
-            last_state_ = state_;
-            mouse_target_->set_port_state(state_);
-        }
+        // Movement carries the time stamp until the first step is performed
+        state_.source = kMouse;
+        pio_state_.source = kMouse;
+        state_.arrival_us = mouse_report.arrival_us;
+        if (mouse_report.relx || mouse_report.rely)
+            pio_state_.arrival_us = mouse_report.arrival_us;
+
+        apply_state();
+    }
+
+    /// @brief Provides telemetry about horizontal and vertical movement still to perform
+    const BacklogTelemetry &backlog_telemetry() {
+        return movement_backlog_.telemetry();
+    }
+
+    /// @brief Returns true if any quadrature signal still has to move
+    bool movement_pending() {
+        return h.accumulator() || v.accumulator() || wheel.accumulator();
+    }
+
+    uint32_t next_deadline(uint32_t now) override {
+        if (!movement_pending())
+            return now + kIdlePeriod;
+
+        // The wheel is always performed in software
+        if (quadrature_pio_.active() && !wheel.accumulator())
+            return now + update_period_ * kStepsPerRefill;
+
+        return deadline_not_before(now, last_update + update_period_);
     }
 
     void ensure_mouse_muxing() override {
         if (mouse_target_)
             mouse_target_->configure_gpios();
 #if CONFIG_DISABLE_AMIGA_WHEELBUSMOUSE == 0
-        if (wheel_target_)
+        // The wheel port might be driven by the PIO of another mouse.
+        // It is always configured by its own processor anyway.
+        if (wheel_target_ && !QuadraturePio::available())
             wheel_target_->configure_gpios();
 #endif
+        quadrature_pio_.start(mouse_target_, pio_state_);
     }
 };
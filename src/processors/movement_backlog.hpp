@@ -0,0 +1,147 @@
+/**
+ * @file movement_backlog.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#include "config.h"
+#include "utility.h"
+
+/// @brief Ways to handle movement which would exceed the maximum output latency
+enum class BacklogPolicy {
+    kScale, ///< Both axes are scaled by the same factor. Keeps the direction
+    kDrop,  ///< Each axis is clamped on its own. Excess movement is dropped
+};
+
+/**
+ * @brief Telemetry of \ref MovementBacklog
+ */
+struct BacklogTelemetry {
+    /// @brief Number of steps still to perform on the busier axis
+    uint32_t backlog_{0};
+
+    /// @brief Time in microseconds the most recent movement will have waited
+    /// until it is performed. Estimated from the current backlog
+    uint32_t age_us_{0};
+
+    /// @brief Highest value of \ref age_us_ so far
+    uint32_t max_age_us_{0};
+
+    /// @brief Number of steps removed by the policy
+    uint32_t discarded_{0};
+};
+
+/**
+ * @brief Limits the movement still to perform on two axes
+ *
+ * Mouse emulations accumulate incoming movement and output it with
+ * the limited rate of the target machine. Without limiting, a fast swipe
+ * would keep the pointer moving long after the hand has stopped.
+ * The backlog is limited to what can be drained within
+ * CONFIG_MAX_OUTPUT_LATENCY_MS.
+ */
+class MovementBacklog {
+  private:
+    /// @brief Maximum number of steps on the busier axis
+    int32_t max_backlog_;
+
+    /// @brief Time in microseconds required to drain a single step on average
+    uint32_t step_duration_us_;
+
+    /// @brief Current telemetry
+    BacklogTelemetry telemetry_;
+
+  public:
+    /// @brief Maximum output latency in microseconds
+    static constexpr uint32_t kMaxLatency{CONFIG_MAX_OUTPUT_LATENCY_MS * 1000};
+
+    // Below, the movement already queued for the PIO takes the whole time. Above, the pointer lags a second
+    static_assert(CONFIG_MAX_OUTPUT_LATENCY_MS >= 10 && CONFIG_MAX_OUTPUT_LATENCY_MS <= 1000,
+                  "CONFIG_MAX_OUTPUT_LATENCY_MS must be between 10 and 1000");
+
+#if CONFIG_BACKLOG_DROP == 1
+    /// @brief Policy to use for movement exceeding \ref kMaxLatency
+    static constexpr BacklogPolicy kPolicy{BacklogPolicy::kDrop};
+#else
+    /// @brief Policy to use for movement exceeding \ref kMaxLatency
+    static constexpr BacklogPolicy kPolicy{BacklogPolicy::kScale};
+#endif
+
+    /**
+     * @brief Construct a new Movement Backlog
+     *
+     * @param max_backlog   Maximum number of steps which can be drained within \ref kMaxLatency
+     */
+    MovementBacklog(uint32_t max_backlog)
+        : max_backlog_(static_cast<int32_t>(std::max<uint32_t>(max_backlog, 1))),
+          step_duration_us_(kMaxLatency / max_backlog_) {
+    }
+
+    ~MovementBacklog() {
+        PRINTF("Movement backlog: max age %lu us, %lu steps discarded\n",
+               static_cast<unsigned long>(telemetry_.max_age_us_), static_cast<unsigned long>(telemetry_.discarded_));
+    }
+
+    /// @brief Returns the maximum number of steps on the busier axis
+    uint32_t max_backlog() {
+        return max_backlog_;
+    }
+
+    /**
+     * @brief Applies the policy after adding new movement
+     *
+     * @param x     Movement still to perform on the first axis
+     * @param y     Movement still to perform on the second axis
+     */
+    void limit(int32_t &x, int32_t &y) {
+        int32_t busier = std::max(std::abs(x), std::abs(y));
+
+        if (busier > max_backlog_) {
+            int32_t old_x = x;
+            int32_t old_y = y;
+
+            if (kPolicy == BacklogPolicy::kScale) {
+                x = static_cast<int32_t>(static_cast<int64_t>(x) * max_backlog_ / busier);
+                y = static_cast<int32_t>(static_cast<int64_t>(y) * max_backlog_ / busier);
+            } else {
+                x = std::clamp(x, -max_backlog_, max_backlog_);
+                y = std::clamp(y, -max_backlog_, max_backlog_);
+            }
+
+            telemetry_.discarded_ += std::abs(old_x - x) + std::abs(old_y - y);
+        }
+
+        update(x, y);
+    }
+
+    /**
+     * @brief Updates the telemetry
+     *
+     * @param x     Movement still to perform on the first axis
+     * @param y     Movement still to perform on the second axis
+     */
+    void update(int32_t x, int32_t y) {
+        telemetry_.backlog_ = std::max(std::abs(x), std::abs(y));
+        telemetry_.age_us_ = telemetry_.backlog_ * step_duration_us_;
+
+        if (telemetry_.age_us_ > telemetry_.max_age_us_) {
+            telemetry_.max_age_us_ = telemetry_.age_us_;
+        }
+    }
+
+    /// @brief Provides the current telemetry
+    const BacklogTelemetry &telemetry() {
+        return telemetry_;
+    }
+};
@@ -12,16 +12,22 @@
 
 #include "utility.h"
 
+#include "config_writer.hpp"
+#include "deadline_scheduler.hpp"
 #include "gamepad_features.hpp"
 #include "interfaces.hpp"
 #include "joystick_mouse_switcher.hpp"
+#include "latency_trace.hpp"
 #include "led_task.hpp"
 #include "mouse_amiga.hpp"
 #include "mouse_atarist.hpp"
 #include "mouse_c1351.hpp"
 #include "mouse_mode_switcher.hpp"
+#include "pointer_acceleration.hpp"
 #include "port_switcher.hpp"
-#include "small_fee.hpp"
+#include "report_bridge.hpp"
+
+#include <atomic>
 
 /**
  * @brief Central manager of data flow in this project
@@ -46,28 +52,139 @@ class Pipeline : public Runnable {
     /// @brief Proxy object which selects a mouse driver
     std::shared_ptr<MouseModeSwitcher> mouse_switcher2_;
 
+    /// @brief Velocity dependent gain in front of \ref mouse_switcher1_
+    std::shared_ptr<PointerAcceleration> acceleration1_;
+    /// @brief Velocity dependent gain in front of \ref mouse_switcher2_
+    std::shared_ptr<PointerAcceleration> acceleration2_;
+
     /// @brief Auto fire implementation
     std::shared_ptr<GamePadFeatures> autofire1;
     /// @brief Auto fire implementation
     std::shared_ptr<GamePadFeatures> autofire2;
 
-    /// @brief List of all objects that require constant attention
-    std::vector<std::shared_ptr<Runnable>> runnables_;
+    /// @brief Calls all objects that require attention when they are due
+    DeadlineScheduler<3> scheduler_;
 
     /// @brief Makes the LED of the Pico blink
     LedPatternGenerator led_pattern_;
-    /// @brief Writes configuration data
-    SingleByteFlashEepromEmulation fee_;
 
+    /// @brief Identifier of \ref led_pattern_ inside \ref scheduler_
+    size_t led_pattern_task_{0};
     /// @brief Currently selected mouse type. Ranges 0-2
     int mouse_mode_{0};
 
+    /// @brief Selected rate profile for every mouse type
+    std::array<size_t, 3> rate_profile_{};
+
+    /// @brief Selected curve of \ref acceleration1_ and \ref acceleration2_
+    size_t acceleration_curve_{0};
+
     /// @brief Is true, if configuration has to be written back
     bool mouse_mode_dirty_{false};
 
     /// @brief Absolute time in milliseconds when to write the configuration
     uint32_t mouse_mode_write_back_at_{0};
 
+    /// @brief Position of the Atari ST rate profile in the configuration byte
+    static constexpr uint8_t kConfigAtariStProfileShift{4};
+    /// @brief Position of the acceleration curve in the configuration byte
+    static constexpr uint8_t kConfigAccelerationShift{5};
+
+    /// @brief Reports from USB core to output core. Only used in dual core mode
+    ReportBridgeQueue bridge_queue_;
+
+    /// @brief Input of \ref primary_mouse_switcher_ for the USB core. Only used in dual core mode
+    std::shared_ptr<ReportBridge> mouse_bridge_;
+    /// @brief Input of \ref primary_joystick_switcher_ for the USB core. Only used in dual core mode
+    std::shared_ptr<ReportBridge> joystick_bridge_;
+
+    /// @brief Set by the USB core if a handler was integrated. Used to flash the LED
+    std::atomic<bool> handler_integrated_{false};
+
+    /// @brief Index of \ref primary_mouse_switcher_ in bridged reports
+    static constexpr uint8_t kMouseHubIndex{0};
+    /// @brief Index of \ref primary_joystick_switcher_ in bridged reports
+    static constexpr uint8_t kJoystickHubIndex{1};
+
+    /**
+     * @brief Provides the object report sources shall use as target for a hub
+     *
+     * @param hub   One of the primary switchers
+     * @return std::shared_ptr<ReportHubInterface> The hub itself or its bridge in dual core mode
+     */
+    std::shared_ptr<ReportHubInterface> source_target(std::shared_ptr<JoystickMouseSwitcher> &hub) {
+        if (hub == primary_mouse_switcher_ && mouse_bridge_)
+            return mouse_bridge_;
+        if (hub == primary_joystick_switcher_ && joystick_bridge_)
+            return joystick_bridge_;
+        return hub;
+    }
+
+    /**
+     * @brief Connects a report source with a hub
+     *
+     * @param source    Source to connect
+     * @param hub       One of the primary switchers
+     */
+    void attach_source(std::shared_ptr<ReportSourceInterface> source, std::shared_ptr<JoystickMouseSwitcher> &hub) {
+        auto target = source_target(hub);
+        source->set_target(target);
+        target->register_source(source);
+    }
+
+    /**
+     * @brief Restores mouse type and rate profiles from the configuration byte
+     *
+     * Bits 0-1 contain the mouse type, bit 4 the Atari ST rate profile and
+     * bits 5-6 the acceleration curve. Bits 2-3 are unused. The Amiga has
+     * a fixed rate and older configurations might still set them.
+     * Older configurations only contain the mouse type and use the first
+     * profiles without acceleration.
+     *
+     * @param config    Configuration byte as stored in flash
+     */
+    void load_config(uint8_t config) {
+        mouse_mode_ = (config & 0x3) % MouseModeSwitcher::number_modes();
+        rate_profile_[1] = ((config >> kConfigAtariStProfileShift) & 0x1) % MouseModeSwitcher::number_rate_profiles(1);
+        acceleration_curve_ = ((config >> kConfigAccelerationShift) & 0x3) % PointerAcceleration::kCurves.size();
+    }
+
+    /// @brief Provides the configuration byte to store in flash
+    uint8_t config_byte() {
+        return static_cast<uint8_t>(mouse_mode_ | (rate_profile_[1] << kConfigAtariStProfileShift) |
+                                    (acceleration_curve_ << kConfigAccelerationShift));
+    }
+
+    /**
+     * @brief Reports a mouse report as activity to the \ref ConfigWriter
+     *
+     * The C1351 emulation feeds movement to the PIO without changing the port state.
+     * Mice only send reports on changes. Gamepads might repeat them and are therefore
+     * only covered by changes of the port state.
+     *
+     * @param hub   Hub which has received a report
+     */
+    static void notify_mouse_activity(JoystickMouseSwitcher &hub) {
+        if (hub.active() == kMouse)
+            ConfigWriter::instance().notify_activity(board_micros());
+    }
+
+    /// @brief Starts a 10 second timer upon expiration the config is stored in flash
+    void schedule_config_write() {
+        mouse_mode_write_back_at_ = board_millis() + 1000 * 10;
+        mouse_mode_dirty_ = true;
+    }
+
+    /// @brief Applies the current mouse type and rate profile to all processors
+    void apply_mouse_mode() {
+        mouse_switcher1_->set_mode(mouse_mode_, rate_profile_[mouse_mode_]);
+        mouse_switcher2_->set_mode(mouse_mode_, rate_profile_[mouse_mode_]);
+        autofire1->set_c64_mode(mouse_mode_ == 2);
+        autofire2->set_c64_mode(mouse_mode_ == 2);
+        acceleration1_->set_curve(acceleration_curve_);
+        acceleration2_->set_curve(acceleration_curve_);
+    }
+
   public:
     virtual ~Pipeline() {
         PRINTF("Pipeline -\n");
@@ -76,14 +193,27 @@ class Pipeline : public Runnable {
     /**
      * @brief Construct a new Pipeline object
      *
+     * In dual core mode, report sources and the controller ports are handled
+     * on different cores. \ref integrate_handler and \ref run_inputs must then
+     * be called by the USB core, while \ref run_outputs, \ref cycle_mouse_mode,
+     * \ref cycle_rate_profile and \ref cycle_acceleration_curve must be called by the output core. Reports are handed over using a queue.
+     *
      * @param joystick_port     Primary jostick port
      * @param mouse_port        Primary mouse port
+     * @param dual_core         True if sources and ports are handled on different cores
      */
     Pipeline(std::shared_ptr<ControllerPortInterface> joystick_port,
-             std::shared_ptr<ControllerPortInterface> mouse_port) {
+             std::shared_ptr<ControllerPortInterface> mouse_port, bool dual_core = false) {
         PRINTF("Pipeline +\n");
 
-        mouse_mode_ = fee_.get_config_byte();
+        if (dual_core) {
+            mouse_bridge_ = std::make_shared<ReportBridge>(primary_mouse_switcher_, kMouseHubIndex, bridge_queue_);
+            joystick_bridge_ =
+                std::make_shared<ReportBridge>(primary_joystick_switcher_, kJoystickHubIndex, bridge_queue_);
+        }
+
+        std::span<const uint8_t> stored = ConfigWriter::instance().get(kConfigMouseMode);
+        load_config(stored.empty() ? 0 : stored[0]);
 
         joystick_port->configure_gpios();
         mouse_port->configure_gpios();
@@ -92,8 +222,15 @@ class Pipeline : public Runnable {
         mouse_port_ = port_switcher.first;
         joystick_port_ = port_switcher.second;
 
+        // Flash is only written while the outputs are quiet
+        auto activity = [](uint32_t time_us) { ConfigWriter::instance().notify_activity(time_us); };
+        mouse_port_->set_activity_callback(activity);
+        joystick_port_->set_activity_callback(activity);
+
         mouse_switcher1_ = std::make_shared<MouseModeSwitcher>();
         mouse_switcher2_ = std::make_shared<MouseModeSwitcher>();
+        acceleration1_ = std::make_shared<PointerAcceleration>();
+        acceleration2_ = std::make_shared<PointerAcceleration>();
         autofire1 = std::make_shared<GamePadFeatures>();
         autofire2 = std::make_shared<GamePadFeatures>();
 
@@ -102,11 +239,14 @@ class Pipeline : public Runnable {
         mouse_switcher1_->set_swap_callback(std::bind(&Pipeline::swap_callback, this));
         mouse_switcher2_->set_swap_callback(std::bind(&Pipeline::swap_callback, this));
 
-        primary_mouse_switcher_->mouse_target_ = mouse_switcher1_;
+        acceleration1_->target_ = mouse_switcher1_;
+        acceleration2_->target_ = mouse_switcher2_;
+
+        primary_mouse_switcher_->mouse_target_ = acceleration1_;
         primary_mouse_switcher_->gamepad_target_ = autofire2;
         primary_mouse_switcher_->other_gamepad_target_ = autofire1;
 
-        primary_joystick_switcher_->mouse_target_ = mouse_switcher2_;
+        primary_joystick_switcher_->mouse_target_ = acceleration2_;
         primary_joystick_switcher_->gamepad_target_ = autofire1;
         primary_joystick_switcher_->other_gamepad_target_ = autofire2;
 
@@ -119,13 +259,19 @@ class Pipeline : public Runnable {
         autofire2->target_ = mouse_port_;
         autofire1->target_ = joystick_port_;
 
-        mouse_switcher1_->set_mode(mouse_mode_);
-        mouse_switcher2_->set_mode(mouse_mode_);
-        autofire1->set_c64_mode(mouse_mode_ == 2);
-        autofire2->set_c64_mode(mouse_mode_ == 2);
+        apply_mouse_mode();
 
-        runnables_.push_back(primary_mouse_switcher_);
-        runnables_.push_back(primary_joystick_switcher_);
+        led_pattern_task_ = scheduler_.add(&led_pattern_);
+        size_t mouse_task = scheduler_.add(primary_mouse_switcher_.get());
+        size_t joystick_task = scheduler_.add(primary_joystick_switcher_.get());
+        primary_mouse_switcher_->set_wake_callback([this, mouse_task]() {
+            scheduler_.wake(mouse_task);
+            notify_mouse_activity(*primary_mouse_switcher_);
+        });
+        primary_joystick_switcher_->set_wake_callback([this, joystick_task]() {
+            scheduler_.wake(joystick_task);
+            notify_mouse_activity(*primary_joystick_switcher_);
+        });
 
         // Ensure muxing is performed even without attached device
         primary_joystick_switcher_->ensure_muxing();
@@ -134,12 +280,22 @@ class Pipeline : public Runnable {
         PRINTF("Pipeline established\n");
     }
 
+    /**
+     * @brief Starts an LED blinking pattern
+     *
+     * @param pattern   pattern to show
+     */
+    void show_led_pattern(enum LedPatternGenerator::Pattern pattern) {
+        led_pattern_.set_pattern(pattern);
+        scheduler_.wake(led_pattern_task_);
+    }
+
     /**
      * @brief Performs controller port swapping
      * Also ensures that GPIOs are correctly mixed
      */
     void swap_callback() {
-        led_pattern_.set_pattern(LedPatternGenerator::k2Long);
+        show_led_pattern(LedPatternGenerator::k2Long);
 
         if (mouse_port_)
             mouse_port_->swap();
@@ -149,6 +305,9 @@ class Pipeline : public Runnable {
 
         if (primary_mouse_switcher_)
             primary_mouse_switcher_->ensure_muxing();
+
+        // Port states must be written again
+        scheduler_.wake_all();
     }
 
     /**
@@ -162,30 +321,72 @@ class Pipeline : public Runnable {
         PRINTF("Cycle mouse mode!\n");
         mouse_mode_ = (mouse_mode_ + 1) % MouseModeSwitcher::number_modes();
 
-        mouse_mode_write_back_at_ = board_millis() + 1000 * 10;
-        mouse_mode_dirty_ = true;
-
-        mouse_switcher1_->set_mode(mouse_mode_);
-        mouse_switcher2_->set_mode(mouse_mode_);
-        autofire1->set_c64_mode(mouse_mode_ == 2);
-        autofire2->set_c64_mode(mouse_mode_ == 2);
+        schedule_config_write();
+        apply_mouse_mode();
 
         primary_joystick_switcher_->ensure_muxing();
         primary_mouse_switcher_->ensure_muxing();
+        scheduler_.wake_all();
 
         switch (mouse_mode_) {
         case 0:
-            led_pattern_.set_pattern(LedPatternGenerator::k3Short); // Amiga
+            show_led_pattern(LedPatternGenerator::k3Short); // Amiga
             break;
         case 1:
-            led_pattern_.set_pattern(LedPatternGenerator::kMorseR); // Atari ST
+            show_led_pattern(LedPatternGenerator::kMorseR); // Atari ST
             break;
         case 2:
-            led_pattern_.set_pattern(LedPatternGenerator::k2Long); // C1351
+            show_led_pattern(LedPatternGenerator::k2Long); // C1351
             break;
         }
     }
 
+    /**
+     * @brief Switches to next rate profile of the current mouse type
+     *
+     * Selects e.g. the conservative rate of the Atari ST.
+     * The profile is indicated by the number of LED blinks.
+     * Like the mouse type, the profile is stored in flash after 10 seconds.
+     * Mouse types with a single profile, like the Amiga, ignore this.
+     */
+    void cycle_rate_profile() {
+        if (MouseModeSwitcher::number_rate_profiles(mouse_mode_) < 2)
+            return;
+
+        size_t &profile = rate_profile_[mouse_mode_];
+        profile = (profile + 1) % MouseModeSwitcher::number_rate_profiles(mouse_mode_);
+        PRINTF("Cycle rate profile to %zu!\n", profile);
+
+        schedule_config_write();
+        apply_mouse_mode();
+
+        primary_joystick_switcher_->ensure_muxing();
+        primary_mouse_switcher_->ensure_muxing();
+        scheduler_.wake_all();
+
+        show_led_pattern(profile == 0 ? LedPatternGenerator::k1Short : LedPatternGenerator::k2Short);
+    }
+
+    /**
+     * @brief Switches to next pointer acceleration curve
+     *
+     * Applies to all mouse types. The curve is indicated by the number of LED blinks.
+     * Like the mouse type, the curve is stored in flash after 10 seconds.
+     */
+    void cycle_acceleration_curve() {
+        acceleration_curve_ = (acceleration_curve_ + 1) % PointerAcceleration::kCurves.size();
+        PRINTF("Cycle acceleration curve to %zu!\n", acceleration_curve_);
+
+        schedule_config_write();
+        acceleration1_->set_curve(acceleration_curve_);
+        acceleration2_->set_curve(acceleration_curve_);
+
+        static constexpr std::array<LedPatternGenerator::Pattern, 4> kPatterns{
+            LedPatternGenerator::k1Short, LedPatternGenerator::k2Short, LedPatternGenerator::k3Short,
+            LedPatternGenerator::k4Short};
+        show_led_pattern(kPatterns[acceleration_curve_]);
+    }
+
     /**
      * @brief Integrates a new HID handler into the pipeline
      *
@@ -200,14 +401,10 @@ class Pipeline : public Runnable {
 
             if (primary_mouse_switcher_->mouse_source_empty()) {
                 PRINTF("Primary mouse\n");
-
-                handler->set_target(primary_mouse_switcher_);
-                primary_mouse_switcher_->register_source(handler);
+                attach_source(handler, primary_mouse_switcher_);
             } else if (primary_joystick_switcher_->mouse_source_empty()) {
                 PRINTF("Secondary mouse\n");
-
-                handler->set_target(primary_joystick_switcher_);
-                primary_joystick_switcher_->register_source(handler);
+                attach_source(handler, primary_joystick_switcher_);
             } else {
                 PRINTF("Mouse ignored!\n");
             }
@@ -216,14 +413,10 @@ class Pipeline : public Runnable {
         case kGamePad:
             if (primary_joystick_switcher_->joystick_source_empty()) {
                 PRINTF("Primary joystick\n");
-
-                handler->set_target(primary_joystick_switcher_);
-                primary_joystick_switcher_->register_source(handler);
+                attach_source(handler, primary_joystick_switcher_);
             } else if (primary_mouse_switcher_->joystick_source_empty()) {
                 PRINTF("Secondary joystick\n");
-
-                handler->set_target(primary_mouse_switcher_);
-                primary_mouse_switcher_->register_source(handler);
+                attach_source(handler, primary_mouse_switcher_);
             } else {
                 PRINTF("Joystick ignored!\n");
             }
@@ -231,22 +424,53 @@ class Pipeline : public Runnable {
             break;
         }
 
-        led_pattern_.set_pattern(LedPatternGenerator::k1Short);
+        // The LED is owned by the output core
+        handler_integrated_.store(true, std::memory_order_release);
     }
 
-    void run() override {
-        led_pattern_.run();
-        for (auto &i : runnables_) {
-            i->run();
+    /**
+     * @brief Processes queued reports and drives the controller ports
+     *
+     * Must be called frequently by the output core.
+     */
+    void run_outputs() {
+        BridgedReport report;
+        while (bridge_queue_.pop(report)) {
+            if (report.hub_ == kMouseHubIndex)
+                ReportBridge::deliver(report, *primary_mouse_switcher_);
+            else
+                ReportBridge::deliver(report, *primary_joystick_switcher_);
         }
 
+        if (handler_integrated_.load(std::memory_order_acquire)) {
+            handler_integrated_.store(false, std::memory_order_relaxed);
+            show_led_pattern(LedPatternGenerator::k1Short);
+        }
+
+        scheduler_.dispatch(board_micros());
+
+#if CONFIG_LATENCY_TRACE == 1
+        LatencyTrace::instance().provide_snapshot();
+#endif
+
         if (mouse_mode_dirty_ && board_millis() > mouse_mode_write_back_at_) {
             PRINTF("Write mouse_mode to flash!\n");
 
-            fee_.write_config(static_cast<uint8_t>(mouse_mode_));
+            uint8_t config = config_byte();
+            ConfigWriter::instance().stage(kConfigMouseMode, std::span(&config, 1));
             mouse_mode_dirty_ = false;
         }
 
+        // Might freeze the outputs for some time. Only done while they are quiet
+        ConfigWriter::instance().run(board_micros());
+    }
+
+    /**
+     * @brief Maintains the association of report sources
+     *
+     * Must be called frequently by the USB core.
+     */
+    void run_inputs() {
         // Perform some plausibility checks
         if (primary_joystick_switcher_->joystick_source_empty() &&
             primary_mouse_switcher_->joystick_source_empty() == false) {
@@ -254,8 +478,7 @@ class Pipeline : public Runnable {
             std::shared_ptr<ReportSourceInterface> joy = primary_mouse_switcher_->take_joystick_source();
 
             if (joy) {
-                joy->set_target(primary_joystick_switcher_);
-                primary_joystick_switcher_->register_source(joy);
+                attach_source(joy, primary_joystick_switcher_);
             }
             PRINTF("Moving joystick over!\n");
         }
@@ -265,10 +488,20 @@ class Pipeline : public Runnable {
 
             std::shared_ptr<ReportSourceInterface> mouse = primary_joystick_switcher_->take_mouse_source();
             if (mouse) {
-                mouse->set_target(primary_mouse_switcher_);
-                primary_mouse_switcher_->register_source(mouse);
+                attach_source(mouse, primary_mouse_switcher_);
             }
             PRINTF("Moving mouse over!\n");
         }
     }
+
+    /// @brief Provides statistics about the dispatching of the processors
+    const SchedulerStats &scheduler_stats() {
+        return scheduler_.stats();
+    }
+
+    /// @brief Performs both \ref run_outputs and \ref run_inputs for single core operation
+    void run() override {
+        run_outputs();
+        run_inputs();
+    }
 };
@@ -0,0 +1,215 @@
+/**
+ * @file pointer_acceleration.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+
+#include "interfaces.hpp"
+#include "utility.h"
+
+/**
+ * @brief Velocity dependent gain of mouse movement
+ *
+ * The gain is a fixed point value with 8 fractional bits, stored per velocity
+ * in a lookup table which is calculated during compilation.
+ * The velocity is measured in quarter counts per millisecond.
+ */
+struct AccelerationCurve {
+    /// @brief Number of velocity steps inside \ref gain_
+    static constexpr size_t kTableSize{64};
+
+    /// @brief Fixed point representation of a gain of 1.0
+    static constexpr uint32_t kUnityGain{256};
+
+    /// @brief Name for debug output
+    const char *name_;
+
+    /// @brief Gain for every velocity. Higher velocities use the last entry
+    std::array<uint16_t, kTableSize> gain_;
+
+    /**
+     * @brief Creates a curve which smoothly changes from one gain to another
+     *
+     * Uses a smoothstep between both velocities to avoid sudden changes
+     * of the pointer speed.
+     *
+     * @param name      Name for debug output
+     * @param low_gain  Gain below low_velocity
+     * @param high_gain Gain above high_velocity
+     * @param low_velocity  Velocity where the gain starts to change
+     * @param high_velocity Velocity where the gain stops to change
+     * @return constexpr AccelerationCurve
+     */
+    static constexpr AccelerationCurve smoothstep(const char *name, uint32_t low_gain, uint32_t high_gain,
+                                                  uint32_t low_velocity, uint32_t high_velocity) {
+        AccelerationCurve curve{name, {}};
+
+        for (uint32_t velocity = 0; velocity < kTableSize; velocity++) {
+            uint32_t gain;
+
+            if (velocity <= low_velocity) {
+                gain = low_gain;
+            } else if (velocity >= high_velocity) {
+                gain = high_gain;
+            } else {
+                // Position between both velocities with 8 fractional bits
+                uint32_t t = ((velocity - low_velocity) << 8) / (high_velocity - low_velocity);
+                // 3t^2 - 2t^3
+                uint32_t s = (t * t * (3 * 256 - 2 * t)) >> 16;
+                gain = low_gain + ((high_gain - low_gain) * s >> 8);
+            }
+
+            curve.gain_[velocity] = static_cast<uint16_t>(gain);
+        }
+
+        return curve;
+    }
+};
+
+/**
+ * @brief Applies a velocity dependent gain to mouse movement
+ *
+ * Sits between \ref JoystickMouseSwitcher and \ref MouseModeSwitcher.
+ * Slow movements can be reduced for precise positioning, while fast movements
+ * can be increased to cross the screen with less movement of the hand.
+ *
+ * Only integer arithmetic is used as the RP2040 has no FPU.
+ * Per report, a single table lookup and a single division for the velocity
+ * is required. Fractions are carried over to the next report.
+ * The wheel is not modified.
+ */
+class PointerAcceleration : public RunnableMouseReportProcessor {
+  private:
+    /// @brief Index of the curve in \ref kCurves
+    size_t curve_{0};
+
+    /// @brief Fractional horizontal movement still to output. 8 fractional bits
+    int32_t remainder_x_{0};
+
+    /// @brief Fractional vertical movement still to output. 8 fractional bits
+    int32_t remainder_y_{0};
+
+    /// @brief Absolute time in microseconds of the last report
+    uint32_t last_report_{0};
+
+    /// @brief Shortest time in microseconds between reports used for the velocity.
+    /// Equal to the highest polling rate of USB full speed
+    static constexpr uint32_t kMinReportInterval{125};
+
+    /// @brief Longest time in microseconds between reports used for the velocity.
+    /// Reports after a longer pause are treated as slow movement
+    static constexpr uint32_t kMaxReportInterval{16000};
+
+    /**
+     * @brief Applies a gain to a single axis
+     *
+     * Rounds towards zero, so both directions behave the same.
+     *
+     * @param value     Movement as reported
+     * @param gain      Fixed point gain with 8 fractional bits
+     * @param remainder Fractional movement of the previous call. Updated
+     * @return int16_t  Resulting movement
+     */
+    static int16_t apply_gain(int32_t value, uint32_t gain, int32_t &remainder) {
+        int32_t product = value * static_cast<int32_t>(gain) + remainder;
+        int32_t result = product / static_cast<int32_t>(AccelerationCurve::kUnityGain);
+        remainder = product - result * static_cast<int32_t>(AccelerationCurve::kUnityGain);
+
+        return static_cast<int16_t>(std::clamp<int32_t>(result, std::numeric_limits<int16_t>::min(),
+                                                        std::numeric_limits<int16_t>::max()));
+    }
+
+  public:
+    /// @brief Available curves. The first one doesn't modify the movement
+    static constexpr std::array<AccelerationCurve, 4> kCurves{
+        AccelerationCurve::smoothstep("Off", 256, 256, 0, 0),
+        AccelerationCurve::smoothstep("Precise", 128, 256, 2, 16),
+        AccelerationCurve::smoothstep("Classic", 256, 512, 8, 40),
+        AccelerationCurve::smoothstep("Fast", 256, 768, 4, 32),
+    };
+
+    /// @brief Next stage of the pipeline
+    std::shared_ptr<RunnableMouseReportProcessor> target_;
+
+    /**
+     * @brief Selects a curve
+     *
+     * @param curve     Index inside \ref kCurves
+     */
+    void set_curve(size_t curve) {
+        curve_ = curve % kCurves.size();
+        remainder_x_ = 0;
+        remainder_y_ = 0;
+        PRINTF("Acceleration curve %s\n", kCurves[curve_].name_);
+    }
+
+    /// @brief Returns the index of the selected curve
+    size_t curve() {
+        return curve_;
+    }
+
+    /**
+     * @brief Calculates the velocity of a movement
+     *
+     * Uses max + min/2 as approximation of the euclidean length.
+     *
+     * @param x         Horizontal movement
+     * @param y         Vertical movement
+     * @param interval  Time in microseconds since the previous movement
+     * @return uint32_t Velocity in quarter counts per millisecond
+     */
+    static uint32_t velocity(int32_t x, int32_t y, uint32_t interval) {
+        uint32_t ax = std::abs(x);
+        uint32_t ay = std::abs(y);
+        uint32_t distance = std::max(ax, ay) + std::min(ax, ay) / 2;
+
+        interval = std::clamp(interval, kMinReportInterval, kMaxReportInterval);
+        return distance * 4000 / interval;
+    }
+
+    void process_mouse_report(MouseReport &report) override {
+        uint32_t now = board_micros();
+        uint32_t interval = now - last_report_;
+        last_report_ = now;
+
+        if (curve_ != 0 && (report.relx || report.rely)) {
+            uint32_t index = std::min<uint32_t>(velocity(report.relx, report.rely, interval),
+                                                AccelerationCurve::kTableSize - 1);
+            uint32_t gain = kCurves[curve_].gain_[index];
+
+            report.relx = apply_gain(report.relx, gain, remainder_x_);
+            report.rely = apply_gain(report.rely, gain, remainder_y_);
+        }
+
+        if (target_)
+            target_->process_mouse_report(report);
+    }
+
+    void ensure_mouse_muxing() override {
+        if (target_)
+            target_->ensure_mouse_muxing();
+    }
+
+    void run() override {
+        if (target_)
+            target_->run();
+    }
+
+    uint32_t next_deadline(uint32_t now) override {
+        return target_ ? target_->next_deadline(now) : now + kIdlePeriod;
+    }
+};
@@ -0,0 +1,407 @@
+/**
+ * @file port_recorder.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "config.h"
+#include "interfaces.hpp"
+#include "utility.h"
+
+/**
+ * @brief Time stamped signal changes of all controller ports
+ *
+ * Filled by \ref PortRecorder. The oldest changes are dropped when the
+ * ring buffer is full. The changes are exported as Value Change Dump, which
+ * can be viewed with GTKWave.
+ *
+ * Every change only affects some of the signals. Steps of the PIO are
+ * recorded ahead of time, when they are queued, with the time the PIO is expected
+ * to perform them. The changes are sorted by time before the export.
+ *
+ * The firmware records on the output core and prints on the USB core. On request,
+ * the output core only copies the changes with \ref provide_snapshot, while
+ * \ref dump_if_ready converts and prints the copy.
+ */
+class PortWaveform {
+  public:
+    /// @brief True if the controller ports are recorded by the firmware
+    static constexpr bool kEnabled{CONFIG_PORT_RECORDER == 1};
+
+    /// @brief Number of controller ports
+    static constexpr size_t kPorts{2};
+
+    /// @brief Number of signals of every controller port
+    static constexpr size_t kSignals{7};
+
+    /// @brief Default number of changes to keep. 16 KiB of RAM and the same for the copy
+    static constexpr size_t kDefaultCapacity{2048};
+
+    /// @brief Signals of \ref ControllerPortState::all_buttons which are driven by the PIO
+    static constexpr uint8_t kDirections{0x0f};
+
+    /// @brief Signals of \ref ControllerPortState::all_buttons which are always driven by the CPU
+    static constexpr uint8_t kButtons{0x70};
+
+    /// @brief A change of some signals of a port
+    struct Change {
+        /// @brief Time in microseconds
+        uint32_t time_us;
+        /// @brief Index of the controller port
+        uint8_t port;
+        /// @brief Affected signals, in the layout of \ref ControllerPortState::all_buttons
+        uint8_t mask;
+        /// @brief New levels of the affected signals. 1 is an active signal
+        uint8_t levels;
+    };
+
+  private:
+    /// @brief Ring buffer of changes
+    std::vector<Change> changes_;
+
+    /// @brief Position of the next change in \ref changes_
+    size_t next_{0};
+
+    /// @brief Number of valid changes in \ref changes_
+    size_t size_{0};
+
+    /// @brief Number of changes which were dropped because of a full buffer
+    uint32_t dropped_{0};
+
+    /// @brief Most recently recorded levels of every port
+    std::array<uint8_t, kPorts> levels_{};
+
+    /// @brief Copy of the changes for the USB core, oldest first
+    std::vector<Change> snapshot_;
+
+    /// @brief Number of valid changes in \ref snapshot_
+    size_t snapshot_size_{0};
+
+    /// @brief Value of \ref dropped_ when \ref snapshot_ was taken
+    uint32_t snapshot_dropped_{0};
+
+    /// @brief Set by the USB core to have the output core fill \ref snapshot_
+    std::atomic<bool> snapshot_requested_{false};
+
+    /// @brief Set by the output core when \ref snapshot_ can be exported
+    std::atomic<bool> snapshot_ready_{false};
+
+    /**
+     * @brief Sorts changes by time. Stable for equal time stamps
+     *
+     * @param changes   Changes to sort, roughly oldest first
+     */
+    static void sort(std::span<Change> changes) {
+        // Only steps of the PIO are out of order, by a few steps at most
+        for (size_t i = 1; i < changes.size(); i++) {
+            Change change = changes[i];
+            size_t j = i;
+            while (j > 0 && static_cast<int32_t>(change.time_us - changes[j - 1].time_us) < 0) {
+                changes[j] = changes[j - 1];
+                j--;
+            }
+            changes[j] = change;
+        }
+    }
+
+    /**
+     * @brief Exports changes as Value Change Dump
+     *
+     * The time is relative to the oldest change. All signals are inactive before.
+     *
+     * @param changes   Changes to export, roughly oldest first. Are sorted in place
+     * @param dropped   Number of changes which were dropped because of a full buffer
+     * @param print     Called with every line of the export
+     */
+    template <typename Print> static void export_changes(std::span<Change> changes, uint32_t dropped, Print &&print) {
+        static constexpr std::array<const char *, kPorts> kPortNames{"right", "left"};
+        static constexpr std::array<const char *, kSignals> kSignalNames{"up",    "down",  "left", "right",
+                                                                         "fire1", "fire2", "fire3"};
+        char line[80];
+
+        sort(changes);
+
+        print("$timescale 1us $end\n");
+        snprintf(line, sizeof(line), "$comment %lu changes dropped $end\n", static_cast<unsigned long>(dropped));
+        print(line);
+        print("$scope module yaumataca $end\n");
+        for (size_t port = 0; port < kPorts; port++) {
+            snprintf(line, sizeof(line), "$scope module %s $end\n", kPortNames[port]);
+            print(line);
+            for (size_t signal = 0; signal < kSignals; signal++) {
+                snprintf(line, sizeof(line), "$var wire 1 %c %s $end\n", identifier(port, signal),
+                         kSignalNames[signal]);
+                print(line);
+            }
+            print("$upscope $end\n");
+        }
+        print("$upscope $end\n");
+        print("$enddefinitions $end\n");
+
+        if (changes.empty())
+            return;
+
+        uint32_t start = changes[0].time_us;
+        print("#0\n$dumpvars\n");
+        for (size_t port = 0; port < kPorts; port++) {
+            for (size_t signal = 0; signal < kSignals; signal++) {
+                snprintf(line, sizeof(line), "0%c\n", identifier(port, signal));
+                print(line);
+            }
+        }
+        print("$end\n");
+
+        std::array<uint8_t, kPorts> levels{};
+        uint32_t last_time = 0;
+        for (const Change &change : changes) {
+            uint8_t changed = (levels[change.port] ^ change.levels) & change.mask;
+            if (!changed)
+                continue;
+
+            uint32_t time = change.time_us - start;
+            if (time != last_time) {
+                snprintf(line, sizeof(line), "#%lu\n", static_cast<unsigned long>(time));
+                print(line);
+                last_time = time;
+            }
+
+            for (size_t signal = 0; signal < kSignals; signal++) {
+                if (changed & (1 << signal)) {
+                    snprintf(line, sizeof(line), "%c%c\n", (change.levels & (1 << signal)) ? '1' : '0',
+                             identifier(change.port, signal));
+                    print(line);
+                }
+            }
+            levels[change.port] ^= changed;
+        }
+    }
+
+  public:
+    /**
+     * @brief Construct a new Port Waveform
+     *
+     * @param capacity  Number of changes to keep
+     */
+    explicit PortWaveform(size_t capacity = kDefaultCapacity) : changes_(capacity), snapshot_(capacity) {
+    }
+
+    /// @brief Returns the instance of the firmware. Changes must only be recorded by the output core
+    static PortWaveform &instance() {
+        static PortWaveform waveform;
+        return waveform;
+    }
+
+    /**
+     * @brief Records a change of some signals
+     *
+     * Nothing is recorded if none of the signals has changed.
+     *
+     * @param port      Index of the controller port
+     * @param mask      Signals to record, in the layout of \ref ControllerPortState::all_buttons
+     * @param levels    Levels of the signals
+     * @param time_us   Time of the change in microseconds
+     */
+    void record(size_t port, uint8_t mask, uint8_t levels, uint32_t time_us) {
+        if (port >= kPorts || ((levels_[port] ^ levels) & mask) == 0)
+            return;
+
+        levels_[port] = (levels_[port] & ~mask) | (levels & mask);
+
+        if (size_ == changes_.size())
+            dropped_++;
+        else
+            size_++;
+
+        changes_[next_] = {time_us, static_cast<uint8_t>(port), mask, static_cast<uint8_t>(levels & mask)};
+        next_ = (next_ + 1) % changes_.size();
+    }
+
+    /// @brief Returns the number of recorded changes
+    size_t size() const {
+        return size_;
+    }
+
+    /// @brief Returns the number of changes which were dropped because of a full buffer
+    uint32_t dropped() const {
+        return dropped_;
+    }
+
+    /// @brief Removes all changes
+    void clear() {
+        next_ = 0;
+        size_ = 0;
+        dropped_ = 0;
+    }
+
+    /**
+     * @brief Exports all changes as Value Change Dump
+     *
+     * The time is relative to the oldest change. All signals are inactive before.
+     * Only for single threaded use, like the replay on the host.
+     *
+     * @param print     Called with every line of the export
+     */
+    template <typename Print> void export_vcd(Print &&print) {
+        // Oldest change first
+        if (size_ == changes_.size()) {
+            std::rotate(changes_.begin(), changes_.begin() + next_, changes_.end());
+            next_ = 0;
+        }
+
+        export_changes(std::span(changes_).first(size_), dropped_, print);
+    }
+
+    /**
+     * @brief Provides the identifier of a signal inside the Value Change Dump
+     *
+     * @param port      Index of the controller port
+     * @param signal    Bit of the signal in \ref ControllerPortState::all_buttons
+     * @return char     Printable character
+     */
+    static char identifier(size_t port, size_t signal) {
+        return static_cast<char>('!' + port * kSignals + signal);
+    }
+
+    /// @brief Asks the output core to provide a copy of the changes. Must be called by the USB core
+    void request_dump() {
+        snapshot_requested_.store(true, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Copies the changes if requested
+     *
+     * Must be called frequently by the output core. Only copies, as printing
+     * the whole waveform would stall the outputs.
+     */
+    void provide_snapshot() {
+        if (!snapshot_requested_.exchange(false, std::memory_order_relaxed))
+            return;
+
+        // The USB core might still export the previous copy
+        if (snapshot_ready_.load(std::memory_order_acquire))
+            return;
+
+        size_t oldest = (next_ + changes_.size() - size_) % changes_.size();
+        for (size_t i = 0; i < size_; i++)
+            snapshot_[i] = changes_[(oldest + i) % changes_.size()];
+
+        snapshot_size_ = size_;
+        snapshot_dropped_ = dropped_;
+        snapshot_ready_.store(true, std::memory_order_release);
+    }
+
+    /**
+     * @brief Exports the copy of the changes as Value Change Dump if the output core has provided one
+     *
+     * Must be called frequently by the USB core.
+     *
+     * @param print     Called with every line of the export
+     * @return true     The copy was exported
+     */
+    template <typename Print> bool export_snapshot(Print &&print) {
+        if (!snapshot_ready_.load(std::memory_order_acquire))
+            return false;
+
+        export_changes(std::span(snapshot_).first(snapshot_size_), snapshot_dropped_, print);
+        snapshot_ready_.store(false, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Prints the copy of the changes if the output core has provided one
+     *
+     * Must be called frequently by the USB core. Uses printf instead of PRINTF,
+     * as CONFIG_PORT_RECORDER selects the RTT logger on its own.
+     */
+    void dump_if_ready() {
+        export_snapshot([](const char *line) { printf("%s", line); });
+    }
+};
+
+/**
+ * @brief Records every change of a controller port in a \ref PortWaveform
+ *
+ * Placed in front of the physical port and forwards everything to it.
+ * Signals driven by the PIO are taken from \ref pio_step_queued instead of \ref set_port_state.
+ */
+class PortRecorder : public ControllerPortInterface {
+  private:
+    /// @brief Port to forward to
+    std::shared_ptr<ControllerPortInterface> target_;
+
+    /// @brief Destination of the changes
+    PortWaveform &waveform_;
+
+    /// @brief True while the directional signals are driven by the PIO
+    bool pio_active_{false};
+
+  public:
+    /**
+     * @brief Construct a new Port Recorder
+     *
+     * @param target    Port to forward to
+     * @param waveform  Destination of the changes. Must outlive this object
+     */
+    PortRecorder(std::shared_ptr<ControllerPortInterface> target, PortWaveform &waveform)
+        : target_(target), waveform_(waveform) {
+    }
+
+    void set_port_state(ControllerPortState &state) override {
+        target_->set_port_state(state);
+
+        uint8_t mask = pio_active_ ? PortWaveform::kButtons : (PortWaveform::kButtons | PortWaveform::kDirections);
+        waveform_.record(target_->get_index(), mask, state.all_buttons, board_micros());
+    }
+
+    void directions_driven_by_pio(bool active) override {
+        pio_active_ = active;
+        target_->directions_driven_by_pio(active);
+    }
+
+    void pio_step_queued(const ControllerPortState &state, uint32_t time_us) override {
+        waveform_.record(target_->get_index(), PortWaveform::kDirections, state.all_buttons, time_us);
+        target_->pio_step_queued(state, time_us);
+    }
+
+    uint get_pot_x_drain_gpio() override {
+        return target_->get_pot_x_drain_gpio();
+    }
+    uint get_pot_y_drain_gpio() override {
+        return target_->get_pot_y_drain_gpio();
+    }
+    uint get_pot_y_sense_gpio() override {
+        return target_->get_pot_y_sense_gpio();
+    }
+    void configure_gpios() override {
+        target_->configure_gpios();
+    }
+    const char *get_name() override {
+        return target_->get_name();
+    }
+    size_t get_index() override {
+        return target_->get_index();
+    }
+    uint32_t get_gpio_mask(const ControllerPortState &state) override {
+        return target_->get_gpio_mask(state);
+    }
+    uint get_direction_gpio_base() override {
+        return target_->get_direction_gpio_base();
+    }
+};
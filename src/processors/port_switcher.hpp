@@ -10,6 +10,8 @@
  */
 
 #include "interfaces.hpp"
+#include "latency_trace.hpp"
+#include <functional>
 #include <memory>
 #include <tuple>
 
@@ -29,6 +31,12 @@ class PortSwitcher : public ControllerPortInterface {
     /// @brief Own data sink for controller port data
     std::shared_ptr<ControllerPortInterface> target_;
 
+    /// @brief Called with the time in microseconds of every change of the outputs
+    std::function<void(uint32_t)> activity_callback_;
+
+    /// @brief State of the last call of \ref set_port_state
+    ControllerPortState last_state_;
+
   public:
     virtual ~PortSwitcher() {
         PRINTF("PortSwitcher -\n");
@@ -68,8 +76,25 @@ class PortSwitcher : public ControllerPortInterface {
             std::swap(target_, swap_sibling_.lock()->target_);
         }
     }
+    /**
+     * @brief Registers callback handler for changes of the outputs
+     *
+     * Called if the port state changes or the PIO is given a step to perform.
+     *
+     * @param activity_callback function pointer or lambda, called with the time of the change
+     */
+    void set_activity_callback(std::function<void(uint32_t)> activity_callback) {
+        activity_callback_ = activity_callback;
+    }
+
     void set_port_state(ControllerPortState &state) override {
         target_->set_port_state(state);
+        // Last stage in front of the physical port
+        LatencyTrace::instance().record(target_->get_index(), state);
+
+        if (activity_callback_ && state != last_state_)
+            activity_callback_(board_micros());
+        last_state_ = state;
     }
     uint get_pot_x_drain_gpio() override {
         return target_->get_pot_x_drain_gpio();
@@ -91,4 +116,23 @@ class PortSwitcher : public ControllerPortInterface {
     size_t get_index() override {
         return target_->get_index();
     }
+
+    uint32_t get_gpio_mask(const ControllerPortState &state) override {
+        return target_->get_gpio_mask(state);
+    }
+
+    uint get_direction_gpio_base() override {
+        return target_->get_direction_gpio_base();
+    }
+
+    void directions_driven_by_pio(bool active) override {
+        target_->directions_driven_by_pio(active);
+    }
+
+    void pio_step_queued(const ControllerPortState &state, uint32_t time_us) override {
+        target_->pio_step_queued(state, time_us);
+
+        if (activity_callback_)
+            activity_callback_(time_us);
+    }
 };
@@ -14,7 +14,8 @@
 
 /**
  * @brief Simulates quadrature encoder
- * Accumulates movements over time. No movement is lost.
+ * Accumulates movements over time. No movement is lost,
+ * unless the backlog is limited by the user.
  */
 class QuadratureEncoder {
   private:
@@ -49,6 +50,16 @@ class QuadratureEncoder {
         return accumulator_;
     }
 
+    /**
+     * @brief Replaces the movement still to perform
+     * Used to limit the backlog
+     *
+     * @param accumulator   Movement to perform in the future
+     */
+    void set_accumulator(int32_t accumulator) {
+        accumulator_ = accumulator;
+    }
+
     /**
      * @brief Step quadrature signals into direction of accumulator
      * Returns pair of signals which are always 90° apart
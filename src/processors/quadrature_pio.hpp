@@ -0,0 +1,193 @@
+/**
+ * @file quadrature_pio.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <memory>
+
+#include "hardware/pio.h"
+#include "interfaces.hpp"
+#include "latency_trace.hpp"
+#include "quadrature_out.pio.h"
+#include "utility.h"
+
+/**
+ * @brief Outputs quadrature steps on the directional pins of a controller port
+ *
+ * Uses a state machine of PIO1 per controller port. Every step is put into the
+ * TX FIFO together with the time to hold it. The PIO performs the timing, which is
+ * exact and independent of the main loop. The CPU only has to refill the FIFO
+ * before it runs empty.
+ *
+ * If \ref setup_pio was not called, \ref active will never return true and
+ * the caller is expected to fall back to software timing.
+ *
+ * The state machines belong to the controller ports, not to the instances.
+ * After a swap of the ports, an instance might start on the state machine
+ * another instance has used before. Only the current owner of a state machine
+ * is allowed to disable it.
+ */
+class QuadraturePio {
+  private:
+    /// @brief PIO unit used for all ports. PIO0 is occupied by \ref C1351Converter
+    static PIO pio_;
+
+    /// @brief Position of program in PIO instruction memory
+    static uint offset_;
+
+    /// @brief Number of state machines. One per controller port
+    static constexpr size_t kStateMachines{2};
+
+    /// @brief Instance which currently drives every state machine
+    static inline std::array<QuadraturePio *, kStateMachines> owners_{};
+
+    /// @brief Controller port to drive
+    std::shared_ptr<ControllerPortInterface> target_;
+
+    /// @brief State machine to use. Equal to index of \ref target_
+    uint sm_{0};
+
+    /// @brief Lowest GPIO number of the pin group driven by the PIO
+    uint base_{0};
+
+    /// @brief Directional pins relative to \ref base_
+    uint32_t direction_mask_{0};
+
+    /// @brief Up, Down, Left and Right are the lowest bits of \ref ControllerPortState::all_buttons
+    static constexpr uint8_t kDirectionBits{0x0f};
+
+    /// @brief Pin levels relative to \ref base_ for every combination of the directional signals.
+    /// Avoids asking \ref target_ for every step
+    std::array<uint32_t, kDirectionBits + 1> step_levels_{};
+
+    /// @brief Time in microseconds the PIO is expected to perform the next queued step
+    uint32_t next_step_us_{0};
+
+    /// @brief Allows unit tests to simulate the PIO
+    friend class QuadraturePioTest;
+    friend class PipelineMuxingTest;
+
+  public:
+    QuadraturePio() {
+    }
+
+    virtual ~QuadraturePio() {
+        stop();
+    }
+
+    /**
+     * @brief Initialize PIO hardware.
+     *
+     * Must be called once before using the PIO.
+     */
+    static void setup_pio() {
+        pio_ = reinterpret_cast<PIO>(PIO1_BASE);
+        offset_ = pio_add_program(pio_, &quadrature_out_program);
+    }
+
+    /// @brief Returns true if \ref setup_pio was called
+    static bool available() {
+        return pio_ != nullptr;
+    }
+
+    /**
+     * @brief Takes over the directional pins of a controller port
+     *
+     * Must be called after \ref ControllerPortInterface::configure_gpios
+     * as this resets the pins to CPU control.
+     *
+     * @param target    Controller port to drive
+     * @param initial   State of the directional signals until the first step
+     */
+    void start(std::shared_ptr<ControllerPortInterface> target, const ControllerPortState &initial) {
+        stop();
+
+        if (!pio_ || !target)
+            return;
+
+        ControllerPortState directions;
+        directions.up = 1;
+        directions.down = 1;
+        directions.left = 1;
+        directions.right = 1;
+
+        target_ = target;
+        sm_ = target->get_index();
+
+        // The previous owner must not disable the state machine anymore
+        QuadraturePio *previous = owners_.at(sm_);
+        if (previous)
+            previous->target_.reset();
+        owners_.at(sm_) = this;
+
+        base_ = target->get_direction_gpio_base();
+        direction_mask_ = target->get_gpio_mask(directions) >> base_;
+
+        for (uint8_t i = 0; i < step_levels_.size(); i++) {
+            ControllerPortState state;
+            state.all_buttons = i;
+            step_levels_[i] = (target->get_gpio_mask(state) >> base_) & direction_mask_;
+        }
+
+        quadrature_out_program_init(pio_, sm_, offset_, base_, direction_mask_ << base_,
+                                    target->get_gpio_mask(initial));
+        target_->directions_driven_by_pio(true);
+    }
+
+    /// @brief Stops the output. Pins are kept on the PIO until reconfigured
+    void stop() {
+        if (target_) {
+            pio_sm_set_enabled(pio_, sm_, false);
+            target_->directions_driven_by_pio(false);
+            target_.reset();
+            owners_.at(sm_) = nullptr;
+        }
+    }
+
+    /// @brief Returns true if steps are performed by the PIO
+    bool active() {
+        return target_ != nullptr;
+    }
+
+    /// @brief Returns true if another step can be queued
+    bool can_take_step() {
+        return !pio_sm_is_tx_fifo_full(pio_, sm_);
+    }
+
+    /**
+     * @brief Queues a step
+     *
+     * Only the directional signals of the state are used.
+     * The latency of the state is recorded up to the time the PIO is expected
+     * to perform the step. With CONFIG_PORT_RECORDER, the step is reported to the
+     * target with the same time.
+     *
+     * @param state     State of the port during the step
+     * @param period_us Time in microseconds to hold the state
+     */
+    void put_step(const ControllerPortState &state, uint32_t period_us) {
+        uint32_t levels = step_levels_[state.all_buttons & kDirectionBits];
+        uint32_t hold_cycles = period_us - QUADRATURE_OUT_STEP_OVERHEAD;
+        pio_sm_put(pio_, sm_, (hold_cycles << 6) | levels);
+
+        // The step is performed when the previous one has ended or immediately when the FIFO was empty
+        uint32_t now = board_micros();
+        if (static_cast<int32_t>(next_step_us_ - now) < 0)
+            next_step_us_ = now;
+
+        LatencyTrace::instance().record(target_->get_index(), state.source, state.arrival_us, next_step_us_);
+#if CONFIG_PORT_RECORDER == 1
+        target_->pio_step_queued(state, next_step_us_);
+#endif
+        next_step_us_ += period_us;
+    }
+};
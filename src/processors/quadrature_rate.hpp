@@ -0,0 +1,67 @@
+/**
+ * @file quadrature_rate.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * @brief Limits of the quadrature step rate a target machine can follow
+ *
+ * Small movements are performed with \ref max_period_, which is known to be
+ * safe. With a growing backlog of movement, the period is reduced to get the
+ * backlog to the screen within a single frame, but never below \ref min_period_.
+ */
+struct QuadratureRateProfile {
+    /// @brief Name for debug output
+    const char *name_;
+
+    /// @brief Time in microseconds between two steps at the highest allowed rate
+    uint32_t min_period_;
+
+    /// @brief Time in microseconds between two steps without backlog
+    uint32_t max_period_;
+
+    /// @brief Time in microseconds the target needs to read the mouse once per frame
+    uint32_t frame_period_;
+
+    /**
+     * @brief Calculates the time between steps for the given backlog
+     *
+     * @param backlog   Number of steps still to perform
+     * @return uint32_t Time in microseconds until the next step
+     */
+    constexpr uint32_t period_for_backlog(uint32_t backlog) const {
+        if (backlog == 0)
+            return max_period_;
+
+        return std::clamp(frame_period_ / backlog, min_period_, max_period_);
+    }
+
+    /**
+     * @brief Calculates the largest backlog which can be drained in time
+     *
+     * @param latency_us    Available time in microseconds
+     * @return uint32_t Number of steps
+     */
+    constexpr uint32_t max_backlog(uint32_t latency_us) const {
+        uint32_t backlog = 0;
+        uint32_t duration = 0;
+
+        for (;;) {
+            duration += period_for_backlog(backlog + 1);
+            if (duration > latency_us)
+                return backlog;
+            backlog++;
+        }
+    }
+};
@@ -0,0 +1,122 @@
+/**
+ * @file report_bridge.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <variant>
+
+#include "interfaces.hpp"
+#include "spsc_queue.hpp"
+#include "utility.h"
+
+/**
+ * @brief A single report on its way from the USB core to the output core
+ */
+struct BridgedReport {
+    /// @brief Index of the \ref ReportHubInterface to deliver to
+    uint8_t hub_;
+    /// @brief The actual report
+    std::variant<MouseReport, GamepadReport> report_;
+};
+
+/// @brief Queue of reports crossing from USB core to output core.
+/// 32 entries are plenty as the output core empties it with every loop.
+using ReportBridgeQueue = SpscQueue<BridgedReport, 32>;
+
+/**
+ * @brief Stand-in for a \ref ReportHubInterface which lives on the other core
+ *
+ * Used as target for report sources if the USB host stack runs on core 0
+ * while the controller ports are driven by core 1.
+ * Reports are not processed but queued and delivered by \ref deliver
+ * on the output core. The source bookkeeping is relayed directly as it
+ * is only touched by the USB core.
+ */
+class ReportBridge : public ReportHubInterface {
+  private:
+    /// @brief The actual hub which is fed by \ref deliver on the output core
+    std::shared_ptr<ReportHubInterface> hub_;
+
+    /// @brief Index used to find \ref hub_ again on the output core
+    uint8_t hub_index_;
+
+    /// @brief Shared queue of all bridges
+    ReportBridgeQueue &queue_;
+
+    /**
+     * @brief Adds a report to the queue
+     *
+     * The output core never blocks for long, so waiting for a free slot
+     * is preferred over losing a button press.
+     *
+     * @param report    Report to enqueue
+     */
+    void enqueue(const BridgedReport &report) {
+        while (!queue_.push(report)) {
+        }
+    }
+
+  public:
+    /**
+     * @brief Construct a new Report Bridge
+     *
+     * @param hub       Hub on the output core to deliver to
+     * @param hub_index Index of the hub. Is handed to \ref deliver later
+     * @param queue     Queue which is shared among all bridges
+     */
+    ReportBridge(std::shared_ptr<ReportHubInterface> hub, uint8_t hub_index, ReportBridgeQueue &queue)
+        : hub_(hub), hub_index_(hub_index), queue_(queue) {
+        PRINTF("ReportBridge +\n");
+    }
+    virtual ~ReportBridge() {
+        PRINTF("ReportBridge -\n");
+    }
+
+    void register_source(std::shared_ptr<ReportSourceInterface> source) override {
+        hub_->register_source(source);
+    }
+
+    void process_mouse_report(MouseReport &report) override {
+        enqueue(BridgedReport{hub_index_, report});
+    }
+
+    void process_gamepad_report(GamepadReport &report) override {
+        enqueue(BridgedReport{hub_index_, report});
+    }
+
+    void ensure_mouse_muxing() override {
+        // Muxing is performed on the output core
+    }
+
+    void ensure_joystick_muxing() override {
+        // Muxing is performed on the output core
+    }
+
+    void run() override {
+        // Nothing to do. The output core runs the actual hub
+    }
+
+    /**
+     * @brief Delivers a queued report to the final destination
+     *
+     * Must be called on the output core.
+     *
+     * @param report    Report taken from the queue
+     * @param hub       Hub to deliver to. Must match the index of the report
+     */
+    static void deliver(BridgedReport &report, ReportHubInterface &hub) {
+        if (auto *mouse = std::get_if<MouseReport>(&report.report_)) {
+            hub.process_mouse_report(*mouse);
+        } else if (auto *gamepad = std::get_if<GamepadReport>(&report.report_)) {
+            hub.process_gamepad_report(*gamepad);
+        }
+    }
+};
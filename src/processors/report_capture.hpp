@@ -0,0 +1,369 @@
+/**
+ * @file report_capture.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <span>
+
+#include "config.h"
+#include "utility.h"
+
+/**
+ * @brief Records raw USB reports in RAM to reproduce problems on the host
+ *
+ * Every report is stored with its time of arrival and the VID/PID of the device
+ * in a ring buffer. The oldest reports are dropped when it is full.
+ * The report descriptors of mounted HID interfaces are kept separately, as they are
+ * required to create the same handlers as the firmware during the replay.
+ *
+ * \ref dump prints the capture as text lines starting with "CAP ".
+ * These lines can be copied from the RTT log and are read back by \ref parse.
+ */
+class ReportCapture {
+  public:
+    /// @brief Type of a captured event
+    enum Kind : char {
+        kMount = 'M',        ///< HID interface was mounted. Carries the report descriptor
+        kHidReport = 'R',    ///< Report of a HID interface
+        kVendorReport = 'V', ///< Transfer of a vendor class interface
+    };
+
+    /// @brief Single captured event
+    struct Event {
+        Kind kind{kHidReport};          ///< Type of the event
+        uint32_t time_us{0};            ///< Time of arrival in microseconds
+        uint8_t dev_addr{0};            ///< TinyUSB device identifier
+        uint8_t instance{0};            ///< TinyUSB interface identifier
+        uint16_t vid{0};                ///< Vendor ID of the device
+        uint16_t pid{0};                ///< Product ID of the device
+        uint16_t usage_page{0};         ///< Usage Page of the first report. Only used by kMount
+        uint16_t usage{0};              ///< Usage of the first report. Only used by kMount
+        std::span<const uint8_t> data;  ///< Report or report descriptor
+    };
+
+    /// @brief Size of the ring buffer for reports in bytes. Must be a power of two
+    static constexpr size_t kCapacity{16384};
+
+    /// @brief Reports are truncated to this length. Equal to the maximum packet size of full speed devices
+    static constexpr size_t kMaxReport{64};
+
+    /// @brief Number of report descriptors which are kept
+    static constexpr size_t kDescriptors{4};
+
+    /// @brief Report descriptors are truncated to this length
+    static constexpr size_t kMaxDescriptor{512};
+
+    /// @brief Maximum length of a line printed by \ref dump, including the terminating zero
+    static constexpr size_t kMaxLine{64 + 3 * kMaxDescriptor};
+
+  private:
+    static_assert((kCapacity & (kCapacity - 1)) == 0, "Capacity must be a power of two");
+
+    /// @brief Stored in front of every report inside the ring buffer
+    struct Header {
+        uint32_t time_us;
+        uint16_t vid;
+        uint16_t pid;
+        uint8_t dev_addr;
+        uint8_t instance;
+        uint8_t kind;
+        uint8_t len;
+    };
+
+    /// @brief Report descriptor of a mounted HID interface
+    struct Descriptor {
+        bool used{false};
+        Header header{};
+        uint16_t usage_page{0};
+        uint16_t usage{0};
+        uint16_t len{0};
+        std::array<uint8_t, kMaxDescriptor> data{};
+    };
+
+    /// @brief Stores a \ref Header followed by the report for every captured report
+    std::array<uint8_t, kCapacity> ring_{};
+
+    /// @brief Position to write the next report to. Only increments and is wrapped on access
+    uint32_t head_{0};
+
+    /// @brief Position of the oldest report. Only increments and is wrapped on access
+    uint32_t tail_{0};
+
+    /// @brief Number of reports inside \ref ring_
+    size_t count_{0};
+
+    /// @brief Number of reports which were dropped to make space for newer ones
+    uint32_t dropped_{0};
+
+    /// @brief Report descriptors of the last mounted HID interfaces
+    std::array<Descriptor, kDescriptors> descriptors_{};
+
+    /// @brief Index in \ref descriptors_ to replace next if the interface is not known yet
+    size_t next_descriptor_{0};
+
+    /**
+     * @brief Copies data into the ring buffer
+     *
+     * @param pos   Position inside the ring buffer. Is wrapped
+     * @param src   Data to copy
+     * @param len   Length in bytes
+     */
+    void write(uint32_t pos, const void *src, size_t len) {
+        auto bytes = static_cast<const uint8_t *>(src);
+        for (size_t i = 0; i < len; i++)
+            ring_[(pos + i) & (kCapacity - 1)] = bytes[i];
+    }
+
+    /**
+     * @brief Copies data out of the ring buffer
+     *
+     * @param pos   Position inside the ring buffer. Is wrapped
+     * @param dst   Destination of the data
+     * @param len   Length in bytes
+     */
+    void read(uint32_t pos, void *dst, size_t len) const {
+        auto bytes = static_cast<uint8_t *>(dst);
+        for (size_t i = 0; i < len; i++)
+            bytes[i] = ring_[(pos + i) & (kCapacity - 1)];
+    }
+
+    /// @brief Removes the oldest report from the ring buffer
+    void drop_oldest() {
+        Header header;
+        read(tail_, &header, sizeof(header));
+        tail_ += sizeof(header) + header.len;
+        count_--;
+        dropped_++;
+    }
+
+    /**
+     * @brief Parses a hexadecimal number
+     *
+     * @param[in,out] text  Text to parse. Is moved behind the number
+     * @param[out] value    Parsed number
+     * @return true         A number was found
+     */
+    static bool parse_hex(const char *&text, unsigned long &value) {
+        char *end;
+        value = strtoul(text, &end, 16);
+        if (end == text)
+            return false;
+        text = end;
+        return true;
+    }
+
+  public:
+    /// @brief Returns the single instance. Must only be used by the USB core
+    static ReportCapture &instance() {
+        static ReportCapture capture;
+        return capture;
+    }
+
+    /**
+     * @brief Keeps the report descriptor of a newly mounted HID interface
+     *
+     * @param dev_addr      TinyUSB device identifier
+     * @param instance      TinyUSB interface identifier
+     * @param vid           Vendor ID of the device
+     * @param pid           Product ID of the device
+     * @param usage_page    Usage Page of the first report
+     * @param usage         Usage of the first report
+     * @param desc          Report descriptor
+     */
+    void mount(uint8_t dev_addr, uint8_t instance, uint16_t vid, uint16_t pid, uint16_t usage_page, uint16_t usage,
+               std::span<const uint8_t> desc) {
+        auto it = std::find_if(descriptors_.begin(), descriptors_.end(), [=](const Descriptor &d) {
+            return d.used && d.header.dev_addr == dev_addr && d.header.instance == instance;
+        });
+
+        if (it == descriptors_.end()) {
+            it = descriptors_.begin() + next_descriptor_;
+            next_descriptor_ = (next_descriptor_ + 1) % kDescriptors;
+        }
+
+        it->used = true;
+        it->header = {board_micros(), vid, pid, dev_addr, instance, kMount, 0};
+        it->usage_page = usage_page;
+        it->usage = usage;
+        it->len = static_cast<uint16_t>(std::min(desc.size(), kMaxDescriptor));
+        std::copy_n(desc.begin(), it->len, it->data.begin());
+    }
+
+    /**
+     * @brief Stores a report. Drops the oldest reports if required
+     *
+     * @param kind      Either kHidReport or kVendorReport
+     * @param dev_addr  TinyUSB device identifier
+     * @param instance  TinyUSB interface identifier
+     * @param vid       Vendor ID of the device
+     * @param pid       Product ID of the device
+     * @param report    Raw report
+     */
+    void report(Kind kind, uint8_t dev_addr, uint8_t instance, uint16_t vid, uint16_t pid,
+                std::span<const uint8_t> report) {
+        Header header{board_micros(), vid, pid, dev_addr, instance, static_cast<uint8_t>(kind),
+                      static_cast<uint8_t>(std::min(report.size(), kMaxReport))};
+        size_t size = sizeof(header) + header.len;
+
+        while (kCapacity - (head_ - tail_) < size)
+            drop_oldest();
+
+        write(head_, &header, sizeof(header));
+        write(head_ + sizeof(header), report.data(), header.len);
+        head_ += size;
+        count_++;
+    }
+
+    /// @brief Returns the number of stored reports
+    size_t size() const {
+        return count_;
+    }
+
+    /// @brief Returns the number of reports which were dropped as the buffer was full
+    uint32_t dropped() const {
+        return dropped_;
+    }
+
+    /// @brief Removes all reports and report descriptors
+    void clear() {
+        head_ = tail_ = 0;
+        count_ = 0;
+        dropped_ = 0;
+        descriptors_ = {};
+        next_descriptor_ = 0;
+    }
+
+    /**
+     * @brief Calls a function for every captured event
+     *
+     * The report descriptors come first, followed by the reports from old to new.
+     *
+     * @param f     Function accepting a const Event &
+     */
+    template <typename F> void for_each(F f) const {
+        std::array<const Descriptor *, kDescriptors> mounted;
+        size_t mounted_count = 0;
+        for (auto &d : descriptors_) {
+            if (d.used)
+                mounted[mounted_count++] = &d;
+        }
+        std::sort(mounted.begin(), mounted.begin() + mounted_count,
+                  [](const Descriptor *a, const Descriptor *b) {
+                      return static_cast<int32_t>(a->header.time_us - b->header.time_us) < 0;
+                  });
+
+        for (size_t i = 0; i < mounted_count; i++) {
+            const Descriptor &d = *mounted[i];
+            f(Event{kMount, d.header.time_us, d.header.dev_addr, d.header.instance, d.header.vid, d.header.pid,
+                    d.usage_page, d.usage, std::span(d.data.data(), d.len)});
+        }
+
+        std::array<uint8_t, kMaxReport> data;
+        for (uint32_t pos = tail_; pos != head_;) {
+            Header header;
+            read(pos, &header, sizeof(header));
+            read(pos + sizeof(header), data.data(), header.len);
+            pos += sizeof(header) + header.len;
+
+            f(Event{static_cast<Kind>(header.kind), header.time_us, header.dev_addr, header.instance, header.vid,
+                    header.pid, 0, 0, std::span(data.data(), header.len)});
+        }
+    }
+
+    /**
+     * @brief Converts an event into a line of text
+     *
+     * @param event     Event to convert
+     * @param line      Destination of the text. Is always terminated
+     * @param size      Size of the destination in bytes
+     * @return size_t   Length of the text
+     */
+    static size_t format(const Event &event, char *line, size_t size) {
+        int len = snprintf(line, size, "CAP %c %lu %u %u %04x %04x %04x %04x", event.kind,
+                           static_cast<unsigned long>(event.time_us), event.dev_addr, event.instance, event.vid,
+                           event.pid, event.usage_page, event.usage);
+
+        size_t pos = std::min(static_cast<size_t>(std::max(len, 0)), size - 1);
+        for (uint8_t byte : event.data) {
+            if (pos + 3 >= size)
+                break;
+            pos += snprintf(line + pos, size - pos, " %02x", byte);
+        }
+        return pos;
+    }
+
+    /**
+     * @brief Reads a line of text created by \ref format
+     *
+     * Text in front of "CAP " is ignored. This allows to parse lines of a log file directly.
+     *
+     * @param line          Line of text
+     * @param[out] event    Parsed event. The data is placed in storage
+     * @param storage       Memory for the data of the event
+     * @return true         A valid event was found
+     */
+    static bool parse(const char *line, Event &event, std::span<uint8_t> storage) {
+        line = strstr(line, "CAP ");
+        if (!line)
+            return false;
+
+        char kind;
+        unsigned long time_us;
+        unsigned dev_addr, instance, vid, pid, usage_page, usage;
+        int consumed = 0;
+        if (sscanf(line, "CAP %c %lu %u %u %x %x %x %x%n", &kind, &time_us, &dev_addr, &instance, &vid, &pid,
+                   &usage_page, &usage, &consumed) != 8)
+            return false;
+
+        if (kind != kMount && kind != kHidReport && kind != kVendorReport)
+            return false;
+
+        event.kind = static_cast<Kind>(kind);
+        event.time_us = static_cast<uint32_t>(time_us);
+        event.dev_addr = static_cast<uint8_t>(dev_addr);
+        event.instance = static_cast<uint8_t>(instance);
+        event.vid = static_cast<uint16_t>(vid);
+        event.pid = static_cast<uint16_t>(pid);
+        event.usage_page = static_cast<uint16_t>(usage_page);
+        event.usage = static_cast<uint16_t>(usage);
+
+        const char *text = line + consumed;
+        size_t len = 0;
+        unsigned long byte;
+        while (len < storage.size() && parse_hex(text, byte))
+            storage[len++] = static_cast<uint8_t>(byte);
+
+        event.data = storage.first(len);
+        return true;
+    }
+
+    /**
+     * @brief Prints the whole capture
+     *
+     * Uses printf instead of PRINTF, as CONFIG_REPORT_CAPTURE selects the RTT logger on its own.
+     */
+    void dump() {
+        static std::array<char, kMaxLine> line;
+
+        printf("Capture of %zu reports. %lu were dropped\n", count_, static_cast<unsigned long>(dropped_));
+        for_each([](const Event &event) {
+            format(event, line.data(), line.size());
+            printf("%s\n", line.data());
+        });
+    }
+};
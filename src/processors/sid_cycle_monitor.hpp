@@ -0,0 +1,171 @@
+/**
+ * @file sid_cycle_monitor.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "c1351.pio.h"
+#include "hardware/pio.h"
+#include "utility.h"
+
+/**
+ * @brief Measures the length of the SID measurement cycle
+ *
+ * The SID drains the POT capacitors for 256 of its clock cycles and counts
+ * for another 256. A PAL C64 runs with 0.985 MHz and a NTSC C64 with 1.023 MHz,
+ * which results in a measurement cycle of 519.7 or 500.6 microseconds.
+ *
+ * A state machine of PIO1 measures the time between the falling edges of
+ * the POT Y sense pin in PIO clock ticks. The result is filtered and provided as
+ * deviation from \ref kReferencePeriod, which allows the C1351 emulation to keep
+ * its timing independent of the machine.
+ *
+ * If \ref setup_pio was not called or no C64 is attached, the reference is assumed.
+ */
+class SidCycleMonitor {
+  public:
+    /// @brief Length of a measurement cycle of a PAL C64 in PIO clock ticks.
+    /// The default calibration of the C1351 emulation was made with such a machine
+    static constexpr uint32_t kReferencePeriod{64958};
+
+    /// @brief Length of a measurement cycle of a NTSC C64 in PIO clock ticks
+    static constexpr uint32_t kNtscPeriod{62579};
+
+    /// @brief Shortest accepted measurement in PIO clock ticks. Shorter ones are glitches
+    static constexpr uint32_t kMinPeriod{60000};
+
+    /// @brief Longest accepted measurement in PIO clock ticks. Longer ones are missed edges
+    static constexpr uint32_t kMaxPeriod{70000};
+
+  private:
+    /// @brief PIO unit used for all ports. Shared with \ref QuadraturePio
+    static PIO pio_;
+
+    /// @brief Position of program in PIO instruction memory
+    static uint offset_;
+
+    /// @brief Number of fractional bits of \ref filtered_
+    static constexpr uint32_t kFilterShift{4};
+
+    /// @brief Maximum number of measurements taken per call of \ref poll
+    static constexpr uint32_t kMaxReadsPerPoll{8};
+
+    /// @brief State machine in use. Negative if not started
+    int sm_{-1};
+
+    /// @brief Low pass filtered length of the measurement cycle with \ref kFilterShift fractional bits
+    uint32_t filtered_{kReferencePeriod << kFilterShift};
+
+    /// @brief True if the filtered length is closer to NTSC than to PAL
+    bool ntsc_{false};
+
+    /// @brief Allows unit tests to simulate the PIO
+    friend class SidCycleMonitorTest;
+
+  public:
+    SidCycleMonitor() {
+    }
+
+    virtual ~SidCycleMonitor() {
+        stop();
+    }
+
+    SidCycleMonitor(SidCycleMonitor const &) = delete;
+    void operator=(SidCycleMonitor const &) = delete;
+
+    /**
+     * @brief Initialize PIO hardware.
+     *
+     * Must be called once before using the PIO.
+     */
+    static void setup_pio() {
+        pio_ = reinterpret_cast<PIO>(PIO1_BASE);
+        offset_ = pio_add_program(pio_, &sid_cycle_capture_program);
+    }
+
+    /**
+     * @brief Converts a value of the state machine into PIO clock ticks
+     *
+     * @param count     Number of decrements of the counter
+     * @return uint32_t Length of the measurement cycle in PIO clock ticks
+     */
+    static constexpr uint32_t period_from_count(uint32_t count) {
+        return count * SID_CYCLE_CAPTURE_LOOP_CYCLES + SID_CYCLE_CAPTURE_OVERHEAD;
+    }
+
+    /**
+     * @brief Starts measuring
+     *
+     * The filtered value is kept, as the machine is usually still the same.
+     *
+     * @param sm            State machine of PIO1 to use
+     * @param sense_pin     GPIO of the POT Y sense pin
+     */
+    void start(uint sm, uint sense_pin) {
+        stop();
+
+        if (!pio_)
+            return;
+
+        sm_ = sm;
+        sid_cycle_capture_program_init(pio_, sm_, offset_, sense_pin);
+    }
+
+    /// @brief Stops measuring
+    void stop() {
+        if (sm_ >= 0) {
+            pio_sm_set_enabled(pio_, sm_, false);
+            sm_ = -1;
+        }
+    }
+
+    /**
+     * @brief Takes new measurements from the state machine
+     *
+     * Must be called regularly to avoid an overflow of the RX FIFO.
+     * Lost measurements are not critical as the length is nearly constant.
+     */
+    void poll() {
+        if (sm_ < 0)
+            return;
+
+        for (uint32_t i = 0; i < kMaxReadsPerPoll && !pio_sm_is_rx_fifo_empty(pio_, sm_); i++) {
+            uint32_t period = period_from_count(pio_sm_get(pio_, sm_));
+
+            if (period < kMinPeriod || period > kMaxPeriod)
+                continue;
+
+            filtered_ = filtered_ - (filtered_ >> kFilterShift) + period;
+        }
+
+        bool ntsc = period() < (kReferencePeriod + kNtscPeriod) / 2;
+        if (ntsc != ntsc_) {
+            ntsc_ = ntsc;
+            PRINTF("SID clock of %s machine detected\n", ntsc_ ? "NTSC" : "PAL");
+        }
+    }
+
+    /// @brief Returns the filtered length of the measurement cycle in PIO clock ticks
+    uint32_t period() {
+        return (filtered_ + (1 << (kFilterShift - 1))) >> kFilterShift;
+    }
+
+    /// @brief Returns the difference of the measurement cycle to \ref kReferencePeriod in PIO clock ticks
+    int32_t deviation() {
+        return static_cast<int32_t>(period()) - static_cast<int32_t>(kReferencePeriod);
+    }
+
+    /// @brief Returns true if the machine is running with a NTSC clock
+    bool ntsc() {
+        return ntsc_;
+    }
+};
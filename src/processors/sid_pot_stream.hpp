@@ -0,0 +1,117 @@
+/**
+ * @file sid_pot_stream.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "hardware/dma.h"
+#include "hardware/pio.h"
+
+/**
+ * @brief Feeds drain durations to a state machine running sid_adc_stim using DMA
+ *
+ * The state machine takes a single value from its TX FIFO per SID
+ * measurement cycle. Values are provided in blocks of \ref kBlockSize.
+ * The DMA moves them into the TX FIFO as soon as there is space.
+ * A new block is only accepted when the TX FIFO is nearly empty. Every queued
+ * value delays new movement by a measurement cycle, so the queue is kept
+ * as short as possible while still bridging a slightly late main loop.
+ */
+class SidPotStream {
+  public:
+    /// @brief Number of measurement cycles provided at once
+    static constexpr size_t kBlockSize{2};
+
+    /// @brief Depth of the TX FIFO of a state machine
+    static constexpr size_t kFifoDepth{4};
+
+    /// @brief A new block is accepted if the TX FIFO holds this number of values or less
+    static constexpr size_t kRefillLevel{1};
+
+    /// @brief Maximum number of measurement cycles which are queued
+    static constexpr size_t kQueuedCycles{kBlockSize + kRefillLevel};
+
+    static_assert(kQueuedCycles <= kFifoDepth, "A block must fit into the TX FIFO");
+
+  private:
+    /// @brief DMA channel in use. Negative if not started
+    int channel_{-1};
+
+    /// @brief PIO unit of the state machine
+    PIO pio_{nullptr};
+
+    /// @brief State machine to feed
+    uint sm_{0};
+
+    /// @brief Values read by the DMA
+    std::array<uint32_t, kBlockSize> block_{};
+
+  public:
+    SidPotStream() {
+    }
+
+    virtual ~SidPotStream() {
+        stop();
+    }
+
+    SidPotStream(SidPotStream const &) = delete;
+    void operator=(SidPotStream const &) = delete;
+
+    /**
+     * @brief Claims a DMA channel to feed a state machine
+     *
+     * @param pio   PIO unit of the state machine
+     * @param sm    state machine to feed
+     */
+    void start(PIO pio, uint sm) {
+        stop();
+
+        pio_ = pio;
+        sm_ = sm;
+        channel_ = dma_claim_unused_channel(true);
+
+        dma_channel_config c = dma_channel_get_default_config(channel_);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, false);
+        channel_config_set_dreq(&c, pio_get_dreq(pio, sm, true));
+
+        dma_channel_configure(channel_, &c, &pio->txf[sm], block_.data(), 0, false);
+    }
+
+    /// @brief Stops the transfer and releases the DMA channel
+    void stop() {
+        if (channel_ >= 0) {
+            dma_channel_abort(channel_);
+            dma_channel_unclaim(channel_);
+            channel_ = -1;
+        }
+    }
+
+    /// @brief Returns true if the previous block was moved to the TX FIFO and the TX FIFO is nearly empty
+    bool can_take_block() {
+        return channel_ >= 0 && !dma_channel_is_busy(channel_) && pio_sm_get_tx_fifo_level(pio_, sm_) <= kRefillLevel;
+    }
+
+    /**
+     * @brief Provides the next block of values
+     *
+     * Must only be called if \ref can_take_block returns true.
+     *
+     * @param values    One value per measurement cycle
+     */
+    void put_block(const std::array<uint32_t, kBlockSize> &values) {
+        block_ = values;
+        dma_channel_transfer_from_buffer_now(channel_, block_.data(), block_.size());
+    }
+};
@@ -0,0 +1,89 @@
+/**
+ * @file spsc_queue.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Wait-free single producer, single consumer ring buffer
+ *
+ * Used to hand over data from one core to the other.
+ * Only atomic loads and stores are used as the Cortex-M0+ has no
+ * exclusive access instructions. This is sufficient as each index
+ * is only ever written by one side.
+ *
+ * @tparam T        Type of the elements. Must be copyable.
+ * @tparam kSize    Number of slots. Must be a power of 2.
+ */
+template <typename T, size_t kSize> class SpscQueue {
+    static_assert((kSize & (kSize - 1)) == 0, "kSize must be a power of 2");
+
+  private:
+    /// @brief Storage of the elements
+    std::array<T, kSize> buffer_;
+
+    /// @brief Number of elements ever pushed. Only written by the producer
+    std::atomic<uint32_t> head_{0};
+
+    /// @brief Number of elements ever popped. Only written by the consumer
+    std::atomic<uint32_t> tail_{0};
+
+  public:
+    /**
+     * @brief Adds an element to the queue. Must only be called by the producer.
+     *
+     * @param value     Element to add
+     * @return true     Element was added
+     * @return false    Queue is full. Nothing was added
+     */
+    bool push(const T &value) {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+
+        if (head - tail_.load(std::memory_order_acquire) >= kSize)
+            return false;
+
+        buffer_[head % kSize] = value;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest element from the queue. Must only be called by the consumer.
+     *
+     * @param value     Destination of the removed element
+     * @return true     Element was removed
+     * @return false    Queue is empty. value is untouched
+     */
+    bool pop(T &value) {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+
+        if (head_.load(std::memory_order_acquire) == tail)
+            return false;
+
+        value = buffer_[tail % kSize];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief Returns true if no elements are queued. Only exact when called by the consumer
+    bool empty() {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_relaxed);
+    }
+
+    /// @brief Returns the capacity of the queue
+    static constexpr size_t capacity() {
+        return kSize;
+    }
+};
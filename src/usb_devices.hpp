@@ -0,0 +1,42 @@
+/**
+ * @file usb_devices.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "device_table.hpp"
+#include "processors/interfaces.hpp"
+#include "tusb.h"
+
+/// Maximum number of reports to read from a single HID Report Descriptor
+#define MAX_REPORT 4
+
+/// @brief State of a mounted HID interface
+struct HidInterfaceSlot {
+    /// Number of valid entries in report_info
+    uint8_t report_count;
+    /// Reports as parsed by TinyUSB
+    tuh_hid_report_info_t report_info[MAX_REPORT];
+    /// Handler of the interface. nullptr if unknown
+    std::shared_ptr<HidHandlerInterface> handler;
+    /// Time of mounting in microseconds. Used to measure the time until the first report
+    uint32_t mount_time_us;
+    /// True until the first report was received after mounting
+    bool awaiting_first_report;
+};
+
+/// @brief All mounted USB devices. Hubs are not stored as they have no handler
+using UsbDeviceTable =
+    DeviceTable<HidInterfaceSlot, std::shared_ptr<ReportSourceInterface>, CFG_TUH_DEVICE_MAX, CFG_TUH_HID>;
+
+/// @brief Used by the HID and the bare API callbacks of TinyUSB
+extern UsbDeviceTable gbl_usb_devices;
@@ -11,25 +11,68 @@
 #endif
 
 #include "bsp/board_api.h"
+#include "hardware/sync.h"
+
+#if CONFIG_DUAL_CORE == 1
+#include "pico/multicore.h"
+#endif
 
 static inline uint32_t board_micros(void) {
     return timer_hw->timerawl;
 }
 
-/// Address in flash where the current mouse mode is stored
-/// via Flash EEPROM emulation
+/// Address in flash where older firmware stored the mouse mode
+/// via Flash EEPROM emulation. Only read to migrate it
+static constexpr uint32_t kFlashLegacyMouseModeOffset{0x40000};
+
+/// Address in flash where older firmware stored the C1351 emulation calibration data.
+/// Only read to migrate it
+static constexpr uint32_t kFlashLegacyCalibrationDataOffset{0x41000};
+
+/// Address in flash where compiled HID report descriptors are cached
 /// Must be dividable by 4096 which is the Flash erase sector size
-static constexpr uint32_t kFlashMouseModeOffset{0x40000};
+static constexpr uint32_t kFlashHidLayoutCacheOffset{0x42000};
 
-/// Address in flash where the C1351 emulation calibration data is stored
+/// Address in flash of the two sectors of the configuration store
 /// Must be dividable by 4096 which is the Flash erase sector size
-static constexpr uint32_t kFlashCalibrationDataOffset{0x41000};
+static constexpr uint32_t kFlashConfigStoreOffset{0x43000};
 
-static inline int8_t saturating_cast(int32_t val) {
-    if (val > std::numeric_limits<int8_t>::max())
-        return std::numeric_limits<int8_t>::max();
-    else if (val < std::numeric_limits<int8_t>::min())
-        return std::numeric_limits<int8_t>::min();
+template <typename T> static inline T saturating_cast(int32_t val) {
+    if (val > std::numeric_limits<T>::max())
+        return std::numeric_limits<T>::max();
+    else if (val < std::numeric_limits<T>::min())
+        return std::numeric_limits<T>::min();
     else
-        return static_cast<int8_t>(val);
-}
\ No newline at end of file
+        return static_cast<T>(val);
+}
+
+/**
+ * @brief Ensures that flash can be erased or programmed safely during its lifetime
+ *
+ * While the flash is busy, no code must be executed from XIP.
+ * Interrupts are disabled and in dual core mode the other core is parked
+ * inside RAM. Requires that the other core has called multicore_lockout_victim_init().
+ */
+class FlashAccessGuard {
+  private:
+    /// @brief Interrupt state to restore
+    uint32_t interrupts_;
+
+  public:
+    FlashAccessGuard() {
+#if CONFIG_DUAL_CORE == 1
+        multicore_lockout_start_blocking();
+#endif
+        interrupts_ = save_and_disable_interrupts();
+    }
+
+    ~FlashAccessGuard() {
+        restore_interrupts(interrupts_);
+#if CONFIG_DUAL_CORE == 1
+        multicore_lockout_end_blocking();
+#endif
+    }
+
+    FlashAccessGuard(FlashAccessGuard const &) = delete;
+    void operator=(FlashAccessGuard const &) = delete;
+};
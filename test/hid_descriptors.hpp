@@ -0,0 +1,76 @@
+/**
+ * @file hid_descriptors.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// HID report descriptors for unit tests.
+// Descriptors marked as composed are not dumped from real devices
+// but written to cover a specific layout or feature of the parser.
+
+/// @brief Generic USB joystick with DragonRise chip. 0079:0006
+inline constexpr uint8_t kDescDragonRise[] = {
+    0x05, 0x01, 0x09, 0x04, 0xa1, 0x01, 0xa1, 0x02, 0x75, 0x08, 0x95, 0x05, 0x15, 0x00, 0x26, 0xff, 0x00, 0x35,
+    0x00, 0x46, 0xff, 0x00, 0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x32, 0x09, 0x35, 0x81, 0x02, 0x75, 0x04,
+    0x95, 0x01, 0x25, 0x07, 0x46, 0x3b, 0x01, 0x65, 0x14, 0x09, 0x39, 0x81, 0x42, 0x65, 0x00, 0x75, 0x01, 0x95,
+    0x0c, 0x25, 0x01, 0x45, 0x01, 0x05, 0x09, 0x19, 0x01, 0x29, 0x0c, 0x81, 0x02, 0x06, 0x00, 0xff, 0x75, 0x01,
+    0x95, 0x08, 0x25, 0x01, 0x45, 0x01, 0x09, 0x01, 0x81, 0x02, 0xc0, 0xa1, 0x02, 0x75, 0x08, 0x95, 0x07, 0x46,
+    0xff, 0x00, 0x26, 0xff, 0x00, 0x09, 0x02, 0x91, 0x02, 0xc0, 0xc0,
+};
+
+/// @brief Input report 1 of the Sony DualShock 4, truncated after the analog triggers
+inline constexpr uint8_t kDescDualShock4[] = {
+    0x05, 0x01, 0x09, 0x05, 0xa1, 0x01, 0x85, 0x01, 0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x35, 0x15, 0x00,
+    0x26, 0xff, 0x00, 0x75, 0x08, 0x95, 0x04, 0x81, 0x02, 0x09, 0x39, 0x15, 0x00, 0x25, 0x07, 0x35, 0x00, 0x46,
+    0x3b, 0x01, 0x65, 0x14, 0x75, 0x04, 0x95, 0x01, 0x81, 0x42, 0x65, 0x00, 0x05, 0x09, 0x19, 0x01, 0x29, 0x0e,
+    0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x0e, 0x81, 0x02, 0x06, 0x00, 0xff, 0x09, 0x20, 0x75, 0x06, 0x95,
+    0x01, 0x15, 0x00, 0x25, 0x7f, 0x81, 0x02, 0x05, 0x01, 0x09, 0x33, 0x09, 0x34, 0x15, 0x00, 0x26, 0xff, 0x00,
+    0x75, 0x08, 0x95, 0x02, 0x81, 0x02, 0xc0,
+};
+
+/// @brief 3 button mouse of appendix B.2 of USB HID 1.11
+inline constexpr uint8_t kDescBootMouse[] = {
+    0x05, 0x01, 0x09, 0x02, 0xa1, 0x01, 0x09, 0x01, 0xa1, 0x00, 0x05, 0x09, 0x19, 0x01, 0x29, 0x03, 0x15, 0x00,
+    0x25, 0x01, 0x95, 0x03, 0x75, 0x01, 0x81, 0x02, 0x95, 0x01, 0x75, 0x05, 0x81, 0x01, 0x05, 0x01, 0x09, 0x30,
+    0x09, 0x31, 0x15, 0x81, 0x25, 0x7f, 0x75, 0x08, 0x95, 0x02, 0x81, 0x06, 0xc0, 0xc0,
+};
+
+/// @brief Composed. Mouse with report ID and 16 bit axes, matching the reports of the rapoo mouse
+inline constexpr uint8_t kDescReportIdMouse[] = {
+    0x05, 0x01, 0x09, 0x02, 0xa1, 0x01, 0x85, 0x01, 0x09, 0x01, 0xa1, 0x00, 0x05, 0x09, 0x19, 0x01, 0x29,
+    0x05, 0x15, 0x00, 0x25, 0x01, 0x95, 0x05, 0x75, 0x01, 0x81, 0x02, 0x95, 0x01, 0x75, 0x03, 0x81, 0x01,
+    0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x16, 0x01, 0x80, 0x26, 0xff, 0x7f, 0x75, 0x10, 0x95, 0x02, 0x81,
+    0x06, 0x09, 0x38, 0x15, 0x81, 0x25, 0x7f, 0x75, 0x08, 0x95, 0x01, 0x81, 0x06, 0xc0, 0xc0,
+};
+
+/// @brief Composed. Mouse with 1600 counts per inch. Push and Pop enclose the axes with their units
+inline constexpr uint8_t kDescPushPopMouse[] = {
+    0x05, 0x01, 0x09, 0x02, 0xa1, 0x01, 0x09, 0x01, 0xa1, 0x00, 0x05, 0x09, 0x19, 0x01, 0x29, 0x03, 0x15,
+    0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x03, 0x81, 0x02, 0x95, 0x05, 0x81, 0x03, 0x05, 0x01, 0x15, 0x81,
+    0x25, 0x7f, 0x75, 0x08, 0x95, 0x01, 0xa4, 0x16, 0xc0, 0xf9, 0x26, 0x40, 0x06, 0x35, 0xff, 0x45, 0x01,
+    0x65, 0x13, 0x55, 0x00, 0x75, 0x10, 0x95, 0x02, 0x09, 0x30, 0x09, 0x31, 0x81, 0x06, 0xb4, 0x09, 0x38,
+    0x81, 0x06, 0xc0, 0xc0,
+};
+
+/// @brief Composed. Joystick with 10 bit axes and 4 buttons
+inline constexpr uint8_t kDesc10BitJoystick[] = {
+    0x05, 0x01, 0x09, 0x04, 0xa1, 0x01, 0xa1, 0x00, 0x09, 0x30, 0x09, 0x31, 0x15, 0x00, 0x26, 0xff, 0x03,
+    0x75, 0x0a, 0x95, 0x02, 0x81, 0x02, 0xc0, 0x05, 0x09, 0x19, 0x01, 0x29, 0x04, 0x15, 0x00, 0x25, 0x01,
+    0x75, 0x01, 0x95, 0x04, 0x81, 0x02, 0xc0,
+};
+
+/// @brief Composed. Gamepad with a long item and axes declared by extended usages on the Button page
+inline constexpr uint8_t kDescExtendedUsages[] = {
+    0x05, 0x01, 0x09, 0x05, 0xa1, 0x01, 0xfe, 0x02, 0x00, 0xaa, 0xbb, 0x05, 0x09, 0x0b, 0x30, 0x00,
+    0x01, 0x00, 0x0b, 0x31, 0x00, 0x01, 0x00, 0x15, 0x81, 0x25, 0x7f, 0x75, 0x08, 0x95, 0x02, 0x81,
+    0x02, 0x19, 0x01, 0x29, 0x02, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x02, 0x81, 0x02, 0xc0,
+};
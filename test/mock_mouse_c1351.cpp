@@ -3,6 +3,7 @@
 #include "utility.h"
 
 std::array<struct C1351CalibrationData, 2> C1351Converter::calibration_;
+std::array<C1351TickTable, 2> C1351Converter::tick_table_;
 
 void C1351Converter::save_calibration_data() {
 }
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "device_registry.hpp"
+#include "processors/latency_trace.hpp"
+#include "processors/pipeline.hpp"
+#include "processors/port_recorder.hpp"
+#include "processors/report_capture.hpp"
+
+/// @brief Virtual clock of the host simulation. Defined next to board_micros()
+extern uint32_t global_time_us;
+
+/// @brief Controller port which remembers every state it was set to
+class RecordingControllerPort : public ControllerPortInterface {
+  private:
+    size_t index_;
+
+  public:
+    /// @brief Time of the change in virtual microseconds and the new state
+    std::vector<std::pair<uint32_t, ControllerPortState>> states_;
+
+    explicit RecordingControllerPort(size_t index) : index_(index) {
+    }
+
+    void set_port_state(ControllerPortState &state) override {
+        states_.emplace_back(global_time_us, state);
+    }
+    uint get_pot_x_drain_gpio() override {
+        return 0;
+    }
+    uint get_pot_y_drain_gpio() override {
+        return 0;
+    }
+    uint get_pot_y_sense_gpio() override {
+        return 0;
+    }
+    void configure_gpios() override {
+    }
+    const char *get_name() override {
+        return index_ ? "Left" : "Right";
+    }
+    size_t get_index() override {
+        return index_;
+    }
+    uint32_t get_gpio_mask(const ControllerPortState &) override {
+        return 0;
+    }
+    uint get_direction_gpio_base() override {
+        return 0;
+    }
+};
+
+/**
+ * @brief Feeds a capture of \ref ReportCapture through the real handlers and a \ref Pipeline
+ *
+ * The virtual clock is advanced to the time of arrival of every event. The pipeline
+ * is run in steps of \ref kStep in between. The result only depends on the capture.
+ *
+ * HID interfaces are created by \ref DeviceRegistry like the firmware does.
+ * Vendor class transfers are counted but skipped, as their drivers depend on the
+ * endpoint transfers of TinyUSB.
+ */
+class ReportReplay {
+  private:
+    /// @brief Handlers of all mounted HID interfaces. Key is the device address and the instance
+    std::map<uint16_t, std::shared_ptr<HidHandlerInterface>> handlers_;
+
+    /// @brief Difference between the virtual clock and the time stamps of the capture
+    uint32_t offset_{0};
+
+    /// @brief True after the first event has defined \ref offset_
+    bool started_{false};
+
+    static uint16_t key(const ReportCapture::Event &event) {
+        return static_cast<uint16_t>((event.dev_addr << 8) | event.instance);
+    }
+
+  public:
+    /// @brief Time in microseconds between two runs of the pipeline
+    static constexpr uint32_t kStep{100};
+
+    std::shared_ptr<RecordingControllerPort> right_port_{std::make_shared<RecordingControllerPort>(0)};
+    std::shared_ptr<RecordingControllerPort> left_port_{std::make_shared<RecordingControllerPort>(1)};
+
+    /// @brief Signal changes of both ports
+    PortWaveform waveform_{1 << 16};
+
+    std::unique_ptr<Pipeline> pipeline_{
+        std::make_unique<Pipeline>(std::make_shared<PortRecorder>(left_port_, waveform_),
+                                   std::make_shared<PortRecorder>(right_port_, waveform_))};
+
+    /// @brief Number of reports which were given to a handler
+    size_t reports_{0};
+
+    /// @brief Number of events which were not replayed
+    size_t skipped_{0};
+
+    /**
+     * @brief Runs the pipeline until the virtual clock has reached a point in time
+     *
+     * @param time_us   Absolute time in virtual microseconds
+     */
+    void advance_to(uint32_t time_us) {
+        while (static_cast<int32_t>(time_us - global_time_us) > 0) {
+            global_time_us += std::min<uint32_t>(kStep, time_us - global_time_us);
+            for (auto &[k, handler] : handlers_)
+                handler->run();
+            pipeline_->run();
+        }
+    }
+
+    /**
+     * @brief Replays a single event
+     *
+     * @param event     Event to replay. Must not be older than the previous one
+     */
+    void process(const ReportCapture::Event &event) {
+        if (!started_) {
+            started_ = true;
+            offset_ = global_time_us - event.time_us;
+        }
+        advance_to(event.time_us + offset_);
+
+        switch (event.kind) {
+        case ReportCapture::kMount: {
+            HidHandlerFactory make = DeviceRegistry::find_hid(event.vid, event.pid, event.usage_page, event.usage);
+            if (!make) {
+                skipped_++;
+                return;
+            }
+
+            std::shared_ptr<HidHandlerInterface> handler = make();
+            pipeline_->integrate_handler(handler);
+            handler->parse_hid_report_descriptor(event.vid, event.pid, event.data.data(),
+                                                 static_cast<uint16_t>(event.data.size()));
+            handler->setup_reception(event.dev_addr, event.instance);
+            handlers_[key(event)] = handler;
+            break;
+        }
+        case ReportCapture::kHidReport: {
+            auto it = handlers_.find(key(event));
+            if (it == handlers_.end()) {
+                skipped_++;
+                return;
+            }
+
+            LatencyTrace::mark_arrival();
+            it->second->process_report(event.data);
+            reports_++;
+            pipeline_->run();
+            break;
+        }
+        case ReportCapture::kVendorReport:
+            skipped_++;
+            break;
+        }
+    }
+
+    /**
+     * @brief Replays all lines of a capture file
+     *
+     * Lines which are not part of the capture are ignored. The file may be a complete RTT log.
+     *
+     * @param file      Opened file
+     * @return size_t   Number of found events
+     */
+    size_t process(FILE *file) {
+        std::vector<char> line(ReportCapture::kMaxLine);
+        std::array<uint8_t, ReportCapture::kMaxDescriptor> storage;
+        size_t events = 0;
+
+        while (fgets(line.data(), static_cast<int>(line.size()), file)) {
+            ReportCapture::Event event;
+            if (ReportCapture::parse(line.data(), event, storage)) {
+                process(event);
+                events++;
+            }
+        }
+
+        return events;
+    }
+};
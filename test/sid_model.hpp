@@ -0,0 +1,146 @@
+/**
+ * @file sid_model.hpp
+ * @author André Zeps
+ * @brief
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Model of a single POT ADC of the SID
+ *
+ * A measurement cycle takes 512 cycles of the system clock.
+ * During the first 256 cycles, the SID drains the capacitor at the POT pin.
+ * Afterwards it counts until the capacitor is charged above a threshold
+ * and latches the counter. If the threshold isn't reached, 255 is latched.
+ *
+ * The C1351 emulation detects the start of the drain and keeps the capacitor
+ * drained for a number of PIO clock ticks. Afterwards, the capacitor needs
+ * some time to be charged above the threshold.
+ */
+class SidPotAdc {
+  private:
+    /// @brief System clock of the C64 in MHz
+    double clock_mhz_;
+
+    /// @brief Time in microseconds from releasing the drain until the threshold is reached
+    double charge_us_;
+
+  public:
+    /// @brief System clock of a PAL C64 in MHz
+    static constexpr double kPalClock{0.985248};
+    /// @brief System clock of a NTSC C64 in MHz
+    static constexpr double kNtscClock{1.022727};
+
+    /// @brief Number of PIO clock ticks per microsecond
+    static constexpr double kPioTicksPerUs{125.0};
+
+    /**
+     * @brief Construct a new SID POT ADC
+     *
+     * @param clock_mhz     System clock of the C64 in MHz
+     * @param charge_us     Time in microseconds from releasing the drain until the threshold is reached
+     */
+    SidPotAdc(double clock_mhz, double charge_us) : clock_mhz_(clock_mhz), charge_us_(charge_us) {
+    }
+
+    /// @brief Duration of a measurement cycle in microseconds
+    double cycle_us() const {
+        return 512.0 / clock_mhz_;
+    }
+
+    /**
+     * @brief Performs a single measurement cycle
+     *
+     * @param ticks     PIO clock ticks the capacitor is drained, counted from the start of the cycle
+     * @return uint8_t  Latched value
+     */
+    uint8_t measure(uint32_t ticks) const {
+        double crossing_us = ticks / kPioTicksPerUs + charge_us_;
+        double counted = crossing_us * clock_mhz_ - 256.0;
+
+        if (counted < 0)
+            return 0;
+        if (counted >= 255)
+            return 255;
+        return static_cast<uint8_t>(counted);
+    }
+};
+
+/**
+ * @brief Model of the C64 side mouse driver of the 1351
+ *
+ * Follows the driver of the 1351 manual, which is used by most software.
+ * Only the lower 7 bit of the POT values are used and the lowest bit is
+ * treated as noise. The change since the previous read must therefore
+ * stay below 64 or the direction is interpreted wrongly.
+ * The previous value is only replaced if the pointer was moved.
+ */
+class C1351Driver {
+  private:
+    /// @brief POT X value of the previous read
+    uint8_t last_x_{0};
+    /// @brief POT Y value of the previous read
+    uint8_t last_y_{0};
+    /// @brief True after the first read
+    bool started_{false};
+
+  public:
+    /// @brief Horizontal position of the pointer
+    int32_t pos_x_{0};
+    /// @brief Vertical position of the pointer. Increasing upwards
+    int32_t pos_y_{0};
+
+    /**
+     * @brief Calculates the movement between two reads of a POT
+     *
+     * @param old_value Value of the previous read
+     * @param new_value Value of the current read
+     * @return int8_t   Movement of the pointer
+     */
+    static int8_t delta(uint8_t old_value, uint8_t new_value) {
+        uint8_t diff = (new_value - old_value) & 0x7f;
+
+        if (diff < 0x40)
+            return static_cast<int8_t>(diff >> 1);
+
+        int8_t negative = static_cast<int8_t>(diff | 0xc0);
+        if (negative == -1)
+            return 0;
+        return static_cast<int8_t>(negative >> 1);
+    }
+
+    /**
+     * @brief Reads both POT registers of the SID
+     *
+     * @param pot_x     Value of POT X
+     * @param pot_y     Value of POT Y
+     */
+    void read(uint8_t pot_x, uint8_t pot_y) {
+        if (!started_) {
+            started_ = true;
+            last_x_ = pot_x;
+            last_y_ = pot_y;
+            return;
+        }
+
+        int8_t dx = delta(last_x_, pot_x);
+        if (dx) {
+            pos_x_ += dx;
+            last_x_ = pot_x;
+        }
+
+        int8_t dy = delta(last_y_, pot_y);
+        if (dy) {
+            pos_y_ += dy;
+            last_y_ = pot_y;
+        }
+    }
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <stdexcept>
+
+#include "flash_kv_store.hpp"
+
+/// @brief Thrown by \ref SimulatedFlash to simulate a loss of power
+struct PowerFail : std::runtime_error {
+    PowerFail() : std::runtime_error("Power fail") {
+    }
+};
+
+/**
+ * @brief Two sectors of NOR flash in RAM
+ *
+ * Programming can only clear bits. Counts the erase cycles of every sector.
+ * Can simulate a loss of power in the middle of an operation.
+ */
+class SimulatedFlash : public FlashInterface {
+  public:
+    std::array<std::array<uint8_t, kSectorSize>, 2> sectors_;
+
+    /// @brief Number of erase cycles of every sector
+    std::array<uint32_t, 2> erase_count_{};
+
+    /// @brief Number of programmed pages
+    uint32_t program_count_{0};
+
+    /// @brief Number of operations until power fails. Negative if power never fails
+    int operations_until_power_fail_{-1};
+
+    SimulatedFlash() {
+        for (auto &sector : sectors_)
+            sector.fill(0xff);
+    }
+
+    std::span<const uint8_t> sector(size_t index) override {
+        return sectors_.at(index);
+    }
+
+    void erase(size_t index) override {
+        if (power_fails()) {
+            // Only the first half was erased
+            std::fill_n(sectors_.at(index).begin(), kSectorSize / 2, 0xff);
+            throw PowerFail();
+        }
+
+        sectors_.at(index).fill(0xff);
+        erase_count_[index]++;
+    }
+
+    void program_page(size_t index, size_t offset, const uint8_t *data) override {
+        if (offset % kPageSize != 0)
+            throw std::invalid_argument("Page not aligned");
+
+        // Only every other byte is programmed if power fails
+        bool fail = power_fails();
+        for (size_t i = 0; i < kPageSize; i += fail ? 2 : 1)
+            sectors_.at(index)[offset + i] &= data[i];
+
+        if (fail)
+            throw PowerFail();
+        program_count_++;
+    }
+
+  private:
+    bool power_fails() {
+        if (operations_until_power_fail_ < 0)
+            return false;
+        return operations_until_power_fail_-- == 0;
+    }
+};
@@ -0,0 +1,7 @@
+#pragma once
+
+#define SEGGER_RTT_MODE_NO_BLOCK_SKIP 0
+
+int SEGGER_RTT_ConfigUpBuffer(unsigned BufferIndex, const char *sName, void *pBuffer, unsigned BufferSize,
+                              unsigned Flags);
+unsigned SEGGER_RTT_WriteNoLock(unsigned BufferIndex, const void *pBuffer, unsigned NumBytes);
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "hardware/pio.h"
+
+#define SID_CYCLE_CAPTURE_LOOP_CYCLES 2
+#define SID_CYCLE_CAPTURE_OVERHEAD 5
+
+void sid_cycle_capture_program_init(PIO pio, uint sm, uint offset, uint sense_pin);
+
+static inline char sid_cycle_capture_program[10];
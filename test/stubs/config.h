@@ -3,3 +3,13 @@
 #define CONFIG_SWAP2BUTTON 0
 #define CONFIG_FORCE_MOUSE_BOOT_MODE 0
 #define CONFIG_DISABLE_AMIGA_WHEELBUSMOUSE 0
+#define CONFIG_DUAL_CORE 0
+#define CONFIG_MAX_OUTPUT_LATENCY_MS 100
+#define CONFIG_BACKLOG_DROP 0
+#define CONFIG_MOUSE_RESOLUTION_CPI 400
+#define CONFIG_MOUSE_DEFAULT_DIVISOR 2
+#define CONFIG_C1351_FULL_STEPS 0
+#define CONFIG_LATENCY_TRACE 1
+#define CONFIG_REPORT_CAPTURE 0
+#define CONFIG_BINARY_TRACE 1
+#define CONFIG_PORT_RECORDER 1
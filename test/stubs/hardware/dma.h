@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+
+typedef struct {
+    uint32_t ctrl;
+} dma_channel_config;
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(uint channel);
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger);
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count);
+bool dma_channel_is_busy(uint channel);
+void dma_channel_abort(uint channel);
+
+static inline dma_channel_config dma_channel_get_default_config(uint) {
+    return dma_channel_config{0};
+}
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config *, enum dma_channel_transfer_size) {
+}
+
+static inline void channel_config_set_read_increment(dma_channel_config *, bool) {
+}
+
+static inline void channel_config_set_write_increment(dma_channel_config *, bool) {
+}
+
+static inline void channel_config_set_dreq(dma_channel_config *, uint) {
+}
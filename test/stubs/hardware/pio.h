@@ -1,15 +1,27 @@
 #pragma once
 
 #define PIO0_BASE 0
+#define PIO1_BASE 1
 typedef void pio_program_t;
 
-typedef void *PIO;
+typedef struct {
+    uint32_t txf[4];
+} pio_hw_t;
+typedef pio_hw_t *PIO;
 
 bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm);
+bool pio_sm_is_tx_fifo_full(PIO pio, uint sm);
+uint pio_sm_get_tx_fifo_level(PIO pio, uint sm);
 void pio_sm_put(PIO pio, uint sm, uint32_t data);
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm);
+uint32_t pio_sm_get(PIO pio, uint sm);
 void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
 void sid_adc_stim_program_init(PIO pio, uint sm, uint offset, uint sense_pin,
                                uint drive_pin);
 uint pio_add_program(PIO pio, const pio_program_t *program);
 
+static inline uint pio_get_dreq(PIO, uint sm, bool is_tx) {
+    return sm * 2 + is_tx;
+}
+
 static inline char sid_adc_stim_program[10];
@@ -0,0 +1,8 @@
+#pragma once
+
+#define QUADRATURE_OUT_STEP_OVERHEAD 4
+
+void quadrature_out_program_init(PIO pio, uint sm, uint offset, uint base_pin, uint32_t pin_mask,
+                                 uint32_t initial_levels);
+
+static inline char quadrature_out_program[10];
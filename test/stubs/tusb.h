@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+
+#define CFG_TUH_DEVICE_MAX 10
+#define CFG_TUH_HID 4
+
+#define HID_USAGE_PAGE_DESKTOP 0x01
+#define HID_USAGE_DESKTOP_MOUSE 0x02
+#define HID_USAGE_DESKTOP_JOYSTICK 0x04
+#define HID_USAGE_DESKTOP_GAMEPAD 0x05
+#define HID_PROTOCOL_REPORT 1
+
+typedef struct {
+    uint8_t report_id;
+    uint8_t usage;
+    uint16_t usage_page;
+} tuh_hid_report_info_t;
+
+typedef enum {
+    XFER_RESULT_SUCCESS = 0,
+    XFER_RESULT_FAILED,
+} xfer_result_t;
+
+struct tuh_xfer_s;
+typedef struct tuh_xfer_s tuh_xfer_t;
+typedef void (*tuh_xfer_cb_t)(tuh_xfer_t *xfer);
+
+struct tuh_xfer_s {
+    uint8_t daddr;
+    uint8_t ep_addr;
+    uint8_t reserved2;
+    xfer_result_t result;
+    uint32_t actual_len;
+    uint16_t buflen;
+    uint8_t *buffer;
+    tuh_xfer_cb_t complete_cb;
+    uintptr_t user_data;
+};
+
+typedef struct {
+    uint8_t bLength;
+    uint8_t bDescriptorType;
+    uint8_t bInterfaceNumber;
+    uint8_t bAlternateSetting;
+    uint8_t bNumEndpoints;
+    uint8_t bInterfaceClass;
+    uint8_t bInterfaceSubClass;
+    uint8_t bInterfaceProtocol;
+    uint8_t iInterface;
+} tusb_desc_interface_t;
+
+typedef struct {
+    uint8_t bLength;
+    uint8_t bDescriptorType;
+    uint8_t bEndpointAddress;
+    uint8_t bmAttributes;
+    uint16_t wMaxPacketSize;
+    uint8_t bInterval;
+} tusb_desc_endpoint_t;
+
+bool tuh_vid_pid_get(uint8_t daddr, uint16_t *vid, uint16_t *pid);
+bool tuh_hid_receive_report(uint8_t dev_addr, uint8_t instance);
+bool tuh_hid_set_protocol(uint8_t dev_addr, uint8_t instance, uint8_t protocol);
+bool tuh_hid_send_report(uint8_t dev_addr, uint8_t instance, uint8_t report_id, const void *report, uint16_t len);
+bool tuh_hid_set_report(uint8_t dev_addr, uint8_t instance, uint8_t report_id, uint8_t report_type, void *report,
+                        uint16_t len);
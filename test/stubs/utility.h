@@ -4,3 +4,14 @@ uint32_t board_micros(void);
 uint32_t board_millis(void);
 
 #define PRINTF(...) printf(__VA_ARGS__)
+
+#include <limits>
+
+template <typename T> static inline T saturating_cast(int32_t val) {
+    if (val > std::numeric_limits<T>::max())
+        return std::numeric_limits<T>::max();
+    else if (val < std::numeric_limits<T>::min())
+        return std::numeric_limits<T>::min();
+    else
+        return static_cast<T>(val);
+}
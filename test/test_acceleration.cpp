@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+#include "processors/pointer_acceleration.hpp"
+#include <gtest/gtest.h>
+
+extern uint32_t global_time_us;
+
+/// Collects the movement after the acceleration
+class MovementSink : public RunnableMouseReportProcessor {
+  public:
+    int32_t x_{0};
+    int32_t y_{0};
+    int32_t wheel_{0};
+    uint32_t reports_{0};
+
+    void process_mouse_report(MouseReport &report) override {
+        x_ += report.relx;
+        y_ += report.rely;
+        wheel_ += report.wheel;
+        reports_++;
+    }
+    void ensure_mouse_muxing() override {
+    }
+    void run() override {
+    }
+};
+
+// The tables must be available without calculation at runtime
+static_assert(PointerAcceleration::kCurves[0].gain_[AccelerationCurve::kTableSize - 1] ==
+              AccelerationCurve::kUnityGain);
+static_assert(PointerAcceleration::kCurves[3].gain_[AccelerationCurve::kTableSize - 1] ==
+              3 * AccelerationCurve::kUnityGain);
+
+TEST(PointerAcceleration, CurvesAreMonotonic) {
+    for (const AccelerationCurve &curve : PointerAcceleration::kCurves) {
+        for (size_t velocity = 1; velocity < AccelerationCurve::kTableSize; velocity++) {
+            EXPECT_GE(curve.gain_[velocity], curve.gain_[velocity - 1]) << curve.name_ << " " << velocity;
+        }
+    }
+}
+
+TEST(PointerAcceleration, OutputGrowsWithSpeed) {
+    // Faster movement of the hand must never result in less movement of the pointer
+    for (size_t curve = 0; curve < PointerAcceleration::kCurves.size(); curve++) {
+        int32_t previous = 0;
+
+        for (int16_t speed = 1; speed < 64; speed++) {
+            auto sink = std::make_shared<MovementSink>();
+            PointerAcceleration acceleration;
+            acceleration.target_ = sink;
+            acceleration.set_curve(curve);
+
+            // 1000 Hz mouse
+            for (int i = 0; i < 100; i++) {
+                global_time_us += 1000;
+                MouseReport report;
+                report.relx = speed;
+                report.rely = static_cast<int16_t>(-speed);
+                acceleration.process_mouse_report(report);
+            }
+
+            EXPECT_GE(sink->x_, previous) << PointerAcceleration::kCurves[curve].name_ << " " << speed;
+            EXPECT_EQ(sink->x_, -sink->y_);
+            previous = sink->x_;
+        }
+    }
+}
+
+TEST(PointerAcceleration, OffKeepsMovement) {
+    auto sink = std::make_shared<MovementSink>();
+    PointerAcceleration acceleration;
+    acceleration.target_ = sink;
+    acceleration.set_curve(0);
+
+    MouseReport report;
+    report.relx = 1000;
+    report.rely = -3;
+    report.wheel = 2;
+    acceleration.process_mouse_report(report);
+
+    EXPECT_EQ(sink->x_, 1000);
+    EXPECT_EQ(sink->y_, -3);
+    EXPECT_EQ(sink->wheel_, 2);
+}
+
+TEST(PointerAcceleration, SlowMovementIsNotLost) {
+    auto sink = std::make_shared<MovementSink>();
+    PointerAcceleration acceleration;
+    acceleration.target_ = sink;
+    acceleration.set_curve(1);
+
+    // Single counts with a gain of 0.5 are carried over
+    for (int i = 0; i < 100; i++) {
+        global_time_us += 8000;
+        MouseReport report;
+        report.relx = 1;
+        report.rely = -1;
+        report.wheel = 1;
+        acceleration.process_mouse_report(report);
+    }
+
+    EXPECT_EQ(sink->x_, 50);
+    EXPECT_EQ(sink->y_, -50);
+    EXPECT_EQ(sink->wheel_, 100);
+}
+
+TEST(PointerAcceleration, VelocityDependsOnReportRate) {
+    // Same speed of the hand with 125 Hz and 1000 Hz
+    EXPECT_EQ(PointerAcceleration::velocity(16, 0, 8000), PointerAcceleration::velocity(2, 0, 1000));
+    // A pause is treated as slow movement
+    EXPECT_EQ(PointerAcceleration::velocity(16, 0, 1000000), PointerAcceleration::velocity(16, 0, 16000));
+    // Diagonal movement is approximated
+    EXPECT_EQ(PointerAcceleration::velocity(4, 4, 1000), 24u);
+}
+
+TEST(Benchmark, PointerAccelerationCost) {
+    auto sink = std::make_shared<MovementSink>();
+    PointerAcceleration acceleration;
+    acceleration.target_ = sink;
+    acceleration.set_curve(2);
+
+    static constexpr uint32_t kReports = 1000000;
+    const AccelerationCurve &curve = PointerAcceleration::kCurves[acceleration.curve()];
+
+    // Reference calculation with 64 bit and without carrying fractions
+    int64_t expected_x = 0;
+    int64_t expected_y = 0;
+    for (uint32_t i = 0; i < kReports; i++) {
+        int32_t x = static_cast<int32_t>(i & 0x3f) - 32;
+        int32_t y = static_cast<int32_t>((i >> 3) & 0x1f) - 16;
+        if (x || y) {
+            uint32_t index = std::min<uint32_t>(PointerAcceleration::velocity(x, y, 1000),
+                                                AccelerationCurve::kTableSize - 1);
+            expected_x += static_cast<int64_t>(x) * curve.gain_[index];
+            expected_y += static_cast<int64_t>(y) * curve.gain_[index];
+        }
+    }
+
+    // Earlier tests have advanced the clock. The first interval must be 1 ms as well
+    MouseReport start;
+    acceleration.process_mouse_report(start);
+
+    auto real_start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < kReports; i++) {
+        global_time_us += 1000;
+        MouseReport report;
+        report.relx = static_cast<int16_t>((i & 0x3f) - 32);
+        report.rely = static_cast<int16_t>(((i >> 3) & 0x1f) - 16);
+        acceleration.process_mouse_report(report);
+    }
+
+    auto real_duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - real_start).count();
+    double ns_per_report = real_duration * 1e9 / kReports;
+    printf("Acceleration per report (host): %.1f ns\n", ns_per_report);
+
+    // Every report used the gain of its velocity. Only the last fraction is still carried
+    EXPECT_EQ(sink->reports_, kReports + 1);
+    EXPECT_LT(std::abs(sink->x_ * int64_t{AccelerationCurve::kUnityGain} - expected_x),
+              int64_t{AccelerationCurve::kUnityGain});
+    EXPECT_LT(std::abs(sink->y_ * int64_t{AccelerationCurve::kUnityGain} - expected_y),
+              int64_t{AccelerationCurve::kUnityGain});
+}
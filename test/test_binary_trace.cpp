@@ -0,0 +1,122 @@
+#include <string>
+#include <vector>
+
+#include "binary_trace.hpp"
+#include "interfaces.hpp"
+#include <gtest/gtest.h>
+
+extern uint32_t global_time_us;
+
+/// @brief Content of all RTT up channels
+static std::vector<uint8_t> rtt_channels[3];
+
+/// @brief Free space of every RTT up channel
+static size_t rtt_free[3]{SIZE_MAX, SIZE_MAX, SIZE_MAX};
+
+int SEGGER_RTT_ConfigUpBuffer(unsigned BufferIndex, const char *, void *, unsigned, unsigned) {
+    rtt_channels[BufferIndex].clear();
+    return 0;
+}
+
+unsigned SEGGER_RTT_WriteNoLock(unsigned BufferIndex, const void *pBuffer, unsigned NumBytes) {
+    // Records are skipped if they don't fit
+    if (NumBytes > rtt_free[BufferIndex])
+        return 0;
+
+    rtt_free[BufferIndex] -= NumBytes;
+    auto bytes = static_cast<const uint8_t *>(pBuffer);
+    rtt_channels[BufferIndex].insert(rtt_channels[BufferIndex].end(), bytes, bytes + NumBytes);
+    return NumBytes;
+}
+
+/// @brief Decodes the complete channel of the first core as text
+static std::vector<std::string> decode_channel() {
+    std::vector<std::string> lines;
+    std::span<const uint8_t> rest(rtt_channels[BinaryTrace::kChannel]);
+    BinaryTrace::Record record;
+    char line[100];
+
+    while (size_t consumed = BinaryTrace::decode(rest, record)) {
+        rest = rest.subspan(consumed);
+        BinaryTrace::format(record, line, sizeof(line));
+        lines.emplace_back(line);
+    }
+    EXPECT_TRUE(rest.empty());
+    return lines;
+}
+
+TEST(BinaryTrace, ArgumentsFromFormat) {
+    EXPECT_EQ(count_trace_args("R %02x"), 1);
+    EXPECT_EQ(count_trace_args("100%% at %d"), 1);
+    EXPECT_EQ(BinaryTrace::kArgs[kTraceMouseReport], 4);
+    EXPECT_EQ(BinaryTrace::kArgs[kTraceOverflow], 1);
+}
+
+TEST(BinaryTrace, CompactRecords) {
+    BinaryTrace::init();
+    global_time_us += 0x12345678;
+    uint32_t t = global_time_us;
+
+    ControllerPortState state;
+    state.up = true;
+    state.fire1 = true;
+    BinaryTrace::write<kTraceRightPort>(state.all_buttons);
+
+    const std::vector<uint8_t> expected{kTraceRightPort,
+                                        static_cast<uint8_t>(t),
+                                        static_cast<uint8_t>(t >> 8),
+                                        static_cast<uint8_t>(t >> 16),
+                                        static_cast<uint8_t>(t >> 24),
+                                        0x11,
+                                        0x00,
+                                        0x00,
+                                        0x00};
+    EXPECT_EQ(rtt_channels[BinaryTrace::kChannel], expected);
+}
+
+TEST(BinaryTrace, DecodeToText) {
+    BinaryTrace::init();
+
+    int16_t relx = -5;
+    BinaryTrace::write<kTraceMouseReport>(relx, 3, 0, 1);
+    BinaryTrace::write<kTraceLeftPort>(0x44);
+    BinaryTrace::write<kTraceXbox360Report>(1, 0x1234, -32767, 100);
+
+    auto lines = decode_channel();
+    ASSERT_EQ(lines.size(), 3);
+    EXPECT_EQ(lines[0], "Mouse X:-5 Y:3 W:0 B:1");
+    EXPECT_EQ(lines[1], "L 44");
+    EXPECT_EQ(lines[2], "Xbox360W 1: buttons 1234 LX:-32767 LY:100");
+
+    // Incomplete records are not decoded
+    BinaryTrace::Record record;
+    std::span<const uint8_t> truncated(rtt_channels[BinaryTrace::kChannel].data(), 8);
+    EXPECT_EQ(BinaryTrace::decode(truncated, record), 0);
+
+    // Unknown events are skipped byte by byte
+    const uint8_t garbage[] = {0xff, kTraceLeftPort, 1, 0, 0, 0, 2, 0, 0, 0};
+    EXPECT_EQ(BinaryTrace::decode(std::span(garbage), record), 1);
+    EXPECT_EQ(record.event, kTraceEvents);
+    EXPECT_EQ(BinaryTrace::decode(std::span(garbage).subspan(1), record), 9);
+    EXPECT_EQ(record.time_us, 1);
+    EXPECT_EQ(record.args[0], 2);
+}
+
+TEST(BinaryTrace, ReportsLostRecords) {
+    BinaryTrace::init();
+
+    // Space for exactly two port states
+    rtt_free[BinaryTrace::kChannel] = 2 * 9;
+    for (int i = 0; i < 5; i++)
+        BinaryTrace::write<kTraceLeftPort>(i);
+
+    rtt_free[BinaryTrace::kChannel] = SIZE_MAX;
+    BinaryTrace::write<kTraceLeftPort>(7);
+
+    auto lines = decode_channel();
+    ASSERT_EQ(lines.size(), 4);
+    EXPECT_EQ(lines[0], "L 00");
+    EXPECT_EQ(lines[1], "L 01");
+    EXPECT_EQ(lines[2], "Trace overflow, 3 records lost");
+    EXPECT_EQ(lines[3], "L 07");
+}
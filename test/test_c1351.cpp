@@ -0,0 +1,64 @@
+#include <cstdio>
+
+#include "processors/mouse_c1351.hpp"
+#include <gtest/gtest.h>
+
+/**
+ * @brief Interpolation as it was performed for every value pushed to the PIO
+ *
+ * @return uint32_t PIO clock ticks
+ */
+static uint32_t reference_ticks(int32_t calib_64, int32_t calib_191, uint32_t pot_value) {
+    float x0, y0, x1, y1, xp, yp;
+
+    y0 = static_cast<float>(calib_64);
+    y1 = static_cast<float>(calib_191);
+    xp = static_cast<float>(pot_value);
+    x0 = 64;
+    x1 = 191;
+    yp = y0 + ((y1 - y0) / (x1 - x0)) * (xp - x0);
+
+    int32_t calibration = static_cast<int32_t>(yp);
+
+    return (256 + pot_value) * 125 + calibration;
+}
+
+/// Counts the entries of a table which differ from the reference
+static uint32_t count_differences(const C1351TickTable &table, const C1351CalibrationData &calib) {
+    uint32_t differences = 0;
+
+    for (uint32_t pot = 64; pot <= 191; pot++) {
+        if (table.pot_x_[pot - 64] != reference_ticks(calib.pot_x_64_, calib.pot_x_191_, pot))
+            differences++;
+        if (table.pot_y_[pot - 64] != reference_ticks(calib.pot_y_64_, calib.pot_y_191_, pot))
+            differences++;
+    }
+
+    return differences;
+}
+
+TEST(C1351TickTable, DefaultCalibration) {
+    C1351TickTable table;
+    EXPECT_EQ(count_differences(table, C1351CalibrationData()), 0u);
+}
+
+TEST(C1351TickTable, IdenticalToInterpolation) {
+    C1351TickTable table;
+    uint32_t differences = 0;
+
+    // Calibrations around the default values, as reached with the wheel
+    for (int32_t calib_64 = -3000; calib_64 <= 3000; calib_64 += 61) {
+        for (int32_t calib_191 = -3000; calib_191 <= 3000; calib_191 += 3) {
+            C1351CalibrationData calib;
+            calib.pot_x_64_ = calib_64;
+            calib.pot_x_191_ = calib_191;
+            calib.pot_y_64_ = calib_191;
+            calib.pot_y_191_ = calib_64;
+
+            table.update(calib);
+            differences += count_differences(table, calib);
+        }
+    }
+
+    EXPECT_EQ(differences, 0u);
+}
@@ -0,0 +1,58 @@
+#include <cstdio>
+
+#include "controller_port_pins.hpp"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+/// @brief Creates a state from \ref ControllerPortState::all_buttons
+static ControllerPortState make_state(size_t all_buttons) {
+    ControllerPortState state;
+    state.all_buttons = static_cast<uint8_t>(all_buttons);
+    return state;
+}
+
+TEST(ControllerPortPins, BitOrderOfState) {
+    // The tables rely on the order of the bit fields
+    ControllerPortState state;
+    state.up = 1;
+    EXPECT_EQ(state.all_buttons, 1 << 0);
+    state = {};
+    state.right = 1;
+    EXPECT_EQ(state.all_buttons, 1 << 3);
+    state = {};
+    state.fire3 = 1;
+    EXPECT_EQ(state.all_buttons, 1 << 6);
+}
+
+TEST(ControllerPortPins, RightPortMatchesPinMapping) {
+    EXPECT_EQ(kRightPortMasks.mask(), (1u << 7) | (1u << 9) | (1u << 10) | (1u << 11) | (1u << 12) | (1u << 14) |
+                                          (1u << 15));
+
+    for (size_t i = 0; i < ControllerPortMasks::kStates; i++) {
+        ControllerPortState state = make_state(i);
+        uint32_t expected = (state.fire2 << 7) | (state.fire1 << 9) | (state.up << 15) | (state.fire3 << 11) |
+                            (state.down << 14) | (state.left << 12) | (state.right << 10);
+        EXPECT_EQ(kRightPortMasks.levels(state), expected) << "State " << i;
+    }
+}
+
+TEST(ControllerPortPins, LeftPortMatchesPinMapping) {
+    EXPECT_EQ(kLeftPortMasks.mask(), 0x7fu);
+
+    for (size_t i = 0; i < ControllerPortMasks::kStates; i++) {
+        ControllerPortState state = make_state(i);
+        uint32_t expected = (state.right << 0) | (state.left << 1) | (state.down << 2) | (state.up << 3) |
+                            (state.fire1 << 4) | (state.fire3 << 5) | (state.fire2 << 6);
+        EXPECT_EQ(kLeftPortMasks.levels(state), expected) << "State " << i;
+    }
+}
+
+TEST(ControllerPortPins, LevelsStayInsideMask) {
+    for (auto &masks : {kRightPortMasks, kLeftPortMasks}) {
+        for (size_t i = 0; i < ControllerPortMasks::kStates; i++)
+            EXPECT_EQ(masks.levels(make_state(i)) & ~masks.mask(), 0u);
+
+        EXPECT_EQ(masks.levels(make_state(ControllerPortMasks::kStates - 1)), masks.mask());
+        EXPECT_EQ(masks.levels(make_state(0)), 0u);
+    }
+}
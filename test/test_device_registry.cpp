@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#include "device_registry.hpp"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+static std::unique_ptr<HidHandlerInterface> make_nothing() {
+    return nullptr;
+}
+
+/**
+ * @brief Creates a table of synthetic devices
+ *
+ * Every 4th device uses the same VID as the previous one, like
+ * vendors with multiple products.
+ *
+ * @tparam N    Number of devices
+ * @return      Sorted table
+ */
+template <size_t N> static constexpr std::array<DeviceRegistry::Entry, N> make_table() {
+    std::array<DeviceRegistry::Entry, N> table{};
+    uint32_t state = 12345;
+
+    for (size_t i = 0; i < N; i++) {
+        state = state * 1103515245 + 12345;
+        uint16_t vid = (i % 4) ? table[i - 1].vid_ : static_cast<uint16_t>(state >> 16);
+        // The index keeps every entry unique
+        uint16_t pid = static_cast<uint16_t>((state & 0xff00) | i);
+        table[i] = {vid, pid, make_nothing, nullptr};
+    }
+
+    return DeviceRegistry::sort(table);
+}
+
+static constexpr auto kSyntheticTable = make_table<256>();
+static_assert(DeviceRegistry::is_valid(kSyntheticTable));
+static_assert(DeviceRegistry::lookup(kSyntheticTable, kSyntheticTable[17].vid_, kSyntheticTable[17].pid_) ==
+              &kSyntheticTable[17]);
+
+TEST(DeviceRegistry, Lookup) {
+    static constexpr auto kTable = DeviceRegistry::sort(std::to_array<DeviceRegistry::Entry>({
+        {0x07b5, 0x0314, make_nothing, nullptr},
+        {0x0079, 0x0011, make_nothing, nullptr},
+        {0x054c, 0x0268, make_nothing, nullptr},
+        {0x054c, 0x05c4, make_nothing, nullptr},
+        {0x045e, 0x02d1, nullptr, nullptr},
+    }));
+    static_assert(DeviceRegistry::is_valid(kTable));
+
+    EXPECT_EQ(kTable[0].vid_, 0x0079);
+    EXPECT_EQ(kTable[4].vid_, 0x07b5);
+
+    for (auto &entry : kTable) {
+        EXPECT_EQ(DeviceRegistry::lookup(kTable, entry.vid_, entry.pid_), &entry);
+    }
+
+    // Neighbours of listed devices
+    EXPECT_EQ(DeviceRegistry::lookup(kTable, 0x054c, 0x0269), nullptr);
+    EXPECT_EQ(DeviceRegistry::lookup(kTable, 0x054d, 0x0268), nullptr);
+    EXPECT_EQ(DeviceRegistry::lookup(kTable, 0x0000, 0x0000), nullptr);
+    EXPECT_EQ(DeviceRegistry::lookup(kTable, 0xffff, 0xffff), nullptr);
+
+    std::array<DeviceRegistry::Entry, 0> empty;
+    EXPECT_EQ(DeviceRegistry::lookup(empty, 0x054c, 0x0268), nullptr);
+}
+
+TEST(DeviceRegistry, DetectsDuplicates) {
+    auto table = DeviceRegistry::sort(std::to_array<DeviceRegistry::Entry>({
+        {0x054c, 0x0268, make_nothing, nullptr},
+        {0x0810, 0x0001, make_nothing, nullptr},
+        {0x054c, 0x0268, nullptr, nullptr},
+    }));
+    EXPECT_FALSE(DeviceRegistry::is_valid(table));
+    EXPECT_TRUE(DeviceRegistry::is_valid(kSyntheticTable));
+}
+
+/// @brief Result of \ref measure_lookup
+struct LookupMeasurement {
+    /// @brief Nanoseconds per lookup
+    double ns_;
+    /// @brief Highest number of entries compared by a single lookup
+    uint32_t max_probes_;
+};
+
+/**
+ * @brief Measures the lookup of all listed devices and the same number of unknown devices
+ *
+ * @param table     Table to search
+ * @param binary    True for the binary search, false for a linear scan as reference
+ * @return LookupMeasurement
+ */
+template <size_t N>
+static LookupMeasurement measure_lookup(const std::array<DeviceRegistry::Entry, N> &table, bool binary) {
+    static constexpr uint32_t kLookups = 1000000;
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<size_t> index(0, N - 1);
+
+    std::vector<std::pair<uint16_t, uint16_t>> devices(1024);
+    for (size_t i = 0; i < devices.size(); i++) {
+        auto &entry = table[index(rng)];
+        // Every second device is not listed
+        devices[i] = {entry.vid_, static_cast<uint16_t>(entry.pid_ ^ ((i & 1) ? 0x8000 : 0))};
+    }
+
+    // Probes are counted in a separate pass to not affect the timing
+    uint32_t max_probes = 0;
+    for (auto [vid, pid] : devices) {
+        uint32_t probes = 0;
+        if (binary) {
+            DeviceRegistry::lookup(table, vid, pid, &probes);
+        } else {
+            for (auto &e : table) {
+                probes++;
+                if (e.vid_ == vid && e.pid_ == pid)
+                    break;
+            }
+        }
+        max_probes = std::max(max_probes, probes);
+    }
+
+    uint32_t found = 0;
+    auto real_start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < kLookups; i++) {
+        auto [vid, pid] = devices[i & (devices.size() - 1)];
+        const DeviceRegistry::Entry *entry = nullptr;
+
+        if (binary) {
+            entry = DeviceRegistry::lookup(table, vid, pid);
+        } else {
+            for (auto &e : table) {
+                if (e.vid_ == vid && e.pid_ == pid) {
+                    entry = &e;
+                    break;
+                }
+            }
+        }
+        found += entry != nullptr;
+    }
+
+    auto real_duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - real_start).count();
+    EXPECT_EQ(found, kLookups / 2);
+    return {real_duration * 1e9 / kLookups, max_probes};
+}
+
+TEST(Benchmark, DeviceRegistryLookup) {
+    static const auto kTable16 = make_table<16>();
+    static const auto kTable1024 = make_table<1024>();
+
+    auto binary16 = measure_lookup(kTable16, true);
+    auto binary256 = measure_lookup(kSyntheticTable, true);
+    auto binary1024 = measure_lookup(kTable1024, true);
+    auto linear16 = measure_lookup(kTable16, false);
+    auto linear256 = measure_lookup(kSyntheticTable, false);
+    auto linear1024 = measure_lookup(kTable1024, false);
+
+    printf("Entries  Binary search         Linear scan\n");
+    printf("%7d  %8.1f ns %4u probes  %8.1f ns %4u probes\n", 16, binary16.ns_, binary16.max_probes_, linear16.ns_,
+           linear16.max_probes_);
+    printf("%7d  %8.1f ns %4u probes  %8.1f ns %4u probes\n", 256, binary256.ns_, binary256.max_probes_,
+           linear256.ns_, linear256.max_probes_);
+    printf("%7d  %8.1f ns %4u probes  %8.1f ns %4u probes\n", 1024, binary1024.ns_, binary1024.max_probes_,
+           linear1024.ns_, linear1024.max_probes_);
+
+    // The binary search compares at most log2(N) + 1 entries. The timing is only printed
+    EXPECT_LE(binary16.max_probes_, std::bit_width(16u));
+    EXPECT_LE(binary256.max_probes_, std::bit_width(256u));
+    EXPECT_LE(binary1024.max_probes_, std::bit_width(1024u));
+    EXPECT_EQ(linear1024.max_probes_, 1024u);
+}
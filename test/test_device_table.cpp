@@ -0,0 +1,153 @@
+#include <map>
+#include <memory>
+#include <random>
+
+#include "device_table.hpp"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+/// @brief Simplified \ref HidInterfaceSlot
+struct TestHidSlot {
+    std::shared_ptr<int> handler;
+};
+
+static constexpr size_t kDevices = 10;
+static constexpr size_t kInstances = 4;
+
+using TestTable = DeviceTable<TestHidSlot, std::shared_ptr<int>, kDevices, kInstances>;
+
+TEST(DeviceTable, RejectsInvalidKeys) {
+    TestTable table;
+
+    EXPECT_EQ(table.hid(0, 0), nullptr);
+    EXPECT_EQ(table.hid(kDevices + 1, 0), nullptr);
+    EXPECT_EQ(table.hid(1, kInstances), nullptr);
+    EXPECT_EQ(table.vendor(0), nullptr);
+    EXPECT_EQ(table.vendor(kDevices + 1), nullptr);
+    EXPECT_NE(table.hid(kDevices, kInstances - 1), nullptr);
+    EXPECT_NE(table.vendor(kDevices), nullptr);
+
+    // Must be ignored
+    table.remove(0);
+    table.remove(kDevices + 1);
+    table.remove_hid(kDevices + 1, 0);
+}
+
+TEST(DeviceTable, FullHub) {
+    TestTable table;
+
+    // A 4 port hub with a mouse, a keyboard with integrated touchpad,
+    // a gamepad and a wireless receiver. All HID devices start with instance 0
+    table.hid(2, 0)->handler = std::make_shared<int>(1);
+    table.hid(3, 0)->handler = std::make_shared<int>(2);
+    table.hid(3, 1)->handler = std::make_shared<int>(3);
+    table.hid(3, 2)->handler = std::make_shared<int>(4);
+    table.hid(4, 0)->handler = std::make_shared<int>(5);
+    *table.vendor(5) = std::make_shared<int>(6);
+
+    EXPECT_EQ(*table.hid(2, 0)->handler, 1);
+    EXPECT_EQ(*table.hid(3, 0)->handler, 2);
+    EXPECT_EQ(*table.hid(3, 2)->handler, 4);
+    EXPECT_EQ(*table.hid(4, 0)->handler, 5);
+    EXPECT_EQ(**table.vendor(5), 6);
+
+    int handlers = 0;
+    table.for_each_hid([&](TestHidSlot &slot) { handlers += slot.handler ? 1 : 0; });
+    EXPECT_EQ(handlers, 5);
+
+    // Unplugging the keyboard must not affect the others
+    std::weak_ptr<int> touchpad = table.hid(3, 1)->handler;
+    table.remove(3);
+    EXPECT_TRUE(touchpad.expired());
+    EXPECT_EQ(table.hid(3, 0)->handler, nullptr);
+    EXPECT_EQ(*table.hid(2, 0)->handler, 1);
+    EXPECT_EQ(*table.hid(4, 0)->handler, 5);
+    EXPECT_EQ(**table.vendor(5), 6);
+}
+
+TEST(DeviceTable, RandomMountAndUnmount) {
+    TestTable table;
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> addr_dist(0, kDevices + 1);
+    std::uniform_int_distribution<int> instance_dist(0, kInstances);
+    std::uniform_int_distribution<int> op_dist(0, 3);
+
+    // Reference of the expected content
+    std::map<std::pair<uint8_t, uint8_t>, int> hid_model;
+    std::map<uint8_t, int> vendor_model;
+    std::vector<std::weak_ptr<int>> released;
+
+    for (int i = 0; i < 20000; i++) {
+        uint8_t addr = static_cast<uint8_t>(addr_dist(rng));
+        uint8_t instance = static_cast<uint8_t>(instance_dist(rng));
+        bool valid_addr = addr >= 1 && addr <= kDevices;
+        bool valid_hid = valid_addr && instance < kInstances;
+
+        switch (op_dist(rng)) {
+        case 0: // HID mount
+            if (TestHidSlot *slot = table.hid(addr, instance)) {
+                slot->handler = std::make_shared<int>(i);
+                hid_model[{addr, instance}] = i;
+            }
+            EXPECT_EQ(table.hid(addr, instance) != nullptr, valid_hid);
+            break;
+        case 1: // HID unmount
+            if (valid_hid && table.hid(addr, instance)->handler)
+                released.push_back(table.hid(addr, instance)->handler);
+            table.remove_hid(addr, instance);
+            hid_model.erase({addr, instance});
+            break;
+        case 2: // Vendor mount
+            if (auto slot = table.vendor(addr)) {
+                *slot = std::make_shared<int>(i);
+                vendor_model[addr] = i;
+            }
+            EXPECT_EQ(table.vendor(addr) != nullptr, valid_addr);
+            break;
+        case 3: // Device unmount
+            if (valid_addr) {
+                for (uint8_t j = 0; j < kInstances; j++) {
+                    if (table.hid(addr, j)->handler)
+                        released.push_back(table.hid(addr, j)->handler);
+                }
+                if (*table.vendor(addr))
+                    released.push_back(*table.vendor(addr));
+            }
+            table.remove(addr);
+            std::erase_if(hid_model, [&](auto &entry) { return entry.first.first == addr; });
+            vendor_model.erase(addr);
+            break;
+        }
+
+        // Compare everything with the reference
+        for (uint8_t a = 1; a <= kDevices; a++) {
+            for (uint8_t j = 0; j < kInstances; j++) {
+                auto it = hid_model.find({a, j});
+                auto &handler = table.hid(a, j)->handler;
+                ASSERT_EQ(handler != nullptr, it != hid_model.end());
+                if (handler) {
+                    ASSERT_EQ(*handler, it->second);
+                }
+            }
+
+            auto it = vendor_model.find(a);
+            auto &vendor = *table.vendor(a);
+            ASSERT_EQ(vendor != nullptr, it != vendor_model.end());
+            if (vendor) {
+                ASSERT_EQ(*vendor, it->second);
+            }
+        }
+
+        int handlers = 0;
+        table.for_each_hid([&](TestHidSlot &slot) { handlers += slot.handler ? 1 : 0; });
+        ASSERT_EQ(handlers, hid_model.size());
+
+        int vendors = 0;
+        table.for_each_vendor([&](std::shared_ptr<int> &slot) { vendors += slot ? 1 : 0; });
+        ASSERT_EQ(vendors, vendor_model.size());
+    }
+
+    // Every removed handler must be destroyed
+    for (auto &handler : released)
+        EXPECT_TRUE(handler.expired());
+}
@@ -0,0 +1,114 @@
+#include <cstdio>
+
+#include "hid_descriptors.hpp"
+#include "hid_report_parser.hpp"
+#include "processors/dpi_scaler.hpp"
+#include <gtest/gtest.h>
+
+TEST(DpiScaler, ResolutionFromDescriptor) {
+    // Physical extents are not given
+    EXPECT_EQ(DpiScaler::resolution_from_descriptor(-127, 127, 0, 0, 0, 0), 0u);
+
+    // Unit is not a length
+    EXPECT_EQ(DpiScaler::resolution_from_descriptor(-127, 127, -127, 127, 0x1001, 0), 0u);
+
+    // 32767 counts for 2.047 inch
+    EXPECT_EQ(DpiScaler::resolution_from_descriptor(-32767, 32767, -2047, 2047, 0x13, -3), 16007u);
+    EXPECT_EQ(DpiScaler::resolution_from_descriptor(-32767, 32767, -2047, 2047, 0x13, 0xd), 16007u);
+
+    // 127 counts for 0.8 cm
+    EXPECT_EQ(DpiScaler::resolution_from_descriptor(-127, 127, -8, 8, 0x11, -1), 403u);
+}
+
+TEST(DpiScaler, TargetResolutionIsNotScaled) {
+    DpiScaler scaler;
+    MouseReport report;
+
+    scaler.set_resolution(DpiScaler::kTargetResolution);
+    EXPECT_FALSE(scaler.active());
+
+    scaler.scale(report, 1000, -1000);
+    EXPECT_EQ(report.relx, 1000);
+    EXPECT_EQ(report.rely, -1000);
+
+    // Saturates instead of overflowing
+    scaler.scale(report, 40000, -40000);
+    EXPECT_EQ(report.relx, 32767);
+    EXPECT_EQ(report.rely, -32768);
+}
+
+TEST(DpiScaler, LowResolutionIsNotScaledUp) {
+    DpiScaler scaler;
+    MouseReport report;
+
+    scaler.set_resolution(200);
+    EXPECT_FALSE(scaler.active());
+
+    scaler.scale(report, 3, -3);
+    EXPECT_EQ(report.relx, 3);
+    EXPECT_EQ(report.rely, -3);
+}
+
+TEST(DpiScaler, HighResolutionMatchesTarget) {
+    DpiScaler scaler;
+    MouseReport report;
+
+    scaler.set_resolution(16000);
+    EXPECT_TRUE(scaler.active());
+
+    // One inch in a single report
+    scaler.scale(report, 16000, -16000);
+    EXPECT_NEAR(report.relx, 400, 1);
+    EXPECT_NEAR(report.rely, -400, 1);
+
+    // Smaller than a count but not lost
+    scaler.scale(report, 40, -40);
+    EXPECT_EQ(report.relx, 1);
+    EXPECT_EQ(report.rely, -1);
+}
+
+TEST(DpiScaler, FractionsAreCarried) {
+    DpiScaler scaler;
+    MouseReport report;
+    int32_t sum_x = 0;
+    int32_t sum_y = 0;
+
+    scaler.set_resolution(16000);
+
+    // One inch split into slow movements, which are below a single count alone
+    for (int i = 0; i < 1600; i++) {
+        scaler.scale(report, 10, -10);
+        sum_x += report.relx;
+        sum_y += report.rely;
+    }
+
+    // Both directions behave the same
+    EXPECT_NEAR(sum_x, 400, 1);
+    EXPECT_EQ(sum_x, -sum_y);
+
+    // Moving back returns to the origin
+    for (int i = 0; i < 1600; i++) {
+        scaler.scale(report, -10, 10);
+        sum_x += report.relx;
+        sum_y += report.rely;
+    }
+
+    EXPECT_EQ(sum_x, 0);
+    EXPECT_EQ(sum_y, 0);
+}
+
+TEST(DpiScaler, DescriptorWithoutPhysicalUnitsUsesDefaultDivisor) {
+    HidReportPlan plan;
+    ASSERT_TRUE(HidReportParser::compile(kDescBootMouse, sizeof(kDescBootMouse),
+                                         HidReportParser::Application::kMouse, plan));
+    ASSERT_EQ(plan.resolution(), 0u);
+
+    DpiScaler scaler;
+    MouseReport report;
+    scaler.set_resolution(plan.resolution());
+    EXPECT_EQ(scaler.active(), DpiScaler::kDefaultDivisor != 1);
+
+    scaler.scale(report, 100, -100);
+    EXPECT_EQ(report.relx, 100 / static_cast<int32_t>(DpiScaler::kDefaultDivisor));
+    EXPECT_EQ(report.rely, -100 / static_cast<int32_t>(DpiScaler::kDefaultDivisor));
+}
@@ -1,6 +1,10 @@
 
+#include <array>
+#include <chrono>
 #include <cstdio>
 #include <memory>
+#include <random>
+#include <tuple>
 
 #include "field_extractor.hpp"
 #include <gmock/gmock.h>
@@ -71,4 +75,167 @@ TEST(FieldExtractor, Extract) {
         auto result = dut.extract(data.data(), data.size());
         EXPECT_EQ(result, -14);
     }
-}
\ No newline at end of file
+}
+/**
+ * @brief Compares the plan against a separate FieldExtractor per field using random reports
+ *
+ * @param plan      Configured plan
+ * @param rng       Random number generator
+ * @param fields    Offset, length and signedness of every field of the plan
+ */
+static void compare_with_extractors(const FieldExtractorPlan &plan, std::mt19937 &rng,
+                                    const std::vector<std::tuple<size_t, size_t, bool>> &fields) {
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<uint8_t> data(16);
+    std::array<int32_t, FieldExtractorPlan::kMaxFields> values;
+
+    for (int i = 0; i < 1000; i++) {
+        for (auto &b : data)
+            b = static_cast<uint8_t>(byte(rng));
+
+        plan.extract(data.data(), data.size(), values.data());
+
+        for (size_t f = 0; f < fields.size(); f++) {
+            FieldExtractor reference;
+            auto [offset, length, relative] = fields[f];
+            reference.configure(offset, length, relative);
+            ASSERT_EQ(values[f], reference.extract(data.data(), data.size()))
+                << "Field " << f << " at " << offset << " with " << length << " bits";
+        }
+    }
+}
+
+TEST(FieldExtractor, PlanSelectsLayout) {
+    struct Case {
+        FieldExtractorPlan::Layout layout;
+        size_t x_index;
+        std::vector<std::tuple<size_t, size_t, bool>> fields;
+    };
+
+    std::vector<Case> cases{
+        // Boot protocol with 3 buttons
+        {FieldExtractorPlan::Layout::kBoot, 1, {{0, 3, false}, {8, 8, true}, {16, 8, true}}},
+        // Boot protocol with 8 buttons and wheel
+        {FieldExtractorPlan::Layout::kBoot, 1, {{0, 8, false}, {8, 8, true}, {16, 8, true}, {24, 8, true}}},
+        // Like boot protocol but with report ID
+        {FieldExtractorPlan::Layout::kAlignedXY8, 1, {{8, 5, false}, {16, 8, true}, {24, 8, true}, {32, 8, true}}},
+        // rapoo mouse
+        {FieldExtractorPlan::Layout::kAlignedXY16, 1, {{8, 5, false}, {16, 16, true}, {32, 16, true}, {48, 8, true}}},
+        // Packed 12 bit axes after 16 buttons
+        {FieldExtractorPlan::Layout::kPackedXY12, 1, {{0, 16, false}, {16, 12, true}, {28, 12, true}, {40, 8, true}}},
+        // X and Y at the start
+        {FieldExtractorPlan::Layout::kPackedXY12, 0, {{0, 12, true}, {12, 12, true}, {24, 3, false}}},
+        // Absolute axes are not specialized
+        {FieldExtractorPlan::Layout::kGeneric, 0, {{0, 8, false}, {8, 8, false}, {44, 12, false}}},
+        // Unaligned axes are not specialized
+        {FieldExtractorPlan::Layout::kGeneric, 1, {{0, 5, false}, {5, 12, true}, {17, 12, true}}},
+        // Axes which don't follow each other are not specialized
+        {FieldExtractorPlan::Layout::kGeneric, 0, {{8, 16, true}, {32, 16, true}}},
+        // No axes at all
+        {FieldExtractorPlan::Layout::kGeneric, 2, {{0, 1, false}, {1, 7, false}}},
+    };
+
+    std::mt19937 rng(1234);
+    for (auto &c : cases) {
+        FieldExtractorPlan plan;
+        for (auto [offset, length, relative] : c.fields)
+            plan.add(offset, length, relative);
+        plan.finalize(c.x_index);
+
+        EXPECT_EQ(plan.layout(), c.layout);
+        EXPECT_EQ(plan.size(), c.fields.size());
+        compare_with_extractors(plan, rng, c.fields);
+    }
+}
+
+TEST(FieldExtractor, PlanMatchesRandomFields) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> count_dist(1, FieldExtractorPlan::kMaxFields);
+    std::uniform_int_distribution<size_t> offset_dist(0, 64);
+    std::uniform_int_distribution<size_t> length_dist(1, 24);
+    std::uniform_int_distribution<int> aligned_length(1, 4);
+    std::bernoulli_distribution coin;
+
+    for (int i = 0; i < 200; i++) {
+        std::vector<std::tuple<size_t, size_t, bool>> fields;
+        size_t count = count_dist(rng);
+
+        for (size_t f = 0; f < count; f++) {
+            if (coin(rng)) {
+                // Byte aligned
+                fields.emplace_back(offset_dist(rng) & ~7, aligned_length(rng) * 8, coin(rng));
+            } else {
+                fields.emplace_back(offset_dist(rng), length_dist(rng), coin(rng));
+            }
+        }
+
+        // Sometimes place a specialized pair of axes
+        if (count >= 2 && coin(rng)) {
+            static constexpr std::array<size_t, 3> kAxisLengths{8, 12, 16};
+            size_t length = kAxisLengths[rng() % kAxisLengths.size()];
+            size_t offset = offset_dist(rng) & ~7;
+            fields[0] = {offset, length, true};
+            fields[1] = {offset + length, length, true};
+        }
+
+        FieldExtractorPlan plan;
+        for (auto [offset, length, relative] : fields)
+            plan.add(offset, length, relative);
+        plan.finalize(0);
+
+        compare_with_extractors(plan, rng, fields);
+    }
+}
+
+TEST(Benchmark, FieldExtractorPlan) {
+    struct Case {
+        const char *name;
+        std::vector<std::tuple<size_t, size_t, bool>> fields;
+    };
+
+    std::vector<Case> cases{
+        {"Boot", {{0, 3, false}, {8, 8, true}, {16, 8, true}, {24, 8, true}}},
+        {"Aligned 16", {{8, 5, false}, {16, 16, true}, {32, 16, true}, {48, 8, true}}},
+        {"Packed 12", {{0, 16, false}, {16, 12, true}, {28, 12, true}, {40, 8, true}}},
+    };
+
+    static constexpr uint32_t kReports = 1000000;
+    std::vector<uint8_t> data({0x01, 0x03, 0xff, 0xfe, 0xff, 0xff, 0xfe, 0x00});
+
+    printf("Layout       Separate  Plan\n");
+    for (auto &c : cases) {
+        std::vector<FieldExtractor> separate(c.fields.size());
+        FieldExtractorPlan plan;
+        for (size_t f = 0; f < c.fields.size(); f++) {
+            auto [offset, length, relative] = c.fields[f];
+            separate[f].configure(offset, length, relative);
+            plan.add(offset, length, relative);
+        }
+        plan.finalize(1);
+
+        int64_t sum_separate = 0;
+        auto real_start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < kReports; i++) {
+            data[2] = static_cast<uint8_t>(i);
+            for (auto &extractor : separate)
+                sum_separate += extractor.extract(data.data(), data.size());
+        }
+        auto separate_duration =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - real_start).count();
+
+        int64_t sum_plan = 0;
+        std::array<int32_t, FieldExtractorPlan::kMaxFields> values;
+        real_start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < kReports; i++) {
+            data[2] = static_cast<uint8_t>(i);
+            plan.extract(data.data(), data.size(), values.data());
+            for (size_t f = 0; f < c.fields.size(); f++)
+                sum_plan += values[f];
+        }
+        auto plan_duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - real_start).count();
+
+        printf("%-12s %5.1f ns %5.1f ns\n", c.name, separate_duration * 1e9 / kReports,
+               plan_duration * 1e9 / kReports);
+        EXPECT_EQ(sum_separate, sum_plan);
+    }
+}
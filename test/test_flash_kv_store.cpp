@@ -0,0 +1,350 @@
+#include <vector>
+
+#include "config_store.hpp"
+#include "processors/config_writer.hpp"
+#include "simulated_flash.hpp"
+#include <gtest/gtest.h>
+
+extern uint32_t global_time_us;
+
+// The host keeps its configuration in RAM
+FlashKvStore &config_store() {
+    static SimulatedFlash flash;
+    static FlashKvStore store(flash);
+    return store;
+}
+
+/// @brief Returns a value as vector for comparison
+static std::vector<uint8_t> value_of(FlashKvStore &store, size_t key) {
+    std::span<const uint8_t> value = store.get(key);
+    return {value.begin(), value.end()};
+}
+
+/// @brief Stores a 32 bit number
+static bool write_number(FlashKvStore &store, size_t key, uint32_t number) {
+    return store.write(key, std::span(reinterpret_cast<const uint8_t *>(&number), sizeof(number)));
+}
+
+/// @brief Reads a 32 bit number. 0 if not stored
+static uint32_t read_number(FlashKvStore &store, size_t key) {
+    uint32_t number = 0;
+    std::span<const uint8_t> value = store.get(key);
+    if (value.size() == sizeof(number))
+        memcpy(&number, value.data(), sizeof(number));
+    return number;
+}
+
+TEST(FlashKvStore, WriteAndMount) {
+    SimulatedFlash flash;
+    FlashKvStore store(flash);
+
+    EXPECT_FALSE(store.formatted());
+    EXPECT_TRUE(store.get(3).empty());
+
+    const std::vector<uint8_t> value{1, 2, 3, 4, 5};
+    ASSERT_TRUE(store.write(3, value));
+    EXPECT_TRUE(store.formatted());
+    EXPECT_EQ(value_of(store, 3), value);
+
+    FlashKvStore mounted(flash);
+    EXPECT_TRUE(mounted.formatted());
+    EXPECT_EQ(value_of(mounted, 3), value);
+    EXPECT_TRUE(mounted.get(2).empty());
+    EXPECT_EQ(mounted.free_space(), store.free_space());
+}
+
+TEST(FlashKvStore, UnchangedValueIsNotWritten) {
+    SimulatedFlash flash;
+    FlashKvStore store(flash);
+
+    ASSERT_TRUE(write_number(store, 0, 42));
+    uint32_t programmed = flash.program_count_;
+    size_t free = store.free_space();
+
+    ASSERT_TRUE(write_number(store, 0, 42));
+    EXPECT_EQ(flash.program_count_, programmed);
+    EXPECT_EQ(store.free_space(), free);
+
+    // An empty value is still a value
+    ASSERT_TRUE(store.write(1, {}));
+    ASSERT_TRUE(store.write(1, {}));
+    EXPECT_EQ(store.free_space(), free - sizeof(FlashKvStore::RecordHeader));
+}
+
+TEST(FlashKvStore, CompactionKeepsNewestValues) {
+    SimulatedFlash flash;
+    FlashKvStore store(flash);
+
+    const std::vector<uint8_t> calibration(32, 0x5a);
+    ASSERT_TRUE(store.write(kConfigC1351Calibration, calibration));
+    ASSERT_TRUE(write_number(store, 7, 7));
+
+    size_t sector = store.active_sector();
+    uint32_t i = 0;
+    while (store.active_sector() == sector)
+        ASSERT_TRUE(write_number(store, kConfigMouseMode, ++i));
+
+    EXPECT_EQ(flash.erase_count_[1 - sector], 1u);
+    EXPECT_EQ(read_number(store, kConfigMouseMode), i);
+    EXPECT_EQ(value_of(store, kConfigC1351Calibration), calibration);
+    EXPECT_EQ(read_number(store, 7), 7u);
+
+    FlashKvStore mounted(flash);
+    EXPECT_EQ(mounted.active_sector(), store.active_sector());
+    EXPECT_EQ(read_number(mounted, kConfigMouseMode), i);
+    EXPECT_EQ(value_of(mounted, kConfigC1351Calibration), calibration);
+}
+
+TEST(FlashKvStore, RejectsWhatDoesNotFit) {
+    SimulatedFlash flash;
+    FlashKvStore store(flash);
+    const std::vector<uint8_t> large(FlashKvStore::kMaxValue, 0x11);
+
+    EXPECT_FALSE(store.write(FlashKvStore::kKeys, {}));
+    EXPECT_FALSE(store.write(0, std::vector<uint8_t>(FlashKvStore::kMaxValue + 1)));
+
+    // 15 large values fit into a sector, 16 don't
+    for (size_t key = 0; key < 15; key++)
+        ASSERT_TRUE(store.write(key, large));
+    EXPECT_FALSE(store.write(15, large));
+
+    for (size_t key = 0; key < 15; key++)
+        EXPECT_EQ(value_of(store, key), large);
+    EXPECT_TRUE(store.get(15).empty());
+}
+
+TEST(FlashKvStore, WearIsSpread) {
+    SimulatedFlash flash;
+    FlashKvStore store(flash);
+
+    for (uint32_t i = 1; i <= 20000; i++)
+        ASSERT_TRUE(write_number(store, i % 3, i));
+
+    // Every sector holds about 500 records between two erases
+    EXPECT_GT(flash.erase_count_[0], 15u);
+    EXPECT_LE(std::max(flash.erase_count_[0], flash.erase_count_[1]) -
+                  std::min(flash.erase_count_[0], flash.erase_count_[1]),
+              1u);
+    EXPECT_EQ(read_number(store, 0), 19998u);
+    EXPECT_EQ(read_number(store, 1), 19999u);
+    EXPECT_EQ(read_number(store, 2), 20000u);
+}
+
+TEST(FlashKvStore, PowerFailKeepsOldOrNewValue) {
+    static constexpr uint32_t kWrites{600};
+
+    // Fill the first sector almost completely, to have a compaction in between
+    SimulatedFlash initial;
+    {
+        FlashKvStore store(initial);
+        ASSERT_TRUE(store.write(5, std::vector<uint8_t>(40, 0x55)));
+        for (uint32_t i = 1; i <= 450; i++)
+            ASSERT_TRUE(write_number(store, 1, i));
+    }
+
+    // Count the operations without loss of power
+    SimulatedFlash reference = initial;
+    {
+        FlashKvStore store(reference);
+        for (uint32_t i = 451; i <= kWrites; i++)
+            ASSERT_TRUE(write_number(store, 1, i));
+    }
+    ASSERT_GT(reference.erase_count_[1], initial.erase_count_[1]);
+    int operations = static_cast<int>(reference.program_count_ - initial.program_count_ + reference.erase_count_[0] +
+                                      reference.erase_count_[1] - initial.erase_count_[0] - initial.erase_count_[1]);
+
+    for (int fail_at = 0; fail_at < operations; fail_at++) {
+        SimulatedFlash flash = initial;
+        flash.operations_until_power_fail_ = fail_at;
+        uint32_t written = 450;
+
+        try {
+            FlashKvStore store(flash);
+            for (uint32_t i = 451; i <= kWrites; i++) {
+                write_number(store, 1, i);
+                written = i;
+            }
+            FAIL() << "Power has not failed at " << fail_at;
+        } catch (const PowerFail &) {
+        }
+
+        // Power is back
+        FlashKvStore store(flash);
+        uint32_t value = read_number(store, 1);
+        EXPECT_TRUE(value == written || value == written + 1) << "fail_at " << fail_at << " value " << value;
+        EXPECT_EQ(value_of(store, 5), std::vector<uint8_t>(40, 0x55)) << "fail_at " << fail_at;
+
+        // Writing is still possible
+        ASSERT_TRUE(write_number(store, 1, 1000));
+        FlashKvStore mounted(flash);
+        EXPECT_EQ(read_number(mounted, 1), 1000u);
+    }
+}
+
+TEST(LegacyConfig, Migration) {
+    std::array<uint8_t, FlashInterface::kSectorSize> mouse_mode_sector;
+    std::array<uint8_t, FlashInterface::kSectorSize> calibration_sector;
+    mouse_mode_sector.fill(0xff);
+    calibration_sector.fill(0xff);
+
+    // The mouse mode was changed three times
+    mouse_mode_sector[0] = 0x01;
+    mouse_mode_sector[1] = 0x22;
+    mouse_mode_sector[2] = 0x06;
+
+    // Calibration is followed by "VALID"
+    for (size_t i = 0; i < 32; i++)
+        calibration_sector[i] = static_cast<uint8_t>(i);
+    memcpy(&calibration_sector[32], "VALID", 6);
+
+    SimulatedFlash flash;
+    FlashKvStore store(flash);
+    LegacyConfig::migrate(store, mouse_mode_sector, calibration_sector, 32);
+
+    EXPECT_TRUE(store.formatted());
+    EXPECT_EQ(value_of(store, kConfigMouseMode), std::vector<uint8_t>{0x06});
+    EXPECT_EQ(value_of(store, kConfigC1351Calibration),
+              std::vector<uint8_t>(calibration_sector.begin(), calibration_sector.begin() + 32));
+
+    // Only performed once
+    mouse_mode_sector[3] = 0x03;
+    LegacyConfig::migrate(store, mouse_mode_sector, calibration_sector, 32);
+    EXPECT_EQ(value_of(store, kConfigMouseMode), std::vector<uint8_t>{0x06});
+}
+
+TEST(LegacyConfig, NothingToMigrate) {
+    std::array<uint8_t, FlashInterface::kSectorSize> erased;
+    erased.fill(0xff);
+
+    SimulatedFlash flash;
+    FlashKvStore store(flash);
+    LegacyConfig::migrate(store, erased, erased, 32);
+
+    // Formatted anyway, to not search again
+    EXPECT_TRUE(store.formatted());
+    EXPECT_TRUE(store.get(kConfigMouseMode).empty());
+    EXPECT_TRUE(store.get(kConfigC1351Calibration).empty());
+    EXPECT_EQ(flash.erase_count_[0] + flash.erase_count_[1], 1u);
+}
+
+/// @brief Flash which advances the virtual clock like the real one
+class SlowFlash : public SimulatedFlash {
+  public:
+    static constexpr uint32_t kEraseTime{45000};
+    static constexpr uint32_t kProgramTime{800};
+
+    void erase(size_t index) override {
+        global_time_us += kEraseTime;
+        SimulatedFlash::erase(index);
+    }
+
+    void program_page(size_t index, size_t offset, const uint8_t *data) override {
+        global_time_us += kProgramTime;
+        SimulatedFlash::program_page(index, offset, data);
+    }
+};
+
+TEST(ConfigWriter, WritesOnlyWhileQuiet) {
+    SlowFlash flash;
+    FlashKvStore store(flash);
+    ConfigWriter writer(store, global_time_us);
+
+    writer.stage(kConfigMouseMode, std::vector<uint8_t>{0x12});
+    EXPECT_TRUE(writer.pending());
+    EXPECT_EQ(writer.get(kConfigMouseMode).size(), 1u);
+    EXPECT_EQ(writer.get(kConfigMouseMode)[0], 0x12);
+    EXPECT_TRUE(store.get(kConfigMouseMode).empty());
+
+    // Outputs are busy for some time
+    for (int i = 0; i < 100; i++) {
+        global_time_us += 50000;
+        writer.notify_activity(global_time_us);
+        EXPECT_FALSE(writer.run(global_time_us));
+    }
+
+    global_time_us += ConfigWriter::kQuietPeriod - 1;
+    EXPECT_FALSE(writer.run(global_time_us));
+    EXPECT_EQ(flash.program_count_, 0u);
+
+    global_time_us += 1;
+    EXPECT_TRUE(writer.run(global_time_us));
+    EXPECT_FALSE(writer.pending());
+    EXPECT_EQ(value_of(store, kConfigMouseMode), std::vector<uint8_t>{0x12});
+    EXPECT_FALSE(writer.run(global_time_us));
+}
+
+TEST(ConfigWriter, StepsOfThePioCountAsActivity) {
+    SlowFlash flash;
+    FlashKvStore store(flash);
+    ConfigWriter writer(store, global_time_us);
+
+    // The PIO performs the step later on
+    writer.stage(kConfigMouseMode, std::vector<uint8_t>{0x01});
+    writer.notify_activity(global_time_us + 10000);
+    writer.notify_activity(global_time_us);
+
+    global_time_us += ConfigWriter::kQuietPeriod;
+    EXPECT_FALSE(writer.run(global_time_us));
+    global_time_us += 10000;
+    EXPECT_TRUE(writer.run(global_time_us));
+}
+
+TEST(ConfigWriter, MeasuresStall) {
+    SlowFlash flash;
+    FlashKvStore store(flash);
+    ConfigWriter writer(store, global_time_us);
+    const std::vector<uint8_t> calibration(32, 0x5a);
+
+    writer.stage(kConfigMouseMode, std::vector<uint8_t>{0x01});
+    writer.stage(kConfigC1351Calibration, calibration);
+    writer.stage(kConfigMouseMode, std::vector<uint8_t>{0x02});
+    global_time_us += ConfigWriter::kQuietPeriod;
+
+    // A single value per call. The first one has to format the store
+    EXPECT_TRUE(writer.run(global_time_us));
+    EXPECT_TRUE(writer.pending());
+    EXPECT_GE(writer.stats().last_stall_us_, SlowFlash::kEraseTime);
+
+    EXPECT_TRUE(writer.run(global_time_us));
+    EXPECT_FALSE(writer.pending());
+    EXPECT_EQ(writer.stats().last_stall_us_, SlowFlash::kProgramTime);
+    EXPECT_GE(writer.stats().max_stall_us_, SlowFlash::kEraseTime);
+    EXPECT_EQ(writer.stats().writes_, 2u);
+    EXPECT_EQ(writer.stats().failed_, 0u);
+
+    EXPECT_EQ(value_of(store, kConfigMouseMode), std::vector<uint8_t>{0x02});
+    EXPECT_EQ(value_of(store, kConfigC1351Calibration), calibration);
+}
+
+TEST(ConfigWriter, DeferredWritesWaitForSettings) {
+    SlowFlash flash;
+    FlashKvStore store(flash);
+    ConfigWriter writer(store, global_time_us);
+    int deferred = 2;
+
+    writer.set_deferred_write([&deferred]() {
+        if (!deferred)
+            return false;
+        deferred--;
+        global_time_us += SlowFlash::kEraseTime;
+        return true;
+    });
+    writer.stage(kConfigMouseMode, std::vector<uint8_t>{0x01});
+
+    EXPECT_FALSE(writer.run(global_time_us));
+    EXPECT_EQ(deferred, 2);
+
+    // Settings first, then one deferred write per call
+    global_time_us += ConfigWriter::kQuietPeriod;
+    EXPECT_TRUE(writer.run(global_time_us));
+    EXPECT_EQ(deferred, 2);
+    EXPECT_TRUE(writer.run(global_time_us));
+    EXPECT_EQ(deferred, 1);
+    EXPECT_TRUE(writer.run(global_time_us));
+    EXPECT_EQ(deferred, 0);
+    EXPECT_EQ(writer.stats().last_stall_us_, SlowFlash::kEraseTime);
+
+    // Nothing left
+    EXPECT_FALSE(writer.run(global_time_us));
+    EXPECT_EQ(writer.stats().writes_, 3u);
+}
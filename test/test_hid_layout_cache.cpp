@@ -0,0 +1,246 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "hid_descriptors.hpp"
+#include "hid_layout_cache.hpp"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using Application = HidReportParser::Application;
+
+/// @brief Simulated flash sector of the cache
+class SimulatedSector {
+  public:
+    std::array<uint8_t, HidLayoutCache::kSectorSize> data_;
+
+    SimulatedSector() {
+        erase();
+    }
+
+    void erase() {
+        data_.fill(0xff);
+    }
+
+    /// @brief Appends a record like the firmware does
+    void append(const HidLayoutCache::Record &record) {
+        size_t slot = HidLayoutCache::used_records(data_);
+        if (slot == HidLayoutCache::kRecords) {
+            erase();
+            slot = 0;
+        }
+        memcpy(&data_[slot * HidLayoutCache::kRecordSize], &record, sizeof(record));
+    }
+};
+
+/// @brief Descriptor of the test corpus
+struct Descriptor {
+    const uint8_t *data_;
+    size_t len_;
+};
+
+static const std::array<Descriptor, 7> kCorpus{{
+    {kDescDragonRise, sizeof(kDescDragonRise)},
+    {kDescDualShock4, sizeof(kDescDualShock4)},
+    {kDescBootMouse, sizeof(kDescBootMouse)},
+    {kDescReportIdMouse, sizeof(kDescReportIdMouse)},
+    {kDescPushPopMouse, sizeof(kDescPushPopMouse)},
+    {kDesc10BitJoystick, sizeof(kDesc10BitJoystick)},
+    {kDescExtendedUsages, sizeof(kDescExtendedUsages)},
+}};
+
+TEST(HidLayoutCache, RestoredPlanMatches) {
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    for (auto &desc : kCorpus) {
+        for (auto application : {Application::kMouse, Application::kJoystick}) {
+            HidReportPlan compiled;
+            bool valid = HidReportParser::compile(desc.data_, desc.len_, application, compiled);
+
+            HidLayoutCache::Record record =
+                HidLayoutCache::make_record(0x1234, 0x5678, desc.data_, desc.len_, application, compiled, valid);
+
+            HidReportPlan restored;
+            EXPECT_EQ(HidLayoutCache::restore(record, restored), valid);
+            EXPECT_EQ(restored.report_id(), compiled.report_id());
+            EXPECT_EQ(restored.resolution(), compiled.resolution());
+            EXPECT_EQ(restored.layout(), compiled.layout());
+            ASSERT_EQ(restored.fields().size(), compiled.fields().size());
+
+            std::vector<uint8_t> report(16);
+            for (int i = 0; i < 100; i++) {
+                for (auto &b : report)
+                    b = static_cast<uint8_t>(byte(rng));
+                report[0] = compiled.report_id() ? compiled.report_id() : report[0];
+
+                HidInputState expected, actual;
+                ASSERT_EQ(restored.extract(report, actual), compiled.extract(report, expected));
+                EXPECT_EQ(actual.x_, expected.x_);
+                EXPECT_EQ(actual.y_, expected.y_);
+                EXPECT_EQ(actual.wheel_, expected.wheel_);
+                EXPECT_EQ(actual.hat_, expected.hat_);
+                EXPECT_EQ(actual.buttons_, expected.buttons_);
+            }
+        }
+    }
+}
+
+TEST(HidLayoutCache, FindsNewestRecord) {
+    SimulatedSector sector;
+    HidReportPlan plan;
+
+    EXPECT_EQ(HidLayoutCache::used_records(sector.data_), 0);
+    EXPECT_EQ(HidLayoutCache::find(sector.data_, 0x054c, 0x05c4, kDescDualShock4, sizeof(kDescDualShock4),
+                                   Application::kJoystick),
+              nullptr);
+
+    bool valid = HidReportParser::compile(kDescDualShock4, sizeof(kDescDualShock4), Application::kJoystick, plan);
+    sector.append(HidLayoutCache::make_record(0x054c, 0x05c4, kDescDualShock4, sizeof(kDescDualShock4),
+                                              Application::kJoystick, plan, valid));
+
+    valid = HidReportParser::compile(kDescBootMouse, sizeof(kDescBootMouse), Application::kMouse, plan);
+    sector.append(HidLayoutCache::make_record(0x046d, 0xc077, kDescBootMouse, sizeof(kDescBootMouse),
+                                              Application::kMouse, plan, valid));
+
+    // Same device with another firmware and descriptor
+    valid = HidReportParser::compile(kDescPushPopMouse, sizeof(kDescPushPopMouse), Application::kMouse, plan);
+    sector.append(HidLayoutCache::make_record(0x046d, 0xc077, kDescPushPopMouse, sizeof(kDescPushPopMouse),
+                                              Application::kMouse, plan, valid));
+
+    EXPECT_EQ(HidLayoutCache::used_records(sector.data_), 3);
+
+    auto record = HidLayoutCache::find(sector.data_, 0x046d, 0xc077, kDescBootMouse, sizeof(kDescBootMouse),
+                                       Application::kMouse);
+    ASSERT_NE(record, nullptr);
+    EXPECT_TRUE(HidLayoutCache::restore(*record, plan));
+    EXPECT_EQ(plan.layout(), FieldExtractorPlan::Layout::kBoot);
+
+    record = HidLayoutCache::find(sector.data_, 0x046d, 0xc077, kDescPushPopMouse, sizeof(kDescPushPopMouse),
+                                  Application::kMouse);
+    ASSERT_NE(record, nullptr);
+    EXPECT_TRUE(HidLayoutCache::restore(*record, plan));
+    EXPECT_EQ(plan.resolution(), 1600);
+
+    // Other VID, PID, application or descriptor
+    EXPECT_EQ(HidLayoutCache::find(sector.data_, 0x046e, 0xc077, kDescBootMouse, sizeof(kDescBootMouse),
+                                   Application::kMouse),
+              nullptr);
+    EXPECT_EQ(HidLayoutCache::find(sector.data_, 0x046d, 0xc078, kDescBootMouse, sizeof(kDescBootMouse),
+                                   Application::kMouse),
+              nullptr);
+    EXPECT_EQ(HidLayoutCache::find(sector.data_, 0x046d, 0xc077, kDescBootMouse, sizeof(kDescBootMouse),
+                                   Application::kJoystick),
+              nullptr);
+    EXPECT_EQ(HidLayoutCache::find(sector.data_, 0x046d, 0xc077, kDescBootMouse, sizeof(kDescBootMouse) - 1,
+                                   Application::kMouse),
+              nullptr);
+
+    // Invalid results are cached as well
+    valid = HidReportParser::compile(kDescBootMouse, sizeof(kDescBootMouse), Application::kJoystick, plan);
+    EXPECT_FALSE(valid);
+    sector.append(HidLayoutCache::make_record(0x046d, 0xc077, kDescBootMouse, sizeof(kDescBootMouse),
+                                              Application::kJoystick, plan, valid));
+    record = HidLayoutCache::find(sector.data_, 0x046d, 0xc077, kDescBootMouse, sizeof(kDescBootMouse),
+                                  Application::kJoystick);
+    ASSERT_NE(record, nullptr);
+    EXPECT_FALSE(HidLayoutCache::restore(*record, plan));
+}
+
+TEST(HidLayoutCache, FullSectorStartsAgain) {
+    SimulatedSector sector;
+    HidReportPlan plan;
+    bool valid = HidReportParser::compile(kDescBootMouse, sizeof(kDescBootMouse), Application::kMouse, plan);
+
+    for (uint16_t pid = 0; pid < HidLayoutCache::kRecords; pid++) {
+        sector.append(HidLayoutCache::make_record(0x046d, pid, kDescBootMouse, sizeof(kDescBootMouse),
+                                                  Application::kMouse, plan, valid));
+    }
+    EXPECT_EQ(HidLayoutCache::used_records(sector.data_), HidLayoutCache::kRecords);
+    EXPECT_NE(HidLayoutCache::find(sector.data_, 0x046d, 0, kDescBootMouse, sizeof(kDescBootMouse),
+                                   Application::kMouse),
+              nullptr);
+
+    sector.append(HidLayoutCache::make_record(0x046d, 0x1000, kDescBootMouse, sizeof(kDescBootMouse),
+                                              Application::kMouse, plan, valid));
+    EXPECT_EQ(HidLayoutCache::used_records(sector.data_), 1);
+    EXPECT_EQ(HidLayoutCache::find(sector.data_, 0x046d, 0, kDescBootMouse, sizeof(kDescBootMouse),
+                                   Application::kMouse),
+              nullptr);
+    EXPECT_NE(HidLayoutCache::find(sector.data_, 0x046d, 0x1000, kDescBootMouse, sizeof(kDescBootMouse),
+                                   Application::kMouse),
+              nullptr);
+}
+
+TEST(HidLayoutCache, PendingRecordsAreWrittenOnce) {
+    SimulatedSector sector;
+    HidReportPlan plan;
+    HidLayoutCache::Record record;
+    bool valid = HidReportParser::compile(kDescBootMouse, sizeof(kDescBootMouse), Application::kMouse, plan);
+
+    EXPECT_FALSE(HidLayoutCache::take_pending(sector.data_, record));
+
+    // The second mouse was attached twice before the ports became quiet
+    auto mouse1 = HidLayoutCache::make_record(0x046d, 0x0001, kDescBootMouse, sizeof(kDescBootMouse),
+                                              Application::kMouse, plan, valid);
+    auto mouse2 = HidLayoutCache::make_record(0x046d, 0x0002, kDescBootMouse, sizeof(kDescBootMouse),
+                                              Application::kMouse, plan, valid);
+    sector.append(mouse1);
+    EXPECT_TRUE(HidLayoutCache::queue(mouse1));
+    EXPECT_TRUE(HidLayoutCache::queue(mouse2));
+    EXPECT_TRUE(HidLayoutCache::queue(mouse2));
+
+    // Already stored records are skipped
+    ASSERT_TRUE(HidLayoutCache::take_pending(sector.data_, record));
+    EXPECT_EQ(record.pid_, 0x0002);
+    sector.append(record);
+    EXPECT_FALSE(HidLayoutCache::take_pending(sector.data_, record));
+    EXPECT_EQ(HidLayoutCache::used_records(sector.data_), 2);
+
+    // Records which don't fit are dropped
+    for (size_t i = 0; i < HidLayoutCache::kPendingRecords; i++)
+        EXPECT_TRUE(HidLayoutCache::queue(mouse2));
+    EXPECT_FALSE(HidLayoutCache::queue(mouse2));
+    EXPECT_FALSE(HidLayoutCache::take_pending(sector.data_, record));
+}
+
+TEST(Benchmark, HidLayoutCache) {
+    static constexpr uint32_t kMounts = 10000;
+
+    // A filled sector with the searched device at the end
+    SimulatedSector sector;
+    HidReportPlan plan;
+    bool valid = HidReportParser::compile(kDescDualShock4, sizeof(kDescDualShock4), Application::kJoystick, plan);
+    for (uint16_t pid = 0; pid < HidLayoutCache::kRecords - 1; pid++) {
+        sector.append(HidLayoutCache::make_record(0x054c, pid, kDescDualShock4, sizeof(kDescDualShock4),
+                                                  Application::kJoystick, plan, valid));
+    }
+    sector.append(HidLayoutCache::make_record(0x054c, 0x05c4, kDescDualShock4, sizeof(kDescDualShock4),
+                                              Application::kJoystick, plan, valid));
+
+    auto real_start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < kMounts; i++) {
+        HidReportParser::compile(kDescDualShock4, sizeof(kDescDualShock4), Application::kJoystick, plan);
+    }
+    double compile_us =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - real_start).count() * 1e6 / kMounts;
+
+    uint32_t hits = 0;
+    real_start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < kMounts; i++) {
+        auto record = HidLayoutCache::find(sector.data_, 0x054c, 0x05c4, kDescDualShock4, sizeof(kDescDualShock4),
+                                           Application::kJoystick);
+        if (record) {
+            HidLayoutCache::restore(*record, plan);
+            hits++;
+        }
+    }
+    double cached_us =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - real_start).count() * 1e6 / kMounts;
+
+    printf("DualShock 4 layout without cache (host): %.2f us\n", compile_us);
+    printf("DualShock 4 layout from full cache (host): %.2f us\n", cached_us);
+
+    EXPECT_EQ(hits, kMounts);
+}
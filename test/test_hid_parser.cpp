@@ -0,0 +1,276 @@
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <span>
+#include <vector>
+
+#include "hid_descriptors.hpp"
+#include "hid_report_parser.hpp"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using Role = HidReportPlan::Role;
+using Application = HidReportParser::Application;
+
+/**
+ * @brief Compiles a descriptor of the test corpus
+ *
+ * @param desc          Descriptor to compile
+ * @param application   Type of device to search for
+ * @param plan          Compiled fields
+ * @return true         The descriptor is usable
+ */
+template <size_t N> static bool compile(const uint8_t (&desc)[N], Application application, HidReportPlan &plan) {
+    return HidReportParser::compile(desc, N, application, plan);
+}
+
+TEST(HidParser, GenericJoystick) {
+    HidReportPlan plan;
+    ASSERT_TRUE(compile(kDescDragonRise, Application::kJoystick, plan));
+    EXPECT_EQ(plan.report_id(), 0);
+
+    // Z and Rz are not used. The vendor defined bits neither
+    EXPECT_EQ(plan.fields().size(), 4);
+    EXPECT_EQ(plan.find(Role::kX)->offset_, 0);
+    EXPECT_EQ(plan.find(Role::kX)->length_, 8);
+    EXPECT_EQ(plan.find(Role::kX)->logical_max_, 255);
+    EXPECT_FALSE(plan.find(Role::kX)->signed_);
+    EXPECT_EQ(plan.find(Role::kY)->offset_, 8);
+    EXPECT_EQ(plan.find(Role::kHat)->offset_, 40);
+    EXPECT_EQ(plan.find(Role::kHat)->length_, 4);
+    EXPECT_EQ(plan.find(Role::kButtons)->offset_, 44);
+    EXPECT_EQ(plan.find(Role::kButtons)->length_, 12);
+    EXPECT_EQ(plan.find(Role::kWheel), nullptr);
+    EXPECT_EQ(plan.layout(), FieldExtractorPlan::Layout::kGeneric);
+
+    HidInputState state;
+    // Left, down, hat released, buttons 1 and 5
+    std::vector<uint8_t> data({0x00, 0xff, 0x7f, 0x7f, 0x7f, 0x1f, 0x01, 0x00});
+    ASSERT_TRUE(plan.extract(data, state));
+    EXPECT_EQ(state.x_, 0);
+    EXPECT_EQ(state.y_, 255);
+    EXPECT_EQ(state.hat_, 0);
+    EXPECT_EQ(state.buttons_, 0x11);
+
+    // Hat east, button 12
+    data = {0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x02, 0x80, 0x00};
+    ASSERT_TRUE(plan.extract(data, state));
+    EXPECT_EQ(state.hat_, 3);
+    EXPECT_EQ(state.buttons_, 1 << 11);
+
+    // Too short to contain all buttons
+    data.resize(6);
+    EXPECT_FALSE(plan.extract(data, state));
+
+    // A joystick is not a mouse
+    EXPECT_FALSE(compile(kDescDragonRise, Application::kMouse, plan));
+}
+
+TEST(HidParser, DualShock4) {
+    HidReportPlan plan;
+    ASSERT_TRUE(compile(kDescDualShock4, Application::kJoystick, plan));
+    EXPECT_EQ(plan.report_id(), 1);
+    EXPECT_EQ(plan.find(Role::kX)->offset_, 8);
+    EXPECT_EQ(plan.find(Role::kY)->offset_, 16);
+    EXPECT_EQ(plan.find(Role::kHat)->offset_, 40);
+    EXPECT_EQ(plan.find(Role::kButtons)->offset_, 44);
+    EXPECT_EQ(plan.find(Role::kButtons)->length_, 14);
+
+    HidInputState state;
+    // Hat north, Square and Share
+    std::vector<uint8_t> data({0x01, 0x80, 0x81, 0x80, 0x80, 0x10, 0x10, 0x00, 0x00, 0x00});
+    ASSERT_TRUE(plan.extract(data, state));
+    EXPECT_EQ(state.x_, 0x80);
+    EXPECT_EQ(state.y_, 0x81);
+    EXPECT_EQ(state.hat_, 1);
+    EXPECT_EQ(state.buttons_, 0x101);
+
+    // Reports of other IDs are ignored
+    data[0] = 0x11;
+    EXPECT_FALSE(plan.extract(data, state));
+}
+
+TEST(HidParser, BootMouse) {
+    HidReportPlan plan;
+    ASSERT_TRUE(compile(kDescBootMouse, Application::kMouse, plan));
+    EXPECT_EQ(plan.report_id(), 0);
+    EXPECT_EQ(plan.resolution(), 0);
+    EXPECT_EQ(plan.layout(), FieldExtractorPlan::Layout::kBoot);
+    EXPECT_EQ(plan.find(Role::kButtons)->offset_, 0);
+    EXPECT_EQ(plan.find(Role::kButtons)->length_, 3);
+    EXPECT_EQ(plan.find(Role::kX)->offset_, 8);
+    EXPECT_TRUE(plan.find(Role::kX)->signed_);
+    EXPECT_TRUE(plan.find(Role::kX)->relative_);
+    EXPECT_EQ(plan.find(Role::kY)->offset_, 16);
+
+    HidInputState state;
+    std::vector<uint8_t> data({0x05, 0xfe, 0x03});
+    ASSERT_TRUE(plan.extract(data, state));
+    EXPECT_EQ(state.buttons_, 5);
+    EXPECT_EQ(state.x_, -2);
+    EXPECT_EQ(state.y_, 3);
+    EXPECT_EQ(state.wheel_, 0);
+
+    // A mouse is not a joystick
+    EXPECT_FALSE(compile(kDescBootMouse, Application::kJoystick, plan));
+}
+
+TEST(HidParser, ReportIdMouse) {
+    HidReportPlan plan;
+    ASSERT_TRUE(compile(kDescReportIdMouse, Application::kMouse, plan));
+    EXPECT_EQ(plan.report_id(), 1);
+    EXPECT_EQ(plan.layout(), FieldExtractorPlan::Layout::kAlignedXY16);
+    EXPECT_EQ(plan.find(Role::kButtons)->offset_, 8);
+    EXPECT_EQ(plan.find(Role::kButtons)->length_, 5);
+    EXPECT_EQ(plan.find(Role::kX)->offset_, 16);
+    EXPECT_EQ(plan.find(Role::kX)->length_, 16);
+    EXPECT_EQ(plan.find(Role::kY)->offset_, 32);
+    EXPECT_EQ(plan.find(Role::kWheel)->offset_, 48);
+
+    // Same reports as in the FieldExtractor test
+    HidInputState state;
+    std::vector<uint8_t> data({0x01, 0x01, 0xf6, 0xff, 0x08, 0x00, 0x02});
+    ASSERT_TRUE(plan.extract(data, state));
+    EXPECT_EQ(state.x_, -10);
+    EXPECT_EQ(state.y_, 8);
+    EXPECT_EQ(state.wheel_, 2);
+    EXPECT_EQ(state.buttons_, 1);
+
+    data = {0x01, 0x03, 0xff, 0xfe, 0xff, 0xff, 0xfe};
+    ASSERT_TRUE(plan.extract(data, state));
+    EXPECT_EQ(state.x_, -257);
+    EXPECT_EQ(state.y_, -1);
+    EXPECT_EQ(state.wheel_, -2);
+    EXPECT_EQ(state.buttons_, 3);
+}
+
+TEST(HidParser, PushPopMouse) {
+    HidReportPlan plan;
+    ASSERT_TRUE(compile(kDescPushPopMouse, Application::kMouse, plan));
+    EXPECT_EQ(plan.resolution(), 1600);
+    EXPECT_EQ(plan.find(Role::kX)->offset_, 8);
+    EXPECT_EQ(plan.find(Role::kX)->length_, 16);
+    EXPECT_EQ(plan.find(Role::kY)->offset_, 24);
+
+    // Pop has restored the size and extents of the wheel
+    const HidReportPlan::Field *wheel = plan.find(Role::kWheel);
+    ASSERT_NE(wheel, nullptr);
+    EXPECT_EQ(wheel->offset_, 40);
+    EXPECT_EQ(wheel->length_, 8);
+    EXPECT_EQ(wheel->logical_min_, -127);
+
+    HidInputState state;
+    std::vector<uint8_t> data({0x02, 0x40, 0x06, 0xc0, 0xf9, 0xff});
+    ASSERT_TRUE(plan.extract(data, state));
+    EXPECT_EQ(state.buttons_, 2);
+    EXPECT_EQ(state.x_, 1600);
+    EXPECT_EQ(state.y_, -1600);
+    EXPECT_EQ(state.wheel_, -1);
+}
+
+TEST(HidParser, TenBitJoystick) {
+    HidReportPlan plan;
+    ASSERT_TRUE(compile(kDesc10BitJoystick, Application::kJoystick, plan));
+    EXPECT_EQ(plan.find(Role::kX)->length_, 10);
+    EXPECT_EQ(plan.find(Role::kX)->logical_max_, 1023);
+    EXPECT_EQ(plan.find(Role::kY)->offset_, 10);
+    EXPECT_EQ(plan.find(Role::kButtons)->offset_, 20);
+    EXPECT_EQ(plan.find(Role::kHat), nullptr);
+
+    HidInputState state;
+    std::vector<uint8_t> data({0xff, 0x03, 0x50});
+    ASSERT_TRUE(plan.extract(data, state));
+    EXPECT_EQ(state.x_, 1023);
+    EXPECT_EQ(state.y_, 0);
+    EXPECT_EQ(state.buttons_, 5);
+}
+
+TEST(HidParser, ExtendedUsagesAndLongItems) {
+    HidReportPlan plan;
+    ASSERT_TRUE(compile(kDescExtendedUsages, Application::kJoystick, plan));
+    EXPECT_EQ(plan.find(Role::kX)->offset_, 0);
+    EXPECT_TRUE(plan.find(Role::kX)->signed_);
+    EXPECT_EQ(plan.find(Role::kY)->offset_, 8);
+    EXPECT_EQ(plan.find(Role::kButtons)->offset_, 16);
+    EXPECT_EQ(plan.find(Role::kButtons)->length_, 2);
+
+    HidInputState state;
+    std::vector<uint8_t> data({0x81, 0x7f, 0x02});
+    ASSERT_TRUE(plan.extract(data, state));
+    EXPECT_EQ(state.x_, -127);
+    EXPECT_EQ(state.y_, 127);
+    EXPECT_EQ(state.buttons_, 2);
+}
+
+TEST(HidParser, TruncatedDescriptor) {
+    HidReportPlan plan;
+
+    // Every prefix must be handled without reading beyond the end
+    for (size_t len = 0; len < sizeof(kDescDualShock4); len++) {
+        HidReportParser::compile(kDescDualShock4, len, Application::kJoystick, plan);
+        EXPECT_LE(plan.fields().size(), HidReportPlan::kMaxFields);
+    }
+
+    EXPECT_FALSE(HidReportParser::compile(kDescDualShock4, 0, Application::kJoystick, plan));
+    EXPECT_EQ(plan.fields().size(), 0);
+}
+
+/// @brief Descriptor of the test corpus with the type of device it contains
+struct CorpusEntry {
+    const char *name;
+    std::span<const uint8_t> desc;
+    Application application;
+};
+
+/// @brief All descriptors of the test corpus
+static const std::array<CorpusEntry, 7> kCorpus{{
+    {"DragonRise", kDescDragonRise, Application::kJoystick},
+    {"DualShock 4", kDescDualShock4, Application::kJoystick},
+    {"Boot mouse", kDescBootMouse, Application::kMouse},
+    {"Report ID mouse", kDescReportIdMouse, Application::kMouse},
+    {"Push Pop mouse", kDescPushPopMouse, Application::kMouse},
+    {"10 bit joystick", kDesc10BitJoystick, Application::kJoystick},
+    {"Extended usages", kDescExtendedUsages, Application::kJoystick},
+}};
+
+TEST(Benchmark, HidDescriptorCompiler) {
+    static constexpr uint32_t kDescriptors = 2000;
+    static constexpr uint32_t kReports = 200000;
+
+    for (const CorpusEntry &entry : kCorpus) {
+        HidReportPlan plan;
+        uint32_t compiled = 0;
+        auto real_start = std::chrono::steady_clock::now();
+
+        for (uint32_t i = 0; i < kDescriptors; i++) {
+            compiled += HidReportParser::compile(entry.desc.data(), entry.desc.size(), entry.application, plan);
+        }
+
+        auto real_duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - real_start).count();
+        double us_per_descriptor = real_duration * 1e6 / kDescriptors;
+
+        // Changing content with the Report ID of the plan
+        HidInputState state;
+        std::vector<uint8_t> data(64);
+        data[0] = plan.report_id();
+        uint32_t extracted = 0;
+        real_start = std::chrono::steady_clock::now();
+
+        for (uint32_t i = 0; i < kReports; i++) {
+            data[1] = static_cast<uint8_t>(i);
+            data[2] = static_cast<uint8_t>(i >> 8);
+            data[6] = static_cast<uint8_t>(i >> 4);
+            extracted += plan.extract(data, state);
+        }
+
+        real_duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - real_start).count();
+        double ns_per_report = real_duration * 1e9 / kReports;
+
+        printf("%-16s descriptor compile (host): %6.2f us, report extraction (host): %5.1f ns\n", entry.name,
+               us_per_descriptor, ns_per_report);
+
+        // Only the amount of work is checked. The timing depends on the host
+        EXPECT_EQ(compiled, kDescriptors) << entry.name;
+        EXPECT_EQ(extracted, kReports) << entry.name;
+    }
+}
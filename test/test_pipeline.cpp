@@ -1,4 +1,6 @@
 
+#include <chrono>
+#include <cinttypes>
 #include <cstdio>
 #include <memory>
 
@@ -23,12 +25,25 @@ uint32_t board_micros() {
 // FAKE_VALUE_FUNC(uint32_t, board_micros);
 FAKE_VOID_FUNC(board_led_write, bool);
 
-FAKE_VALUE_FUNC(bool, pio_sm_is_tx_fifo_empty, PIO, uint);
+FAKE_VALUE_FUNC(bool, pio_sm_is_tx_fifo_full, PIO, uint);
+FAKE_VALUE_FUNC(uint, pio_sm_get_tx_fifo_level, PIO, uint);
 FAKE_VOID_FUNC(pio_sm_put, PIO, uint, uint32_t);
 
 FAKE_VOID_FUNC(pio_sm_set_enabled, PIO, uint, bool);
 FAKE_VOID_FUNC(sid_adc_stim_program_init, PIO, uint, uint, uint, uint);
 FAKE_VALUE_FUNC(uint, pio_add_program, PIO, const pio_program_t *);
+FAKE_VOID_FUNC(quadrature_out_program_init, PIO, uint, uint, uint, uint32_t, uint32_t);
+FAKE_VOID_FUNC(sid_cycle_capture_program_init, PIO, uint, uint, uint);
+FAKE_VALUE_FUNC(bool, pio_sm_is_rx_fifo_empty, PIO, uint);
+FAKE_VALUE_FUNC(uint32_t, pio_sm_get, PIO, uint);
+
+FAKE_VALUE_FUNC(int, dma_claim_unused_channel, bool);
+FAKE_VOID_FUNC(dma_channel_unclaim, uint);
+FAKE_VOID_FUNC(dma_channel_configure, uint, const dma_channel_config *, volatile void *, const volatile void *, uint,
+               bool);
+FAKE_VOID_FUNC(dma_channel_transfer_from_buffer_now, uint, const volatile void *, uint32_t);
+FAKE_VALUE_FUNC(bool, dma_channel_is_busy, uint);
+FAKE_VOID_FUNC(dma_channel_abort, uint);
 
 using testing::_;
 
@@ -40,6 +55,8 @@ class MockControllerPort : public ControllerPortInterface {
     MOCK_METHOD(uint, get_pot_y_sense_gpio, ());
     MOCK_METHOD(void, configure_gpios, ());
     MOCK_METHOD(size_t, get_index, ());
+    MOCK_METHOD(uint32_t, get_gpio_mask, (const ControllerPortState &state));
+    MOCK_METHOD(uint, get_direction_gpio_base, ());
 
     const char *get_name() override {
         return "";
@@ -55,7 +72,8 @@ class MockHidHandler : public HidHandlerInterface {
     }
     std::shared_ptr<ReportHubInterface> target_;
 
-    void parse_hid_report_descriptor(uint8_t const *desc_report, uint16_t desc_len) override {};
+    void parse_hid_report_descriptor(uint16_t vid, uint16_t pid, uint8_t const *desc_report,
+                                     uint16_t desc_len) override {};
 
     void setup_reception(int8_t dev_addr, uint8_t instance) override {};
 
@@ -72,6 +90,10 @@ class MockHidHandler : public HidHandlerInterface {
 };
 PIO C1351Converter::pio_{nullptr};
 uint C1351Converter::offset_{0};
+PIO QuadraturePio::pio_{nullptr};
+uint QuadraturePio::offset_{0};
+PIO SidCycleMonitor::pio_{nullptr};
+uint SidCycleMonitor::offset_{0};
 
 ControllerPortState cps_from_text(const char *text) {
     ControllerPortState result;
@@ -192,7 +214,7 @@ TEST(Pipeline, SingleJoystickAndAmigaMouse) {
         }
 
         for (int i = 0; i < 30; i++) {
-            global_time_us += AmigaMouse::kUpdatePeriod;
+            global_time_us += AmigaMouse::kRateProfiles[0].max_period_;
             pipeline->run();
         }
     }
@@ -226,7 +248,7 @@ TEST(Pipeline, SingleJoystickAndAmigaMouse) {
         }
 
         for (int i = 0; i < 30; i++) {
-            global_time_us += AmigaMouse::kUpdatePeriod;
+            global_time_us += AmigaMouse::kRateProfiles[0].max_period_;
             pipeline->run();
         }
     }
@@ -258,7 +280,7 @@ TEST(Pipeline, SingleJoystickAndAmigaMouse) {
         }
 
         for (int i = 0; i < 30; i++) {
-            global_time_us += AmigaMouse::kUpdatePeriod;
+            global_time_us += AmigaMouse::kRateProfiles[0].max_period_;
             pipeline->run();
         }
     }
@@ -421,11 +443,87 @@ TEST(Pipeline, DualAmigaMouse) {
     }
 
     for (int i = 0; i < 30; i++) {
-        global_time_us += AmigaMouse::kUpdatePeriod;
+        global_time_us += AmigaMouse::kRateProfiles[0].max_period_;
         pipeline->run();
     }
 }
 
+/// Tracks whether the pins of the port are muxed to the PIO or to the CPU
+class MuxTrackingPort : public ControllerPortInterface {
+  private:
+    size_t index_;
+
+  public:
+    /// Taken by \ref QuadraturePio. Only \ref configure_gpios gives them back to the CPU
+    bool pins_on_pio_{false};
+
+    explicit MuxTrackingPort(size_t index) : index_(index) {
+    }
+
+    void set_port_state(ControllerPortState &) override {
+    }
+    uint get_pot_x_drain_gpio() override {
+        return 0;
+    }
+    uint get_pot_y_drain_gpio() override {
+        return 0;
+    }
+    uint get_pot_y_sense_gpio() override {
+        return 13;
+    }
+    void configure_gpios() override {
+        pins_on_pio_ = false;
+    }
+    void directions_driven_by_pio(bool active) override {
+        if (active)
+            pins_on_pio_ = true;
+    }
+    const char *get_name() override {
+        return index_ ? "Left" : "Right";
+    }
+    size_t get_index() override {
+        return index_;
+    }
+    uint32_t get_gpio_mask(const ControllerPortState &) override {
+        return 0;
+    }
+    uint get_direction_gpio_base() override {
+        return 10;
+    }
+};
+
+/// Lets the mouse emulations use the PIO
+class PipelineMuxingTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        RESET_FAKE(sid_adc_stim_program_init);
+        QuadraturePio::pio_ = reinterpret_cast<PIO>(PIO1_BASE);
+    }
+
+    void TearDown() override {
+        QuadraturePio::pio_ = nullptr;
+    }
+};
+
+TEST_F(PipelineMuxingTest, C1351TakesPinsBackFromPio) {
+
+    auto port_joy = std::make_shared<MuxTrackingPort>(1);
+    auto port_mouse = std::make_shared<MuxTrackingPort>(0);
+    auto pipeline = std::make_unique<Pipeline>(port_joy, port_mouse);
+
+    // The stored configuration might start with any mouse type
+    for (size_t i = 0; i < MouseModeSwitcher::number_modes() && !port_mouse->pins_on_pio_; i++)
+        pipeline->cycle_mouse_mode();
+    ASSERT_TRUE(port_mouse->pins_on_pio_);
+
+    // Amiga or Atari ST are followed by the C1351
+    while (sid_adc_stim_program_init_fake.call_count == 0)
+        pipeline->cycle_mouse_mode();
+
+    EXPECT_FALSE(port_mouse->pins_on_pio_);
+    EXPECT_FALSE(port_joy->pins_on_pio_);
+}
+
 TEST(Pipeline, DualJoystick) {
 
     std::shared_ptr<MockControllerPort> port_joy = std::make_shared<MockControllerPort>();
@@ -466,4 +564,310 @@ TEST(Pipeline, DualJoystick) {
         mock_joy2->target_->process_gamepad_report(report2);
     }
     pipeline->run();
-}
\ No newline at end of file
+}
+TEST(Pipeline, DualCoreBridge) {
+
+    std::shared_ptr<MockControllerPort> port_joy = std::make_shared<MockControllerPort>();
+    std::shared_ptr<MockControllerPort> port_mouse = std::make_shared<MockControllerPort>();
+
+    EXPECT_CALL(*port_joy, configure_gpios).Times(testing::AtLeast(1));
+    EXPECT_CALL(*port_mouse, configure_gpios).Times(testing::AtLeast(1));
+
+    auto pipeline = std::make_unique<Pipeline>(port_joy, port_mouse, true);
+
+    std::shared_ptr<MockHidHandler> mock_joy = std::make_shared<MockHidHandler>(ReportType::kGamePad);
+    pipeline->integrate_handler(mock_joy);
+    EXPECT_TRUE(mock_joy->target_);
+
+    ControllerPortState nothing_pressed;
+    EXPECT_CALL(*port_joy, set_port_state(nothing_pressed));
+    pipeline->run_outputs();
+
+    ControllerPortState fire_pressed;
+    fire_pressed.fire1 = true;
+
+    GamepadReport report;
+    report.fire = 1;
+    mock_joy->target_->process_gamepad_report(report);
+
+    // The report is queued and only delivered by the output core
+    testing::Mock::VerifyAndClearExpectations(port_joy.get());
+    EXPECT_CALL(*port_joy, set_port_state(_)).Times(0);
+    pipeline->run_inputs();
+    testing::Mock::VerifyAndClearExpectations(port_joy.get());
+
+    EXPECT_CALL(*port_joy, set_port_state(fire_pressed));
+    pipeline->run_outputs();
+}
+
+/// @brief Records all mouse reports which reach the end of the pipeline
+class RecordingMouseProcessor : public RunnableMouseReportProcessor {
+  public:
+    std::vector<MouseReport> reports_;
+
+    void process_mouse_report(MouseReport &report) override {
+        reports_.push_back(report);
+    }
+    void ensure_mouse_muxing() override {
+    }
+    void run() override {
+    }
+    uint32_t next_deadline(uint32_t now) override {
+        return now + kIdlePeriod;
+    }
+};
+
+/// @brief Switcher in mouse mode with \ref RecordingMouseProcessor as target
+struct CoalescingFixture {
+    std::shared_ptr<JoystickMouseSwitcher> switcher_{std::make_shared<JoystickMouseSwitcher>(kMouse)};
+    std::shared_ptr<RecordingMouseProcessor> recorder_{std::make_shared<RecordingMouseProcessor>()};
+    uint32_t deadline_{0};
+
+    CoalescingFixture() {
+        switcher_->mouse_target_ = recorder_;
+        switcher_->other_gamepad_target_ = std::make_shared<GamePadFeatures>();
+        switcher_->set_wake_callback([this]() { deadline_ = global_time_us; });
+    }
+
+    /// @brief Behaves like \ref DeadlineScheduler with a single task
+    void dispatch() {
+        if (static_cast<int32_t>(global_time_us - deadline_) >= 0) {
+            switcher_->run();
+            deadline_ = switcher_->next_deadline(global_time_us);
+        }
+    }
+
+    void report(int16_t x, uint8_t buttons = 0) {
+        MouseReport report;
+        report.relx = x;
+        report.button_pressed = buttons;
+        switcher_->process_mouse_report(report);
+    }
+};
+
+TEST(JoystickMouseSwitcher, CoalescesMovement) {
+    CoalescingFixture f;
+
+    // The first report after a pause is forwarded without waiting
+    f.report(1);
+    ASSERT_EQ(f.recorder_->reports_.size(), 1);
+
+    // 1000 Hz mouse moving one count per report
+    for (int i = 0; i < 10; i++) {
+        global_time_us += 1000;
+        f.report(1);
+        f.dispatch();
+    }
+
+    // Every 2 ms, the movement of 2 reports is forwarded
+    ASSERT_EQ(f.recorder_->reports_.size(), 6);
+    for (size_t i = 1; i < f.recorder_->reports_.size(); i++) {
+        EXPECT_EQ(f.recorder_->reports_[i].relx, 2);
+        EXPECT_EQ(f.recorder_->reports_[i].button_pressed, 0);
+    }
+}
+
+TEST(JoystickMouseSwitcher, SlowMouseIsNotDelayed) {
+    CoalescingFixture f;
+
+    // 125 Hz mouse. Every report is forwarded as it arrives
+    for (size_t i = 1; i <= 10; i++) {
+        global_time_us += 8000;
+        f.report(1);
+        ASSERT_EQ(f.recorder_->reports_.size(), i);
+    }
+}
+
+TEST(JoystickMouseSwitcher, PreservesButtonEdges) {
+    CoalescingFixture f;
+
+    // Press and release within a single drain period
+    f.report(3);
+    global_time_us += 125;
+    f.report(4, 1);
+    global_time_us += 125;
+    f.report(5, 1);
+    global_time_us += 125;
+    f.report(6, 0);
+    global_time_us += 125;
+    f.report(7, 0);
+
+    // Edges are forwarded without waiting, after the movement before them
+    ASSERT_EQ(f.recorder_->reports_.size(), 4);
+    EXPECT_EQ(f.recorder_->reports_[0].relx, 3);
+    EXPECT_EQ(f.recorder_->reports_[0].button_pressed, 0);
+    EXPECT_EQ(f.recorder_->reports_[1].relx, 4);
+    EXPECT_EQ(f.recorder_->reports_[1].button_pressed, 1);
+    EXPECT_EQ(f.recorder_->reports_[2].relx, 5);
+    EXPECT_EQ(f.recorder_->reports_[2].button_pressed, 1);
+    EXPECT_EQ(f.recorder_->reports_[3].relx, 6);
+    EXPECT_EQ(f.recorder_->reports_[3].button_pressed, 0);
+
+    global_time_us += MouseDeltaAccumulator::kDrainPeriod;
+    f.dispatch();
+    ASSERT_EQ(f.recorder_->reports_.size(), 5);
+    EXPECT_EQ(f.recorder_->reports_[4].relx, 7);
+    EXPECT_EQ(f.recorder_->reports_[4].button_pressed, 0);
+
+    // Movement exceeding 16 bit is split but not lost
+    for (int i = 0; i < 3; i++)
+        f.report(30000);
+    global_time_us += MouseDeltaAccumulator::kDrainPeriod;
+    f.dispatch();
+    ASSERT_EQ(f.recorder_->reports_.size(), 8);
+    EXPECT_EQ(f.recorder_->reports_[5].relx, 32767);
+    EXPECT_EQ(f.recorder_->reports_[6].relx, 32767);
+    EXPECT_EQ(f.recorder_->reports_[7].relx, 90000 - 2 * 32767);
+}
+
+TEST(Benchmark, MousePollingRate) {
+    static constexpr uint32_t kLoopPeriod{50};
+    static constexpr uint32_t kDuration{1000000};
+
+    printf("Polling rate  Reports  Forwarded  CPU time per second\n");
+
+    std::array<size_t, 4> forwarded;
+    const std::array<uint32_t, 4> kRates{125, 500, 1000, 8000};
+
+    for (size_t i = 0; i < kRates.size(); i++) {
+        CoalescingFixture f;
+        uint32_t start = global_time_us;
+        uint32_t next_report = start;
+        uint32_t reports = 0;
+        double cpu = 0;
+
+        for (uint32_t t = 0; t < kDuration; t += kLoopPeriod) {
+            global_time_us = start + t;
+            auto real_start = std::chrono::steady_clock::now();
+
+            while (static_cast<int32_t>(global_time_us - next_report) >= 0) {
+                // A button edge every 100 ms
+                f.report(1, (t / 100000) & 1);
+                reports++;
+                next_report = start + static_cast<uint32_t>(uint64_t(reports) * kDuration / kRates[i]);
+            }
+            f.dispatch();
+
+            cpu += std::chrono::duration<double>(std::chrono::steady_clock::now() - real_start).count();
+        }
+        forwarded[i] = f.recorder_->reports_.size();
+
+        // Nothing is lost after the last drain
+        global_time_us = start + kDuration + MouseDeltaAccumulator::kDrainPeriod;
+        f.dispatch();
+        int32_t sum = 0;
+        for (auto &r : f.recorder_->reports_)
+            sum += r.relx;
+        EXPECT_EQ(sum, static_cast<int32_t>(reports));
+
+        printf("%9" PRIu32 " Hz  %7" PRIu32 "  %9zu  %16.1f us\n", kRates[i], reports, forwarded[i], cpu * 1e6);
+    }
+
+    // One forwarded report per drain period and at most two per button edge
+    for (size_t i = 0; i < kRates.size(); i++) {
+        EXPECT_LE(forwarded[i], kDuration / MouseDeltaAccumulator::kDrainPeriod + 2 * 10);
+    }
+}
+
+TEST(LatencyHistogram, Buckets) {
+    LatencyHistogram h;
+
+    h.record(0);
+    h.record(125);
+    h.record(126);
+    h.record(3000);
+    h.record(100000);
+
+    EXPECT_EQ(h.buckets_[0], 2);
+    EXPECT_EQ(h.buckets_[1], 1);
+    EXPECT_EQ(h.buckets_[5], 1);
+    EXPECT_EQ(h.buckets_.back(), 1);
+    EXPECT_EQ(h.count_, 5);
+    EXPECT_EQ(h.max_us_, 100000);
+    EXPECT_EQ(h.mean_us(), (125 + 126 + 3000 + 100000) / 5);
+}
+
+TEST(LatencyTrace, RecordsOnlyFirstOutput) {
+    LatencyTrace trace;
+
+    trace.record(0, kGamePad, 1000, 1500);
+    // Same report again, e.g. after a muxing change
+    trace.record(0, kGamePad, 1000, 2500);
+    // Older report which was overtaken
+    trace.record(0, kGamePad, 900, 2600);
+    // Unknown arrival
+    trace.record(0, kGamePad, 0, 2700);
+    // Invalid port
+    trace.record(2, kGamePad, 3000, 3100);
+
+    EXPECT_EQ(trace.histogram(0, kGamePad).count_, 1);
+    EXPECT_EQ(trace.histogram(0, kGamePad).max_us_, 500);
+    EXPECT_EQ(trace.histogram(0, kMouse).count_, 0);
+    EXPECT_EQ(trace.histogram(1, kGamePad).count_, 0);
+
+    trace.record(0, kGamePad, 2000, 2300);
+    EXPECT_EQ(trace.histogram(0, kGamePad).count_, 2);
+
+    trace.reset();
+    EXPECT_EQ(trace.histogram(0, kGamePad).count_, 0);
+}
+
+TEST(LatencyTrace, DumpIsCopiedOnRequest) {
+    LatencyTrace trace;
+    trace.record(0, kMouse, 1000, 1500);
+
+    // Nothing is copied or printed without a request
+    trace.provide_snapshot();
+    EXPECT_FALSE(trace.dump_if_ready());
+
+    trace.request_dump();
+    EXPECT_FALSE(trace.dump_if_ready());
+    trace.provide_snapshot();
+
+    // Recording continues while the copy is printed
+    trace.record(0, kMouse, 2000, 2100);
+    EXPECT_TRUE(trace.dump_if_ready());
+    EXPECT_FALSE(trace.dump_if_ready());
+    EXPECT_EQ(trace.histogram(0, kMouse).count_, 2);
+}
+
+TEST(LatencyTrace, GamepadReportToPort) {
+    std::shared_ptr<MockControllerPort> port_joy = std::make_shared<MockControllerPort>();
+    std::shared_ptr<MockControllerPort> port_mouse = std::make_shared<MockControllerPort>();
+
+    EXPECT_CALL(*port_joy, configure_gpios).Times(testing::AtLeast(1));
+    EXPECT_CALL(*port_mouse, configure_gpios).Times(testing::AtLeast(1));
+    ON_CALL(*port_joy, get_index).WillByDefault(testing::Return(1));
+    ON_CALL(*port_mouse, get_index).WillByDefault(testing::Return(0));
+    EXPECT_CALL(*port_joy, get_index).Times(testing::AnyNumber());
+    EXPECT_CALL(*port_mouse, get_index).Times(testing::AnyNumber());
+    EXPECT_CALL(*port_joy, set_port_state(_)).Times(testing::AnyNumber());
+
+    auto pipeline = std::make_unique<Pipeline>(port_joy, port_mouse);
+
+    std::shared_ptr<MockHidHandler> mock_joy = std::make_shared<MockHidHandler>(ReportType::kGamePad);
+    pipeline->integrate_handler(mock_joy);
+    pipeline->run();
+
+    LatencyTrace::instance().reset();
+    // Time stamp 0 is reserved for unknown
+    global_time_us += 1000;
+
+    GamepadReport report;
+    report.fire = 1;
+    report.arrival_us = global_time_us;
+    mock_joy->target_->process_gamepad_report(report);
+
+    global_time_us += 700;
+    pipeline->run();
+
+    const LatencyHistogram &h = LatencyTrace::instance().histogram(1, kGamePad);
+    EXPECT_EQ(h.count_, 1);
+    EXPECT_EQ(h.max_us_, 700);
+
+    // Nothing changes on the port. Nothing is recorded
+    global_time_us += 700;
+    pipeline->run();
+    EXPECT_EQ(h.count_, 1);
+    EXPECT_EQ(LatencyTrace::instance().histogram(0, kGamePad).count_, 0);
+}
@@ -0,0 +1,126 @@
+#include <string>
+#include <vector>
+
+#include "port_recorder.hpp"
+#include "report_replay.hpp"
+#include <gtest/gtest.h>
+
+/// @brief Exports a waveform into a single string
+static std::string to_vcd(PortWaveform &waveform) {
+    std::string vcd;
+    waveform.export_vcd([&vcd](const char *line) { vcd += line; });
+    return vcd;
+}
+
+/// @brief Returns the part of the export after the initial values
+static std::string changes_of(const std::string &vcd) {
+    return vcd.substr(vcd.find("$end\n", vcd.find("$dumpvars")) + 5);
+}
+
+TEST(PortRecorder, RecordsChangesAndForwards) {
+    PortWaveform waveform;
+    auto left = std::make_shared<RecordingControllerPort>(1);
+    PortRecorder recorder(left, waveform);
+
+    ControllerPortState state;
+    state.fire1 = true;
+    recorder.set_port_state(state);
+    global_time_us += 100;
+    recorder.set_port_state(state);
+    global_time_us += 150;
+    state.fire1 = false;
+    state.up = true;
+    recorder.set_port_state(state);
+
+    EXPECT_EQ(left->states_.size(), 3u);
+    EXPECT_EQ(waveform.size(), 2u);
+
+    std::string vcd = to_vcd(waveform);
+    EXPECT_NE(vcd.find("$scope module left $end\n$var wire 1 ( up $end"), std::string::npos);
+    EXPECT_EQ(changes_of(vcd), "1,\n#250\n1(\n0,\n");
+}
+
+TEST(PortRecorder, DirectionsFromPio) {
+    PortWaveform waveform;
+    auto right = std::make_shared<RecordingControllerPort>(0);
+    PortRecorder recorder(right, waveform);
+    uint32_t start = global_time_us;
+
+    recorder.directions_driven_by_pio(true);
+
+    // Steps are queued ahead of time
+    ControllerPortState step;
+    step.right = true;
+    recorder.pio_step_queued(step, start);
+    step.up = true;
+    recorder.pio_step_queued(step, start + 400);
+
+    // The CPU has no control over the directions
+    ControllerPortState state;
+    state.fire1 = true;
+    state.down = true;
+    global_time_us += 200;
+    recorder.set_port_state(state);
+
+    EXPECT_EQ(changes_of(to_vcd(waveform)), "1$\n#200\n1%\n#400\n1!\n");
+
+    // Directions are with the CPU again
+    recorder.directions_driven_by_pio(false);
+    global_time_us += 300;
+    recorder.set_port_state(state);
+    EXPECT_EQ(changes_of(to_vcd(waveform)), "1$\n#200\n1%\n#400\n1!\n#500\n0!\n1\"\n0$\n");
+}
+
+TEST(PortRecorder, DropsOldestChanges) {
+    PortWaveform waveform(4);
+    auto right = std::make_shared<RecordingControllerPort>(0);
+    PortRecorder recorder(right, waveform);
+
+    ControllerPortState state;
+    for (int i = 0; i < 6; i++) {
+        global_time_us += 10;
+        state.fire1 = !state.fire1;
+        recorder.set_port_state(state);
+    }
+
+    EXPECT_EQ(waveform.size(), 4u);
+    EXPECT_EQ(waveform.dropped(), 2u);
+
+    // Time is relative to the oldest change which is kept
+    std::string vcd = to_vcd(waveform);
+    EXPECT_NE(vcd.find("$comment 2 changes dropped $end"), std::string::npos);
+    EXPECT_EQ(changes_of(vcd), "1%\n#10\n0%\n#20\n1%\n#30\n0%\n");
+}
+
+TEST(PortRecorder, SnapshotIsExportedOnRequest) {
+    PortWaveform waveform(4);
+    auto right = std::make_shared<RecordingControllerPort>(0);
+    PortRecorder recorder(right, waveform);
+    std::string vcd;
+    auto print = [&vcd](const char *line) { vcd += line; };
+
+    ControllerPortState state;
+    for (int i = 0; i < 6; i++) {
+        global_time_us += 10;
+        state.fire1 = !state.fire1;
+        recorder.set_port_state(state);
+    }
+
+    // Nothing is copied without a request
+    waveform.provide_snapshot();
+    EXPECT_FALSE(waveform.export_snapshot(print));
+
+    waveform.request_dump();
+    waveform.provide_snapshot();
+
+    // Recording continues while the copy is exported
+    global_time_us += 10;
+    state.fire1 = !state.fire1;
+    recorder.set_port_state(state);
+
+    EXPECT_TRUE(waveform.export_snapshot(print));
+    EXPECT_NE(vcd.find("$comment 2 changes dropped $end"), std::string::npos);
+    EXPECT_EQ(changes_of(vcd), "1%\n#10\n0%\n#20\n1%\n#30\n0%\n");
+    EXPECT_FALSE(waveform.export_snapshot(print));
+    EXPECT_EQ(waveform.dropped(), 3u);
+}
@@ -0,0 +1,606 @@
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <queue>
+
+#include "processors/mouse_amiga.hpp"
+#include "processors/mouse_atarist.hpp"
+#include "processors/mouse_c1351.hpp"
+#include "processors/mouse_mode_switcher.hpp"
+#include "processors/port_recorder.hpp"
+#include "processors/port_switcher.hpp"
+#include <gtest/gtest.h>
+
+#include "fff.h"
+
+extern uint32_t global_time_us;
+
+DECLARE_FAKE_VALUE_FUNC(bool, pio_sm_is_tx_fifo_full, PIO, uint);
+DECLARE_FAKE_VOID_FUNC(pio_sm_put, PIO, uint, uint32_t);
+DECLARE_FAKE_VOID_FUNC(pio_sm_set_enabled, PIO, uint, bool);
+DECLARE_FAKE_VOID_FUNC(quadrature_out_program_init, PIO, uint, uint, uint, uint32_t, uint32_t);
+
+/// Behaves like the right controller port
+class RightPortStub : public ControllerPortInterface {
+  public:
+    uint32_t state_changes_{0};
+
+    void set_port_state(ControllerPortState &) override {
+        state_changes_++;
+    }
+    uint get_pot_x_drain_gpio() override {
+        return 7;
+    }
+    uint get_pot_y_drain_gpio() override {
+        return 11;
+    }
+    uint get_pot_y_sense_gpio() override {
+        return 13;
+    }
+    void configure_gpios() override {
+    }
+    const char *get_name() override {
+        return "Right";
+    }
+    size_t get_index() override {
+        return 0;
+    }
+    uint32_t get_gpio_mask(const ControllerPortState &state) override {
+        return (state.fire2 << 7) | (state.fire1 << 9) | (state.up << 15) | (state.fire3 << 11) |
+               (state.down << 14) | (state.left << 12) | (state.right << 10);
+    }
+    uint get_direction_gpio_base() override {
+        return 10;
+    }
+};
+
+/// Behaves like the left controller port. Only the state machine differs
+class LeftPortStub : public RightPortStub {
+  public:
+    const char *get_name() override {
+        return "Left";
+    }
+    size_t get_index() override {
+        return 1;
+    }
+};
+
+/// Simulated TX FIFO of the PIO state machine
+static size_t fifo_level;
+
+static bool fifo_full(PIO, uint) {
+    return fifo_level >= 4;
+}
+
+static void fifo_put(PIO, uint, uint32_t) {
+    fifo_level++;
+}
+
+class QuadraturePioTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        RESET_FAKE(pio_sm_is_tx_fifo_full);
+        RESET_FAKE(pio_sm_put);
+        RESET_FAKE(quadrature_out_program_init);
+        pio_sm_is_tx_fifo_full_fake.custom_fake = fifo_full;
+        pio_sm_put_fake.custom_fake = fifo_put;
+        fifo_level = 0;
+
+        QuadraturePio::pio_ = reinterpret_cast<PIO>(PIO1_BASE);
+    }
+
+    void TearDown() override {
+        QuadraturePio::pio_ = nullptr;
+    }
+
+    /// Returns the directional pins of a queued step relative to the GPIO base
+    static uint32_t step_levels(size_t index) {
+        return pio_sm_put_fake.arg2_history[index] & 0x3f;
+    }
+
+    /// Returns the hold time of a queued step in PIO cycles
+    static uint32_t step_hold(size_t index) {
+        return pio_sm_put_fake.arg2_history[index] >> 6;
+    }
+};
+
+TEST_F(QuadraturePioTest, AmigaStepsAreQueued) {
+    auto port = std::make_shared<RightPortStub>();
+    AmigaMouse mouse;
+    mouse.mouse_target_ = port;
+    mouse.ensure_mouse_muxing();
+
+    // Directions of the right port are GPIO 10, 12, 14 and 15
+    ASSERT_EQ(quadrature_out_program_init_fake.call_count, 1u);
+    EXPECT_EQ(quadrature_out_program_init_fake.arg3_val, 10u);
+    EXPECT_EQ(quadrature_out_program_init_fake.arg4_val, 0xd400u);
+    EXPECT_EQ(quadrature_out_program_init_fake.arg5_val, 0u);
+
+    MouseReport report;
+    report.relx = 6;
+    mouse.process_mouse_report(report);
+
+    // Only the FIFO depth is queued
+    mouse.run();
+    ASSERT_EQ(pio_sm_put_fake.call_count, 4u);
+
+    // Right is GPIO 10, Down is GPIO 14. Right must lead
+    EXPECT_EQ(step_levels(0), 0x10u);
+    EXPECT_EQ(step_levels(1), 0x11u);
+    EXPECT_EQ(step_levels(2), 0x01u);
+    EXPECT_EQ(step_levels(3), 0x00u);
+    for (size_t i = 0; i < 4; i++)
+        EXPECT_EQ(step_hold(i) + QUADRATURE_OUT_STEP_OVERHEAD, AmigaMouse::kRateProfiles[0].max_period_);
+
+    // The PIO has performed 2 steps until the next refill
+    uint32_t now = global_time_us;
+    EXPECT_EQ(mouse.next_deadline(now), now + 2 * AmigaMouse::kRateProfiles[0].max_period_);
+    fifo_level -= 2;
+    mouse.run();
+    ASSERT_EQ(pio_sm_put_fake.call_count, 6u);
+    EXPECT_EQ(step_levels(4), 0x10u);
+    EXPECT_EQ(step_levels(5), 0x11u);
+
+    // Nothing left to do
+    EXPECT_EQ(mouse.next_deadline(now), now + Runnable::kIdlePeriod);
+
+    // Movement is not written by the CPU
+    EXPECT_EQ(port->state_changes_, 0u);
+}
+
+TEST_F(QuadraturePioTest, AtariStButtonsStayWithCpu) {
+    auto port = std::make_shared<RightPortStub>();
+    AtariStMouse mouse;
+    mouse.mouse_target_ = port;
+    mouse.ensure_mouse_muxing();
+
+    MouseReport report;
+    report.left = 1;
+    report.rely = -1;
+    mouse.process_mouse_report(report);
+    mouse.run();
+
+    EXPECT_EQ(port->state_changes_, 1u);
+    ASSERT_EQ(pio_sm_put_fake.call_count, 1u);
+    // Vertical movement is on left and right signals. Left is GPIO 12
+    EXPECT_EQ(step_levels(0), 0x04u);
+    EXPECT_EQ(step_hold(0) + QUADRATURE_OUT_STEP_OVERHEAD, AtariStMouse::kRateProfiles[0].max_period_);
+}
+
+TEST_F(QuadraturePioTest, StepsAreRecordedAtPioTime) {
+    PortWaveform waveform;
+    auto port = std::make_shared<RightPortStub>();
+    AmigaMouse mouse;
+    mouse.mouse_target_ = std::make_shared<PortRecorder>(port, waveform);
+    mouse.ensure_mouse_muxing();
+
+    MouseReport report;
+    report.relx = 6;
+    mouse.process_mouse_report(report);
+    mouse.run();
+    ASSERT_EQ(pio_sm_put_fake.call_count, 4u);
+
+    std::string vcd;
+    waveform.export_vcd([&vcd](const char *line) { vcd += line; });
+
+    // Steps are queued at once, but performed one period after the other
+    const uint32_t period = AmigaMouse::kRateProfiles[0].max_period_;
+    std::string changes = vcd.substr(vcd.find("$end\n", vcd.find("$dumpvars")) + 5);
+    EXPECT_EQ(changes, "1\"\n#" + std::to_string(period) + "\n1$\n#" + std::to_string(2 * period) + "\n0\"\n#" +
+                           std::to_string(3 * period) + "\n0$\n");
+}
+
+/// Enable state of both state machines
+static std::array<bool, 2> sm_enabled;
+
+static void sm_set_enabled(PIO, uint sm, bool enabled) {
+    sm_enabled.at(sm) = enabled;
+}
+
+static void sm_init(PIO, uint sm, uint, uint, uint32_t, uint32_t) {
+    sm_enabled.at(sm) = true;
+}
+
+TEST_F(QuadraturePioTest, LatencyIsRecordedAtStepTime) {
+    QuadraturePio pio;
+    pio.start(std::make_shared<LeftPortStub>(), ControllerPortState());
+    LatencyTrace::instance().reset();
+    global_time_us += 1000;
+
+    // Performed immediately by the idle PIO
+    ControllerPortState state;
+    state.source = kMouse;
+    state.arrival_us = global_time_us;
+    state.right = 1;
+    pio.put_step(state, 200);
+
+    // Performed after the previous step has ended
+    global_time_us += 50;
+    state.arrival_us = global_time_us;
+    state.down = 1;
+    pio.put_step(state, 200);
+
+    const LatencyHistogram &h = LatencyTrace::instance().histogram(1, kMouse);
+    EXPECT_EQ(h.count_, 2u);
+    EXPECT_EQ(h.max_us_, 150u);
+    EXPECT_EQ(LatencyTrace::instance().histogram(0, kMouse).count_, 0u);
+}
+
+TEST_F(QuadraturePioTest, SwapKeepsBothPortsRunning) {
+    pio_sm_set_enabled_fake.custom_fake = sm_set_enabled;
+    quadrature_out_program_init_fake.custom_fake = sm_init;
+    sm_enabled = {};
+
+    auto ports = PortSwitcher::construct_pair(std::make_shared<RightPortStub>(), std::make_shared<LeftPortStub>());
+    AmigaMouse mouse1;
+    AmigaMouse mouse2;
+    mouse1.mouse_target_ = ports.first;
+    mouse2.mouse_target_ = ports.second;
+    mouse1.ensure_mouse_muxing();
+    mouse2.ensure_mouse_muxing();
+    EXPECT_EQ(sm_enabled, (std::array<bool, 2>{true, true}));
+
+    // Same order as Pipeline::swap_callback. The second mouse takes over the state machine of the first one
+    ports.first->swap();
+    mouse2.ensure_mouse_muxing();
+    mouse1.ensure_mouse_muxing();
+    EXPECT_EQ(sm_enabled, (std::array<bool, 2>{true, true}));
+
+    // Movement of the first mouse is now performed by the state machine of the left port
+    MouseReport report;
+    report.relx = 1;
+    mouse1.process_mouse_report(report);
+    mouse1.run();
+    ASSERT_GT(pio_sm_put_fake.call_count, 0u);
+    EXPECT_EQ(pio_sm_put_fake.arg1_val, 1u);
+
+    // And back again
+    ports.first->swap();
+    mouse1.ensure_mouse_muxing();
+    mouse2.ensure_mouse_muxing();
+    EXPECT_EQ(sm_enabled, (std::array<bool, 2>{true, true}));
+
+    pio_sm_set_enabled_fake.custom_fake = nullptr;
+    quadrature_out_program_init_fake.custom_fake = nullptr;
+}
+
+TEST(QuadratureRateProfile, PeriodAdaptsToBacklog) {
+    const QuadratureRateProfile &st = AtariStMouse::kRateProfiles[0];
+
+    // Small movements use the safe period
+    EXPECT_EQ(st.period_for_backlog(0), st.max_period_);
+    EXPECT_EQ(st.period_for_backlog(5), st.max_period_);
+
+    // Big movements are limited by the fastest period
+    EXPECT_EQ(st.period_for_backlog(500), st.min_period_);
+
+    // Somewhere between, the backlog is drained within one frame
+    EXPECT_EQ(st.period_for_backlog(50), 400u);
+}
+
+TEST_F(QuadraturePioTest, FastFlickUsesHigherRate) {
+    auto port = std::make_shared<RightPortStub>();
+    AtariStMouse mouse;
+    mouse.mouse_target_ = port;
+    mouse.ensure_mouse_muxing();
+
+    MouseReport report;
+    report.relx = 127;
+    mouse.process_mouse_report(report);
+    mouse.process_mouse_report(report);
+    mouse.run();
+
+    ASSERT_EQ(pio_sm_put_fake.call_count, 4u);
+    EXPECT_EQ(step_hold(0) + QUADRATURE_OUT_STEP_OVERHEAD, AtariStMouse::kRateProfiles[0].min_period_);
+
+    // Refill is performed at the higher rate
+    uint32_t now = global_time_us;
+    EXPECT_EQ(mouse.next_deadline(now), now + 2 * AtariStMouse::kRateProfiles[0].min_period_);
+}
+
+TEST(QuadratureRateProfile, AmigaStaysAtVerifiedRate) {
+    ASSERT_EQ(MouseModeSwitcher::number_rate_profiles(0), 1u);
+    const QuadratureRateProfile &profile = AmigaMouse::kRateProfiles[0];
+    EXPECT_EQ(profile.period_for_backlog(0), AmigaMouse::kVerifiedPeriod);
+    EXPECT_EQ(profile.period_for_backlog(500), AmigaMouse::kVerifiedPeriod);
+
+    // 127 steps per frame are never exceeded
+    EXPECT_LE(profile.frame_period_ / profile.min_period_, 127u);
+}
+
+TEST_F(QuadraturePioTest, WideMovementIsNotTruncated) {
+    auto port = std::make_shared<RightPortStub>();
+    AmigaMouse mouse;
+    mouse.mouse_target_ = port;
+    mouse.ensure_mouse_muxing();
+
+    // A single report of a high resolution mouse exceeds 8 bit
+    MouseReport report;
+    report.relx = 300;
+    report.rely = -200;
+    mouse.process_mouse_report(report);
+
+    EXPECT_EQ(mouse.backlog_telemetry().backlog_, 300u);
+    EXPECT_EQ(mouse.backlog_telemetry().discarded_, 0u);
+}
+
+DECLARE_FAKE_VALUE_FUNC(int, dma_claim_unused_channel, bool);
+DECLARE_FAKE_VOID_FUNC(dma_channel_transfer_from_buffer_now, uint, const volatile void *, uint32_t);
+DECLARE_FAKE_VALUE_FUNC(bool, dma_channel_is_busy, uint);
+DECLARE_FAKE_VALUE_FUNC(uint, pio_sm_get_tx_fifo_level, PIO, uint);
+
+/// Absolute time in microseconds when the simulated SID starts the next measurement cycle
+static uint32_t next_sid_cycle;
+
+/// Values of every DMA channel which are not yet taken by the simulated SID.
+/// Consists of the TX FIFO and the remaining DMA transfer.
+static std::array<uint32_t, 12> sid_queued;
+
+/// Number of claimed DMA channels
+static int sid_channels;
+
+/// Lets the simulated SID take a value for every measurement cycle which has passed
+static void sid_advance() {
+    while (static_cast<int32_t>(global_time_us - next_sid_cycle) >= 0) {
+        for (auto &queued : sid_queued) {
+            if (queued > 0)
+                queued--;
+        }
+        next_sid_cycle += 512;
+    }
+}
+
+static int sid_dma_claim(bool) {
+    return sid_channels++;
+}
+
+static bool sid_dma_busy(uint channel) {
+    sid_advance();
+    // The DMA is busy as long as the TX FIFO can't take the whole transfer
+    return sid_queued.at(channel) > SidPotStream::kFifoDepth;
+}
+
+/// X is fed by an even state machine and the first claimed channel. Y by the odd one.
+static uint sid_fifo_level(PIO, uint sm) {
+    sid_advance();
+    return std::min<uint32_t>(sid_queued.at(sm % 2), SidPotStream::kFifoDepth);
+}
+
+static void sid_dma_transfer(uint channel, const volatile void *, uint32_t count) {
+    sid_advance();
+    sid_queued.at(channel) += count;
+}
+
+/**
+ * @brief Feeds a swipe with 1000 Hz reports and measures the output latency
+ *
+ * The speed of the swipe follows a sine half wave.
+ * Processors are run exactly when they are due.
+ *
+ * @param mouse         Mouse emulation to test
+ * @param duration_ms   Duration of the swipe
+ * @param peak          Highest movement per report
+ * @param diagonal      Move on both axes
+ * @return uint32_t Worst case time in microseconds between report and output of its movement
+ */
+template <typename Mouse>
+static uint32_t swipe_latency(Mouse &mouse, uint32_t duration_ms, int peak, bool diagonal) {
+    // Reports which are not yet performed. Time of report and steps to perform until then
+    std::queue<std::pair<uint32_t, uint64_t>> pending;
+    uint64_t drained = 0;
+    uint32_t worst = 0;
+    uint32_t start = global_time_us;
+    uint32_t next_report = start;
+    uint32_t report_cnt = 0;
+
+    while (report_cnt < duration_ms || !pending.empty()) {
+        uint32_t deadline = mouse.next_deadline(global_time_us);
+        if (report_cnt < duration_ms && static_cast<int32_t>(next_report - deadline) <= 0) {
+            global_time_us = next_report;
+
+            MouseReport report;
+            int movement = static_cast<int>(peak * std::sin(M_PI * report_cnt / duration_ms));
+            report.relx = static_cast<int8_t>(movement);
+            report.rely = static_cast<int8_t>(diagonal ? -movement / 2 : 0);
+            mouse.process_mouse_report(report);
+
+            pending.push(std::make_pair(global_time_us, drained + mouse.backlog_telemetry().backlog_));
+            next_report += 1000;
+            report_cnt++;
+        } else {
+            global_time_us = std::max(deadline, global_time_us);
+        }
+
+        uint32_t before = mouse.backlog_telemetry().backlog_;
+        mouse.run();
+        drained += before - mouse.backlog_telemetry().backlog_;
+
+        while (!pending.empty() && drained >= pending.front().second) {
+            worst = std::max(worst, global_time_us - pending.front().first);
+            pending.pop();
+        }
+    }
+
+    return worst;
+}
+
+/// Swipes from gentle to the fastest possible
+static constexpr std::array<std::tuple<uint32_t, int, bool>, 6> kSwipes{{
+    {50, 10, false},
+    {100, 40, true},
+    {200, 127, false},
+    {200, 127, true},
+    {500, 80, false},
+    {1000, 127, true},
+}};
+
+TEST(MovementBacklog, QuadratureDrainTimeIsBounded) {
+    for (auto &swipe : kSwipes) {
+        for (size_t profile = 0; profile < AtariStMouse::kRateProfiles.size(); profile++) {
+            auto port = std::make_shared<RightPortStub>();
+            AmigaMouse amiga(profile % AmigaMouse::kRateProfiles.size());
+            amiga.mouse_target_ = port;
+            AtariStMouse atari(profile);
+            atari.mouse_target_ = port;
+
+            uint32_t amiga_latency =
+                swipe_latency(amiga, std::get<0>(swipe), std::get<1>(swipe), std::get<2>(swipe));
+            uint32_t atari_latency =
+                swipe_latency(atari, std::get<0>(swipe), std::get<1>(swipe), std::get<2>(swipe));
+
+            printf("Swipe %4u ms, peak %3d: Amiga %6u us (%5u discarded), Atari ST %6u us (%5u discarded)\n",
+                   std::get<0>(swipe), std::get<1>(swipe), amiga_latency, amiga.backlog_telemetry().discarded_,
+                   atari_latency, atari.backlog_telemetry().discarded_);
+
+            EXPECT_LE(amiga_latency, MovementBacklog::kMaxLatency);
+            EXPECT_LE(atari_latency, MovementBacklog::kMaxLatency);
+            EXPECT_LE(amiga.backlog_telemetry().max_age_us_, MovementBacklog::kMaxLatency);
+            EXPECT_LE(atari.backlog_telemetry().max_age_us_, MovementBacklog::kMaxLatency);
+        }
+    }
+}
+
+TEST(MovementBacklog, C1351DrainTimeIsBounded) {
+    RESET_FAKE(dma_claim_unused_channel);
+    RESET_FAKE(dma_channel_is_busy);
+    RESET_FAKE(dma_channel_transfer_from_buffer_now);
+    RESET_FAKE(pio_sm_get_tx_fifo_level);
+    dma_claim_unused_channel_fake.custom_fake = sid_dma_claim;
+    dma_channel_is_busy_fake.custom_fake = sid_dma_busy;
+    dma_channel_transfer_from_buffer_now_fake.custom_fake = sid_dma_transfer;
+    pio_sm_get_tx_fifo_level_fake.custom_fake = sid_fifo_level;
+    next_sid_cycle = global_time_us;
+
+    for (auto &swipe : kSwipes) {
+        auto port = std::make_shared<RightPortStub>();
+        C1351Converter c1351;
+        sid_channels = 0;
+        sid_queued.fill(0);
+        c1351.set_target(port);
+        c1351.ensure_mouse_muxing();
+
+        uint32_t latency = swipe_latency(c1351, std::get<0>(swipe), std::get<1>(swipe), std::get<2>(swipe));
+
+        printf("Swipe %4u ms, peak %3d: C1351 %6u us (%5u discarded)\n", std::get<0>(swipe), std::get<1>(swipe),
+               latency, c1351.backlog_telemetry().discarded_);
+
+        EXPECT_LE(latency, MovementBacklog::kMaxLatency);
+        EXPECT_LE(c1351.backlog_telemetry().max_age_us_, MovementBacklog::kMaxLatency);
+    }
+
+    RESET_FAKE(dma_claim_unused_channel);
+    RESET_FAKE(dma_channel_is_busy);
+    RESET_FAKE(dma_channel_transfer_from_buffer_now);
+    RESET_FAKE(pio_sm_get_tx_fifo_level);
+}
+
+TEST(C1351Stream, LateLoopKeepsStreaming) {
+    RESET_FAKE(dma_claim_unused_channel);
+    RESET_FAKE(dma_channel_is_busy);
+    RESET_FAKE(dma_channel_transfer_from_buffer_now);
+    RESET_FAKE(pio_sm_get_tx_fifo_level);
+    dma_claim_unused_channel_fake.custom_fake = sid_dma_claim;
+    dma_channel_is_busy_fake.custom_fake = sid_dma_busy;
+    dma_channel_transfer_from_buffer_now_fake.custom_fake = sid_dma_transfer;
+    pio_sm_get_tx_fifo_level_fake.custom_fake = sid_fifo_level;
+    next_sid_cycle = global_time_us;
+    sid_channels = 0;
+    sid_queued.fill(0);
+
+    auto port = std::make_shared<RightPortStub>();
+    C1351Converter c1351;
+    c1351.set_target(port);
+    c1351.ensure_mouse_muxing();
+
+    MouseReport report;
+    report.relx = 100;
+    c1351.process_mouse_report(report);
+
+    // Main loop on time. New values must not wait behind a long queue
+    for (int i = 0; i < 10; i++) {
+        global_time_us = c1351.next_deadline(global_time_us);
+        c1351.run();
+        EXPECT_LE(sid_queued[0], SidPotStream::kQueuedCycles);
+        EXPECT_LE(sid_queued[1], SidPotStream::kQueuedCycles);
+    }
+    uint32_t transfers = dma_channel_transfer_from_buffer_now_fake.call_count;
+
+    // Main loop stalls for a measurement cycle since the last check
+    global_time_us += SidPotStream::kRefillLevel * 512;
+    sid_advance();
+
+    // The SID was still provided with new values
+    EXPECT_GT(sid_queued[0], 0u);
+    EXPECT_GT(sid_queued[1], 0u);
+
+    // Both axes are fed together as soon as the queue is short
+    while (dma_channel_transfer_from_buffer_now_fake.call_count == transfers) {
+        c1351.run();
+        global_time_us = c1351.next_deadline(global_time_us);
+    }
+    EXPECT_EQ(dma_channel_transfer_from_buffer_now_fake.call_count, transfers + 2);
+    EXPECT_EQ(sid_queued[0], sid_queued[1]);
+
+    RESET_FAKE(dma_claim_unused_channel);
+    RESET_FAKE(dma_channel_is_busy);
+    RESET_FAKE(dma_channel_transfer_from_buffer_now);
+    RESET_FAKE(pio_sm_get_tx_fifo_level);
+}
+
+TEST(C1351Stream, LatencyIncludesQueuedCycles) {
+    RESET_FAKE(dma_claim_unused_channel);
+    RESET_FAKE(dma_channel_is_busy);
+    RESET_FAKE(dma_channel_transfer_from_buffer_now);
+    RESET_FAKE(pio_sm_get_tx_fifo_level);
+    dma_claim_unused_channel_fake.custom_fake = sid_dma_claim;
+    dma_channel_is_busy_fake.custom_fake = sid_dma_busy;
+    dma_channel_transfer_from_buffer_now_fake.custom_fake = sid_dma_transfer;
+    pio_sm_get_tx_fifo_level_fake.custom_fake = sid_fifo_level;
+    next_sid_cycle = global_time_us;
+    sid_channels = 0;
+    sid_queued.fill(0);
+
+    auto port = std::make_shared<RightPortStub>();
+    C1351Converter c1351;
+    c1351.set_target(port);
+    c1351.ensure_mouse_muxing();
+    LatencyTrace::instance().reset();
+    global_time_us += 1000;
+
+    MouseReport report;
+    report.relx = 10;
+    report.arrival_us = global_time_us;
+    c1351.process_mouse_report(report);
+    c1351.run();
+
+    // Handed over immediately, but performed after the queued cycles
+    const LatencyHistogram &h = LatencyTrace::instance().histogram(port->get_index(), kMouse);
+    ASSERT_EQ(h.count_, 1u);
+    EXPECT_EQ(h.max_us_, SidPotStream::kQueuedCycles * 512);
+
+    RESET_FAKE(dma_claim_unused_channel);
+    RESET_FAKE(dma_channel_is_busy);
+    RESET_FAKE(dma_channel_transfer_from_buffer_now);
+    RESET_FAKE(pio_sm_get_tx_fifo_level);
+}
+
+TEST(MovementBacklog, PolicyKeepsDirection) {
+    MovementBacklog backlog(100);
+
+    int32_t x = 300;
+    int32_t y = -150;
+    backlog.limit(x, y);
+
+    EXPECT_EQ(x, 100);
+    EXPECT_EQ(y, -50);
+    EXPECT_EQ(backlog.telemetry().discarded_, 300u);
+    EXPECT_EQ(backlog.telemetry().age_us_, MovementBacklog::kMaxLatency);
+
+    // Movement within the limit is untouched
+    x = 20;
+    y = 30;
+    backlog.limit(x, y);
+    EXPECT_EQ(x, 20);
+    EXPECT_EQ(y, 30);
+    EXPECT_EQ(backlog.telemetry().backlog_, 30u);
+}
@@ -0,0 +1,243 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "hid_descriptors.hpp"
+#include "hid_layout_cache.hpp"
+#include "report_replay.hpp"
+#include "tusb.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "fff.h"
+
+FAKE_VALUE_FUNC(bool, tuh_hid_receive_report, uint8_t, uint8_t);
+FAKE_VALUE_FUNC(bool, tuh_hid_set_protocol, uint8_t, uint8_t, uint8_t);
+FAKE_VALUE_FUNC(bool, tuh_hid_send_report, uint8_t, uint8_t, uint8_t, const void *, uint16_t);
+FAKE_VALUE_FUNC(bool, tuh_hid_set_report, uint8_t, uint8_t, uint8_t, uint8_t, void *, uint16_t);
+
+// The host has no flash to cache the layouts in
+bool HidLayoutCache::compile(uint16_t, uint16_t, const uint8_t *desc, size_t len,
+                             HidReportParser::Application application, HidReportPlan &plan) {
+    return HidReportParser::compile(desc, len, application, plan);
+}
+
+// Vendor class drivers are not replayed
+std::shared_ptr<ReportSourceInterface> open_xbox_one_handler(uint8_t, uint8_t const *, uint16_t) {
+    return nullptr;
+}
+std::shared_ptr<ReportSourceInterface> open_xbox_360_wireless_receiver_handler(uint8_t, uint8_t const *, uint16_t) {
+    return nullptr;
+}
+
+static constexpr uint16_t kMouseVid{0x1234};
+static constexpr uint16_t kMousePid{0x0001};
+static constexpr uint16_t kJoystickVid{0x0079};
+static constexpr uint16_t kJoystickPid{0x0006};
+
+/**
+ * @brief Captures a mouse and a joystick like the firmware would
+ *
+ * @param capture   Destination of the capture
+ * @param duration  Time in microseconds of mouse movement at 1 kHz
+ */
+static void capture_session(ReportCapture &capture, uint32_t duration) {
+    capture.mount(1, 0, kMouseVid, kMousePid, HID_USAGE_PAGE_DESKTOP, HID_USAGE_DESKTOP_MOUSE,
+                  std::span(kDescBootMouse));
+    global_time_us += 1000;
+    capture.mount(2, 0, kJoystickVid, kJoystickPid, HID_USAGE_PAGE_DESKTOP, HID_USAGE_DESKTOP_JOYSTICK,
+                  std::span(kDescDragonRise));
+
+    for (uint32_t t = 0; t < duration; t += 1000) {
+        global_time_us += 1000;
+        const uint8_t mouse[] = {0x00, 0x05, 0xfd};
+        capture.report(ReportCapture::kHidReport, 1, 0, kMouseVid, kMousePid, std::span(mouse));
+    }
+
+    // Joystick up with fire
+    global_time_us += 1000;
+    const uint8_t joystick[] = {0x7f, 0x00, 0x7f, 0x7f, 0x7f, 0x1f, 0x00, 0x00};
+    capture.report(ReportCapture::kHidReport, 2, 0, kJoystickVid, kJoystickPid, std::span(joystick));
+
+    // Not replayed
+    global_time_us += 1000;
+    const uint8_t vendor[] = {0x20, 0x00, 0x01, 0x0e};
+    capture.report(ReportCapture::kVendorReport, 3, 0, 0x045e, 0x02d1, std::span(vendor));
+}
+
+/// @brief Converts a capture into the lines printed by \ref ReportCapture::dump
+static std::vector<std::string> to_lines(const ReportCapture &capture) {
+    std::vector<std::string> lines;
+    std::vector<char> line(ReportCapture::kMaxLine);
+
+    capture.for_each([&](const ReportCapture::Event &event) {
+        ReportCapture::format(event, line.data(), line.size());
+        lines.emplace_back(line.data());
+    });
+    return lines;
+}
+
+/// @brief Replays lines of a capture and returns all states of both ports
+static std::vector<std::pair<uint32_t, ControllerPortState>> replay_lines(const std::vector<std::string> &lines,
+                                                                           size_t &reports) {
+    ReportReplay replay;
+    std::array<uint8_t, ReportCapture::kMaxDescriptor> storage;
+    uint32_t start = global_time_us;
+
+    for (auto &line : lines) {
+        ReportCapture::Event event;
+        EXPECT_TRUE(ReportCapture::parse(line.c_str(), event, storage));
+        replay.process(event);
+    }
+    replay.advance_to(global_time_us + 100000);
+    reports = replay.reports_;
+
+    // Make the result independent of the start of the virtual clock
+    std::vector<std::pair<uint32_t, ControllerPortState>> states;
+    for (auto port : {replay.right_port_, replay.left_port_}) {
+        for (auto &[time, state] : port->states_)
+            states.emplace_back(time - start, state);
+    }
+    return states;
+}
+
+TEST(ReportCapture, DropsOldestReports) {
+    auto capture = std::make_unique<ReportCapture>();
+    const uint8_t report[ReportCapture::kMaxReport + 10]{};
+
+    // Header of 12 bytes and 64 bytes of the truncated report
+    size_t fitting = ReportCapture::kCapacity / (12 + ReportCapture::kMaxReport);
+    for (size_t i = 0; i < fitting + 5; i++) {
+        global_time_us += 100;
+        capture->report(ReportCapture::kHidReport, 1, 0, 1, 2, std::span(report));
+    }
+
+    EXPECT_EQ(capture->size(), fitting);
+    EXPECT_EQ(capture->dropped(), 5);
+
+    uint32_t last = 0;
+    size_t count = 0;
+    capture->for_each([&](const ReportCapture::Event &event) {
+        EXPECT_EQ(event.data.size(), ReportCapture::kMaxReport);
+        if (count) {
+            EXPECT_EQ(event.time_us - last, 100);
+        }
+        last = event.time_us;
+        count++;
+    });
+    EXPECT_EQ(count, fitting);
+    EXPECT_EQ(last, global_time_us);
+}
+
+TEST(ReportCapture, FormatAndParse) {
+    auto capture = std::make_unique<ReportCapture>();
+    capture_session(*capture, 3000);
+
+    std::vector<std::string> lines = to_lines(*capture);
+    ASSERT_EQ(lines.size(), 2 + 3 + 2);
+    EXPECT_EQ(lines[0].substr(0, 6), "CAP M ");
+
+    std::array<uint8_t, ReportCapture::kMaxDescriptor> storage;
+    ReportCapture::Event event;
+
+    // Lines of the RTT log have a prefix
+    std::string logged = "00> " + lines[1];
+    ASSERT_TRUE(ReportCapture::parse(logged.c_str(), event, storage));
+    EXPECT_EQ(event.kind, ReportCapture::kMount);
+    EXPECT_EQ(event.vid, kJoystickVid);
+    EXPECT_EQ(event.usage, HID_USAGE_DESKTOP_JOYSTICK);
+    ASSERT_EQ(event.data.size(), sizeof(kDescDragonRise));
+    EXPECT_TRUE(std::equal(event.data.begin(), event.data.end(), kDescDragonRise));
+
+    ASSERT_TRUE(ReportCapture::parse(lines.back().c_str(), event, storage));
+    EXPECT_EQ(event.kind, ReportCapture::kVendorReport);
+    EXPECT_EQ(event.dev_addr, 3);
+    EXPECT_EQ(event.data.size(), 4);
+    EXPECT_EQ(event.data[3], 0x0e);
+
+    EXPECT_FALSE(ReportCapture::parse("Mouse X:5 Y:-3", event, storage));
+}
+
+TEST(ReportReplay, Deterministic) {
+    auto capture = std::make_unique<ReportCapture>();
+    capture_session(*capture, 50000);
+    std::vector<std::string> lines = to_lines(*capture);
+
+    size_t reports1, reports2;
+    auto states1 = replay_lines(lines, reports1);
+    global_time_us += 12345;
+    auto states2 = replay_lines(lines, reports2);
+
+    EXPECT_EQ(reports1, 50 + 1);
+    EXPECT_EQ(reports2, reports1);
+    ASSERT_EQ(states1.size(), states2.size());
+    for (size_t i = 0; i < states1.size(); i++) {
+        EXPECT_EQ(states1[i].first, states2[i].first);
+        EXPECT_EQ(states1[i].second, states2[i].second);
+    }
+
+    // The joystick has reached the left port
+    ControllerPortState up_and_fire;
+    up_and_fire.up = true;
+    up_and_fire.fire1 = true;
+    EXPECT_TRUE(std::any_of(states1.begin(), states1.end(), [&](auto &s) { return s.second == up_and_fire; }));
+}
+
+/**
+ * @brief Replays a capture of the field
+ *
+ * Usage: REPLAY_CAPTURE=capture.txt ./unittest --gtest_filter=ReportReplay.FieldCapture
+ * The capture can be a complete RTT log.
+ * With REPLAY_VCD=ports.vcd, the signals of the controller ports are written for GTKWave.
+ */
+TEST(ReportReplay, FieldCapture) {
+    const char *path = getenv("REPLAY_CAPTURE");
+    if (!path)
+        GTEST_SKIP() << "REPLAY_CAPTURE is not set";
+
+    FILE *file = fopen(path, "r");
+    ASSERT_TRUE(file) << "Can't open " << path;
+
+    ReportReplay replay;
+    LatencyTrace::instance().reset();
+
+    auto start = std::chrono::steady_clock::now();
+    size_t events = replay.process(file);
+    double cpu = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fclose(file);
+
+    printf("%zu events, %zu reports replayed, %zu skipped in %.3f s\n", events, replay.reports_, replay.skipped_, cpu);
+    printf("Left port changes: %zu  Right port changes: %zu\n", replay.left_port_->states_.size(),
+           replay.right_port_->states_.size());
+    LatencyTrace::instance().dump();
+
+    const char *vcd_path = getenv("REPLAY_VCD");
+    if (vcd_path) {
+        FILE *vcd = fopen(vcd_path, "w");
+        ASSERT_TRUE(vcd) << "Can't open " << vcd_path;
+        replay.waveform_.export_vcd([vcd](const char *line) { fputs(line, vcd); });
+        fclose(vcd);
+        printf("%zu signal changes written to %s\n", replay.waveform_.size(), vcd_path);
+    }
+}
+
+TEST(Benchmark, ReportReplay) {
+    auto capture = std::make_unique<ReportCapture>();
+    capture_session(*capture, 200000);
+    std::vector<std::string> lines = to_lines(*capture);
+
+    ReportReplay replay;
+    std::array<uint8_t, ReportCapture::kMaxDescriptor> storage;
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto &line : lines) {
+        ReportCapture::Event event;
+        ReportCapture::parse(line.c_str(), event, storage);
+        replay.process(event);
+    }
+    double cpu = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("Replayed %zu reports in %.1f us per report\n", replay.reports_, cpu * 1e6 / replay.reports_);
+    EXPECT_EQ(replay.reports_, 200 + 1);
+}
@@ -0,0 +1,221 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+
+#include "processors/pipeline.hpp"
+#include <gtest/gtest.h>
+
+extern uint32_t global_time_us;
+
+/// Runnable which is due in fixed periods and counts its calls
+class PeriodicTask : public Runnable {
+  public:
+    uint32_t period_;
+    uint32_t last_run_{0};
+    uint32_t runs_{0};
+
+    PeriodicTask(uint32_t period) : period_(period) {
+    }
+
+    void run() override {
+        last_run_ = global_time_us;
+        runs_++;
+    }
+
+    uint32_t next_deadline(uint32_t) override {
+        return last_run_ + period_;
+    }
+};
+
+TEST(DeadlineScheduler, DispatchesOnlyDueTasks) {
+    DeadlineScheduler<4> scheduler;
+    PeriodicTask fast(100), slow(1000);
+
+    global_time_us = 0;
+    scheduler.add(&fast);
+    size_t slow_id = scheduler.add(&slow);
+
+    // Everything is due after registration
+    EXPECT_EQ(scheduler.dispatch(global_time_us), 2u);
+    EXPECT_EQ(scheduler.dispatch(global_time_us), 0u);
+
+    for (global_time_us = 1; global_time_us <= 1000; global_time_us++) {
+        scheduler.dispatch(global_time_us);
+    }
+
+    EXPECT_EQ(fast.runs_, 11u);
+    EXPECT_EQ(slow.runs_, 2u);
+
+    // Woken tasks are dispatched immediately
+    scheduler.wake(slow_id);
+    EXPECT_EQ(scheduler.dispatch(global_time_us), 1u);
+    EXPECT_EQ(slow.runs_, 3u);
+
+    // All dispatches were in time
+    EXPECT_EQ(scheduler.stats().lateness_[0], scheduler.stats().dispatches_);
+}
+
+TEST(DeadlineScheduler, RejectsTasksBeyondCapacity) {
+    DeadlineScheduler<3> scheduler;
+    PeriodicTask a(100), b(100), c(100), d(100);
+
+    global_time_us = 0;
+    EXPECT_EQ(scheduler.add(&a), 0u);
+    EXPECT_EQ(scheduler.add(&b), 1u);
+    EXPECT_EQ(scheduler.add(&c), 2u);
+    EXPECT_EQ(scheduler.add(&d), DeadlineScheduler<3>::kInvalidId);
+
+    // The rejected task is never dispatched, waking it has no effect
+    scheduler.wake(DeadlineScheduler<3>::kInvalidId);
+    EXPECT_EQ(scheduler.dispatch(global_time_us), 3u);
+    EXPECT_EQ(scheduler.dispatch(global_time_us), 0u);
+    EXPECT_EQ(d.runs_, 0u);
+}
+
+TEST(DeadlineScheduler, SurvivesTimerOverflow) {
+    DeadlineScheduler<2> scheduler;
+    PeriodicTask task(100);
+
+    global_time_us = 0xffffff00;
+    scheduler.add(&task);
+
+    for (uint32_t i = 0; i < 1000; i++) {
+        scheduler.dispatch(global_time_us++);
+    }
+
+    EXPECT_EQ(task.runs_, 10u);
+}
+
+/// Controller port which just remembers the last state
+class NullControllerPort : public ControllerPortInterface {
+  public:
+    ControllerPortState state_;
+    uint32_t changes_{0};
+
+    void set_port_state(ControllerPortState &state) override {
+        state_ = state;
+        changes_++;
+    }
+    uint get_pot_x_drain_gpio() override {
+        return 0;
+    }
+    uint get_pot_y_drain_gpio() override {
+        return 0;
+    }
+    uint get_pot_y_sense_gpio() override {
+        return 0;
+    }
+    void configure_gpios() override {
+    }
+    const char *get_name() override {
+        return "";
+    }
+    size_t get_index() override {
+        return 0;
+    }
+    uint32_t get_gpio_mask(const ControllerPortState &) override {
+        return 0;
+    }
+    uint get_direction_gpio_base() override {
+        return 0;
+    }
+};
+
+/// Report source which only keeps the connection to the pipeline
+class BenchmarkSource : public ReportSourceInterface {
+  private:
+    ReportType type_;
+
+  public:
+    std::shared_ptr<ReportHubInterface> target_;
+
+    BenchmarkSource(ReportType t) : type_(t) {
+    }
+    ReportType expected_report() override {
+        return type_;
+    }
+    void set_target(std::shared_ptr<ReportHubInterface> target) override {
+        target_ = target;
+    }
+    void run() override {
+    }
+};
+
+TEST(Benchmark, SchedulerBusyConfiguration) {
+    auto port_joy = std::make_shared<NullControllerPort>();
+    auto port_mouse = std::make_shared<NullControllerPort>();
+    auto pipeline = std::make_unique<Pipeline>(port_joy, port_mouse);
+
+    auto mouse1 = std::make_shared<BenchmarkSource>(kMouse);
+    auto mouse2 = std::make_shared<BenchmarkSource>(kMouse);
+    auto joy1 = std::make_shared<BenchmarkSource>(kGamePad);
+    auto joy2 = std::make_shared<BenchmarkSource>(kGamePad);
+
+    pipeline->integrate_handler(mouse1);
+    pipeline->integrate_handler(joy1);
+    pipeline->integrate_handler(mouse2);
+    pipeline->integrate_handler(joy2);
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> movement(-20, 20);
+    // Duration of a main loop iteration caused by USB activity
+    std::uniform_int_distribution<uint32_t> loop_duration(2, 40);
+
+    static constexpr uint32_t kSimulatedUs = 10 * 1000 * 1000;
+    uint32_t start = global_time_us;
+    uint32_t next_mouse_report = start;
+    uint32_t next_joy_report = start;
+    uint32_t iterations = 0;
+    uint32_t dispatches_before = pipeline->scheduler_stats().dispatches_;
+
+    auto real_start = std::chrono::steady_clock::now();
+
+    while (global_time_us - start < kSimulatedUs) {
+        if (static_cast<int32_t>(global_time_us - next_mouse_report) >= 0) {
+            // 1000 Hz mice
+            next_mouse_report += 1000;
+            MouseReport report;
+            report.relx = static_cast<int8_t>(movement(rng));
+            report.rely = static_cast<int8_t>(movement(rng));
+            mouse1->target_->process_mouse_report(report);
+            mouse2->target_->process_mouse_report(report);
+        }
+
+        if (static_cast<int32_t>(global_time_us - next_joy_report) >= 0) {
+            // 250 Hz gamepads with auto fire held
+            next_joy_report += 4000;
+            GamepadReport report;
+            report.auto_fire = 1;
+            report.up = (global_time_us >> 16) & 1;
+            joy1->target_->process_gamepad_report(report);
+            joy2->target_->process_gamepad_report(report);
+        }
+
+        pipeline->run();
+        iterations++;
+        global_time_us += loop_duration(rng);
+    }
+
+    auto real_duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - real_start).count();
+    const SchedulerStats &stats = pipeline->scheduler_stats();
+    uint32_t dispatches = stats.dispatches_ - dispatches_before;
+
+    printf("Loop iterations:      %u\n", iterations);
+    printf("Dispatches:           %u (%.2f per iteration)\n", dispatches, double(dispatches) / iterations);
+    printf("Dispatches per second (host): %.0f\n", dispatches / real_duration);
+    printf("Deadline lateness distribution:\n");
+    for (size_t i = 0; i < stats.lateness_.size(); i++) {
+        if (i < SchedulerStats::kLatenessBounds.size())
+            printf("  <= %3u us: %u\n", SchedulerStats::kLatenessBounds[i], stats.lateness_[i]);
+        else
+            printf("   > %3u us: %u\n", SchedulerStats::kLatenessBounds.back(), stats.lateness_[i]);
+    }
+
+    // Only due tasks are dispatched
+    EXPECT_LT(dispatches, iterations);
+    // Deadlines can only be missed by the duration of one loop iteration
+    EXPECT_EQ(stats.lateness_[5] + stats.lateness_[6] + stats.lateness_[7], 0u);
+    EXPECT_GT(port_mouse->changes_, 0u);
+    EXPECT_GT(port_joy->changes_, 0u);
+}
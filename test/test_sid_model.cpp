@@ -0,0 +1,428 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <memory>
+
+#include "processors/mouse_c1351.hpp"
+#include "sid_model.hpp"
+#include <gtest/gtest.h>
+
+#include "fff.h"
+
+extern uint32_t global_time_us;
+
+DECLARE_FAKE_VALUE_FUNC(int, dma_claim_unused_channel, bool);
+DECLARE_FAKE_VOID_FUNC(dma_channel_transfer_from_buffer_now, uint, const volatile void *, uint32_t);
+DECLARE_FAKE_VALUE_FUNC(bool, dma_channel_is_busy, uint);
+DECLARE_FAKE_VALUE_FUNC(uint, pio_sm_get_tx_fifo_level, PIO, uint);
+DECLARE_FAKE_VALUE_FUNC(bool, pio_sm_is_rx_fifo_empty, PIO, uint);
+DECLARE_FAKE_VALUE_FUNC(uint32_t, pio_sm_get, PIO, uint);
+
+/// Time in microseconds from releasing the drain until the threshold of POT X is reached.
+/// Derived from the default calibration, which puts every value in the middle of its window.
+static constexpr double kChargeX{18.6};
+/// Time in microseconds from releasing the drain until the threshold of POT Y is reached
+static constexpr double kChargeY{16.95};
+
+/// Duration of a PAL frame in microseconds. 312 lines of 63 cycles
+static constexpr uint32_t kPalFrame{19950};
+/// Duration of a NTSC frame in microseconds. 263 lines of 65 cycles
+static constexpr uint32_t kNtscFrame{16715};
+
+/// Controller port without any function
+class SidTestPort : public ControllerPortInterface {
+  public:
+    void set_port_state(ControllerPortState &) override {
+    }
+    uint get_pot_x_drain_gpio() override {
+        return 7;
+    }
+    uint get_pot_y_drain_gpio() override {
+        return 11;
+    }
+    uint get_pot_y_sense_gpio() override {
+        return 13;
+    }
+    void configure_gpios() override {
+    }
+    const char *get_name() override {
+        return "Sid";
+    }
+    size_t get_index() override {
+        return 0;
+    }
+    uint32_t get_gpio_mask(const ControllerPortState &) override {
+        return 0;
+    }
+    uint get_direction_gpio_base() override {
+        return 10;
+    }
+};
+
+/// Values of every DMA channel which are not yet taken by the state machine.
+/// Consists of the TX FIFO and the remaining DMA transfer.
+static std::array<std::deque<uint32_t>, 2> dma_queue;
+
+/// Number of claimed DMA channels
+static int dma_channels;
+
+static int model_dma_claim(bool) {
+    return dma_channels++;
+}
+
+static bool model_dma_busy(uint channel) {
+    return dma_queue.at(channel).size() > SidPotStream::kFifoDepth;
+}
+
+/// X is fed by an even state machine and the first claimed channel. Y by the odd one.
+static uint model_fifo_level(PIO, uint sm) {
+    return std::min(dma_queue.at(sm % 2).size(), SidPotStream::kFifoDepth);
+}
+
+static void model_dma_transfer(uint channel, const volatile void *read_addr, uint32_t count) {
+    const volatile uint32_t *values = static_cast<const volatile uint32_t *>(read_addr);
+    for (uint32_t i = 0; i < count; i++)
+        dma_queue.at(channel).push_back(static_cast<uint32_t>(values[i]));
+}
+
+/// Measurements of the capture state machine which are not yet taken by the CPU
+static std::deque<uint32_t> capture_queue;
+
+static bool model_capture_empty(PIO, uint) {
+    return capture_queue.empty();
+}
+
+static uint32_t model_capture_get(PIO, uint) {
+    uint32_t count = capture_queue.front();
+    capture_queue.pop_front();
+    return count;
+}
+
+/// Provides access to the PIO of \ref SidCycleMonitor
+class SidCycleMonitorTest : public testing::Test {
+  public:
+    /**
+     * @brief Simulates the capture state machine
+     *
+     * @param enabled   True to let the monitor use the PIO
+     */
+    static void simulate_pio(bool enabled) {
+        RESET_FAKE(pio_sm_is_rx_fifo_empty);
+        RESET_FAKE(pio_sm_get);
+        pio_sm_is_rx_fifo_empty_fake.custom_fake = model_capture_empty;
+        pio_sm_get_fake.custom_fake = model_capture_get;
+        capture_queue.clear();
+
+        SidCycleMonitor::pio_ = enabled ? reinterpret_cast<PIO>(PIO1_BASE) : nullptr;
+    }
+
+    /// @brief Provides a single measurement cycle of the given length
+    static void capture(double period_ticks) {
+        capture_queue.push_back(static_cast<uint32_t>(
+            std::lround((period_ticks - SID_CYCLE_CAPTURE_OVERHEAD) / SID_CYCLE_CAPTURE_LOOP_CYCLES)));
+    }
+
+  protected:
+    void SetUp() override {
+        simulate_pio(true);
+    }
+
+    void TearDown() override {
+        simulate_pio(false);
+    }
+};
+
+/// Outcome of \ref simulate
+struct SimulationResult {
+    /// @brief Horizontal movement accepted by the emulation
+    int32_t performed_{0};
+    /// @brief Horizontal movement seen by the C64, unwrapped from the 7 bit POT value
+    int32_t seen_{0};
+    /// @brief Horizontal position of the C64 pointer
+    int32_t pointer_{0};
+    /// @brief Number of reads where the pointer moved against the direction of the mouse
+    uint32_t wrong_direction_{0};
+    /// @brief Number of reads performed by the C64
+    uint32_t reads_{0};
+    /// @brief Final value of POT X
+    uint8_t pot_x_{0};
+};
+
+/**
+ * @brief Moves a mouse with constant speed to the right and lets a C64 follow it
+ *
+ * The emulation, the SID and the C64 software are run exactly when they are due.
+ *
+ * @param pattern       Slew pattern of the emulation
+ * @param clock_mhz     System clock of the C64
+ * @param read_period   Time in microseconds between two reads of the POT registers by the C64
+ * @param speed         Movement per second, distributed over the reports of a 1000 Hz mouse
+ * @param duration_ms   Duration of the movement
+ * @param full_steps    Keep the noise bit stable
+ * @return SimulationResult
+ */
+static SimulationResult simulate(const C1351Converter::SlewPattern &pattern, double clock_mhz, uint32_t read_period,
+                                 int32_t speed, uint32_t duration_ms, bool full_steps = false) {
+    RESET_FAKE(dma_claim_unused_channel);
+    RESET_FAKE(dma_channel_is_busy);
+    RESET_FAKE(dma_channel_transfer_from_buffer_now);
+    RESET_FAKE(pio_sm_get_tx_fifo_level);
+    dma_claim_unused_channel_fake.custom_fake = model_dma_claim;
+    dma_channel_is_busy_fake.custom_fake = model_dma_busy;
+    dma_channel_transfer_from_buffer_now_fake.custom_fake = model_dma_transfer;
+    pio_sm_get_tx_fifo_level_fake.custom_fake = model_fifo_level;
+    dma_channels = 0;
+    for (auto &queue : dma_queue)
+        queue.clear();
+    SidCycleMonitorTest::simulate_pio(true);
+
+    SidPotAdc adc_x(clock_mhz, kChargeX);
+    SidPotAdc adc_y(clock_mhz, kChargeY);
+    C1351Driver driver;
+    SimulationResult result;
+
+    auto port = std::make_shared<SidTestPort>();
+    C1351Converter c1351;
+    c1351.set_target(port);
+    c1351.set_slew_pattern(pattern);
+    c1351.set_full_steps(full_steps);
+    c1351.ensure_mouse_muxing();
+
+    // The C64 takes its first read before the mouse is moved.
+    // Until then, the emulation has measured the clock of the SID.
+    uint32_t start = global_time_us;
+    uint32_t next_read = start + 100000;
+    uint32_t next_report = next_read + 1;
+    double next_sid_cycle = start;
+    uint32_t reports = 0;
+
+    // Values pulled by the state machines and values latched by the SID
+    uint32_t ticks_x = 0;
+    uint32_t ticks_y = 0;
+    uint8_t pot_x = 0;
+    uint8_t pot_y = 0;
+    uint8_t last_pot_x = 0;
+
+    // Continue after the movement until the pointer has settled
+    uint32_t end = next_report + duration_ms * 1000 + MovementBacklog::kMaxLatency + 3 * read_period;
+
+    while (static_cast<int32_t>(global_time_us - end) < 0) {
+        uint32_t deadline = std::min(c1351.next_deadline(global_time_us), next_read);
+        deadline = std::min(deadline, static_cast<uint32_t>(next_sid_cycle));
+        if (reports < duration_ms)
+            deadline = std::min(deadline, next_report);
+        global_time_us = std::max(deadline, global_time_us);
+
+        if (global_time_us >= static_cast<uint32_t>(next_sid_cycle)) {
+            // Latch the previous cycle and start the next one.
+            // Without new values, the state machine repeats the last one.
+            pot_x = adc_x.measure(ticks_x);
+            pot_y = adc_y.measure(ticks_y);
+
+            if (!dma_queue[0].empty()) {
+                ticks_x = dma_queue[0].front();
+                dma_queue[0].pop_front();
+            }
+            if (!dma_queue[1].empty()) {
+                ticks_y = dma_queue[1].front();
+                dma_queue[1].pop_front();
+            }
+
+            SidCycleMonitorTest::capture(adc_x.cycle_us() * SidPotAdc::kPioTicksPerUs);
+            next_sid_cycle += adc_x.cycle_us();
+        }
+
+        if (reports < duration_ms && global_time_us == next_report) {
+            MouseReport report;
+            report.relx = (reports + 1) * speed / 1000 - reports * speed / 1000;
+            c1351.process_mouse_report(report);
+            next_report += 1000;
+            reports++;
+        }
+
+        c1351.run();
+
+        if (global_time_us == next_read) {
+            int32_t before = driver.pos_x_;
+            driver.read(pot_x, pot_y);
+            if ((driver.pos_x_ - before) * speed < 0)
+                result.wrong_direction_++;
+
+            // Sign extend the 7 bit difference
+            if (result.reads_)
+                result.seen_ += static_cast<int8_t>(((pot_x - last_pot_x) & 0x7f) << 1) >> 1;
+            last_pot_x = pot_x;
+            result.reads_++;
+            next_read += read_period;
+        }
+    }
+
+    result.performed_ = static_cast<int32_t>(reports) * speed / 1000 - c1351.backlog_telemetry().discarded_;
+    result.pointer_ = driver.pos_x_;
+    result.pot_x_ = pot_x;
+
+    SidCycleMonitorTest::simulate_pio(false);
+    RESET_FAKE(dma_claim_unused_channel);
+    RESET_FAKE(dma_channel_is_busy);
+    RESET_FAKE(dma_channel_transfer_from_buffer_now);
+
+    return result;
+}
+
+TEST(SidModel, CalibrationHitsEveryValue) {
+    C1351TickTable table;
+    SidPotAdc adc_x(SidPotAdc::kPalClock, kChargeX);
+    SidPotAdc adc_y(SidPotAdc::kPalClock, kChargeY);
+
+    for (uint32_t pot = C1351TickTable::kPotMin; pot <= C1351TickTable::kPotMax; pot++) {
+        EXPECT_EQ(adc_x.measure(table.pot_x_[pot - C1351TickTable::kPotMin]), pot);
+        EXPECT_EQ(adc_y.measure(table.pot_y_[pot - C1351TickTable::kPotMin]), pot);
+    }
+}
+
+TEST(SidModel, DriftCorrectionHitsEveryValueOnNtsc) {
+    C1351TickTable table;
+    SidPotAdc adc_x(SidPotAdc::kNtscClock, kChargeX);
+    SidPotAdc adc_y(SidPotAdc::kNtscClock, kChargeY);
+    int32_t deviation = SidCycleMonitor::kNtscPeriod - SidCycleMonitor::kReferencePeriod;
+
+    for (uint32_t pot = C1351TickTable::kPotMin; pot <= C1351TickTable::kPotMax; pot++) {
+        uint32_t index = pot - C1351TickTable::kPotMin;
+        int32_t correction = C1351TickTable::drift_correction(pot, deviation);
+
+        EXPECT_EQ(adc_x.measure(table.pot_x_[index] + correction), pot);
+        EXPECT_EQ(adc_y.measure(table.pot_y_[index] + correction), pot);
+
+        // Without correction, the values are far off
+        EXPECT_GT(adc_x.measure(table.pot_x_[index]), pot + 10);
+    }
+}
+
+TEST(SidModel, DriverInterpretsChange) {
+    EXPECT_EQ(C1351Driver::delta(64, 64), 0);
+    EXPECT_EQ(C1351Driver::delta(64, 65), 0);
+    EXPECT_EQ(C1351Driver::delta(64, 66), 1);
+    EXPECT_EQ(C1351Driver::delta(66, 64), -1);
+    EXPECT_EQ(C1351Driver::delta(65, 64), 0);
+    // Wrap around of the 7 bit value
+    EXPECT_EQ(C1351Driver::delta(190, 66), 2);
+    // Too much change is interpreted as the other direction
+    EXPECT_EQ(C1351Driver::delta(64, 64 + 70), -29);
+}
+
+TEST(SidModel, DefaultSlewFollowsFrameReaders) {
+    for (auto setup : {std::make_pair(SidPotAdc::kPalClock, kPalFrame), std::make_pair(SidPotAdc::kNtscClock, kNtscFrame)}) {
+        SimulationResult result = simulate(C1351Converter::kDefaultSlewPattern, setup.first, setup.second, 20000, 500);
+
+        EXPECT_EQ(result.wrong_direction_, 0u);
+        EXPECT_EQ(result.seen_, result.performed_);
+        // The emulation starts at 94. The SID clock must not cause an offset
+        EXPECT_EQ(result.pot_x_, static_cast<uint8_t>((30 + result.performed_) % 128 + 64));
+        // The driver only moves the pointer by one for every two steps and drops the remainder
+        EXPECT_LE(result.pointer_ * 2, result.performed_);
+        EXPECT_GE(result.pointer_ * 2 + static_cast<int32_t>(result.reads_), result.performed_);
+    }
+}
+
+TEST(SidModel, FasterSlewBreaksFrameReaders) {
+    // 2 per measurement cycle exceeds the 63 steps a frame reader can distinguish
+    static constexpr C1351Converter::SlewPattern kFast{2, 2, 2, 2, 2, 2, 2, 2};
+
+    SimulationResult result = simulate(kFast, SidPotAdc::kPalClock, kPalFrame, 20000, 500);
+    EXPECT_GT(result.wrong_direction_, 0u);
+
+    // Software which reads twice per frame is able to follow
+    result = simulate(kFast, SidPotAdc::kPalClock, kPalFrame / 2, 20000, 500);
+    EXPECT_EQ(result.wrong_direction_, 0u);
+    EXPECT_EQ(result.seen_, result.performed_);
+}
+
+TEST(SidModel, FullStepsKeepHalfSteps) {
+    // A slow movement which causes odd changes between reads
+    SimulationResult result = simulate(C1351Converter::kDefaultSlewPattern, SidPotAdc::kPalClock, kPalFrame, 150, 1000);
+    EXPECT_EQ(result.seen_, result.performed_);
+    EXPECT_EQ(result.wrong_direction_, 0u);
+    // A third of the movement is lost inside the driver
+    EXPECT_LT(result.pointer_ * 2, result.performed_ * 3 / 4);
+
+    result = simulate(C1351Converter::kDefaultSlewPattern, SidPotAdc::kPalClock, kPalFrame, 150, 1000, true);
+    EXPECT_EQ(result.wrong_direction_, 0u);
+    EXPECT_EQ(result.pointer_ * 2, result.performed_);
+    EXPECT_EQ(result.pot_x_, static_cast<uint8_t>((30 + result.performed_) % 128 + 64));
+
+    // The half step is carried until it is completed
+    result = simulate(C1351Converter::kDefaultSlewPattern, SidPotAdc::kPalClock, kPalFrame, 150, 980, true);
+    EXPECT_EQ(result.pointer_ * 2 + 1, result.performed_);
+    EXPECT_EQ(result.pot_x_, static_cast<uint8_t>((30 + result.performed_ - 1) % 128 + 64));
+}
+
+TEST(Benchmark, C1351SlewAgainstReaders) {
+    static constexpr std::array<std::pair<const char *, C1351Converter::SlewPattern>, 5> kPatterns{{
+        {"1.0", {1, 1, 1, 1, 1, 1, 1, 1}},
+        {"1.5", C1351Converter::kDefaultSlewPattern},
+        {"1.75", {1, 1, 2, 2, 2, 2, 2, 2}},
+        {"2.0", {2, 2, 2, 2, 2, 2, 2, 2}},
+        {"2.25", {2, 2, 2, 2, 2, 2, 3, 3}},
+    }};
+
+    static constexpr std::array<std::pair<const char *, uint32_t>, 3> kReaders{{
+        {"PAL frame", kPalFrame},
+        {"NTSC frame", kNtscFrame},
+        {"Half PAL frame", kPalFrame / 2},
+    }};
+
+    printf("Slew  Reader          Steps/s  Pointer/s  Full steps  Wrong reads\n");
+    for (auto &pattern : kPatterns) {
+        for (auto &reader : kReaders) {
+            double clock = (reader.second == kNtscFrame) ? SidPotAdc::kNtscClock : SidPotAdc::kPalClock;
+            SimulationResult result = simulate(pattern.second, clock, reader.second, 20000, 1000);
+            SimulationResult full = simulate(pattern.second, clock, reader.second, 20000, 1000, true);
+
+            printf("%-5s %-14s %8d  %9d  %10d  %5u/%u\n", pattern.first, reader.first, result.seen_, result.pointer_,
+                   full.pointer_, result.wrong_direction_, result.reads_);
+        }
+    }
+}
+
+TEST_F(SidCycleMonitorTest, DetectsNtscMachine) {
+    SidCycleMonitor monitor;
+
+    // Without measurements, the reference is assumed
+    EXPECT_EQ(monitor.deviation(), 0);
+    monitor.start(2, 13);
+    monitor.poll();
+    EXPECT_EQ(monitor.deviation(), 0);
+    EXPECT_FALSE(monitor.ntsc());
+
+    for (int i = 0; i < 200; i++) {
+        capture(512 / SidPotAdc::kNtscClock * SidPotAdc::kPioTicksPerUs);
+        monitor.poll();
+    }
+
+    EXPECT_TRUE(monitor.ntsc());
+    EXPECT_NEAR(monitor.period(), SidCycleMonitor::kNtscPeriod, 1);
+
+    for (int i = 0; i < 200; i++) {
+        capture(512 / SidPotAdc::kPalClock * SidPotAdc::kPioTicksPerUs);
+        monitor.poll();
+    }
+
+    EXPECT_FALSE(monitor.ntsc());
+    EXPECT_NEAR(monitor.deviation(), 0, 1);
+}
+
+TEST_F(SidCycleMonitorTest, IgnoresGlitches) {
+    SidCycleMonitor monitor;
+    monitor.start(2, 13);
+
+    // Short pulses and missed edges
+    for (int i = 0; i < 100; i++) {
+        capture(1000);
+        capture(2 * SidCycleMonitor::kNtscPeriod);
+    }
+    while (!capture_queue.empty())
+        monitor.poll();
+
+    EXPECT_EQ(monitor.deviation(), 0);
+}
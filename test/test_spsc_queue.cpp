@@ -0,0 +1,85 @@
+#include <cstdio>
+#include <thread>
+
+#include "report_bridge.hpp"
+#include <gtest/gtest.h>
+
+TEST(SpscQueue, PushPop) {
+    SpscQueue<uint32_t, 4> queue;
+    uint32_t value;
+
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop(value));
+
+    for (uint32_t i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.push(i));
+    }
+    // Full now
+    EXPECT_FALSE(queue.push(99));
+
+    for (uint32_t i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(SpscQueue, NoLossOrReorderUnderLoad) {
+    static constexpr uint32_t kReports = 1000000;
+    ReportBridgeQueue queue;
+
+    // Mimics the USB core, producing mouse and gamepad reports alternately.
+    // The sequence number is encoded into the movement and button fields.
+    std::thread producer([&queue]() {
+        for (uint32_t i = 0; i < kReports; i++) {
+            BridgedReport report;
+            report.hub_ = i & 1;
+
+            if (i & 1) {
+                GamepadReport gamepad;
+                gamepad.button_pressed = i;
+                report.report_ = gamepad;
+            } else {
+                MouseReport mouse;
+                mouse.relx = static_cast<int8_t>(i);
+                mouse.rely = static_cast<int8_t>(i >> 8);
+                mouse.wheel = static_cast<int8_t>(i >> 16);
+                report.report_ = mouse;
+            }
+
+            while (!queue.push(report)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    // Mimics the output core
+    uint32_t received = 0;
+    uint32_t errors = 0;
+    while (received < kReports) {
+        BridgedReport report;
+        if (!queue.pop(report)) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        if (report.hub_ != (received & 1)) {
+            errors++;
+        } else if (auto *gamepad = std::get_if<GamepadReport>(&report.report_)) {
+            errors += gamepad->button_pressed != received;
+        } else if (auto *mouse = std::get_if<MouseReport>(&report.report_)) {
+            uint32_t seq = static_cast<uint8_t>(mouse->relx) | (static_cast<uint8_t>(mouse->rely) << 8) |
+                           (static_cast<uint8_t>(mouse->wheel) << 16);
+            errors += seq != (received & 0xffffff);
+        } else {
+            errors++;
+        }
+        received++;
+    }
+
+    producer.join();
+
+    EXPECT_EQ(received, kReports);
+    EXPECT_EQ(errors, 0u);
+    EXPECT_TRUE(queue.empty());
+}
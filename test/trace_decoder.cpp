@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "binary_trace.hpp"
+
+/**
+ * @brief Converts binary traces of \ref BinaryTrace to text
+ *
+ * Usage: trace_decoder channel1.bin [channel2.bin]
+ *
+ * The files are raw dumps of the RTT channels, e.g. recorded by openocd with
+ * "rtt server start 9091 1" and "nc localhost 9091 > channel1.bin".
+ * Traces of both cores are merged by their time stamps.
+ */
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s channel1.bin [channel2.bin]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<std::pair<BinaryTrace::Record, int>> records;
+    size_t unknown = 0;
+
+    for (int file_index = 1; file_index < argc; file_index++) {
+        FILE *file = fopen(argv[file_index], "rb");
+        if (!file) {
+            fprintf(stderr, "Can't open %s\n", argv[file_index]);
+            return 1;
+        }
+
+        std::vector<uint8_t> data;
+        int c;
+        while ((c = fgetc(file)) != EOF)
+            data.push_back(static_cast<uint8_t>(c));
+        fclose(file);
+
+        std::span<const uint8_t> rest(data);
+        BinaryTrace::Record record;
+        while (size_t consumed = BinaryTrace::decode(rest, record)) {
+            rest = rest.subspan(consumed);
+            if (record.event == kTraceEvents)
+                unknown++;
+            else
+                records.emplace_back(record, file_index);
+        }
+
+        if (!rest.empty())
+            fprintf(stderr, "%s: %zu bytes of an incomplete record at the end\n", argv[file_index], rest.size());
+    }
+
+    if (records.empty())
+        return 0;
+
+    // Relative to the first record to survive the wrap around of the clock
+    uint32_t start = records.front().first.time_us;
+    for (auto &entry : records) {
+        if (static_cast<int32_t>(entry.first.time_us - start) < 0)
+            start = entry.first.time_us;
+    }
+
+    std::stable_sort(records.begin(), records.end(), [start](auto &a, auto &b) {
+        return a.first.time_us - start < b.first.time_us - start;
+    });
+
+    char line[200];
+    for (auto &[record, channel] : records) {
+        BinaryTrace::format(record, line, sizeof(line));
+        if (argc > 2)
+            printf("%10u us  %d  %s\n", record.time_us, channel - 1, line);
+        else
+            printf("%10u us  %s\n", record.time_us, line);
+    }
+
+    if (unknown)
+        fprintf(stderr, "%zu bytes with unknown events were skipped\n", unknown);
+
+    return 0;
+}